@@ -40,36 +40,74 @@ namespace impl {
 namespace pixel {
 
 using ::aidl::google::hardware::power::impl::pixel::PowerHintSession;
+using ::android::perfmgr::BoostSource;
+using ::android::perfmgr::HintIdRegistry;
 
 constexpr char kPowerHalStateProp[] = "vendor.powerhal.state";
 constexpr char kPowerHalAudioProp[] = "vendor.powerhal.audio";
 constexpr char kPowerHalRenderingProp[] = "vendor.powerhal.rendering";
 constexpr char kPowerHalAdpfRateProp[] = "vendor.powerhal.adpf.rate";
 constexpr int64_t kPowerHalAdpfRateDefault = -1;
+constexpr char kPowerHalVerboseProp[] = "vendor.powerhal.verbose";
 
-Power::Power(std::shared_ptr<HintManager> hm, std::shared_ptr<DisplayLowPower> dlpw)
+// HintIds are never released, so the tables stay valid across config reloads
+template <typename E>
+std::vector<Power::HintHandle> Power::resolveHints() {
+    std::vector<HintHandle> hints;
+    for (const E value : ndk::enum_range<E>()) {
+        const size_t index = static_cast<size_t>(value);
+        if (index >= hints.size()) {
+            // gaps in the enum resolve to the empty name, which no config defines
+            hints.resize(index + 1, {"", HintIdRegistry::Intern("")});
+        }
+        hints[index] = {toString(value), HintIdRegistry::Intern(toString(value))};
+    }
+    return hints;
+}
+
+template <typename E>
+const Power::HintHandle *Power::getHint(const std::vector<HintHandle> &hints, E type) {
+    const size_t index = static_cast<size_t>(type);
+    return index < hints.size() ? &hints[index] : nullptr;
+}
+
+Power::Power(std::shared_ptr<HintManager> hm, std::shared_ptr<DisplayLowPower> dlpw,
+             std::shared_ptr<BoostArbiter> arbiter)
     : mHintManager(hm),
       mDisplayLowPower(dlpw),
+      mBoostArbiter(arbiter),
       mInteractionHandler(nullptr),
       mVRModeOn(false),
       mSustainedPerfModeOn(false),
       mAdpfRateNs(
-              ::android::base::GetIntProperty(kPowerHalAdpfRateProp, kPowerHalAdpfRateDefault)) {
-    mInteractionHandler = std::make_unique<InteractionHandler>(mHintManager);
+              ::android::base::GetIntProperty(kPowerHalAdpfRateProp, kPowerHalAdpfRateDefault)),
+      mBoostHints(resolveHints<Boost>()),
+      mModeHints(resolveHints<Mode>()),
+      mVrHintId(HintIdRegistry::Intern("VR")),
+      mSustainedPerfHintId(HintIdRegistry::Intern("SUSTAINED_PERFORMANCE")),
+      mVrSustainedPerfHintId(HintIdRegistry::Intern("VR_SUSTAINED_PERFORMANCE")),
+      mVerbose(::android::base::GetBoolProperty(kPowerHalVerboseProp, false)) {
+    mInteractionHandler = std::make_unique<InteractionHandler>(mBoostArbiter);
     mInteractionHandler->Init();
 
+    // Restored modes go through the arbiter like setMode, so its policy sees
+    // them enabled and their hints are accounted.
     std::string state = ::android::base::GetProperty(kPowerHalStateProp, "");
     if (state == "SUSTAINED_PERFORMANCE") {
         LOG(INFO) << "Initialize with SUSTAINED_PERFORMANCE on";
-        mHintManager->DoHint("SUSTAINED_PERFORMANCE");
+        mBoostArbiter->SetMode(mSustainedPerfHintId, true);
+        mBoostArbiter->DoHint(BoostSource::MODE, mSustainedPerfHintId);
         mSustainedPerfModeOn = true;
     } else if (state == "VR") {
         LOG(INFO) << "Initialize with VR on";
-        mHintManager->DoHint(state);
+        mBoostArbiter->SetMode(mVrHintId, true);
+        mBoostArbiter->DoHint(BoostSource::MODE, mVrHintId);
         mVRModeOn = true;
     } else if (state == "VR_SUSTAINED_PERFORMANCE") {
         LOG(INFO) << "Initialize with SUSTAINED_PERFORMANCE and VR on";
-        mHintManager->DoHint("VR_SUSTAINED_PERFORMANCE");
+        mBoostArbiter->SetMode(mSustainedPerfHintId, true);
+        mBoostArbiter->SetMode(mVrHintId, true);
+        mBoostArbiter->DoHint(BoostSource::MODE, mVrSustainedPerfHintId);
         mSustainedPerfModeOn = true;
         mVRModeOn = true;
     } else {
@@ -79,13 +117,17 @@ Power::Power(std::shared_ptr<HintManager> hm, std::shared_ptr<DisplayLowPower> d
     state = ::android::base::GetProperty(kPowerHalAudioProp, "");
     if (state == "AUDIO_STREAMING_LOW_LATENCY") {
         LOG(INFO) << "Initialize with AUDIO_LOW_LATENCY on";
-        mHintManager->DoHint(state);
+        const HintId audio = getHint(mModeHints, Mode::AUDIO_STREAMING_LOW_LATENCY)->id;
+        mBoostArbiter->SetMode(audio, true);
+        mBoostArbiter->DoHint(BoostSource::MODE, audio);
     }
 
     state = ::android::base::GetProperty(kPowerHalRenderingProp, "");
     if (state == "EXPENSIVE_RENDERING") {
         LOG(INFO) << "Initialize with EXPENSIVE_RENDERING on";
-        mHintManager->DoHint("EXPENSIVE_RENDERING");
+        const HintId rendering = getHint(mModeHints, Mode::EXPENSIVE_RENDERING)->id;
+        mBoostArbiter->SetMode(rendering, true);
+        mBoostArbiter->DoHint(BoostSource::MODE, rendering);
     }
 
     // Now start to take powerhint
@@ -93,31 +135,39 @@ Power::Power(std::shared_ptr<HintManager> hm, std::shared_ptr<DisplayLowPower> d
 }
 
 ndk::ScopedAStatus Power::setMode(Mode type, bool enabled) {
-    LOG(DEBUG) << "Power setMode: " << toString(type) << " to: " << enabled;
-    PowerSessionManager::getInstance()->updateHintMode(toString(type), enabled);
+    const HintHandle *hint = getHint(mModeHints, type);
+    if (hint == nullptr) {
+        LOG(ERROR) << "Power setMode: unknown mode " << static_cast<int32_t>(type);
+        return ndk::ScopedAStatus::ok();
+    }
+    if (mVerbose) {
+        LOG(INFO) << "Power setMode: " << hint->name << " to: " << enabled;
+    }
+    PowerSessionManager::getInstance()->updateHintMode(hint->name, enabled);
+    mBoostArbiter->SetMode(hint->id, enabled);
     switch (type) {
         case Mode::LOW_POWER:
             mDisplayLowPower->SetDisplayLowPower(enabled);
             if (enabled) {
-                mHintManager->DoHint(toString(type));
+                mBoostArbiter->DoHint(BoostSource::MODE, hint->id);
             } else {
-                mHintManager->EndHint(toString(type));
+                mBoostArbiter->EndHint(BoostSource::MODE, hint->id);
             }
             break;
         case Mode::SUSTAINED_PERFORMANCE:
             if (enabled && !mSustainedPerfModeOn) {
                 if (!mVRModeOn) {  // Sustained mode only.
-                    mHintManager->DoHint("SUSTAINED_PERFORMANCE");
+                    mBoostArbiter->DoHint(BoostSource::MODE, mSustainedPerfHintId);
                 } else {  // Sustained + VR mode.
-                    mHintManager->EndHint("VR");
-                    mHintManager->DoHint("VR_SUSTAINED_PERFORMANCE");
+                    mBoostArbiter->EndHint(BoostSource::MODE, mVrHintId);
+                    mBoostArbiter->DoHint(BoostSource::MODE, mVrSustainedPerfHintId);
                 }
                 mSustainedPerfModeOn = true;
             } else if (!enabled && mSustainedPerfModeOn) {
-                mHintManager->EndHint("VR_SUSTAINED_PERFORMANCE");
-                mHintManager->EndHint("SUSTAINED_PERFORMANCE");
+                mBoostArbiter->EndHint(BoostSource::MODE, mVrSustainedPerfHintId);
+                mBoostArbiter->EndHint(BoostSource::MODE, mSustainedPerfHintId);
                 if (mVRModeOn) {  // Switch back to VR Mode.
-                    mHintManager->DoHint("VR");
+                    mBoostArbiter->DoHint(BoostSource::MODE, mVrHintId);
                 }
                 mSustainedPerfModeOn = false;
             }
@@ -125,17 +175,17 @@ ndk::ScopedAStatus Power::setMode(Mode type, bool enabled) {
         case Mode::VR:
             if (enabled && !mVRModeOn) {
                 if (!mSustainedPerfModeOn) {  // VR mode only.
-                    mHintManager->DoHint("VR");
+                    mBoostArbiter->DoHint(BoostSource::MODE, mVrHintId);
                 } else {  // Sustained + VR mode.
-                    mHintManager->EndHint("SUSTAINED_PERFORMANCE");
-                    mHintManager->DoHint("VR_SUSTAINED_PERFORMANCE");
+                    mBoostArbiter->EndHint(BoostSource::MODE, mSustainedPerfHintId);
+                    mBoostArbiter->DoHint(BoostSource::MODE, mVrSustainedPerfHintId);
                 }
                 mVRModeOn = true;
             } else if (!enabled && mVRModeOn) {
-                mHintManager->EndHint("VR_SUSTAINED_PERFORMANCE");
-                mHintManager->EndHint("VR");
+                mBoostArbiter->EndHint(BoostSource::MODE, mVrSustainedPerfHintId);
+                mBoostArbiter->EndHint(BoostSource::MODE, mVrHintId);
                 if (mSustainedPerfModeOn) {  // Switch back to sustained Mode.
-                    mHintManager->DoHint("SUSTAINED_PERFORMANCE");
+                    mBoostArbiter->DoHint(BoostSource::MODE, mSustainedPerfHintId);
                 }
                 mVRModeOn = false;
             }
@@ -169,9 +219,9 @@ ndk::ScopedAStatus Power::setMode(Mode type, bool enabled) {
             [[fallthrough]];
         default:
             if (enabled) {
-                mHintManager->DoHint(toString(type));
+                mBoostArbiter->DoHint(BoostSource::MODE, hint->id);
             } else {
-                mHintManager->EndHint(toString(type));
+                mBoostArbiter->EndHint(BoostSource::MODE, hint->id);
             }
             break;
     }
@@ -180,18 +230,23 @@ ndk::ScopedAStatus Power::setMode(Mode type, bool enabled) {
 }
 
 ndk::ScopedAStatus Power::isModeSupported(Mode type, bool *_aidl_return) {
-    bool supported = mHintManager->IsHintSupported(toString(type));
+    const HintHandle *hint = getHint(mModeHints, type);
+    bool supported = hint != nullptr && mHintManager->IsHintSupported(hint->id);
     // LOW_POWER handled insides PowerHAL specifically
     if (type == Mode::LOW_POWER) {
         supported = true;
     }
-    LOG(INFO) << "Power mode " << toString(type) << " isModeSupported: " << supported;
+    if (mVerbose) {
+        LOG(INFO) << "Power mode " << toString(type) << " isModeSupported: " << supported;
+    }
     *_aidl_return = supported;
     return ndk::ScopedAStatus::ok();
 }
 
 ndk::ScopedAStatus Power::setBoost(Boost type, int32_t durationMs) {
-    LOG(DEBUG) << "Power setBoost: " << toString(type) << " duration: " << durationMs;
+    if (mVerbose) {
+        LOG(INFO) << "Power setBoost: " << toString(type) << " duration: " << durationMs;
+    }
     switch (type) {
         case Boost::INTERACTION:
             if (mVRModeOn || mSustainedPerfModeOn) {
@@ -209,26 +264,36 @@ ndk::ScopedAStatus Power::setBoost(Boost type, int32_t durationMs) {
             [[fallthrough]];
         case Boost::CAMERA_SHOT:
             [[fallthrough]];
-        default:
+        default: {
             if (mVRModeOn || mSustainedPerfModeOn) {
                 break;
             }
+            const HintHandle *hint = getHint(mBoostHints, type);
+            if (hint == nullptr) {
+                LOG(ERROR) << "Power setBoost: unknown boost " << static_cast<int32_t>(type);
+                break;
+            }
             if (durationMs > 0) {
-                mHintManager->DoHint(toString(type), std::chrono::milliseconds(durationMs));
+                mBoostArbiter->DoHint(BoostSource::BOOST, hint->id,
+                                      std::chrono::milliseconds(durationMs));
             } else if (durationMs == 0) {
-                mHintManager->DoHint(toString(type));
+                mBoostArbiter->DoHint(BoostSource::BOOST, hint->id);
             } else {
-                mHintManager->EndHint(toString(type));
+                mBoostArbiter->EndHint(BoostSource::BOOST, hint->id);
             }
             break;
+        }
     }
 
     return ndk::ScopedAStatus::ok();
 }
 
 ndk::ScopedAStatus Power::isBoostSupported(Boost type, bool *_aidl_return) {
-    bool supported = mHintManager->IsHintSupported(toString(type));
-    LOG(INFO) << "Power boost " << toString(type) << " isBoostSupported: " << supported;
+    const HintHandle *hint = getHint(mBoostHints, type);
+    bool supported = hint != nullptr && mHintManager->IsHintSupported(hint->id);
+    if (mVerbose) {
+        LOG(INFO) << "Power boost " << toString(type) << " isBoostSupported: " << supported;
+    }
     *_aidl_return = supported;
     return ndk::ScopedAStatus::ok();
 }
@@ -237,18 +302,47 @@ constexpr const char *boolToString(bool b) {
     return b ? "true" : "false";
 }
 
-binder_status_t Power::dump(int fd, const char **, uint32_t) {
+binder_status_t Power::dump(int fd, const char **args, uint32_t numArgs) {
+    // dumpsys android.hardware.power.IPower/default --reload
+    if (numArgs > 0 && std::string(args[0]) == "--reload") {
+        const std::string config_path = mHintManager->GetConfigPath();
+        const bool reloaded = mHintManager->Reload(config_path);
+        std::string result(::android::base::StringPrintf(
+                "Reload %s: %s\n", config_path.c_str(), reloaded ? "done" : "failed"));
+        if (!::android::base::WriteStringToFd(result, fd)) {
+            PLOG(ERROR) << "Failed to dump state to fd";
+        }
+        fsync(fd);
+        return STATUS_OK;
+    }
+    // dumpsys android.hardware.power.IPower/default --adpf-binary
+    if (numArgs > 0 && std::string(args[0]) == "--adpf-binary") {
+        PowerSessionManager::getInstance()->dumpBinaryToFd(fd);
+        fsync(fd);
+        return STATUS_OK;
+    }
     std::string buf(::android::base::StringPrintf(
             "HintManager Running: %s\n"
             "VRMode: %s\n"
             "SustainedPerformanceMode: %s\n",
             boolToString(mHintManager->IsRunning()), boolToString(mVRModeOn),
             boolToString(mSustainedPerfModeOn)));
+    // Hints whose node requests were shadowed by higher priority values
+    std::string shadowed_hints;
+    for (const auto &[hint, stats] : mHintManager->GetAllHintStats()) {
+        if (stats.shadowed > 0) {
+            shadowed_hints += " " + hint + ":" + std::to_string(stats.shadowed);
+        }
+    }
+    buf += "ShadowedHints:" + (shadowed_hints.empty() ? " none" : shadowed_hints) + "\n";
     // Dump nodes through libperfmgr
     mHintManager->DumpToFd(fd);
     if (!::android::base::WriteStringToFd(buf, fd)) {
         PLOG(ERROR) << "Failed to dump state to fd";
     }
+    mBoostArbiter->DumpToFd(fd);
+    mInteractionHandler->DumpToFd(fd);
+    PowerSessionManager::getInstance()->dumpToFd(fd);
     fsync(fd);
     return STATUS_OK;
 }
@@ -18,9 +18,12 @@
 
 #include <atomic>
 #include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include <aidl/android/hardware/power/BnPower.h>
+#include <perfmgr/BoostArbiter.h>
 #include <perfmgr/HintManager.h>
 
 #include "disp-power/DisplayLowPower.h"
@@ -36,11 +39,14 @@ namespace pixel {
 using ::aidl::android::hardware::power::Boost;
 using ::aidl::android::hardware::power::IPowerHintSession;
 using ::aidl::android::hardware::power::Mode;
+using ::android::perfmgr::BoostArbiter;
+using ::android::perfmgr::HintId;
 using ::android::perfmgr::HintManager;
 
 class Power : public ::aidl::android::hardware::power::BnPower {
   public:
-    Power(std::shared_ptr<HintManager> hm, std::shared_ptr<DisplayLowPower> dlpw);
+    Power(std::shared_ptr<HintManager> hm, std::shared_ptr<DisplayLowPower> dlpw,
+          std::shared_ptr<BoostArbiter> arbiter);
     ndk::ScopedAStatus setMode(Mode type, bool enabled) override;
     ndk::ScopedAStatus isModeSupported(Mode type, bool *_aidl_return) override;
     ndk::ScopedAStatus setBoost(Boost type, int32_t durationMs) override;
@@ -53,12 +59,33 @@ class Power : public ::aidl::android::hardware::power::BnPower {
     binder_status_t dump(int fd, const char **args, uint32_t numArgs) override;
 
   private:
+    // Hint of one Boost or Mode value, resolved once so that dispatch does not
+    // build or look up strings.
+    struct HintHandle {
+        std::string name;
+        HintId id;
+    };
+    template <typename E>
+    static std::vector<HintHandle> resolveHints();
+    // Return nullptr for a value unknown to this build
+    template <typename E>
+    static const HintHandle *getHint(const std::vector<HintHandle> &hints, E type);
+
     std::shared_ptr<HintManager> mHintManager;
     std::shared_ptr<DisplayLowPower> mDisplayLowPower;
+    std::shared_ptr<BoostArbiter> mBoostArbiter;
     std::unique_ptr<InteractionHandler> mInteractionHandler;
     std::atomic<bool> mVRModeOn;
     std::atomic<bool> mSustainedPerfModeOn;
     const int64_t mAdpfRateNs;
+    // indexed by Boost and Mode value
+    const std::vector<HintHandle> mBoostHints;
+    const std::vector<HintHandle> mModeHints;
+    const HintId mVrHintId;
+    const HintId mSustainedPerfHintId;
+    const HintId mVrSustainedPerfHintId;
+    // log every setBoost/setMode call and support query
+    const bool mVerbose;
 };
 
 }  // namespace pixel
@@ -36,13 +36,25 @@ namespace power {
 namespace impl {
 namespace pixel {
 
+using ::android::perfmgr::BoostSource;
+using ::android::perfmgr::HintId;
+using ::android::perfmgr::HintIdRegistry;
+
 ndk::ScopedAStatus PowerExt::setMode(const std::string &mode, bool enabled) {
     LOG(DEBUG) << "PowerExt setMode: " << mode << " to: " << enabled;
 
-    if (enabled) {
-        mHintManager->DoHint(mode);
-    } else {
-        mHintManager->EndHint(mode);
+    // Thermal severity modes come here, keep the ones a config names for the
+    // arbitration policy. Unknown names are not interned.
+    HintId hint;
+    if (HintIdRegistry::Find(mode, &hint)) {
+        mBoostArbiter->SetMode(hint, enabled);
+    }
+    if (mHintManager->GetHintId(mode, &hint)) {
+        if (enabled) {
+            mBoostArbiter->DoHint(BoostSource::EXT, hint);
+        } else {
+            mBoostArbiter->EndHint(BoostSource::EXT, hint);
+        }
     }
     PowerSessionManager::getInstance()->updateHintMode(mode, enabled);
 
@@ -59,12 +71,17 @@ ndk::ScopedAStatus PowerExt::isModeSupported(const std::string &mode, bool *_aid
 ndk::ScopedAStatus PowerExt::setBoost(const std::string &boost, int32_t durationMs) {
     LOG(DEBUG) << "PowerExt setBoost: " << boost << " duration: " << durationMs;
 
+    HintId hint;
+    if (!mHintManager->GetHintId(boost, &hint)) {
+        LOG(ERROR) << "PowerExt setBoost: unknown boost " << boost;
+        return ndk::ScopedAStatus::ok();
+    }
     if (durationMs > 0) {
-        mHintManager->DoHint(boost, std::chrono::milliseconds(durationMs));
+        mBoostArbiter->DoHint(BoostSource::EXT, hint, std::chrono::milliseconds(durationMs));
     } else if (durationMs == 0) {
-        mHintManager->DoHint(boost);
+        mBoostArbiter->DoHint(BoostSource::EXT, hint);
     } else {
-        mHintManager->EndHint(boost);
+        mBoostArbiter->EndHint(BoostSource::EXT, hint);
     }
 
     return ndk::ScopedAStatus::ok();
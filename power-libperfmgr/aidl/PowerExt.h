@@ -21,6 +21,7 @@
 #include <thread>
 
 #include <aidl/google/hardware/power/extension/pixel/BnPowerExt.h>
+#include <perfmgr/BoostArbiter.h>
 #include <perfmgr/HintManager.h>
 
 #include "disp-power/DisplayLowPower.h"
@@ -32,12 +33,14 @@ namespace power {
 namespace impl {
 namespace pixel {
 
+using ::android::perfmgr::BoostArbiter;
 using ::android::perfmgr::HintManager;
 
 class PowerExt : public ::aidl::google::hardware::power::extension::pixel::BnPowerExt {
   public:
-    PowerExt(std::shared_ptr<HintManager> hm, std::shared_ptr<DisplayLowPower> dlpw)
-        : mHintManager(hm), mDisplayLowPower(dlpw) {}
+    PowerExt(std::shared_ptr<HintManager> hm, std::shared_ptr<DisplayLowPower> dlpw,
+             std::shared_ptr<BoostArbiter> arbiter)
+        : mHintManager(hm), mDisplayLowPower(dlpw), mBoostArbiter(arbiter) {}
     ndk::ScopedAStatus setMode(const std::string &mode, bool enabled) override;
     ndk::ScopedAStatus isModeSupported(const std::string &mode, bool *_aidl_return) override;
     ndk::ScopedAStatus setBoost(const std::string &boost, int32_t durationMs) override;
@@ -46,6 +49,7 @@ class PowerExt : public ::aidl::google::hardware::power::extension::pixel::BnPow
   private:
     std::shared_ptr<HintManager> mHintManager;
     std::shared_ptr<DisplayLowPower> mDisplayLowPower;
+    std::shared_ptr<BoostArbiter> mBoostArbiter;
 };
 
 }  // namespace pixel
@@ -18,12 +18,10 @@
 #define ATRACE_TAG (ATRACE_TAG_POWER | ATRACE_TAG_HAL)
 
 #include <android-base/logging.h>
-#include <android-base/parsedouble.h>
-#include <android-base/properties.h>
 #include <android-base/stringprintf.h>
-#include <sys/syscall.h>
 #include <time.h>
 #include <utils/Trace.h>
+#include <algorithm>
 #include <atomic>
 
 #include "PowerHintSession.h"
@@ -37,121 +35,32 @@ namespace impl {
 namespace pixel {
 
 using ::android::base::StringPrintf;
+using ::android::perfmgr::ControllerOutput;
+using ::android::perfmgr::RefreshRateSwitchConfig;
 using std::chrono::duration_cast;
 using std::chrono::nanoseconds;
 using std::literals::chrono_literals::operator""s;
 
-constexpr char kPowerHalAdpfPidPOver[] = "vendor.powerhal.adpf.pid_p.over";
-constexpr char kPowerHalAdpfPidPUnder[] = "vendor.powerhal.adpf.pid_p.under";
-constexpr char kPowerHalAdpfPidI[] = "vendor.powerhal.adpf.pid_i";
-constexpr char kPowerHalAdpfPidDOver[] = "vendor.powerhal.adpf.pid_d.over";
-constexpr char kPowerHalAdpfPidDUnder[] = "vendor.powerhal.adpf.pid_d.under";
-constexpr char kPowerHalAdpfPidIInit[] = "vendor.powerhal.adpf.pid_i.init";
-constexpr char kPowerHalAdpfPidIHighLimit[] = "vendor.powerhal.adpf.pid_i.high_limit";
-constexpr char kPowerHalAdpfPidILowLimit[] = "vendor.powerhal.adpf.pid_i.low_limit";
-constexpr char kPowerHalAdpfUclampEnable[] = "vendor.powerhal.adpf.uclamp";
-constexpr char kPowerHalAdpfUclampMinGranularity[] = "vendor.powerhal.adpf.uclamp_min.granularity";
-constexpr char kPowerHalAdpfUclampMinHighLimit[] = "vendor.powerhal.adpf.uclamp_min.high_limit";
-constexpr char kPowerHalAdpfUclampMinLowLimit[] = "vendor.powerhal.adpf.uclamp_min.low_limit";
-constexpr char kPowerHalAdpfStaleTimeFactor[] = "vendor.powerhal.adpf.stale_timeout_factor";
-constexpr char kPowerHalAdpfPSamplingWindow[] = "vendor.powerhal.adpf.p.window";
-constexpr char kPowerHalAdpfISamplingWindow[] = "vendor.powerhal.adpf.i.window";
-constexpr char kPowerHalAdpfDSamplingWindow[] = "vendor.powerhal.adpf.d.window";
-
-namespace {
-/* there is no glibc or bionic wrapper */
-struct sched_attr {
-    __u32 size;
-    __u32 sched_policy;
-    __u64 sched_flags;
-    __s32 sched_nice;
-    __u32 sched_priority;
-    __u64 sched_runtime;
-    __u64 sched_deadline;
-    __u64 sched_period;
-    __u32 sched_util_min;
-    __u32 sched_util_max;
-};
-
-static int sched_setattr(int pid, struct sched_attr *attr, unsigned int flags) {
-    static const bool kPowerHalAdpfUclamp =
-            ::android::base::GetBoolProperty(kPowerHalAdpfUclampEnable, true);
-    if (!kPowerHalAdpfUclamp) {
-        ALOGV("PowerHintSession:%s: skip", __func__);
-        return 0;
-    }
-    return syscall(__NR_sched_setattr, pid, attr, flags);
-}
-
-static inline int64_t ns_to_100us(int64_t ns) {
-    return ns / 100000;
-}
-
-static double getDoubleProperty(const char *prop, double value) {
-    std::string result = ::android::base::GetProperty(prop, std::to_string(value).c_str());
-    if (!::android::base::ParseDouble(result.c_str(), &value)) {
-        ALOGE("PowerHintSession : failed to parse double in %s", prop);
-    }
-    return value;
-}
-
-static double sPidPOver = getDoubleProperty(kPowerHalAdpfPidPOver, 2.0);
-static double sPidPUnder = getDoubleProperty(kPowerHalAdpfPidPUnder, 1.0);
-static double sPidI = getDoubleProperty(kPowerHalAdpfPidI, 0.001);
-static double sPidDOver = getDoubleProperty(kPowerHalAdpfPidDOver, 500.0);
-static double sPidDUnder = getDoubleProperty(kPowerHalAdpfPidDUnder, 0.0);
-static const int64_t sPidIInit =
-        (sPidI == 0) ? 0
-                     : static_cast<int64_t>(::android::base::GetIntProperty<int64_t>(
-                                                    kPowerHalAdpfPidIInit, 200) /
-                                            sPidI);
-static const int64_t sPidIHighLimit =
-        (sPidI == 0) ? 0
-                     : static_cast<int64_t>(::android::base::GetIntProperty<int64_t>(
-                                                    kPowerHalAdpfPidIHighLimit, 512) /
-                                            sPidI);
-static const int64_t sPidILowLimit =
-        (sPidI == 0) ? 0
-                     : static_cast<int64_t>(::android::base::GetIntProperty<int64_t>(
-                                                    kPowerHalAdpfPidILowLimit, -30) /
-                                            sPidI);
-static const int32_t sUclampMinHighLimit =
-        ::android::base::GetUintProperty<uint32_t>(kPowerHalAdpfUclampMinHighLimit, 384);
-static const int32_t sUclampMinLowLimit =
-        ::android::base::GetUintProperty<uint32_t>(kPowerHalAdpfUclampMinLowLimit, 2);
-static const uint32_t sUclampMinGranularity =
-        ::android::base::GetUintProperty<uint32_t>(kPowerHalAdpfUclampMinGranularity, 5);
-static const int64_t sStaleTimeFactor =
-        ::android::base::GetUintProperty<uint32_t>(kPowerHalAdpfStaleTimeFactor, 20);
-static const int64_t sPSamplingWindow =
-        ::android::base::GetUintProperty<uint32_t>(kPowerHalAdpfPSamplingWindow, 1);
-static const int64_t sISamplingWindow =
-        ::android::base::GetUintProperty<uint32_t>(kPowerHalAdpfISamplingWindow, 0);
-static const int64_t sDSamplingWindow =
-        ::android::base::GetUintProperty<uint32_t>(kPowerHalAdpfDSamplingWindow, 1);
-
-}  // namespace
-
 PowerHintSession::PowerHintSession(int32_t tgid, int32_t uid, const std::vector<int32_t> &threadIds,
                                    int64_t durationNanos, const nanoseconds adpfRate)
-    : kAdpfRate(adpfRate) {
+    : kAdpfRate(adpfRate),
+      mIdString(StringPrintf("%" PRId32 "-%" PRId32 "-%" PRIxPTR, tgid, uid,
+                             reinterpret_cast<uintptr_t>(this) & 0xffff)),
+      mTraceNames(mIdString) {
     mDescriptor = new AppHintDesc(tgid, uid, threadIds);
     mDescriptor->duration = std::chrono::nanoseconds(durationNanos);
-    mStaleHandler = sp<StaleHandler>(new StaleHandler(this));
-    mPowerManagerHandler = PowerSessionManager::getInstance();
+    mRefreshRate = PowerSessionManager::getInstance()->getDisplayRefreshRate();
+    updateAdpfConfig(PowerSessionManager::getInstance()->getAdpfConfig());
 
     if (ATRACE_ENABLED()) {
-        const std::string idstr = getIdString();
-        std::string sz = StringPrintf("adpf.%s-target", idstr.c_str());
-        ATRACE_INT(sz.c_str(), (int64_t)mDescriptor->duration.count());
-        sz = StringPrintf("adpf.%s-active", idstr.c_str());
-        ATRACE_INT(sz.c_str(), mDescriptor->is_active.load());
-        sz = StringPrintf("adpf.%s-stale", idstr.c_str());
-        ATRACE_INT(sz.c_str(), isStale());
+        ATRACE_INT(mTraceNames.target.c_str(), (int64_t)mDescriptor->duration.count());
+        ATRACE_INT(mTraceNames.active.c_str(), mDescriptor->is_active.load());
+        ATRACE_INT(mTraceNames.stale.c_str(), isStale());
     }
     PowerSessionManager::getInstance()->addPowerSession(this);
     // init boost
-    setUclamp(sUclampMinHighLimit);
+    setUclamp(mProfile->controller_config.uclamp_min_high);
+    updateStaleDeadline();
     ALOGV("PowerHintSession created: %s", mDescriptor->toString().c_str());
 }
 
@@ -159,52 +68,54 @@ PowerHintSession::~PowerHintSession() {
     close();
     ALOGV("PowerHintSession deleted: %s", mDescriptor->toString().c_str());
     if (ATRACE_ENABLED()) {
-        const std::string idstr = getIdString();
-        std::string sz = StringPrintf("adpf.%s-target", idstr.c_str());
-        ATRACE_INT(sz.c_str(), 0);
-        sz = StringPrintf("adpf.%s-actl_last", idstr.c_str());
-        ATRACE_INT(sz.c_str(), 0);
-        sz = sz = StringPrintf("adpf.%s-active", idstr.c_str());
-        ATRACE_INT(sz.c_str(), 0);
+        ATRACE_INT(mTraceNames.target.c_str(), 0);
+        ATRACE_INT(mTraceNames.actlLast.c_str(), 0);
+        ATRACE_INT(mTraceNames.active.c_str(), 0);
     }
     delete mDescriptor;
 }
 
-std::string PowerHintSession::getIdString() const {
-    std::string idstr = StringPrintf("%" PRId32 "-%" PRId32 "-%" PRIxPTR, mDescriptor->tgid,
-                                     mDescriptor->uid, reinterpret_cast<uintptr_t>(this) & 0xffff);
-    return idstr;
+const std::string &PowerHintSession::getIdString() const {
+    return mIdString;
+}
+
+SessionTelemetry *PowerHintSession::getTelemetry() {
+    return &mTelemetry;
 }
 
+PowerHintSession::TraceNames::TraceNames(const std::string &idstr)
+    : target(StringPrintf("adpf.%s-target", idstr.c_str())),
+      active(StringPrintf("adpf.%s-active", idstr.c_str())),
+      stale(StringPrintf("adpf.%s-stale", idstr.c_str())),
+      min(StringPrintf("adpf.%s-min", idstr.c_str())),
+      wakeup(StringPrintf("adpf.%s-wakeup", idstr.c_str())),
+      err(StringPrintf("adpf.%s-err", idstr.c_str())),
+      integral(StringPrintf("adpf.%s-integral", idstr.c_str())),
+      derivative(StringPrintf("adpf.%s-derivative", idstr.c_str())),
+      actlLast(StringPrintf("adpf.%s-actl_last", idstr.c_str())),
+      sampleSize(StringPrintf("adpf.%s-sample_size", idstr.c_str())),
+      pidCount(StringPrintf("adpf.%s-pid.count", idstr.c_str())),
+      pidPOut(StringPrintf("adpf.%s-pid.pOut", idstr.c_str())),
+      pidIOut(StringPrintf("adpf.%s-pid.iOut", idstr.c_str())),
+      pidDOut(StringPrintf("adpf.%s-pid.dOut", idstr.c_str())),
+      pidFfOut(StringPrintf("adpf.%s-pid.ffOut", idstr.c_str())),
+      pidOutput(StringPrintf("adpf.%s-pid.output", idstr.c_str())),
+      pidOvertime(StringPrintf("adpf.%s-pid.overtime", idstr.c_str())),
+      saturated(StringPrintf("adpf.%s-saturated", idstr.c_str())) {}
+
 void PowerHintSession::updateUniveralBoostMode() {
-    PowerHintMonitor::getInstance()->getLooper()->sendMessage(mPowerManagerHandler, NULL);
+    PowerSessionManager::getInstance()->updateSessionActive(this);
 }
 
-int PowerHintSession::setUclamp(int32_t min, int32_t max) {
+int PowerHintSession::setUclamp(int32_t min) {
     std::lock_guard<std::mutex> guard(mLock);
     min = std::max(0, min);
-    min = std::min(min, max);
-    max = std::max(0, max);
-    max = std::max(min, max);
+    min = std::min(min, kMaxUclampValue);
     if (ATRACE_ENABLED()) {
-        const std::string idstr = getIdString();
-        std::string sz = StringPrintf("adpf.%s-min", idstr.c_str());
-        ATRACE_INT(sz.c_str(), min);
-    }
-    for (const auto tid : mDescriptor->threadIds) {
-        sched_attr attr = {};
-        attr.size = sizeof(attr);
-
-        attr.sched_flags = (SCHED_FLAG_KEEP_ALL | SCHED_FLAG_UTIL_CLAMP);
-        attr.sched_util_min = min;
-        attr.sched_util_max = max;
-
-        int ret = sched_setattr(tid, &attr, 0);
-        if (ret) {
-            ALOGW("sched_setattr failed for thread %d, err=%d", tid, errno);
-        }
-        ALOGV("PowerHintSession tid: %d, uclamp(%d, %d)", tid, min, max);
+        ATRACE_INT(mTraceNames.min.c_str(), min);
     }
+    // Threads shared with other sessions get the max of all sessions
+    PowerSessionManager::getInstance()->setUclampMin(this, min);
     mDescriptor->current_min = min;
     return 0;
 }
@@ -216,9 +127,7 @@ ndk::ScopedAStatus PowerHintSession::pause() {
     setUclamp(0);
     mDescriptor->is_active.store(false);
     if (ATRACE_ENABLED()) {
-        const std::string idstr = getIdString();
-        std::string sz = StringPrintf("adpf.%s-active", idstr.c_str());
-        ATRACE_INT(sz.c_str(), mDescriptor->is_active.load());
+        ATRACE_INT(mTraceNames.active.c_str(), mDescriptor->is_active.load());
     }
     updateUniveralBoostMode();
     return ndk::ScopedAStatus::ok();
@@ -228,14 +137,13 @@ ndk::ScopedAStatus PowerHintSession::resume() {
     if (mDescriptor->is_active.load())
         return ndk::ScopedAStatus::fromExceptionCode(EX_ILLEGAL_STATE);
     mDescriptor->is_active.store(true);
-    mDescriptor->integral_error = std::max(sPidIInit, mDescriptor->integral_error);
+    mController->ResetIntegral();
     // resume boost
-    setUclamp(sUclampMinHighLimit);
+    setUclamp(mProfile->controller_config.uclamp_min_high);
     if (ATRACE_ENABLED()) {
-        const std::string idstr = getIdString();
-        std::string sz = StringPrintf("adpf.%s-active", idstr.c_str());
-        ATRACE_INT(sz.c_str(), mDescriptor->is_active.load());
+        ATRACE_INT(mTraceNames.active.c_str(), mDescriptor->is_active.load());
     }
+    updateStaleDeadline();
     updateUniveralBoostMode();
     return ndk::ScopedAStatus::ok();
 }
@@ -245,10 +153,9 @@ ndk::ScopedAStatus PowerHintSession::close() {
     if (!mSessionClosed.compare_exchange_strong(sessionClosedExpectedToBe, true)) {
         return ndk::ScopedAStatus::fromExceptionCode(EX_ILLEGAL_STATE);
     }
-    PowerHintMonitor::getInstance()->getLooper()->removeMessages(mStaleHandler);
+    PowerHintMonitor::getInstance()->removeStaleDeadline(this);
     setUclamp(0);
     PowerSessionManager::getInstance()->removePowerSession(this);
-    updateUniveralBoostMode();
     return ndk::ScopedAStatus::ok();
 }
 
@@ -260,14 +167,11 @@ ndk::ScopedAStatus PowerHintSession::updateTargetWorkDuration(int64_t targetDura
     ALOGV("update target duration: %" PRId64 " ns", targetDurationNanos);
     double ratio =
             targetDurationNanos == 0 ? 1.0 : mDescriptor->duration.count() / targetDurationNanos;
-    mDescriptor->integral_error =
-            std::max(sPidIInit, static_cast<int64_t>(mDescriptor->integral_error * ratio));
+    mController->RescaleIntegral(ratio);
 
     mDescriptor->duration = std::chrono::nanoseconds(targetDurationNanos);
     if (ATRACE_ENABLED()) {
-        const std::string idstr = getIdString();
-        std::string sz = StringPrintf("adpf.%s-target", idstr.c_str());
-        ATRACE_INT(sz.c_str(), (int64_t)mDescriptor->duration.count());
+        ATRACE_INT(mTraceNames.target.c_str(), (int64_t)mDescriptor->duration.count());
     }
 
     return ndk::ScopedAStatus::ok();
@@ -287,103 +191,123 @@ ndk::ScopedAStatus PowerHintSession::reportActualWorkDuration(
         ALOGE("Error: shouldn't report duration during pause state.");
         return ndk::ScopedAStatus::fromExceptionCode(EX_ILLEGAL_STATE);
     }
+    std::shared_ptr<const AdpfConfig> adpfConfig =
+            PowerSessionManager::getInstance()->getAdpfConfig();
+    if (adpfConfig != mAdpfConfig) {
+        updateAdpfConfig(std::move(adpfConfig));
+    }
     if (PowerHintMonitor::getInstance()->isRunning() && isStale()) {
-        mDescriptor->integral_error = std::max(sPidIInit, mDescriptor->integral_error);
+        mController->ResetIntegral();
         if (ATRACE_ENABLED()) {
-            const std::string idstr = getIdString();
-            std::string sz = StringPrintf("adpf.%s-wakeup", idstr.c_str());
-            ATRACE_INT(sz.c_str(), mDescriptor->integral_error);
-            ATRACE_INT(sz.c_str(), 0);
+            ATRACE_INT(mTraceNames.wakeup.c_str(), mController->GetIntegral());
+            ATRACE_INT(mTraceNames.wakeup.c_str(), 0);
         }
     }
-    int64_t targetDurationNanos = (int64_t)mDescriptor->duration.count();
+    const int refreshRate = PowerSessionManager::getInstance()->getDisplayRefreshRate();
+    if (refreshRate != mRefreshRate) {
+        updateRefreshRate(refreshRate);
+    }
     int64_t length = actualDurations.size();
-    int64_t p_start =
-            sPSamplingWindow == 0 || sPSamplingWindow > length ? 0 : length - sPSamplingWindow;
-    int64_t i_start =
-            sISamplingWindow == 0 || sISamplingWindow > length ? 0 : length - sISamplingWindow;
-    int64_t d_start =
-            sDSamplingWindow == 0 || sDSamplingWindow > length ? 0 : length - sDSamplingWindow;
-    int64_t dt = ns_to_100us(targetDurationNanos);
-    int64_t err_sum = 0;
-    int64_t derivative_sum = 0;
-    for (int64_t i = std::min({p_start, i_start, d_start}); i < length; i++) {
-        int64_t actualDurationNanos = actualDurations[i].durationNanos;
-        if (std::abs(actualDurationNanos) > targetDurationNanos * 20) {
-            ALOGW("The actual duration is way far from the target (%" PRId64 " >> %" PRId64 ")",
-                  actualDurationNanos, targetDurationNanos);
-        }
-        // PID control algorithm
-        int64_t error = ns_to_100us(actualDurationNanos - targetDurationNanos);
-        if (i >= d_start) {
-            derivative_sum += error - mDescriptor->previous_error;
-        }
-        if (i >= p_start) {
-            err_sum += error;
-        }
-        if (i >= i_start) {
-            mDescriptor->integral_error = mDescriptor->integral_error + error * dt;
-            mDescriptor->integral_error = std::min(sPidIHighLimit, mDescriptor->integral_error);
-            mDescriptor->integral_error = std::max(sPidILowLimit, mDescriptor->integral_error);
+    uint64_t overTarget = 0;
+    mDurationsNs.resize(length);
+    for (int64_t i = 0; i < length; i++) {
+        mDurationsNs[i] = actualDurations[i].durationNanos;
+        if (mDurationsNs[i] > mDescriptor->duration.count()) {
+            overTarget++;
         }
-        mDescriptor->previous_error = error;
     }
+    const ControllerOutput out =
+            mController->Update(mDurationsNs.data(), length, mDescriptor->duration.count());
     if (ATRACE_ENABLED()) {
-        const std::string idstr = getIdString();
-        std::string sz = StringPrintf("adpf.%s-err", idstr.c_str());
-        ATRACE_INT(sz.c_str(), err_sum / (length - p_start));
-        sz = StringPrintf("adpf.%s-integral", idstr.c_str());
-        ATRACE_INT(sz.c_str(), mDescriptor->integral_error);
-        sz = StringPrintf("adpf.%s-derivative", idstr.c_str());
-        ATRACE_INT(sz.c_str(), derivative_sum / dt / (length - d_start));
+        ATRACE_INT(mTraceNames.err.c_str(), out.err);
+        ATRACE_INT(mTraceNames.integral.c_str(), out.integral);
+        ATRACE_INT(mTraceNames.derivative.c_str(), out.derivative);
     }
-    int64_t pOut = static_cast<int64_t>((err_sum > 0 ? sPidPOver : sPidPUnder) * err_sum /
-                                        (length - p_start));
-    int64_t iOut = static_cast<int64_t>(sPidI * mDescriptor->integral_error);
-    int64_t dOut = static_cast<int64_t>((derivative_sum > 0 ? sPidDOver : sPidDUnder) *
-                                        derivative_sum / dt / (length - d_start));
-
-    int64_t output = pOut + iOut + dOut;
 
     if (ATRACE_ENABLED()) {
-        const std::string idstr = getIdString();
-        std::string sz = StringPrintf("adpf.%s-actl_last", idstr.c_str());
-        ATRACE_INT(sz.c_str(), actualDurations[length - 1].durationNanos);
-        sz = StringPrintf("adpf.%s-target", idstr.c_str());
-        ATRACE_INT(sz.c_str(), (int64_t)mDescriptor->duration.count());
-        sz = StringPrintf("adpf.%s-sample_size", idstr.c_str());
-        ATRACE_INT(sz.c_str(), length);
-        sz = StringPrintf("adpf.%s-pid.count", idstr.c_str());
-        ATRACE_INT(sz.c_str(), mDescriptor->update_count);
-        sz = StringPrintf("adpf.%s-pid.pOut", idstr.c_str());
-        ATRACE_INT(sz.c_str(), pOut);
-        sz = StringPrintf("adpf.%s-pid.iOut", idstr.c_str());
-        ATRACE_INT(sz.c_str(), iOut);
-        sz = StringPrintf("adpf.%s-pid.dOut", idstr.c_str());
-        ATRACE_INT(sz.c_str(), dOut);
-        sz = StringPrintf("adpf.%s-pid.output", idstr.c_str());
-        ATRACE_INT(sz.c_str(), output);
-        sz = StringPrintf("adpf.%s-stale", idstr.c_str());
-        ATRACE_INT(sz.c_str(), isStale());
-        sz = StringPrintf("adpf.%s-pid.overtime", idstr.c_str());
-        ATRACE_INT(sz.c_str(), err_sum > 0);
+        ATRACE_INT(mTraceNames.actlLast.c_str(), actualDurations[length - 1].durationNanos);
+        ATRACE_INT(mTraceNames.target.c_str(), (int64_t)mDescriptor->duration.count());
+        ATRACE_INT(mTraceNames.sampleSize.c_str(), length);
+        ATRACE_INT(mTraceNames.pidCount.c_str(), mDescriptor->update_count);
+        ATRACE_INT(mTraceNames.pidPOut.c_str(), out.p_out);
+        ATRACE_INT(mTraceNames.pidIOut.c_str(), out.i_out);
+        ATRACE_INT(mTraceNames.pidDOut.c_str(), out.d_out);
+        ATRACE_INT(mTraceNames.pidFfOut.c_str(), out.ff_out);
+        ATRACE_INT(mTraceNames.pidOutput.c_str(), out.output);
+        ATRACE_INT(mTraceNames.stale.c_str(), isStale());
+        ATRACE_INT(mTraceNames.pidOvertime.c_str(), out.err > 0);
     }
     mDescriptor->update_count++;
 
-    mStaleHandler->updateStaleTimer();
+    updateStaleDeadline();
 
     /* apply to all the threads in the group */
-    if (output != 0) {
-        int next_min = std::min(sUclampMinHighLimit, static_cast<int>(output));
-        next_min = std::max(sUclampMinLowLimit, next_min);
-        if (std::abs(mDescriptor->current_min - next_min) > sUclampMinGranularity) {
-            setUclamp(next_min);
+    int next_min;
+    if (SessionController::GetNextUclampMin(mProfile->controller_config, out.output,
+                                            mDescriptor->current_min, &next_min)) {
+        setUclamp(next_min);
+    }
+    // Over target with nothing left to give
+    const bool saturated =
+            out.err > 0 && mDescriptor->current_min >= mProfile->controller_config.uclamp_min_high;
+    if (mSaturation.Update(saturated, mAdpfConfig->escalation)) {
+        if (ATRACE_ENABLED()) {
+            ATRACE_INT(mTraceNames.saturated.c_str(), mSaturation.IsSaturated());
         }
+        PowerSessionManager::getInstance()->setSessionSaturated(this, mSaturation.IsSaturated());
     }
+    mTelemetry.RecordReport({actualDurations[length - 1].timeStampNanos,
+                             actualDurations[length - 1].durationNanos,
+                             mDescriptor->duration.count(), static_cast<int32_t>(out.p_out),
+                             static_cast<int32_t>(out.i_out), static_cast<int32_t>(out.d_out),
+                             mDescriptor->current_min},
+                            overTarget);
 
     return ndk::ScopedAStatus::ok();
 }
 
+void PowerHintSession::updateAdpfConfig(std::shared_ptr<const AdpfConfig> adpfConfig) {
+    mAdpfConfig = std::move(adpfConfig);
+    const AdpfProfile &profile =
+            mAdpfConfig->SelectProfile(mDescriptor->uid, [](const std::string &mode) {
+                return PowerSessionManager::getInstance()->isModeEnabled(mode);
+            });
+    // A reloaded profile restarts the controller state
+    mController = SessionController::Create(profile.controller, profile.controller_config);
+    if (mController == nullptr) {
+        ALOGE("PowerHintSession %s: unknown controller %s, using pid", mIdString.c_str(),
+              profile.controller.c_str());
+        mController = SessionController::Create("pid", profile.controller_config);
+    }
+    mProfile = &profile;
+    ALOGV("PowerHintSession %s: profile %s, controller %s", mIdString.c_str(),
+          profile.name.c_str(), mController->GetName());
+    updateRefreshRate(mRefreshRate);
+}
+
+void PowerHintSession::updateRefreshRate(int refreshRate) {
+    const RefreshRateSwitchConfig &config = mAdpfConfig->refresh_rate_switch;
+    if (refreshRate != mRefreshRate) {
+        ATRACE_NAME("adpf refresh rate switch");
+        switch (config.integral) {
+            case RefreshRateSwitchConfig::IntegralPolicy::RESET:
+                mController->ResetIntegral();
+                break;
+            case RefreshRateSwitchConfig::IntegralPolicy::RESCALE:
+                // Same direction as a target change: a faster panel needs more boost
+                mController->RescaleIntegral(static_cast<double>(refreshRate) / mRefreshRate);
+                break;
+            case RefreshRateSwitchConfig::IntegralPolicy::NONE:
+                break;
+        }
+        mRefreshRate = refreshRate;
+    }
+    mStaleTimeout = duration_cast<milliseconds>(kAdpfRate) * mProfile->stale_time_factor;
+    if (config.scale_stale_timeout && refreshRate > 0) {
+        mStaleTimeout = mStaleTimeout * RefreshRateSwitchConfig::kReferenceRate / refreshRate;
+    }
+}
+
 std::string AppHintDesc::toString() const {
     std::string out =
             StringPrintf("session %" PRIxPTR "\n", reinterpret_cast<uintptr_t>(this) & 0xffff);
@@ -410,8 +334,7 @@ bool PowerHintSession::isActive() {
 }
 
 bool PowerHintSession::isStale() {
-    auto now = std::chrono::steady_clock::now();
-    return now >= mStaleHandler->getStaleTime();
+    return mStale.load();
 }
 
 const std::vector<int> &PowerHintSession::getTidList() const {
@@ -419,60 +342,30 @@ const std::vector<int> &PowerHintSession::getTidList() const {
 }
 
 void PowerHintSession::setStale() {
+    mStale.store(true);
     if (ATRACE_ENABLED()) {
-        const std::string idstr = getIdString();
-        std::string sz = StringPrintf("adpf.%s-stale", idstr.c_str());
-        ATRACE_INT(sz.c_str(), 1);
+        ATRACE_INT(mTraceNames.stale.c_str(), 1);
     }
+    mTelemetry.RecordStaleTransition();
     // Reset to default uclamp value.
     setUclamp(0);
-    // Deliver a task to check if all sessions are inactive.
+    // Check if all sessions are inactive.
     updateUniveralBoostMode();
 }
 
-void PowerHintSession::StaleHandler::updateStaleTimer() {
-    std::lock_guard<std::mutex> guard(mStaleLock);
-    if (PowerHintMonitor::getInstance()->isRunning()) {
-        auto when = getStaleTime();
-        auto now = std::chrono::steady_clock::now();
-        mLastUpdatedTime.store(now);
-        if (now > when) {
-            mSession->updateUniveralBoostMode();
-        }
-        if (!mIsMonitoringStale.load()) {
-            auto next = getStaleTime();
-            PowerHintMonitor::getInstance()->getLooper()->sendMessageDelayed(
-                    duration_cast<nanoseconds>(next - now).count(), this, NULL);
-            mIsMonitoringStale.store(true);
-        }
+void PowerHintSession::updateStaleDeadline() {
+    if (!PowerHintMonitor::getInstance()->isRunning()) {
+        return;
+    }
+    PowerHintMonitor::getInstance()->updateStaleDeadline(this, steady_clock::now() + mStaleTimeout);
+    if (mStale.exchange(false)) {
         if (ATRACE_ENABLED()) {
-            const std::string idstr = mSession->getIdString();
-            std::string sz = StringPrintf("adpf.%s-stale", idstr.c_str());
-            ATRACE_INT(sz.c_str(), 0);
+            ATRACE_INT(mTraceNames.stale.c_str(), 0);
         }
+        updateUniveralBoostMode();
     }
 }
 
-time_point<steady_clock> PowerHintSession::StaleHandler::getStaleTime() {
-    return mLastUpdatedTime.load() +
-           std::chrono::duration_cast<milliseconds>(mSession->kAdpfRate) * sStaleTimeFactor;
-}
-
-void PowerHintSession::StaleHandler::handleMessage(const Message &) {
-    std::lock_guard<std::mutex> guard(mStaleLock);
-    auto now = std::chrono::steady_clock::now();
-    auto when = getStaleTime();
-    // Check if the session is stale based on the last_updated_time.
-    if (now > when) {
-        mSession->setStale();
-        mIsMonitoringStale.store(false);
-        return;
-    }
-    // Schedule for the next checking time.
-    PowerHintMonitor::getInstance()->getLooper()->sendMessageDelayed(
-            duration_cast<nanoseconds>(when - now).count(), this, NULL);
-}
-
 }  // namespace pixel
 }  // namespace impl
 }  // namespace power
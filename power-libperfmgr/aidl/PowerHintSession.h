@@ -18,10 +18,16 @@
 
 #include <aidl/android/hardware/power/BnPowerHintSession.h>
 #include <aidl/android/hardware/power/WorkDuration.h>
+#include <perfmgr/AdpfConfig.h>
+#include <perfmgr/SessionController.h>
+#include <perfmgr/SessionEscalation.h>
+#include <perfmgr/SessionTelemetry.h>
 #include <utils/Looper.h>
 #include <utils/Thread.h>
 
+#include <memory>
 #include <mutex>
+#include <string>
 #include <unordered_map>
 
 namespace aidl {
@@ -36,6 +42,11 @@ using aidl::android::hardware::power::WorkDuration;
 using ::android::Message;
 using ::android::MessageHandler;
 using ::android::sp;
+using ::android::perfmgr::AdpfConfig;
+using ::android::perfmgr::AdpfProfile;
+using ::android::perfmgr::SaturationFilter;
+using ::android::perfmgr::SessionController;
+using ::android::perfmgr::SessionTelemetry;
 using std::chrono::milliseconds;
 using std::chrono::nanoseconds;
 using std::chrono::steady_clock;
@@ -50,9 +61,7 @@ struct AppHintDesc {
           duration(0LL),
           current_min(0),
           is_active(true),
-          update_count(0),
-          integral_error(0),
-          previous_error(0) {}
+          update_count(0) {}
     std::string toString() const;
     const int32_t tgid;
     const int32_t uid;
@@ -61,10 +70,8 @@ struct AppHintDesc {
     int current_min;
     // status
     std::atomic<bool> is_active;
-    // pid
+    // controller
     uint64_t update_count;
-    int64_t integral_error;
-    int64_t previous_error;
 };
 
 class PowerHintSession : public BnPowerHintSession {
@@ -81,34 +88,67 @@ class PowerHintSession : public BnPowerHintSession {
     bool isActive();
     bool isStale();
     const std::vector<int> &getTidList() const;
+    // tgid-uid-session id used in atrace counters and dumps
+    const std::string &getIdString() const;
+    SessionTelemetry *getTelemetry();
+    // Called by PowerHintMonitor once the stale deadline passed
+    void setStale();
 
   private:
-    class StaleHandler : public MessageHandler {
-      public:
-        StaleHandler(PowerHintSession *session)
-            : mSession(session), mIsMonitoringStale(false), mLastUpdatedTime(steady_clock::now()) {}
-        void handleMessage(const Message &message) override;
-        void updateStaleTimer();
-        time_point<steady_clock> getStaleTime();
-
-      private:
-        PowerHintSession *mSession;
-        std::atomic<bool> mIsMonitoringStale;
-        std::atomic<time_point<steady_clock>> mLastUpdatedTime;
-        std::mutex mStaleLock;
-    };
-
-  private:
-    void setStale();
+    // Push the stale deadline out by the stale timeout, waking up the
+    // session if it was stale.
+    void updateStaleDeadline();
+    // Select the profile of the session in adpfConfig and restart the
+    // controller with it
+    void updateAdpfConfig(std::shared_ptr<const AdpfConfig> adpfConfig);
+    // Follow a display refresh rate switch as set by RefreshRateSwitchConfig
+    void updateRefreshRate(int refreshRate);
     void updateUniveralBoostMode();
-    int setUclamp(int32_t min, int32_t max = kMaxUclampValue);
-    std::string getIdString() const;
+    int setUclamp(int32_t min);
     AppHintDesc *mDescriptor = nullptr;
-    sp<StaleHandler> mStaleHandler;
-    sp<MessageHandler> mPowerManagerHandler;
+    std::unique_ptr<SessionController> mController;
+    // config the controller was created from and the profile selected in
+    // it, only replaced on the binder thread of the session
+    std::shared_ptr<const AdpfConfig> mAdpfConfig;
+    const AdpfProfile *mProfile = nullptr;
+    // missing the target at the uclamp.min high limit, binder thread only
+    SaturationFilter mSaturation;
+    // durations of the latest report, reused across reports
+    std::vector<int64_t> mDurationsNs;
     std::mutex mLock;
     const nanoseconds kAdpfRate;
+    // display refresh rate the controller state is for, binder thread only
+    int mRefreshRate;
+    // time without report before the session gets stale, binder thread only
+    milliseconds mStaleTimeout;
+    const std::string mIdString;
+    // atrace counter names, formatted once per session
+    struct TraceNames {
+        explicit TraceNames(const std::string &idstr);
+        const std::string target;
+        const std::string active;
+        const std::string stale;
+        const std::string min;
+        const std::string wakeup;
+        const std::string err;
+        const std::string integral;
+        const std::string derivative;
+        const std::string actlLast;
+        const std::string sampleSize;
+        const std::string pidCount;
+        const std::string pidPOut;
+        const std::string pidIOut;
+        const std::string pidDOut;
+        const std::string pidFfOut;
+        const std::string pidOutput;
+        const std::string pidOvertime;
+        const std::string saturated;
+    };
+    const TraceNames mTraceNames;
+    // latest reports and counters for Power::dump
+    SessionTelemetry mTelemetry;
     std::atomic<bool> mSessionClosed = false;
+    std::atomic<bool> mStale = false;
 };
 
 }  // namespace pixel
@@ -17,12 +17,19 @@
 #define LOG_TAG "powerhal-libperfmgr"
 #define ATRACE_TAG (ATRACE_TAG_POWER | ATRACE_TAG_HAL)
 
+#include <android-base/file.h>
+#include <android-base/properties.h>
+#include <android-base/stringprintf.h>
 #include <log/log.h>
 #include <processgroup/processgroup.h>
+#include <sys/syscall.h>
 #include <utils/Trace.h>
 
 #include "PowerSessionManager.h"
 
+#include <algorithm>
+#include <cinttypes>
+
 namespace aidl {
 namespace google {
 namespace hardware {
@@ -30,93 +37,432 @@ namespace power {
 namespace impl {
 namespace pixel {
 
-void PowerSessionManager::setHintManager(std::shared_ptr<HintManager> const &hint_manager) {
-    // Only initialize hintmanager instance if hint is supported.
-    if (hint_manager->IsHintSupported(kDisableBoostHintName)) {
-        mHintManager = hint_manager;
+constexpr char kPowerHalAdpfUclampEnable[] = "vendor.powerhal.adpf.uclamp";
+
+namespace {
+/* there is no glibc or bionic wrapper */
+struct sched_attr {
+    __u32 size;
+    __u32 sched_policy;
+    __u64 sched_flags;
+    __s32 sched_nice;
+    __u32 sched_priority;
+    __u64 sched_runtime;
+    __u64 sched_deadline;
+    __u64 sched_period;
+    __u32 sched_util_min;
+    __u32 sched_util_max;
+};
+
+static int sched_setattr(int pid, struct sched_attr *attr, unsigned int flags) {
+    static const bool kPowerHalAdpfUclamp =
+            ::android::base::GetBoolProperty(kPowerHalAdpfUclampEnable, true);
+    if (!kPowerHalAdpfUclamp) {
+        ALOGV("PowerSessionManager:%s: skip", __func__);
+        return 0;
     }
+    return syscall(__NR_sched_setattr, pid, attr, flags);
+}
+}  // namespace
+
+void PowerSessionManager::setHintManager(std::shared_ptr<HintManager> const &hint_manager,
+                                         std::shared_ptr<BoostArbiter> const &arbiter) {
+    // Kept for the ADPF settings even if the disable boost hint is not supported
+    mHintManager = hint_manager;
+    mBoostArbiter = arbiter;
+    mDisableBoostHintId = HintIdRegistry::Intern(kDisableBoostHintName);
+    mDisableBoostHintSupported = hint_manager->IsHintSupported(kDisableBoostHintName);
 }
 
 void PowerSessionManager::updateHintMode(const std::string &mode, bool enabled) {
     ALOGV("PowerSessionManager::updateHintMode: mode: %s, enabled: %d", mode.c_str(), enabled);
+    {
+        std::lock_guard<std::mutex> guard(mModeLock);
+        if (enabled) {
+            mEnabledModes.insert(mode);
+        } else {
+            mEnabledModes.erase(mode);
+        }
+    }
     if (enabled && mode.compare(0, 8, "REFRESH_") == 0) {
+        int rate = 0;
         if (mode.compare("REFRESH_120FPS") == 0) {
-            mDisplayRefreshRate = 120;
+            rate = 120;
         } else if (mode.compare("REFRESH_90FPS") == 0) {
-            mDisplayRefreshRate = 90;
+            rate = 90;
         } else if (mode.compare("REFRESH_60FPS") == 0) {
-            mDisplayRefreshRate = 60;
+            rate = 60;
+        }
+        // Sessions pick up the new rate on their next report
+        if (rate > 0 && mDisplayRefreshRate.exchange(rate) != rate) {
+            startPreBoost();
         }
     }
 }
 
 int PowerSessionManager::getDisplayRefreshRate() {
-    return mDisplayRefreshRate;
+    return mDisplayRefreshRate.load();
+}
+
+std::shared_ptr<const AdpfConfig> PowerSessionManager::getAdpfConfig() {
+    if (mHintManager) {
+        return mHintManager->GetAdpfConfig();
+    }
+    static const std::shared_ptr<const AdpfConfig> kDefaultConfig =
+            std::make_shared<const AdpfConfig>();
+    return kDefaultConfig;
+}
+
+bool PowerSessionManager::isModeEnabled(const std::string &mode) {
+    std::lock_guard<std::mutex> guard(mModeLock);
+    return mEnabledModes.count(mode) > 0;
+}
+
+void PowerSessionManager::startPreBoost() {
+    const auto &config = getAdpfConfig()->refresh_rate_switch;
+    // The end of the pre-boost is posted to PowerHintMonitor
+    if (config.preboost_uclamp_min <= 0 || config.preboost_duration.count() <= 0 ||
+        !PowerHintMonitor::getInstance()->isRunning()) {
+        return;
+    }
+    ATRACE_CALL();
+    std::lock_guard<std::mutex> guard(mLock);
+    mPreBoostMin = config.preboost_uclamp_min;
+    mPreBoostEnd = std::chrono::steady_clock::now() + config.preboost_duration;
+    mPreBoostCount++;
+    // Applied right away, the switch edge is what the pre-boost is for
+    applyAllUclampLocked();
+    PowerHintMonitor::getInstance()->getLooper()->sendMessageDelayed(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(config.preboost_duration).count(),
+            this, Message(kMessageEndPreBoost));
+}
+
+void PowerSessionManager::endPreBoost() {
+    std::lock_guard<std::mutex> guard(mLock);
+    // A later switch extended the pre-boost, its own message ends it
+    if (mPreBoostMin == 0 || std::chrono::steady_clock::now() < mPreBoostEnd) {
+        return;
+    }
+    mPreBoostMin = 0;
+    applyAllUclampLocked();
+}
+
+void PowerSessionManager::applyAllUclampLocked() {
+    for (const auto &[session, state] : mSessions) {
+        uint64_t syscalls = 0;
+        for (auto t : session->getTidList()) {
+            auto it = mTidUclampMap.find(t);
+            if (it != mTidUclampMap.end() && applyUclampLocked(t, &it->second)) {
+                syscalls++;
+            }
+        }
+        session->getTelemetry()->RecordSetattr(syscalls);
+    }
 }
 
 void PowerSessionManager::addPowerSession(PowerHintSession *session) {
     std::lock_guard<std::mutex> guard(mLock);
     for (auto t : session->getTidList()) {
-        if (mTidRefCountMap.find(t) == mTidRefCountMap.end()) {
+        auto it = mTidUclampMap.find(t);
+        if (it == mTidUclampMap.end()) {
             if (!SetTaskProfiles(t, {"ResetUclampGrp"})) {
                 ALOGW("Failed to set ResetUclampGrp task profile for tid:%d", t);
             } else {
-                mTidRefCountMap[t] = 1;
+                mTidUclampMap[t].sessionMins.emplace_back(session, 0);
             }
             continue;
         }
-        if (mTidRefCountMap[t] <= 0) {
-            ALOGE("Error! Unexpected zero/negative RefCount:%d for tid:%d", mTidRefCountMap[t], t);
+        if (it->second.sessionMins.empty()) {
+            ALOGE("Error! Unexpected empty session list for tid:%d", t);
             continue;
         }
-        mTidRefCountMap[t]++;
+        it->second.sessionMins.emplace_back(session, 0);
     }
-    mSessions.insert(session);
+    mSessionUclampMap.try_emplace(session);
+    mSessions.emplace(session, SessionState());
+    updateSessionActiveLocked(session, session->isActive() && !session->isStale());
 }
 
 void PowerSessionManager::removePowerSession(PowerHintSession *session) {
     std::lock_guard<std::mutex> guard(mLock);
     for (auto t : session->getTidList()) {
-        if (mTidRefCountMap.find(t) == mTidRefCountMap.end()) {
-            ALOGE("Unexpected Error! Failed to look up tid:%d in TidRefCountMap", t);
+        auto it = mTidUclampMap.find(t);
+        if (it == mTidUclampMap.end()) {
+            ALOGE("Unexpected Error! Failed to look up tid:%d in TidUclampMap", t);
             continue;
         }
-        mTidRefCountMap[t]--;
-        if (mTidRefCountMap[t] <= 0) {
+        auto &sessionMins = it->second.sessionMins;
+        sessionMins.erase(std::remove_if(sessionMins.begin(), sessionMins.end(),
+                                         [session](const auto &s) { return s.first == session; }),
+                          sessionMins.end());
+        // Fall back to the remaining sessions of the thread, or reset it
+        applyUclampLocked(t, &it->second);
+        if (sessionMins.empty()) {
             if (!SetTaskProfiles(t, {"NoResetUclampGrp"})) {
                 ALOGW("Failed to set NoResetUclampGrp task profile for tid:%d", t);
             }
-            mTidRefCountMap.erase(t);
+            mTidUclampMap.erase(it);
         }
     }
+    mSessionUclampMap.erase(session);
+    updateSessionActiveLocked(session, false);
     mSessions.erase(session);
 }
 
-std::optional<bool> PowerSessionManager::isAnySessionActive() {
+void PowerSessionManager::updateSessionActive(PowerHintSession *session) {
+    std::lock_guard<std::mutex> guard(mLock);
+    // Read the state under mLock so concurrent updates of one session are
+    // applied in order
+    updateSessionActiveLocked(session, session->isActive() && !session->isStale());
+}
+
+void PowerSessionManager::updateSessionActiveLocked(PowerHintSession *session, bool active) {
+    auto it = mSessions.find(session);
+    if (it == mSessions.end() || it->second.active == active) {
+        return;
+    }
+    it->second.active = active;
+    mActiveSessionCount += active ? 1 : -1;
+    if (it->second.saturated) {
+        mSaturatedSessionCount += active ? 1 : -1;
+    }
+    if (mActiveSessionCount == (active ? 1 : 0)) {
+        PowerHintMonitor::getInstance()->getLooper()->sendMessage(
+                this, Message(kMessageUpdateBoostMode));
+    }
+    updateEscalationLocked();
+}
+
+void PowerSessionManager::setSessionSaturated(PowerHintSession *session, bool saturated) {
     std::lock_guard<std::mutex> guard(mLock);
-    bool active = false;
-    for (PowerHintSession *s : mSessions) {
-        // session active and not stale is actually active.
-        if (s->isActive() && !s->isStale()) {
-            active = true;
-            break;
+    auto it = mSessions.find(session);
+    if (it == mSessions.end() || it->second.saturated == saturated) {
+        return;
+    }
+    it->second.saturated = saturated;
+    if (it->second.active) {
+        mSaturatedSessionCount += saturated ? 1 : -1;
+        updateEscalationLocked();
+    }
+}
+
+void PowerSessionManager::updateEscalationLocked() {
+    const bool wanted = ShouldEscalate(mEscalationWanted, mSaturatedSessionCount,
+                                       mActiveSessionCount, getAdpfConfig()->escalation);
+    if (wanted == mEscalationWanted) {
+        return;
+    }
+    mEscalationWanted = wanted;
+    PowerHintMonitor::getInstance()->getLooper()->sendMessage(
+            this, Message(kMessageUpdateEscalation));
+}
+
+void PowerSessionManager::updateEscalation() {
+    ATRACE_CALL();
+    bool wanted;
+    {
+        std::lock_guard<std::mutex> guard(mLock);
+        wanted = mEscalationWanted;
+    }
+    sp<Looper> looper = PowerHintMonitor::getInstance()->getLooper();
+    // Drop the pending renewal, it is posted again below while escalated
+    looper->removeMessages(this, kMessageUpdateEscalation);
+    if (!mHintManager) {
+        return;
+    }
+    std::shared_ptr<const AdpfConfig> adpfConfig = getAdpfConfig();
+    const EscalationConfig &config = adpfConfig->escalation;
+    if (mEscalated && (!wanted || config.hint.empty() || mEscalatedHintId != config.hint_id)) {
+        mBoostArbiter->EndHint(BoostSource::ADPF, mEscalatedHintId);
+        mEscalated = false;
+        ATRACE_INT("adpf.escalated", 0);
+    }
+    if (!wanted || config.hint.empty()) {
+        return;
+    }
+    if (!mEscalated) {
+        ALOGV("PowerSessionManager::updateEscalation: %s", config.hint.c_str());
+        mEscalated = true;
+        mEscalatedHintId = config.hint_id;
+        mEscalationCount++;
+        ATRACE_INT("adpf.escalated", 1);
+    }
+    mBoostArbiter->DoHint(BoostSource::ADPF, config.hint_id, config.duration);
+    // Renew before the hint times out
+    looper->sendMessageDelayed(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(config.duration).count() / 2,
+            this, Message(kMessageUpdateEscalation));
+}
+
+void PowerSessionManager::setUclampMin(PowerHintSession *session, int min) {
+    std::lock_guard<std::mutex> guard(mLock);
+    auto stats = mSessionUclampMap.find(session);
+    if (stats == mSessionUclampMap.end()) {
+        return;
+    }
+    for (auto t : session->getTidList()) {
+        auto it = mTidUclampMap.find(t);
+        if (it == mTidUclampMap.end()) {
+            continue;
+        }
+        for (auto &s : it->second.sessionMins) {
+            if (s.first == session) {
+                s.second = min;
+            }
         }
     }
-    if (active == mActive) {
-        return std::nullopt;
-    } else {
-        mActive = active;
+    auto now = std::chrono::steady_clock::now();
+    stats->second.updates++;
+    if (!stats->second.pending) {
+        stats->second.pending = true;
+        stats->second.pendingSince = now;
+    }
+    if (!PowerHintMonitor::getInstance()->isRunning()) {
+        applySessionUclampLocked(session, &stats->second);
+        return;
+    }
+    if (mApplyScheduled) {
+        return;
+    }
+    // Coalesce updates arriving within one frame of the last apply
+    auto framePeriod = std::chrono::nanoseconds(std::chrono::seconds(1)) /
+                       std::max(mDisplayRefreshRate.load(), 1);
+    auto delay = std::max(mLastApplyTime + framePeriod - now,
+                          std::chrono::steady_clock::duration::zero());
+    PowerHintMonitor::getInstance()->getLooper()->sendMessageDelayed(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(delay).count(), this,
+            Message(kMessageApplyUclamp));
+    mApplyScheduled = true;
+}
+
+void PowerSessionManager::applyPendingUclamp() {
+    ATRACE_CALL();
+    std::lock_guard<std::mutex> guard(mLock);
+    mApplyScheduled = false;
+    mLastApplyTime = std::chrono::steady_clock::now();
+    for (auto &[session, stats] : mSessionUclampMap) {
+        if (stats.pending) {
+            applySessionUclampLocked(session, &stats);
+        }
     }
+}
 
-    return active;
+void PowerSessionManager::applySessionUclampLocked(PowerHintSession *session,
+                                                   SessionUclamp *stats) {
+    uint64_t syscalls = 0;
+    for (auto t : session->getTidList()) {
+        auto it = mTidUclampMap.find(t);
+        if (it != mTidUclampMap.end() && applyUclampLocked(t, &it->second)) {
+            syscalls++;
+        }
+    }
+    session->getTelemetry()->RecordSetattr(syscalls);
+    stats->applyLatency.Record(std::chrono::steady_clock::now() - stats->pendingSince);
+    stats->pending = false;
 }
 
-void PowerSessionManager::handleMessage(const Message &) {
-    auto active = isAnySessionActive();
-    if (!active.has_value()) {
+void PowerSessionManager::dumpToFd(int fd) {
+    std::string out("========== Begin ADPF uclamp ==========\n");
+    std::string sessions("========== Begin ADPF sessions ==========\n");
+    {
+        std::lock_guard<std::mutex> guard(mLock);
+        out.append(::android::base::StringPrintf(
+                "Refresh rate: %d, pre-boosts: %" PRIu64 ", pre-boost min: %d\n",
+                mDisplayRefreshRate.load(), mPreBoostCount, mPreBoostMin));
+        out.append(::android::base::StringPrintf(
+                "Active sessions: %d, saturated: %d, escalated: %d, escalations: %" PRIu64 "\n",
+                mActiveSessionCount, mSaturatedSessionCount, mEscalationWanted,
+                mEscalationCount.load()));
+        out.append("Session\tUpdates\tSyscalls\tApply P50(us)\tApply P99(us)\n");
+        for (const auto &[session, stats] : mSessionUclampMap) {
+            out.append(::android::base::StringPrintf(
+                    "%s\t%" PRIu64 "\t%" PRIu64 "\t%.1f\t%.1f\n", session->getIdString().c_str(),
+                    stats.updates, session->getTelemetry()->GetCounters().setattr,
+                    stats.applyLatency.Percentile(50).count() / 1000.0,
+                    stats.applyLatency.Percentile(99).count() / 1000.0));
+        }
+        for (const auto &[session, state] : mSessions) {
+            session->getTelemetry()->DumpText(session->getIdString(), &sessions);
+        }
+    }
+    out.append("==========  End ADPF uclamp  ==========\n");
+    sessions.append("==========  End ADPF sessions  ==========\n");
+    out.append(sessions);
+    if (!::android::base::WriteStringToFd(out, fd)) {
+        ALOGE("Failed to dump ADPF uclamp to fd");
+    }
+}
+
+void PowerSessionManager::dumpBinaryToFd(int fd) {
+    std::string out;
+    {
+        std::lock_guard<std::mutex> guard(mLock);
+        SessionTelemetry::DumpBinaryHeader(mSessions.size(), &out);
+        for (const auto &[session, state] : mSessions) {
+            session->getTelemetry()->DumpBinary(session->getIdString(), &out);
+        }
+    }
+    if (!::android::base::WriteStringToFd(out, fd)) {
+        ALOGE("Failed to dump ADPF telemetry to fd");
+    }
+}
+
+bool PowerSessionManager::applyUclampLocked(int tid, TidUclamp *state) {
+    int min = 0;
+    for (const auto &s : state->sessionMins) {
+        min = std::max(min, s.second);
+        if (mPreBoostMin > min) {
+            auto it = mSessions.find(s.first);
+            if (it != mSessions.end() && it->second.active) {
+                min = mPreBoostMin;
+            }
+        }
+    }
+    if (min == state->appliedMin) {
+        return false;
+    }
+    sched_attr attr = {};
+    attr.size = sizeof(attr);
+
+    attr.sched_flags = (SCHED_FLAG_KEEP_ALL | SCHED_FLAG_UTIL_CLAMP);
+    attr.sched_util_min = min;
+    attr.sched_util_max = kMaxUclampValue;
+
+    int ret = sched_setattr(tid, &attr, 0);
+    if (ret) {
+        ALOGW("sched_setattr failed for thread %d, err=%d", tid, errno);
+        // Retry on next update
+        state->appliedMin = -1;
+        return true;
+    }
+    ALOGV("PowerSessionManager tid: %d, uclamp(%d, %d)", tid, min, kMaxUclampValue);
+    state->appliedMin = min;
+    return true;
+}
+
+void PowerSessionManager::handleMessage(const Message &message) {
+    if (message.what == kMessageApplyUclamp) {
+        applyPendingUclamp();
+        return;
+    }
+    if (message.what == kMessageEndPreBoost) {
+        endPreBoost();
         return;
     }
-    if (active.value()) {
+    if (message.what == kMessageUpdateEscalation) {
+        updateEscalation();
+        return;
+    }
+    bool active;
+    {
+        std::lock_guard<std::mutex> guard(mLock);
+        active = mActiveSessionCount > 0;
+        if (active == mActive) {
+            return;
+        }
+        mActive = active;
+    }
+    if (active) {
         disableSystemTopAppBoost();
     } else {
         enableSystemTopAppBoost();
@@ -124,16 +470,16 @@ void PowerSessionManager::handleMessage(const Message &) {
 }
 
 void PowerSessionManager::enableSystemTopAppBoost() {
-    if (mHintManager) {
+    if (mDisableBoostHintSupported) {
         ALOGV("PowerSessionManager::enableSystemTopAppBoost!!");
-        mHintManager->EndHint(kDisableBoostHintName);
+        mBoostArbiter->EndHint(BoostSource::ADPF, mDisableBoostHintId);
     }
 }
 
 void PowerSessionManager::disableSystemTopAppBoost() {
-    if (mHintManager) {
+    if (mDisableBoostHintSupported) {
         ALOGV("PowerSessionManager::disableSystemTopAppBoost!!");
-        mHintManager->DoHint(kDisableBoostHintName);
+        mBoostArbiter->DoHint(BoostSource::ADPF, mDisableBoostHintId);
     }
 }
 
@@ -155,6 +501,53 @@ sp<Looper> PowerHintMonitor::getLooper() {
     return mLooper;
 }
 
+void PowerHintMonitor::updateStaleDeadline(PowerHintSession *session,
+                                           steady_clock::time_point deadline) {
+    std::lock_guard<std::mutex> guard(mStaleLock);
+    mStaleDeadlines.Update(session, deadline);
+    // Deadlines pushed out by reports leave the armed timer alone, it is
+    // re-armed for the soonest deadline when it fires.
+    if (deadline < mArmedDeadline) {
+        armStaleTimerLocked(steady_clock::now());
+    }
+}
+
+void PowerHintMonitor::removeStaleDeadline(PowerHintSession *session) {
+    std::lock_guard<std::mutex> guard(mStaleLock);
+    mStaleDeadlines.Remove(session);
+}
+
+void PowerHintMonitor::checkStaleDeadlines() {
+    ATRACE_CALL();
+    std::lock_guard<std::mutex> guard(mStaleLock);
+    mArmedDeadline = steady_clock::time_point::max();
+    const auto now = steady_clock::now();
+    std::vector<PowerHintSession *> expired;
+    mStaleDeadlines.PopExpired(now, &expired);
+    // Under mStaleLock, so sessions cannot be closed meanwhile
+    for (PowerHintSession *session : expired) {
+        session->setStale();
+    }
+    armStaleTimerLocked(now);
+}
+
+void PowerHintMonitor::armStaleTimerLocked(steady_clock::time_point now) {
+    if (mStaleDeadlines.Empty()) {
+        return;
+    }
+    if (mArmedDeadline != steady_clock::time_point::max()) {
+        mLooper->removeMessages(mStaleTimer);
+    }
+    mArmedDeadline = mStaleDeadlines.Top().first;
+    const auto delay = std::max(mArmedDeadline - now, steady_clock::duration::zero());
+    mLooper->sendMessageDelayed(std::chrono::duration_cast<std::chrono::nanoseconds>(delay).count(),
+                                mStaleTimer, Message());
+}
+
+void PowerHintMonitor::StaleTimer::handleMessage(const Message &) {
+    mMonitor->checkStaleDeadlines();
+}
+
 }  // namespace pixel
 }  // namespace impl
 }  // namespace power
@@ -19,12 +19,20 @@
 #include "PowerHintSession.h"
 
 #include <android-base/properties.h>
+#include <perfmgr/BoostArbiter.h>
+#include <perfmgr/DeadlineHeap.h>
 #include <perfmgr/HintManager.h>
+#include <perfmgr/LatencyHistogram.h>
+#include <perfmgr/SessionEscalation.h>
 #include <utils/Looper.h>
 
+#include <atomic>
+#include <memory>
 #include <mutex>
-#include <optional>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace aidl {
 namespace google {
@@ -37,21 +45,51 @@ using ::android::Looper;
 using ::android::Message;
 using ::android::MessageHandler;
 using ::android::Thread;
+using ::android::perfmgr::AdpfConfig;
+using ::android::perfmgr::BoostArbiter;
+using ::android::perfmgr::BoostSource;
+using ::android::perfmgr::DeadlineHeap;
+using ::android::perfmgr::EscalationConfig;
+using ::android::perfmgr::HintId;
+using ::android::perfmgr::HintIdRegistry;
 using ::android::perfmgr::HintManager;
+using ::android::perfmgr::LatencyHistogram;
+using ::android::perfmgr::ShouldEscalate;
 
 constexpr char kPowerHalAdpfDisableTopAppBoost[] = "vendor.powerhal.adpf.disable.hint";
 
 class PowerSessionManager : public MessageHandler {
   public:
-    // current hint info
+    // current hint info, a REFRESH_* mode switching the display refresh rate
+    // starts the pre-boost of RefreshRateSwitchConfig
     void updateHintMode(const std::string &mode, bool enabled);
     int getDisplayRefreshRate();
+    // ADPF settings of the current powerhint config
+    std::shared_ptr<const AdpfConfig> getAdpfConfig();
+    // Whether the power mode is enabled, for AdpfProfile::modes
+    bool isModeEnabled(const std::string &mode);
     // monitoring session status
     void addPowerSession(PowerHintSession *session);
     void removePowerSession(PowerHintSession *session);
+    // Count session as active if it is active and not stale. The universal
+    // boost mode is updated when the count of active sessions crosses zero.
+    void updateSessionActive(PowerHintSession *session);
+    // Set whether session is saturated, see EscalationConfig. The escalation
+    // hint is done while enough of the active sessions are saturated.
+    void setSessionSaturated(PowerHintSession *session, bool saturated);
+    // Publish the uclamp.min wanted by session for its threads. Each thread
+    // gets the max of the values of all sessions it belongs to, and is only
+    // written when that effective value changes. Updates are applied on the
+    // PowerHintMonitor thread, at most once per display frame.
+    void setUclampMin(PowerHintSession *session, int min);
+    // Dump uclamp apply latency and telemetry of each session
+    void dumpToFd(int fd);
+    // Dump session telemetry in the SessionTelemetry binary format
+    void dumpBinaryToFd(int fd);
 
     void handleMessage(const Message &message) override;
-    void setHintManager(std::shared_ptr<HintManager> const &hint_manager);
+    void setHintManager(std::shared_ptr<HintManager> const &hint_manager,
+                        std::shared_ptr<BoostArbiter> const &arbiter);
 
     // Singleton
     static sp<PowerSessionManager> getInstance() {
@@ -60,21 +98,103 @@ class PowerSessionManager : public MessageHandler {
     }
 
   private:
-    std::optional<bool> isAnySessionActive();
+    // uclamp.min state of a thread shared by one or more sessions
+    struct TidUclamp {
+        // min published by each session having the thread
+        std::vector<std::pair<PowerHintSession *, int>> sessionMins;
+        // min last written to the thread, -1 if not written yet
+        int appliedMin = -1;
+    };
+    // state of a session as counted in mActiveSessionCount and
+    // mSaturatedSessionCount
+    struct SessionState {
+        bool active = false;
+        bool saturated = false;
+    };
+    // uclamp.min updates of a session
+    struct SessionUclamp {
+        // setUclampMin calls, the sched_setattr calls made for them are in
+        // the session telemetry
+        uint64_t updates = 0;
+        // time from the first pending update to applying it
+        LatencyHistogram applyLatency;
+        bool pending = false;
+        std::chrono::steady_clock::time_point pendingSince;
+    };
+    // Message::what of handleMessage
+    enum MessageType : int {
+        kMessageUpdateBoostMode = 0,
+        kMessageApplyUclamp = 1,
+        kMessageEndPreBoost = 2,
+        kMessageUpdateEscalation = 3,
+    };
+    // Write the max of sessionMins to tid if it changed, mLock held. Threads
+    // of active sessions get at least mPreBoostMin. Return true if
+    // sched_setattr was called.
+    bool applyUclampLocked(int tid, TidUclamp *state);
+    // Apply the pending updates of all sessions.
+    void applyPendingUclamp();
+    void applySessionUclampLocked(PowerHintSession *session, SessionUclamp *stats);
+    // Write the threads of all sessions, e.g. when the pre-boost floor moves
+    void applyAllUclampLocked();
+    void updateSessionActiveLocked(PowerHintSession *session, bool active);
+    // Post an escalation update if the saturated session count crossed a
+    // threshold, mLock held
+    void updateEscalationLocked();
+    // Do, renew or end the escalation hint, on the PowerHintMonitor thread
+    void updateEscalation();
+    // Raise active sessions to the pre-boost floor for its duration
+    void startPreBoost();
+    void endPreBoost();
     void disableSystemTopAppBoost();
     void enableSystemTopAppBoost();
     const std::string kDisableBoostHintName;
     std::shared_ptr<HintManager> mHintManager;
-    std::unordered_set<PowerHintSession *> mSessions;  // protected by mLock
-    std::unordered_map<int, int> mTidRefCountMap;      // protected by mLock
+    // hints of sessions go through the arbiter
+    std::shared_ptr<BoostArbiter> mBoostArbiter;
+    HintId mDisableBoostHintId;
+    bool mDisableBoostHintSupported;
+    std::unordered_map<PowerHintSession *, SessionState> mSessions;  // protected by mLock
+    int mActiveSessionCount;                                         // protected by mLock
+    // active sessions that are saturated, protected by mLock
+    int mSaturatedSessionCount;
+    bool mEscalationWanted;  // protected by mLock
+    // hint of the current escalation if mEscalated, PowerHintMonitor thread only
+    bool mEscalated;
+    HintId mEscalatedHintId;
+    std::atomic<uint64_t> mEscalationCount;
+    std::unordered_map<int, TidUclamp> mTidUclampMap;  // protected by mLock
+    // protected by mLock
+    std::unordered_map<PowerHintSession *, SessionUclamp> mSessionUclampMap;
+    bool mApplyScheduled;                                  // protected by mLock
+    std::chrono::steady_clock::time_point mLastApplyTime;  // protected by mLock
+    // uclamp.min floor of active sessions during a pre-boost, 0 if none,
+    // protected by mLock
+    int mPreBoostMin;
+    std::chrono::steady_clock::time_point mPreBoostEnd;  // protected by mLock
+    uint64_t mPreBoostCount;                              // protected by mLock
     std::mutex mLock;
-    int mDisplayRefreshRate;
+    std::mutex mModeLock;
+    std::unordered_set<std::string> mEnabledModes;  // protected by mModeLock
+    std::atomic<int> mDisplayRefreshRate;
     bool mActive;  // protected by mLock
     // Singleton
     PowerSessionManager()
         : kDisableBoostHintName(::android::base::GetProperty(kPowerHalAdpfDisableTopAppBoost,
                                                              "ADPF_DISABLE_TA_BOOST")),
           mHintManager(nullptr),
+          mBoostArbiter(nullptr),
+          mDisableBoostHintId(0),
+          mDisableBoostHintSupported(false),
+          mActiveSessionCount(0),
+          mSaturatedSessionCount(0),
+          mEscalationWanted(false),
+          mEscalated(false),
+          mEscalatedHintId(0),
+          mEscalationCount(0),
+          mApplyScheduled(false),
+          mPreBoostMin(0),
+          mPreBoostCount(0),
           mDisplayRefreshRate(60),
           mActive(false) {}
     PowerSessionManager(PowerSessionManager const &) = delete;
@@ -86,6 +206,11 @@ class PowerHintMonitor : public Thread {
     void start();
     bool threadLoop() override;
     sp<Looper> getLooper();
+    // Stale tracking of all sessions: one deadline per session in a heap,
+    // with only the soonest one armed on the looper. Sessions past their
+    // deadline get PowerHintSession::setStale on the looper thread.
+    void updateStaleDeadline(PowerHintSession *session, steady_clock::time_point deadline);
+    void removeStaleDeadline(PowerHintSession *session);
     // Singleton
     static sp<PowerHintMonitor> getInstance() {
         static sp<PowerHintMonitor> instance = new PowerHintMonitor();
@@ -95,9 +220,30 @@ class PowerHintMonitor : public Thread {
     void operator=(PowerHintMonitor const &) = delete;
 
   private:
+    class StaleTimer : public MessageHandler {
+      public:
+        explicit StaleTimer(PowerHintMonitor *monitor) : mMonitor(monitor) {}
+        void handleMessage(const Message &message) override;
+
+      private:
+        PowerHintMonitor *mMonitor;
+    };
+    // Set the sessions past their deadline stale and arm the next deadline
+    void checkStaleDeadlines();
+    void armStaleTimerLocked(steady_clock::time_point now);
     sp<Looper> mLooper;
+    sp<StaleTimer> mStaleTimer;
+    std::mutex mStaleLock;
+    DeadlineHeap<PowerHintSession *> mStaleDeadlines;  // protected by mStaleLock
+    // deadline of the armed StaleTimer message, max() if none, protected by
+    // mStaleLock
+    steady_clock::time_point mArmedDeadline;
     // Singleton
-    PowerHintMonitor() : Thread(false), mLooper(new Looper(true)) {}
+    PowerHintMonitor()
+        : Thread(false),
+          mLooper(new Looper(true)),
+          mStaleTimer(new StaleTimer(this)),
+          mArmedDeadline(steady_clock::time_point::max()) {}
 };
 
 }  // namespace pixel
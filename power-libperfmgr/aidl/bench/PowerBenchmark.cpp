@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <android-base/strings.h>
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "Power.h"
+#include "disp-power/DisplayLowPower.h"
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+constexpr char kConfig[] = R"(
+{
+    "Nodes": [
+        {
+            "Name": "BenchNode",
+            "Path": "NODE_PATH",
+            "Values": ["2", "1", "0"],
+            "DefaultIndex": 2,
+            "ResetOnInit": true
+        }
+    ],
+    "Actions": [
+        {
+            "PowerHint": "DISPLAY_UPDATE_IMMINENT",
+            "Node": "BenchNode",
+            "Value": "1",
+            "Duration": 100
+        },
+        {
+            "PowerHint": "CAMERA_SHOT",
+            "Node": "BenchNode",
+            "Value": "2",
+            "Duration": 100
+        }
+    ]
+}
+)";
+
+// One Power instance shared by all benchmark threads, as with the binder
+// thread pool of the service.
+class PowerBench {
+  public:
+    static PowerBench &get() {
+        static PowerBench *bench = new PowerBench();
+        return *bench;
+    }
+
+    std::shared_ptr<Power> power;
+    std::shared_ptr<HintManager> hm;
+
+  private:
+    PowerBench() {
+        const std::string node_path = std::string(mDir.path) + "/node";
+        ::android::base::WriteStringToFile("", node_path);
+        const std::string config =
+                ::android::base::StringReplace(kConfig, "NODE_PATH", node_path, false);
+        const std::string config_path = std::string(mDir.path) + "/powerhint.json";
+        ::android::base::WriteStringToFile(config, config_path);
+        hm = HintManager::GetFromJSON(config_path, true);
+        power = ndk::SharedRefBase::make<Power>(hm, std::make_shared<DisplayLowPower>(),
+                                                std::make_shared<BoostArbiter>(hm));
+    }
+
+    TemporaryDir mDir;
+};
+
+// setBoost throughput of a supported boost from range(0) binder threads
+static void BM_PowerSetBoost(benchmark::State &state) {
+    std::shared_ptr<Power> power = PowerBench::get().power;
+    for (auto _ : state) {
+        power->setBoost(Boost::DISPLAY_UPDATE_IMMINENT, 0);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PowerSetBoost)->Threads(1)->Threads(4)->Threads(8)->UseRealTime();
+
+// setBoost of a boost missing from the config, which only does the lookup
+static void BM_PowerSetBoostUnsupported(benchmark::State &state) {
+    std::shared_ptr<Power> power = PowerBench::get().power;
+    for (auto _ : state) {
+        power->setBoost(Boost::ML_ACC, 0);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PowerSetBoostUnsupported)->Threads(1)->Threads(4)->Threads(8)->UseRealTime();
+
+// The string dispatch setBoost used before, for comparison
+static void BM_HintManagerDoHintByName(benchmark::State &state) {
+    std::shared_ptr<HintManager> hm = PowerBench::get().hm;
+    for (auto _ : state) {
+        hm->DoHint(toString(Boost::DISPLAY_UPDATE_IMMINENT));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HintManagerDoHintByName)->Threads(1)->Threads(4)->Threads(8)->UseRealTime();
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
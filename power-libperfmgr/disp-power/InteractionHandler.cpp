@@ -17,16 +17,20 @@
 #define LOG_TAG "powerhal-libperfmgr"
 #define ATRACE_TAG (ATRACE_TAG_POWER | ATRACE_TAG_HAL)
 
+#include <algorithm>
 #include <array>
 #include <memory>
 
 #include <fcntl.h>
+#include <inttypes.h>
 #include <poll.h>
 #include <sys/eventfd.h>
 #include <time.h>
 #include <unistd.h>
 
+#include <android-base/file.h>
 #include <android-base/properties.h>
+#include <android-base/stringprintf.h>
 #include <utils/Log.h>
 #include <utils/Trace.h>
 
@@ -44,6 +48,8 @@ namespace power {
 namespace impl {
 namespace pixel {
 
+using ::android::perfmgr::BoostSource;
+
 namespace {
 
 static const bool kDisplayIdleSupport =
@@ -58,6 +64,13 @@ static const uint32_t kMaxDurationMs =
         ::android::base::GetUintProperty("vendor.powerhal.interaction.max", /*default*/ 5650U);
 static const uint32_t kDurationOffsetMs =
         ::android::base::GetUintProperty("vendor.powerhal.interaction.offset", /*default*/ 650U);
+// Learn the boost duration from how long the display takes to go idle
+static const bool kLearnDuration =
+        ::android::base::GetBoolProperty("vendor.powerhal.interaction.learn", true);
+// Percentage of learned boosts allowed to end before the display goes idle
+static const uint32_t kMissBudgetPct =
+        ::android::base::GetUintProperty("vendor.powerhal.interaction.miss_budget", /*default*/ 5U);
+static const std::array<const char *, INTERACTION_GESTURE_COUNT> kGestureNames = {"tap", "fling"};
 
 static size_t CalcTimespecDiffMs(struct timespec start, struct timespec end) {
     size_t diff_in_ms = 0;
@@ -79,10 +92,16 @@ static int FbIdleOpen(void) {
 
 }  // namespace
 
-InteractionHandler::InteractionHandler(std::shared_ptr<HintManager> const &hint_manager)
+InteractionHandler::InteractionHandler(std::shared_ptr<BoostArbiter> const &arbiter)
     : mState(INTERACTION_STATE_UNINITIALIZED),
       mDurationMs(0),
-      mHintManager(hint_manager) {}
+      mRequestedMs(0),
+      mStaticDurationMs(0),
+      mGesture(INTERACTION_GESTURE_TAP),
+      mObserving(false),
+      mModels{{ReleaseTimeModel(kMissBudgetPct / 100.0), ReleaseTimeModel(kMissBudgetPct / 100.0)}},
+      mBoostArbiter(arbiter),
+      mHintId(::android::perfmgr::HintIdRegistry::Intern("INTERACTION")) {}
 
 InteractionHandler::~InteractionHandler() {
     Exit();
@@ -130,14 +149,14 @@ void InteractionHandler::Exit() {
 
 void InteractionHandler::PerfLock() {
     ALOGV("%s: acquiring perf lock", __func__);
-    if (!mHintManager->DoHint("INTERACTION")) {
+    if (!mBoostArbiter->DoHint(BoostSource::INTERACTION, mHintId)) {
         ALOGE("%s: do hint INTERACTION failed", __func__);
     }
 }
 
 void InteractionHandler::PerfRel() {
     ALOGV("%s: releasing perf lock", __func__);
-    if (!mHintManager->EndHint("INTERACTION")) {
+    if (!mBoostArbiter->EndHint(BoostSource::INTERACTION, mHintId)) {
         ALOGE("%s: end hint INTERACTION failed", __func__);
     }
 }
@@ -160,31 +179,53 @@ void InteractionHandler::Acquire(int32_t duration) {
     // 1) override property is set OR
     // 2) InteractionHandler not initialized
     if (!kDisplayIdleSupport || mState == INTERACTION_STATE_UNINITIALIZED) {
-        mHintManager->DoHint("INTERACTION", std::chrono::milliseconds(finalDuration));
+        mBoostArbiter->DoHint(BoostSource::INTERACTION, mHintId,
+                              std::chrono::milliseconds(finalDuration));
         return;
     }
 
+    // Durations from here on count from now, so include the initial idle wait
+    const enum InteractionGesture gesture =
+            duration > 0 ? INTERACTION_GESTURE_FLING : INTERACTION_GESTURE_TAP;
+    const int32_t staticDuration = kWaitMs + finalDuration;
+    int32_t appliedDuration = staticDuration;
+    if (kLearnDuration) {
+        const std::chrono::milliseconds learned = mModels[gesture].Duration(
+                std::chrono::milliseconds(std::max(duration, 0)),
+                std::chrono::milliseconds(staticDuration));
+        appliedDuration = std::max(static_cast<int32_t>(learned.count()),
+                                   static_cast<int32_t>(kWaitMs));
+    }
+
     struct timespec cur_timespec;
     clock_gettime(CLOCK_MONOTONIC, &cur_timespec);
-    if (mState != INTERACTION_STATE_IDLE && finalDuration <= mDurationMs) {
+    if (mState != INTERACTION_STATE_IDLE && appliedDuration <= mDurationMs) {
         size_t elapsed_time = CalcTimespecDiffMs(mLastTimespec, cur_timespec);
         // don't hint if previous hint's duration covers this hint's duration
-        if (elapsed_time <= (mDurationMs - finalDuration)) {
+        if (elapsed_time <= (mDurationMs - appliedDuration)) {
             ALOGV("%s: Previous duration (%d) cover this (%d) elapsed: %lld", __func__,
-                  static_cast<int>(mDurationMs), static_cast<int>(finalDuration),
+                  static_cast<int>(mDurationMs), static_cast<int>(appliedDuration),
                   static_cast<long long>(elapsed_time));
             return;
         }
     }
     mLastTimespec = cur_timespec;
-    mDurationMs = finalDuration;
+    mDurationMs = appliedDuration;
+    mRequestedMs = duration;
+    mStaticDurationMs = staticDuration;
+    mGesture = gesture;
 
-    ALOGV("%s: input: %d final duration: %d", __func__, duration, finalDuration);
+    ALOGV("%s: input: %d final duration: %d applied: %d", __func__, duration, finalDuration,
+          appliedDuration);
 
-    if (mState == INTERACTION_STATE_WAITING)
+    if (mState == INTERACTION_STATE_WAITING) {
         AbortWaitLocked();
-    else if (mState == INTERACTION_STATE_IDLE)
+    } else if (mState == INTERACTION_STATE_IDLE) {
         PerfLock();
+        // stop observing the previous boost
+        if (mObserving)
+            AbortWaitLocked();
+    }
 
     mState = INTERACTION_STATE_INTERACTION;
     mCond.notify_one();
@@ -213,7 +254,15 @@ void InteractionHandler::AbortWaitLocked() {
         ALOGW("Unable to write to event fd (%zd)", ret);
 }
 
-void InteractionHandler::WaitForIdle(int32_t wait_ms, int32_t timeout_ms) {
+// should be called while locked
+void InteractionHandler::ClearAbortLocked() {
+    uint64_t val;
+    ssize_t ret = read(mEventFd, &val, sizeof(val));
+    ALOGW_IF(ret < 0 && errno != EAGAIN, "%s: failed to clear eventfd (%zd, %d)", __func__, ret,
+             errno);
+}
+
+enum WaitResult InteractionHandler::WaitForIdle(int32_t wait_ms, int32_t timeout_ms) {
     char data[MAX_LENGTH];
     ssize_t ret;
     struct pollfd pfd[2];
@@ -230,32 +279,99 @@ void InteractionHandler::WaitForIdle(int32_t wait_ms, int32_t timeout_ms) {
     ret = poll(pfd, 1, wait_ms);
     if (ret > 0) {
         ALOGV("%s: wait aborted", __func__);
-        return;
+        return WAIT_RESULT_ABORTED;
     } else if (ret < 0) {
         ALOGE("%s: error in poll while waiting", __func__);
-        return;
+        return WAIT_RESULT_ERROR;
     }
 
     ret = pread(mIdleFd, data, sizeof(data), 0);
     if (!ret) {
         ALOGE("%s: Unexpected EOF!", __func__);
-        return;
+        return WAIT_RESULT_ERROR;
     }
 
     if (!strncmp(data, "idle", 4)) {
         ALOGV("%s: already idle", __func__);
-        return;
+        return WAIT_RESULT_IDLE;
     }
 
     ret = poll(pfd, 2, timeout_ms);
-    if (ret < 0)
+    if (ret < 0) {
         ALOGE("%s: Error on waiting for idle (%zd)", __func__, ret);
-    else if (ret == 0)
+        return WAIT_RESULT_ERROR;
+    } else if (ret == 0) {
         ALOGV("%s: timed out waiting for idle", __func__);
-    else if (pfd[0].revents)
+        return WAIT_RESULT_TIMEOUT;
+    } else if (pfd[0].revents) {
         ALOGV("%s: wait for idle aborted", __func__);
-    else if (pfd[1].revents)
-        ALOGV("%s: idle detected", __func__);
+        return WAIT_RESULT_ABORTED;
+    }
+    ALOGV("%s: idle detected", __func__);
+    return WAIT_RESULT_IDLE;
+}
+
+void InteractionHandler::Observe(const Boost &boost) {
+    std::unique_lock<std::mutex> lk(mLock);
+    // a new boost is already pending
+    if (mState != INTERACTION_STATE_IDLE)
+        return;
+    mObserving = true;
+    lk.unlock();
+
+    struct timespec cur_timespec;
+    clock_gettime(CLOCK_MONOTONIC, &cur_timespec);
+    const int32_t remaining =
+            boost.static_ms - static_cast<int32_t>(CalcTimespecDiffMs(boost.start, cur_timespec));
+    enum WaitResult result = WAIT_RESULT_TIMEOUT;
+    if (remaining > 0)
+        result = WaitForIdle(0, remaining);
+
+    lk.lock();
+    mObserving = false;
+    // drop an abort that raced with the end of the wait
+    ClearAbortLocked();
+    // a new Acquire cut the observation short, the boost did not miss
+    if (result != WAIT_RESULT_ERROR && result != WAIT_RESULT_ABORTED)
+        RecordLocked(boost, result == WAIT_RESULT_IDLE);
+}
+
+// should be called while locked
+void InteractionHandler::RecordLocked(const Boost &boost, bool settled) {
+    struct timespec cur_timespec;
+    clock_gettime(CLOCK_MONOTONIC, &cur_timespec);
+    const std::chrono::milliseconds settle(CalcTimespecDiffMs(boost.start, cur_timespec));
+    ALOGV("%s: %s settle: %lld settled: %d applied: %d", __func__, kGestureNames[boost.gesture],
+          static_cast<long long>(settle.count()), settled, boost.applied_ms);
+    mModels[boost.gesture].Record(settle, settled,
+                                  std::chrono::milliseconds(std::max(boost.requested_ms, 0)),
+                                  std::chrono::milliseconds(boost.applied_ms),
+                                  std::chrono::milliseconds(boost.static_ms));
+}
+
+void InteractionHandler::DumpToFd(int fd) {
+    std::lock_guard<std::mutex> lk(mLock);
+    std::string buf(::android::base::StringPrintf(
+            "Interaction boost learning: %s, miss budget: %u%%\n",
+            kLearnDuration ? "enabled" : "disabled", kMissBudgetPct));
+    for (size_t i = 0; i < mModels.size(); i++) {
+        const ReleaseTimeModel &model = mModels[i];
+        const ReleaseTimeModel::Stats &stats = model.GetStats();
+        const std::optional<std::chrono::milliseconds> overshoot = model.Overshoot();
+        const long long saved = (stats.static_held - stats.held).count();
+        const long long static_held = stats.static_held.count();
+        buf += ::android::base::StringPrintf(
+                "  %s: overshoot: %s samples: %zu boosts: %" PRIu64 " misses: %" PRIu64
+                " held: %lldms static: %lldms saved: %lldms (%.1f%%)\n",
+                kGestureNames[i],
+                overshoot ? (std::to_string(overshoot->count()) + "ms").c_str() : "static",
+                model.Samples(), stats.boosts, stats.misses,
+                static_cast<long long>(stats.held.count()), static_held, saved,
+                static_held > 0 ? 100.0 * saved / static_held : 0.0);
+    }
+    if (!::android::base::WriteStringToFd(buf, fd)) {
+        ALOGE("%s: failed to dump interaction state (%d)", __func__, errno);
+    }
 }
 
 void InteractionHandler::Routine() {
@@ -268,10 +384,21 @@ void InteractionHandler::Routine() {
         if (mState == INTERACTION_STATE_UNINITIALIZED)
             return;
         mState = INTERACTION_STATE_WAITING;
+        const Boost boost = {mLastTimespec, mRequestedMs, mDurationMs, mStaticDurationMs,
+                             mGesture};
         lk.unlock();
 
-        WaitForIdle(kWaitMs, mDurationMs);
+        enum WaitResult result = WaitForIdle(kWaitMs, boost.applied_ms - kWaitMs);
         Release();
+        if (!kLearnDuration)
+            continue;
+        if (result == WAIT_RESULT_IDLE) {
+            lk.lock();
+            RecordLocked(boost, true);
+            lk.unlock();
+        } else if (result == WAIT_RESULT_TIMEOUT) {
+            Observe(boost);
+        }
     }
 }
 
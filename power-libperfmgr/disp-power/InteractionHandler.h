@@ -16,13 +16,15 @@
 
 #pragma once
 
+#include <array>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
 
-#include <perfmgr/HintManager.h>
+#include <perfmgr/BoostArbiter.h>
+#include <perfmgr/ReleaseTimeModel.h>
 
 namespace aidl {
 namespace google {
@@ -31,7 +33,9 @@ namespace power {
 namespace impl {
 namespace pixel {
 
-using ::android::perfmgr::HintManager;
+using ::android::perfmgr::BoostArbiter;
+using ::android::perfmgr::HintId;
+using ::android::perfmgr::ReleaseTimeModel;
 
 enum InteractionState {
     INTERACTION_STATE_UNINITIALIZED,
@@ -40,18 +44,45 @@ enum InteractionState {
     INTERACTION_STATE_WAITING,
 };
 
+enum InteractionGesture {
+    INTERACTION_GESTURE_TAP,
+    INTERACTION_GESTURE_FLING,
+    INTERACTION_GESTURE_COUNT,
+};
+
+enum WaitResult {
+    WAIT_RESULT_IDLE,
+    WAIT_RESULT_TIMEOUT,
+    WAIT_RESULT_ABORTED,
+    WAIT_RESULT_ERROR,
+};
+
 class InteractionHandler {
   public:
-    InteractionHandler(std::shared_ptr<HintManager> const &hint_manager);
+    InteractionHandler(std::shared_ptr<BoostArbiter> const &arbiter);
     ~InteractionHandler();
     bool Init();
     void Exit();
     void Acquire(int32_t duration);
+    void DumpToFd(int fd);
 
   private:
     void Release();
-    void WaitForIdle(int32_t wait_ms, int32_t timeout_ms);
+    enum WaitResult WaitForIdle(int32_t wait_ms, int32_t timeout_ms);
     void AbortWaitLocked();
+    void ClearAbortLocked();
+    struct Boost {
+        struct timespec start;
+        int32_t requested_ms;
+        int32_t applied_ms;
+        int32_t static_ms;
+        enum InteractionGesture gesture;
+    };
+    // Keep watching the display after a timed out boost until it settles or
+    // the static duration ends, then record the boost. Nothing is recorded
+    // if a new Acquire aborts the wait.
+    void Observe(const Boost &boost);
+    void RecordLocked(const Boost &boost, bool settled);
     void Routine();
 
     void PerfLock();
@@ -62,10 +93,17 @@ class InteractionHandler {
     int mEventFd;
     int32_t mDurationMs;
     struct timespec mLastTimespec;
+    // What the last Acquire asked for and what the static policy would hold
+    int32_t mRequestedMs;
+    int32_t mStaticDurationMs;
+    enum InteractionGesture mGesture;
+    bool mObserving;
+    std::array<ReleaseTimeModel, INTERACTION_GESTURE_COUNT> mModels;
     std::unique_ptr<std::thread> mThread;
     std::mutex mLock;
     std::condition_variable mCond;
-    std::shared_ptr<HintManager> mHintManager;
+    std::shared_ptr<BoostArbiter> mBoostArbiter;
+    const HintId mHintId;
 };
 
 }  // namespace pixel
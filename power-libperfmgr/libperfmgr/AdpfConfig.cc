@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "libperfmgr"
+
+#include "perfmgr/AdpfConfig.h"
+
+#include <algorithm>
+
+namespace android {
+namespace perfmgr {
+
+namespace {
+
+// JSON keys of the ControllerConfig tunables
+constexpr struct {
+    const char *key;
+    void (*set)(double value, ControllerConfig *config);
+} kTunables[] = {
+        {"PID_Po", [](double v, ControllerConfig *c) { c->p_over = v; }},
+        {"PID_Pu", [](double v, ControllerConfig *c) { c->p_under = v; }},
+        {"PID_I", [](double v, ControllerConfig *c) { c->i = v; }},
+        {"PID_Do", [](double v, ControllerConfig *c) { c->d_over = v; }},
+        {"PID_Du", [](double v, ControllerConfig *c) { c->d_under = v; }},
+        {"PID_I_Init", [](double v, ControllerConfig *c) { c->i_init = v; }},
+        {"PID_I_High", [](double v, ControllerConfig *c) { c->i_high_limit = v; }},
+        {"PID_I_Low", [](double v, ControllerConfig *c) { c->i_low_limit = v; }},
+        {"SamplingWindow_P", [](double v, ControllerConfig *c) { c->p_window = v; }},
+        {"SamplingWindow_I", [](double v, ControllerConfig *c) { c->i_window = v; }},
+        {"SamplingWindow_D", [](double v, ControllerConfig *c) { c->d_window = v; }},
+        {"UclampMin_High", [](double v, ControllerConfig *c) { c->uclamp_min_high = v; }},
+        {"UclampMin_Low", [](double v, ControllerConfig *c) { c->uclamp_min_low = v; }},
+        {"UclampMin_Granularity",
+         [](double v, ControllerConfig *c) { c->uclamp_min_granularity = v; }},
+        {"FeedForwardGain", [](double v, ControllerConfig *c) { c->ff_gain = v; }},
+        {"TrendAlpha", [](double v, ControllerConfig *c) { c->trend_alpha = v; }},
+        {"TrendBeta", [](double v, ControllerConfig *c) { c->trend_beta = v; }},
+        {"MarginStep", [](double v, ControllerConfig *c) { c->margin_step = v; }},
+        {"MarginMax", [](double v, ControllerConfig *c) { c->margin_max = v; }},
+        {"MissRateTarget", [](double v, ControllerConfig *c) { c->miss_rate_target = v; }},
+};
+
+}  // namespace
+
+const AdpfProfile &AdpfConfig::SelectProfile(
+        int32_t uid, const std::function<bool(const std::string &)> &is_mode_enabled) const {
+    for (const AdpfProfile &profile : profiles) {
+        if (std::find(profile.uids.begin(), profile.uids.end(), uid) != profile.uids.end()) {
+            return profile;
+        }
+    }
+    for (const AdpfProfile &profile : profiles) {
+        if (std::any_of(profile.modes.begin(), profile.modes.end(), is_mode_enabled)) {
+            return profile;
+        }
+    }
+    return profiles.front();
+}
+
+bool SetControllerTunable(const std::string &key, double value, ControllerConfig *config) {
+    for (const auto &tunable : kTunables) {
+        if (key == tunable.key) {
+            tunable.set(value, config);
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace perfmgr
+}  // namespace android
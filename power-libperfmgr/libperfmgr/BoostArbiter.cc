@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG (ATRACE_TAG_POWER | ATRACE_TAG_HAL)
+#define LOG_TAG "libperfmgr"
+
+#include "perfmgr/BoostArbiter.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/stringprintf.h>
+#include <inttypes.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+
+#include "perfmgr/HintManager.h"
+
+namespace android {
+namespace perfmgr {
+
+namespace {
+
+constexpr std::array<const char *, static_cast<std::size_t>(BoostSource::COUNT)> kSourceNames = {
+        "Boost", "Mode", "Interaction", "Adpf", "Ext"};
+
+bool Contains(const std::vector<HintId> &ids, HintId id) {
+    return std::find(ids.begin(), ids.end(), id) != ids.end();
+}
+
+}  // namespace
+
+const char *BoostSourceName(BoostSource source) {
+    return kSourceNames[static_cast<std::size_t>(source)];
+}
+
+bool ParseBoostSource(const std::string &name, BoostSource *source) {
+    for (std::size_t i = 0; i < kSourceNames.size(); i++) {
+        if (name == kSourceNames[i]) {
+            *source = static_cast<BoostSource>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+BoostPolicy::Verdict BoostPolicy::Apply(BoostSource source, HintId hint,
+                                        std::chrono::milliseconds duration,
+                                        std::chrono::milliseconds hint_timeout,
+                                        int32_t priority,
+                                        const std::vector<bool> &enabled_modes) const {
+    Verdict verdict;
+    verdict.duration = duration;
+    for (const BoostRule &rule : rules) {
+        if (rule.sources != 0 && !(rule.sources & (1u << static_cast<uint32_t>(source)))) {
+            continue;
+        }
+        if (!rule.hints.empty() && !Contains(rule.hints, hint)) {
+            continue;
+        }
+        if (priority > rule.max_priority) {
+            continue;
+        }
+        if (!rule.modes.empty() &&
+            std::none_of(rule.modes.begin(), rule.modes.end(), [&](HintId mode) {
+                return mode < enabled_modes.size() && enabled_modes[mode];
+            })) {
+            continue;
+        }
+        if (rule.drop) {
+            verdict.drop = true;
+            return verdict;
+        }
+        // 0 is the hint's own timeout, where 0 again means forever
+        const std::chrono::milliseconds effective =
+                duration.count() > 0 ? duration : hint_timeout;
+        if (effective.count() == 0 || effective > rule.max_duration) {
+            verdict.capped = true;
+            verdict.duration = rule.max_duration;
+        }
+        return verdict;
+    }
+    return verdict;
+}
+
+BoostArbiter::BoostArbiter(std::shared_ptr<HintManager> hm) : hm_(std::move(hm)) {}
+
+int32_t BoostArbiter::DefaultPriority(BoostSource source) {
+    switch (source) {
+        case BoostSource::INTERACTION:
+            return 0;
+        case BoostSource::BOOST:
+        case BoostSource::ADPF:
+            return 10;
+        case BoostSource::MODE:
+            return 20;
+        case BoostSource::EXT:
+        default:
+            return 30;
+    }
+}
+
+BoostArbiter::Hold *BoostArbiter::GetHoldLocked(HintId hint) {
+    if (hint >= holds_.size()) {
+        holds_.resize(hint + 1);
+    }
+    return &holds_[hint];
+}
+
+void BoostArbiter::SettleLocked(Hold *hold, std::chrono::steady_clock::time_point now,
+                                std::chrono::steady_clock::time_point end_time) {
+    if (!hold->active) {
+        return;
+    }
+    // the hint may have been ended early around the arbiter
+    const std::chrono::steady_clock::time_point deadline = std::min(hold->deadline, end_time);
+    const std::chrono::steady_clock::time_point end = std::min(now, deadline);
+    if (end > hold->start) {
+        stats_[static_cast<std::size_t>(hold->source)].cost +=
+                std::chrono::duration<double, std::milli>(end - hold->start).count() *
+                hold->level;
+    }
+    if (now >= deadline) {
+        hold->active = false;
+    } else {
+        hold->start = now;
+    }
+}
+
+bool BoostArbiter::DoHint(BoostSource source, HintId hint, std::chrono::milliseconds duration,
+                          int32_t priority) {
+    std::chrono::milliseconds hint_timeout;
+    double level;
+    const bool supported = hm_->GetHintInfo(hint, &hint_timeout, &level);
+    std::chrono::steady_clock::time_point end_time = std::chrono::steady_clock::time_point::min();
+    bool enabled = false;
+    hm_->GetHintEndTime(hint, &end_time, &enabled);
+    std::shared_ptr<const BoostPolicy> policy = hm_->GetBoostPolicy();
+    const auto now = std::chrono::steady_clock::now();
+
+    std::chrono::milliseconds submit_duration(0);
+    std::chrono::steady_clock::time_point deadline;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        SourceStats &stats = stats_[static_cast<std::size_t>(source)];
+        stats.requests++;
+        // unsupported hints are left for HintManager to fail as before
+        if (supported) {
+            const BoostPolicy::Verdict verdict = policy->Apply(source, hint, duration,
+                                                               hint_timeout, priority,
+                                                               enabled_modes_);
+            if (verdict.drop) {
+                stats.dropped++;
+                ATRACE_INT("arbiter.dropped", static_cast<int>(stats.dropped));
+                LOG(VERBOSE) << "Drop " << HintIdRegistry::GetName(hint) << " from "
+                             << BoostSourceName(source);
+                return false;
+            }
+            if (verdict.capped) {
+                stats.capped++;
+            }
+            const std::chrono::milliseconds timeout =
+                    verdict.duration.count() > 0 ? verdict.duration : hint_timeout;
+            deadline = timeout.count() > 0 ? now + timeout
+                                           : std::chrono::steady_clock::time_point::max();
+            SettleLocked(GetHoldLocked(hint), now, end_time);
+            // end_time also covers requests made around the arbiter
+            if (enabled && end_time >= deadline) {
+                stats.coalesced++;
+                return true;
+            }
+            submit_duration = verdict.duration;
+        }
+    }
+
+    // HintManager is called without lock_ held
+    const bool ret = submit_duration.count() > 0 ? hm_->DoHint(hint, submit_duration)
+                                                 : hm_->DoHint(hint);
+    if (ret && supported) {
+        std::lock_guard<std::mutex> lock(lock_);
+        Hold *hold = GetHoldLocked(hint);
+        hold->active = true;
+        hold->source = source;
+        hold->start = now;
+        hold->deadline = deadline;
+        hold->level = level;
+    }
+    return ret;
+}
+
+bool BoostArbiter::EndHint(BoostSource source, HintId hint) {
+    std::chrono::steady_clock::time_point end_time = std::chrono::steady_clock::time_point::min();
+    bool enabled = false;
+    hm_->GetHintEndTime(hint, &end_time, &enabled);
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stats_[static_cast<std::size_t>(source)].requests++;
+        Hold *hold = GetHoldLocked(hint);
+        SettleLocked(hold, std::chrono::steady_clock::now(), end_time);
+        hold->active = false;
+    }
+    return hm_->EndHint(hint);
+}
+
+void BoostArbiter::SetMode(HintId mode, bool enabled) {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (mode >= enabled_modes_.size()) {
+        enabled_modes_.resize(mode + 1, false);
+    }
+    enabled_modes_[mode] = enabled;
+}
+
+std::array<BoostArbiter::SourceStats, static_cast<std::size_t>(BoostSource::COUNT)>
+BoostArbiter::GetStats() {
+    std::size_t num_holds;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        num_holds = holds_.size();
+    }
+    // hints unsupported now, e.g. after a Reload, are settled as ended
+    std::vector<std::chrono::steady_clock::time_point> end_times(
+            num_holds, std::chrono::steady_clock::time_point::min());
+    bool enabled;
+    for (std::size_t i = 0; i < num_holds; i++) {
+        hm_->GetHintEndTime(static_cast<HintId>(i), &end_times[i], &enabled);
+    }
+
+    std::lock_guard<std::mutex> lock(lock_);
+    const auto now = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < num_holds; i++) {
+        SettleLocked(&holds_[i], now, end_times[i]);
+    }
+    return stats_;
+}
+
+void BoostArbiter::DumpToFd(int fd) {
+    const auto stats = GetStats();
+    std::string buf("========== Begin boost arbiter ==========\n"
+                    "Source\tRequests\tCoalesced\tCapped\tDropped\tCost(ms*level)\n");
+    for (std::size_t i = 0; i < stats.size(); i++) {
+        buf += android::base::StringPrintf(
+                "%s\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\t%.0f\n",
+                kSourceNames[i], stats[i].requests, stats[i].coalesced, stats[i].capped,
+                stats[i].dropped, stats[i].cost);
+    }
+    buf += "==========  End boost arbiter  ==========\n";
+    if (!android::base::WriteStringToFd(buf, fd)) {
+        LOG(ERROR) << "Failed to dump fd: " << fd;
+    }
+}
+
+}  // namespace perfmgr
+}  // namespace android
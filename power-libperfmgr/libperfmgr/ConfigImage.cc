@@ -0,0 +1,604 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "libperfmgr"
+
+#include "perfmgr/ConfigImage.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/strings.h>
+#include <android-base/unique_fd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <cstring>
+#include <functional>
+
+#include "perfmgr/FileNode.h"
+#include "perfmgr/PropertyNode.h"
+#include "perfmgr/SessionController.h"
+
+namespace android {
+namespace perfmgr {
+
+namespace {
+
+constexpr char kImageMagic[8] = {'P', 'E', 'R', 'F', 'M', 'G', 'R', '\0'};
+// Bump on any change of the structures below; entry sizes recorded per table
+// catch a missed bump that changes the size of an entry
+constexpr uint32_t kImageVersion = 4;
+// Images are only loaded on the ABI they were compiled for
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+struct StrRef {
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct TableRef {
+    uint32_t offset;
+    uint32_t count;
+    // sizeof of an entry as written, checked on load
+    uint32_t entry_size;
+};
+
+struct ImageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t source_hash;
+    uint64_t source_size;
+    TableRef strings;
+    TableRef nodes;
+    TableRef values;
+    TableRef depends;
+    TableRef hints;
+    TableRef node_actions;
+    TableRef hint_actions;
+    TableRef adpf;
+    TableRef adpf_profiles;
+    TableRef adpf_uids;
+    TableRef adpf_modes;
+    TableRef boost_rules;
+    TableRef boost_names;
+    uint32_t reserved;
+};
+static_assert(kImageVersion == 4 && sizeof(ImageHeader) == 192,
+              "ImageHeader changed, bump kImageVersion and update the size");
+
+struct ImageNode {
+    StrRef name;
+    StrRef path;
+    StrRef write_group;
+    uint32_t first_value;
+    uint32_t num_values;
+    uint32_t first_depend;
+    uint32_t num_depends;
+    uint32_t default_index;
+    uint8_t is_file;
+    uint8_t reset_on_init;
+    uint8_t hold_fd;
+    uint8_t reserved;
+};
+
+struct ImageHint {
+    StrRef name;
+    uint32_t first_node_action;
+    uint32_t num_node_actions;
+    uint32_t first_hint_action;
+    uint32_t num_hint_actions;
+};
+
+struct ImageNodeAction {
+    uint32_t node_index;
+    uint32_t value_index;
+    uint64_t timeout_ms;
+};
+
+struct ImageHintAction {
+    uint32_t type;
+    StrRef value;
+};
+
+// AdpfConfig apart from its profiles, a single entry
+struct ImageAdpf {
+    uint32_t integral;
+    uint32_t scale_stale_timeout;
+    int32_t preboost_uclamp_min;
+    uint32_t enter_reports;
+    uint32_t exit_reports;
+    StrRef escalation_hint;
+    uint32_t reserved;
+    uint64_t preboost_duration_ms;
+    double enter_fraction;
+    double exit_fraction;
+    uint64_t escalation_duration_ms;
+};
+
+struct ImageAdpfProfile {
+    StrRef name;
+    StrRef controller;
+    uint32_t stale_time_factor;
+    uint32_t first_uid;
+    uint32_t num_uids;
+    uint32_t first_mode;
+    uint32_t num_modes;
+    uint32_t reserved;
+    // kept as is, so any change of ControllerConfig needs a version bump
+    ControllerConfig controller_config;
+};
+
+// BoostRule with modes and hints by name, as HintIds are per process
+struct ImageBoostRule {
+    uint32_t first_mode;
+    uint32_t num_modes;
+    uint32_t first_hint;
+    uint32_t num_hints;
+    uint32_t sources;
+    int32_t max_priority;
+    uint32_t drop;
+    uint32_t reserved;
+    uint64_t max_duration_ms;
+};
+
+class ImageWriter {
+  public:
+    StrRef AddString(const std::string &s) {
+        auto it = strings_index_.find(s);
+        if (it != strings_index_.end()) {
+            return it->second;
+        }
+        StrRef ref{static_cast<uint32_t>(strings_.size()), static_cast<uint32_t>(s.size())};
+        strings_.append(s);
+        strings_index_.emplace(s, ref);
+        return ref;
+    }
+
+    std::string strings_;
+    std::unordered_map<std::string, StrRef> strings_index_;
+    std::vector<ImageNode> nodes_;
+    std::vector<StrRef> values_;
+    std::vector<StrRef> depends_;
+    std::vector<ImageHint> hints_;
+    std::vector<ImageNodeAction> node_actions_;
+    std::vector<ImageHintAction> hint_actions_;
+    std::vector<ImageAdpfProfile> adpf_profiles_;
+    std::vector<int32_t> adpf_uids_;
+    std::vector<StrRef> adpf_modes_;
+    std::vector<ImageBoostRule> boost_rules_;
+    std::vector<StrRef> boost_names_;
+};
+
+template <typename T>
+TableRef AppendTable(std::string *image, const std::vector<T> &table) {
+    // Keep every table aligned for direct access from the mapping
+    image->resize((image->size() + alignof(uint64_t) - 1) & ~(alignof(uint64_t) - 1));
+    TableRef ref{static_cast<uint32_t>(image->size()), static_cast<uint32_t>(table.size()),
+                 static_cast<uint32_t>(sizeof(T))};
+    image->append(reinterpret_cast<const char *>(table.data()), table.size() * sizeof(T));
+    return ref;
+}
+
+// Read-only view of a mapped image with bounds checked accessors
+class ImageReader {
+  public:
+    ImageReader(const uint8_t *data, std::size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    const T *GetTable(const TableRef &ref) const {
+        if (ref.entry_size != sizeof(T) || ref.offset % alignof(T) != 0 || ref.offset > size_ ||
+            ref.count > (size_ - ref.offset) / sizeof(T)) {
+            return nullptr;
+        }
+        return reinterpret_cast<const T *>(data_ + ref.offset);
+    }
+
+    bool GetString(const StrRef &ref, std::string *s) const {
+        if (ref.offset > strings_.count || ref.size > strings_.count - ref.offset) {
+            return false;
+        }
+        s->assign(strings_data_ + ref.offset, ref.size);
+        return true;
+    }
+
+    bool SetStrings(const TableRef &ref) {
+        strings_data_ = GetTable<char>(ref);
+        strings_ = ref;
+        return strings_data_ != nullptr;
+    }
+
+  private:
+    const uint8_t *data_;
+    const std::size_t size_;
+    const char *strings_data_ = nullptr;
+    TableRef strings_ = {0, 0, 0};
+};
+
+bool InRange(uint32_t first, uint32_t count, uint32_t table_size) {
+    return first <= table_size && count <= table_size - first;
+}
+
+}  // namespace
+
+std::string ConfigImage::GetImagePath(const std::string &config_path) {
+    if (android::base::EndsWith(config_path, ".json")) {
+        return config_path.substr(0, config_path.size() - 5) + ".bin";
+    }
+    return config_path + ".bin";
+}
+
+uint64_t ConfigImage::HashSource(const std::string &json_doc) {
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : json_doc) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+bool ConfigImage::Write(const std::string &image_path, const std::string &json_doc,
+                        const std::vector<std::unique_ptr<Node>> &nodes,
+                        const std::vector<bool> &is_file,
+                        const std::unordered_map<std::string, Hint> &actions,
+                        const AdpfConfig &adpf, const BoostPolicy &boost_policy) {
+    if (nodes.size() != is_file.size()) {
+        LOG(ERROR) << "Node types do not match nodes";
+        return false;
+    }
+    ImageWriter w;
+    for (std::size_t i = 0; i < nodes.size(); i++) {
+        const Node &node = *nodes[i];
+        ImageNode n = {};
+        n.name = w.AddString(node.GetName());
+        n.path = w.AddString(node.GetPath());
+        n.write_group = w.AddString(node.GetWriteGroup());
+        n.first_value = w.values_.size();
+        for (const auto &value : node.GetValues()) {
+            w.values_.emplace_back(w.AddString(value));
+        }
+        n.num_values = w.values_.size() - n.first_value;
+        n.first_depend = w.depends_.size();
+        for (const auto &dep : node.GetDependsOn()) {
+            w.depends_.emplace_back(w.AddString(dep));
+        }
+        n.num_depends = w.depends_.size() - n.first_depend;
+        n.default_index = node.GetDefaultIndex();
+        n.is_file = is_file[i];
+        n.reset_on_init = node.GetResetOnInit();
+        // no dynamic_cast intentionally in Android
+        n.hold_fd = is_file[i] && reinterpret_cast<const FileNode &>(node).GetHoldFd();
+        w.nodes_.emplace_back(n);
+    }
+    for (const auto &a : actions) {
+        ImageHint h = {};
+        h.name = w.AddString(a.first);
+        h.first_node_action = w.node_actions_.size();
+        for (const auto &action : a.second.node_actions) {
+            w.node_actions_.push_back({static_cast<uint32_t>(action.node_index),
+                                       static_cast<uint32_t>(action.value_index),
+                                       static_cast<uint64_t>(action.timeout_ms.count())});
+        }
+        h.num_node_actions = w.node_actions_.size() - h.first_node_action;
+        h.first_hint_action = w.hint_actions_.size();
+        for (const auto &action : a.second.hint_actions) {
+            w.hint_actions_.push_back(
+                    {static_cast<uint32_t>(action.type), w.AddString(action.value)});
+        }
+        h.num_hint_actions = w.hint_actions_.size() - h.first_hint_action;
+        w.hints_.emplace_back(h);
+    }
+    for (const auto &profile : adpf.profiles) {
+        ImageAdpfProfile p = {};
+        p.name = w.AddString(profile.name);
+        p.controller = w.AddString(profile.controller);
+        p.stale_time_factor = profile.stale_time_factor;
+        p.first_uid = w.adpf_uids_.size();
+        w.adpf_uids_.insert(w.adpf_uids_.end(), profile.uids.begin(), profile.uids.end());
+        p.num_uids = profile.uids.size();
+        p.first_mode = w.adpf_modes_.size();
+        for (const auto &mode : profile.modes) {
+            w.adpf_modes_.emplace_back(w.AddString(mode));
+        }
+        p.num_modes = profile.modes.size();
+        p.controller_config = profile.controller_config;
+        w.adpf_profiles_.emplace_back(p);
+    }
+    ImageAdpf image_adpf = {};
+    image_adpf.integral = static_cast<uint32_t>(adpf.refresh_rate_switch.integral);
+    image_adpf.scale_stale_timeout = adpf.refresh_rate_switch.scale_stale_timeout;
+    image_adpf.preboost_uclamp_min = adpf.refresh_rate_switch.preboost_uclamp_min;
+    image_adpf.preboost_duration_ms = adpf.refresh_rate_switch.preboost_duration.count();
+    image_adpf.escalation_hint = w.AddString(adpf.escalation.hint);
+    image_adpf.enter_reports = adpf.escalation.enter_reports;
+    image_adpf.exit_reports = adpf.escalation.exit_reports;
+    image_adpf.enter_fraction = adpf.escalation.enter_fraction;
+    image_adpf.exit_fraction = adpf.escalation.exit_fraction;
+    image_adpf.escalation_duration_ms = adpf.escalation.duration.count();
+    for (const auto &rule : boost_policy.rules) {
+        ImageBoostRule b = {};
+        b.first_mode = w.boost_names_.size();
+        for (HintId mode : rule.modes) {
+            w.boost_names_.emplace_back(w.AddString(HintIdRegistry::GetName(mode)));
+        }
+        b.num_modes = rule.modes.size();
+        b.first_hint = w.boost_names_.size();
+        for (HintId hint : rule.hints) {
+            w.boost_names_.emplace_back(w.AddString(HintIdRegistry::GetName(hint)));
+        }
+        b.num_hints = rule.hints.size();
+        b.sources = rule.sources;
+        b.max_priority = rule.max_priority;
+        b.drop = rule.drop;
+        b.max_duration_ms = rule.max_duration.count();
+        w.boost_rules_.emplace_back(b);
+    }
+
+    ImageHeader header = {};
+    std::memcpy(header.magic, kImageMagic, sizeof(kImageMagic));
+    header.version = kImageVersion;
+    header.byte_order = kByteOrderMark;
+    header.source_hash = HashSource(json_doc);
+    header.source_size = json_doc.size();
+    std::string image(sizeof(header), '\0');
+    header.strings = AppendTable(&image, std::vector<char>(w.strings_.begin(), w.strings_.end()));
+    header.nodes = AppendTable(&image, w.nodes_);
+    header.values = AppendTable(&image, w.values_);
+    header.depends = AppendTable(&image, w.depends_);
+    header.hints = AppendTable(&image, w.hints_);
+    header.node_actions = AppendTable(&image, w.node_actions_);
+    header.hint_actions = AppendTable(&image, w.hint_actions_);
+    header.adpf = AppendTable(&image, std::vector<ImageAdpf>{image_adpf});
+    header.adpf_profiles = AppendTable(&image, w.adpf_profiles_);
+    header.adpf_uids = AppendTable(&image, w.adpf_uids_);
+    header.adpf_modes = AppendTable(&image, w.adpf_modes_);
+    header.boost_rules = AppendTable(&image, w.boost_rules_);
+    header.boost_names = AppendTable(&image, w.boost_names_);
+    std::memcpy(image.data(), &header, sizeof(header));
+
+    if (!android::base::WriteStringToFile(image, image_path)) {
+        PLOG(ERROR) << "Failed to write config image " << image_path;
+        return false;
+    }
+    LOG(INFO) << "Wrote config image " << image_path << ": " << image.size() << " bytes, "
+              << w.nodes_.size() << " nodes, " << w.hints_.size() << " hints";
+    return true;
+}
+
+bool ConfigImage::Load(const std::string &image_path, const std::string &json_doc,
+                       std::vector<std::unique_ptr<Node>> *nodes,
+                       std::unordered_map<std::string, Hint> *actions, AdpfConfig *adpf,
+                       BoostPolicy *boost_policy) {
+    android::base::unique_fd fd(TEMP_FAILURE_RETRY(open(image_path.c_str(), O_RDONLY | O_CLOEXEC)));
+    if (fd < 0) {
+        LOG(INFO) << "No config image " << image_path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(ImageHeader)) {
+        LOG(WARNING) << "Invalid config image " << image_path;
+        return false;
+    }
+    const std::size_t size = st.st_size;
+    void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        PLOG(WARNING) << "Failed to map config image " << image_path;
+        return false;
+    }
+    std::unique_ptr<void, std::function<void(void *)>> unmap(
+            map, [size](void *p) { munmap(p, size); });
+
+    const uint8_t *data = static_cast<const uint8_t *>(map);
+    ImageHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kImageMagic, sizeof(kImageMagic)) != 0 ||
+        header.version != kImageVersion || header.byte_order != kByteOrderMark) {
+        LOG(WARNING) << "Unsupported config image " << image_path;
+        return false;
+    }
+    if (header.source_size != json_doc.size() || header.source_hash != HashSource(json_doc)) {
+        LOG(WARNING) << "Stale config image " << image_path;
+        return false;
+    }
+
+    ImageReader r(data, size);
+    const auto *image_nodes = r.GetTable<ImageNode>(header.nodes);
+    const auto *values = r.GetTable<StrRef>(header.values);
+    const auto *depends = r.GetTable<StrRef>(header.depends);
+    const auto *hints = r.GetTable<ImageHint>(header.hints);
+    const auto *node_actions = r.GetTable<ImageNodeAction>(header.node_actions);
+    const auto *hint_actions = r.GetTable<ImageHintAction>(header.hint_actions);
+    const auto *image_adpf = r.GetTable<ImageAdpf>(header.adpf);
+    const auto *adpf_profiles = r.GetTable<ImageAdpfProfile>(header.adpf_profiles);
+    const auto *adpf_uids = r.GetTable<int32_t>(header.adpf_uids);
+    const auto *adpf_modes = r.GetTable<StrRef>(header.adpf_modes);
+    const auto *boost_rules = r.GetTable<ImageBoostRule>(header.boost_rules);
+    const auto *boost_names = r.GetTable<StrRef>(header.boost_names);
+    if (!r.SetStrings(header.strings) || !image_nodes || !values || !depends || !hints ||
+        !node_actions || !hint_actions || !image_adpf || header.adpf.count != 1 ||
+        !adpf_profiles || header.adpf_profiles.count == 0 || !adpf_uids || !adpf_modes ||
+        !boost_rules || !boost_names) {
+        LOG(WARNING) << "Malformed config image " << image_path;
+        return false;
+    }
+
+    std::vector<std::unique_ptr<Node>> nodes_loaded;
+    for (uint32_t i = 0; i < header.nodes.count; i++) {
+        const ImageNode &n = image_nodes[i];
+        std::string name, path, write_group;
+        if (!r.GetString(n.name, &name) || !r.GetString(n.path, &path) ||
+            !r.GetString(n.write_group, &write_group) || n.num_values == 0 ||
+            !InRange(n.first_value, n.num_values, header.values.count) ||
+            !InRange(n.first_depend, n.num_depends, header.depends.count) ||
+            n.default_index >= n.num_values) {
+            LOG(WARNING) << "Malformed Node[" << i << "] in config image " << image_path;
+            return false;
+        }
+        std::vector<RequestGroup> values_loaded;
+        std::string value;
+        for (uint32_t j = n.first_value; j < n.first_value + n.num_values; j++) {
+            if (!r.GetString(values[j], &value)) {
+                LOG(WARNING) << "Malformed Node[" << i << "] in config image " << image_path;
+                return false;
+            }
+            values_loaded.emplace_back(value);
+        }
+        std::vector<std::string> depends_on;
+        for (uint32_t j = n.first_depend; j < n.first_depend + n.num_depends; j++) {
+            if (!r.GetString(depends[j], &value)) {
+                LOG(WARNING) << "Malformed Node[" << i << "] in config image " << image_path;
+                return false;
+            }
+            depends_on.emplace_back(value);
+        }
+        if (n.is_file) {
+            nodes_loaded.emplace_back(std::make_unique<FileNode>(
+                    std::move(name), std::move(path), std::move(values_loaded), n.default_index,
+                    n.reset_on_init, n.hold_fd));
+        } else {
+            nodes_loaded.emplace_back(std::make_unique<PropertyNode>(
+                    std::move(name), std::move(path), std::move(values_loaded), n.default_index,
+                    n.reset_on_init));
+        }
+        nodes_loaded.back()->SetDependsOn(std::move(depends_on));
+        nodes_loaded.back()->SetWriteGroup(std::move(write_group));
+    }
+
+    std::unordered_map<std::string, Hint> actions_loaded;
+    for (uint32_t i = 0; i < header.hints.count; i++) {
+        const ImageHint &h = hints[i];
+        std::string name;
+        if (!r.GetString(h.name, &name) ||
+            !InRange(h.first_node_action, h.num_node_actions, header.node_actions.count) ||
+            !InRange(h.first_hint_action, h.num_hint_actions, header.hint_actions.count)) {
+            LOG(WARNING) << "Malformed Hint[" << i << "] in config image " << image_path;
+            return false;
+        }
+        Hint &hint = actions_loaded[name];
+        for (uint32_t j = h.first_node_action; j < h.first_node_action + h.num_node_actions;
+             j++) {
+            const ImageNodeAction &a = node_actions[j];
+            if (a.node_index >= nodes_loaded.size() ||
+                a.value_index >= image_nodes[a.node_index].num_values) {
+                LOG(WARNING) << "Malformed Hint[" << i << "] in config image " << image_path;
+                return false;
+            }
+            hint.node_actions.emplace_back(a.node_index, a.value_index,
+                                           std::chrono::milliseconds(a.timeout_ms));
+        }
+        for (uint32_t j = h.first_hint_action; j < h.first_hint_action + h.num_hint_actions;
+             j++) {
+            const ImageHintAction &a = hint_actions[j];
+            std::string value;
+            if (a.type > static_cast<uint32_t>(HintActionType::MaskHint) ||
+                !r.GetString(a.value, &value)) {
+                LOG(WARNING) << "Malformed Hint[" << i << "] in config image " << image_path;
+                return false;
+            }
+            hint.hint_actions.emplace_back(static_cast<HintActionType>(a.type), value);
+        }
+    }
+
+    AdpfConfig adpf_loaded;
+    adpf_loaded.profiles.clear();
+    for (uint32_t i = 0; i < header.adpf_profiles.count; i++) {
+        const ImageAdpfProfile &p = adpf_profiles[i];
+        AdpfProfile profile;
+        if (!r.GetString(p.name, &profile.name) ||
+            !r.GetString(p.controller, &profile.controller) ||
+            !InRange(p.first_uid, p.num_uids, header.adpf_uids.count) ||
+            !InRange(p.first_mode, p.num_modes, header.adpf_modes.count) ||
+            !SessionController::Create(profile.controller, p.controller_config)) {
+            LOG(WARNING) << "Malformed Profile[" << i << "] in config image " << image_path;
+            return false;
+        }
+        profile.stale_time_factor = p.stale_time_factor;
+        profile.uids.assign(adpf_uids + p.first_uid, adpf_uids + p.first_uid + p.num_uids);
+        std::string mode;
+        for (uint32_t j = p.first_mode; j < p.first_mode + p.num_modes; j++) {
+            if (!r.GetString(adpf_modes[j], &mode)) {
+                LOG(WARNING) << "Malformed Profile[" << i << "] in config image " << image_path;
+                return false;
+            }
+            profile.modes.emplace_back(mode);
+        }
+        profile.controller_config = p.controller_config;
+        adpf_loaded.profiles.emplace_back(std::move(profile));
+    }
+    const ImageAdpf &a = *image_adpf;
+    if (a.integral > static_cast<uint32_t>(RefreshRateSwitchConfig::IntegralPolicy::RESCALE) ||
+        !r.GetString(a.escalation_hint, &adpf_loaded.escalation.hint)) {
+        LOG(WARNING) << "Malformed AdpfConfig in config image " << image_path;
+        return false;
+    }
+    RefreshRateSwitchConfig *rs = &adpf_loaded.refresh_rate_switch;
+    rs->integral = static_cast<RefreshRateSwitchConfig::IntegralPolicy>(a.integral);
+    rs->scale_stale_timeout = a.scale_stale_timeout;
+    rs->preboost_uclamp_min = a.preboost_uclamp_min;
+    rs->preboost_duration = std::chrono::milliseconds(a.preboost_duration_ms);
+    EscalationConfig *esc = &adpf_loaded.escalation;
+    esc->enter_reports = a.enter_reports;
+    esc->exit_reports = a.exit_reports;
+    esc->enter_fraction = a.enter_fraction;
+    esc->exit_fraction = a.exit_fraction;
+    esc->duration = std::chrono::milliseconds(a.escalation_duration_ms);
+
+    // Names are checked before interning, a malformed image adds no ids
+    std::vector<std::vector<std::string>> rule_names(header.boost_rules.count);
+    for (uint32_t i = 0; i < header.boost_rules.count; i++) {
+        const ImageBoostRule &b = boost_rules[i];
+        if (!InRange(b.first_mode, b.num_modes, header.boost_names.count) ||
+            !InRange(b.first_hint, b.num_hints, header.boost_names.count)) {
+            LOG(WARNING) << "Malformed BoostArbiter Rule[" << i << "] in config image "
+                         << image_path;
+            return false;
+        }
+        rule_names[i].resize(b.num_modes + b.num_hints);
+        for (uint32_t j = 0; j < b.num_modes + b.num_hints; j++) {
+            uint32_t name = j < b.num_modes ? b.first_mode + j : b.first_hint + j - b.num_modes;
+            if (!r.GetString(boost_names[name], &rule_names[i][j])) {
+                LOG(WARNING) << "Malformed BoostArbiter Rule[" << i << "] in config image "
+                             << image_path;
+                return false;
+            }
+        }
+    }
+    BoostPolicy policy_loaded;
+    for (uint32_t i = 0; i < header.boost_rules.count; i++) {
+        const ImageBoostRule &b = boost_rules[i];
+        BoostRule rule;
+        for (uint32_t j = 0; j < b.num_modes + b.num_hints; j++) {
+            (j < b.num_modes ? rule.modes : rule.hints)
+                    .emplace_back(HintIdRegistry::Intern(rule_names[i][j]));
+        }
+        rule.sources = b.sources;
+        rule.max_priority = b.max_priority;
+        rule.drop = b.drop;
+        rule.max_duration = std::chrono::milliseconds(b.max_duration_ms);
+        policy_loaded.rules.emplace_back(std::move(rule));
+    }
+
+    *nodes = std::move(nodes_loaded);
+    *actions = std::move(actions_loaded);
+    *adpf = std::move(adpf_loaded);
+    *boost_policy = std::move(policy_loaded);
+    return true;
+}
+
+}  // namespace perfmgr
+}  // namespace android
@@ -27,9 +27,43 @@
 #include <android-base/strings.h>
 #include <utils/Trace.h>
 
+#include <fcntl.h>
+#include <linux/magic.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
 namespace android {
 namespace perfmgr {
 
+namespace {
+// Only regular files on a real file system keep a stale tail after a shorter
+// write and need syncing. Character devices such as /dev/cpu_dma_latency
+// reject ftruncate, and kernfs/procfs attributes take the whole value at
+// offset 0.
+bool IsPlainFile(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    struct statfs sfs;
+    if (fstatfs(fd, &sfs) != 0) {
+        return false;
+    }
+    switch (sfs.f_type) {
+        case SYSFS_MAGIC:
+        case PROC_SUPER_MAGIC:
+        case CGROUP_SUPER_MAGIC:
+        case CGROUP2_SUPER_MAGIC:
+        case DEBUGFS_MAGIC:
+        case TRACEFS_MAGIC:
+            return false;
+        default:
+            return true;
+    }
+}
+}  // namespace
+
 FileNode::FileNode(std::string name, std::string node_path,
                    std::vector<RequestGroup> req_sorted,
                    std::size_t default_val_index, bool reset_on_init,
@@ -37,8 +71,44 @@ FileNode::FileNode(std::string name, std::string node_path,
     : Node(std::move(name), std::move(node_path), std::move(req_sorted),
            default_val_index, reset_on_init),
       hold_fd_(hold_fd),
+      is_plain_file_(false),
       warn_timeout_(
           android::base::GetBoolProperty("ro.debuggable", false) ? 5ms : 50ms) {
+    // Node fd is opened once at config load and kept for later updates. Nodes
+    // with hold_fd_ tie the request lifetime to the fd, so they are only
+    // opened on demand.
+    if (!hold_fd_) {
+        OpenFd();
+    }
+}
+
+bool FileNode::OpenFd() {
+    if (fd_ == -1) {
+        fd_.reset(TEMP_FAILURE_RETRY(open(node_path_.c_str(), O_WRONLY | O_CLOEXEC)));
+        if (fd_ == -1) {
+            return false;
+        }
+        is_plain_file_ = IsPlainFile(fd_);
+    }
+    return true;
+}
+
+bool FileNode::WriteValue(const std::string &value) {
+    if (!OpenFd()) {
+        return false;
+    }
+    ssize_t written = TEMP_FAILURE_RETRY(pwrite(fd_, value.data(), value.size(), 0));
+    bool ok = written == static_cast<ssize_t>(value.size());
+    // For a plain file, drop stale tail and sync
+    if (ok && is_plain_file_) {
+        ok = TEMP_FAILURE_RETRY(ftruncate(fd_, value.size())) == 0;
+        fsync(fd_);
+    }
+    if (!ok) {
+        // Reopen on next update, e.g. node removed by hotplug (ENODEV)
+        fd_.reset();
+    }
+    return ok;
 }
 
 std::chrono::milliseconds FileNode::Update(bool log_error) {
@@ -62,25 +132,20 @@ std::chrono::milliseconds FileNode::Update(bool log_error) {
             ATRACE_BEGIN(tag.c_str());
         }
         android::base::Timer t;
-        fd_.reset(TEMP_FAILURE_RETRY(
-            open(node_path_.c_str(), O_WRONLY | O_CLOEXEC | O_TRUNC)));
-
-        if (fd_ == -1 || !android::base::WriteStringToFd(req_value, fd_)) {
+        if (!WriteValue(req_value)) {
             if (log_error) {
-                LOG(WARNING) << "Failed to write to node: " << node_path_
-                             << " with value: " << req_value << ", fd: " << fd_;
+                PLOG(WARNING) << "Failed to write to node: " << node_path_
+                              << " with value: " << req_value;
             }
             // Retry in 500ms or sooner
             expire_time = std::min(expire_time, std::chrono::milliseconds(500));
         } else {
-            // For regular file system, we need fsync
-            fsync(fd_);
             // Some dev node requires file to remain open during the entire hint
             // duration e.g. /dev/cpu_dma_latency, so fd_ is intentionally kept
             // open during any requested value other than default one. If
             // request a default value, node will write the value and then
             // release the fd.
-            if ((!hold_fd_) || value_index == default_val_index_) {
+            if (hold_fd_ && value_index == default_val_index_) {
                 fd_.reset();
             }
             auto duration = t.duration();
@@ -100,6 +165,29 @@ std::chrono::milliseconds FileNode::Update(bool log_error) {
     return expire_time;
 }
 
+bool FileNode::MigrateFrom(Node* old) {
+    if (!Node::MigrateFrom(old)) {
+        return false;
+    }
+    if (hold_fd_ && current_val_index_ != default_val_index_) {
+        fd_ = old->ReleaseHeldFd();
+        if (fd_ == -1) {
+            // Nothing held by old, write the value again to hold it here
+            reset_on_init_ = true;
+            return false;
+        }
+        is_plain_file_ = IsPlainFile(fd_);
+    }
+    return true;
+}
+
+android::base::unique_fd FileNode::ReleaseHeldFd() {
+    if (!hold_fd_) {
+        return {};
+    }
+    return std::move(fd_);
+}
+
 bool FileNode::GetHoldFd() const {
     return hold_fd_;
 }
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "libperfmgr"
+
+#include "perfmgr/HintId.h"
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace android {
+namespace perfmgr {
+
+namespace {
+struct Registry {
+    std::mutex lock;
+    std::unordered_map<std::string, HintId> ids;
+    // deque keeps references to names stable while growing
+    std::deque<std::string> names;
+};
+
+Registry &GetRegistry() {
+    static Registry *registry = new Registry();
+    return *registry;
+}
+}  // namespace
+
+HintId HintIdRegistry::Intern(const std::string &name) {
+    Registry &r = GetRegistry();
+    std::lock_guard<std::mutex> lock(r.lock);
+    auto it = r.ids.find(name);
+    if (it != r.ids.end()) {
+        return it->second;
+    }
+    HintId id = static_cast<HintId>(r.names.size());
+    r.names.emplace_back(name);
+    r.ids.emplace(name, id);
+    return id;
+}
+
+bool HintIdRegistry::Find(const std::string &name, HintId *id) {
+    Registry &r = GetRegistry();
+    std::lock_guard<std::mutex> lock(r.lock);
+    auto it = r.ids.find(name);
+    if (it == r.ids.end()) {
+        return false;
+    }
+    *id = it->second;
+    return true;
+}
+
+const std::string &HintIdRegistry::GetName(HintId id) {
+    static const std::string kEmpty;
+    Registry &r = GetRegistry();
+    std::lock_guard<std::mutex> lock(r.lock);
+    return id < r.names.size() ? r.names[id] : kEmpty;
+}
+
+std::size_t HintIdRegistry::Size() {
+    Registry &r = GetRegistry();
+    std::lock_guard<std::mutex> lock(r.lock);
+    return r.names.size();
+}
+
+}  // namespace perfmgr
+}  // namespace android
@@ -21,6 +21,7 @@
 
 #include <android-base/file.h>
 #include <android-base/logging.h>
+#include <android-base/properties.h>
 #include <android-base/stringprintf.h>
 #include <json/reader.h>
 #include <json/value.h>
@@ -30,6 +31,7 @@
 #include <algorithm>
 #include <set>
 
+#include "perfmgr/ConfigImage.h"
 #include "perfmgr/FileNode.h"
 #include "perfmgr/PropertyNode.h"
 
@@ -40,33 +42,257 @@ namespace {
 constexpr std::chrono::milliseconds kMilliSecondZero = std::chrono::milliseconds(0);
 constexpr std::chrono::steady_clock::time_point kTimePointMax =
         std::chrono::steady_clock::time_point::max();
+// Fallback to update every node on each NodeLooperThread wake up
+constexpr char kFullUpdateProperty[] = "vendor.powerhal.perfmgr.full_update";
+// Calls still on the old config after this fail the reload
+constexpr std::chrono::milliseconds kReloadDrainTimeout = std::chrono::milliseconds(1000);
+
+// Parse json_doc into root
+bool ParseJsonRoot(const std::string &json_doc, Json::Value *root) {
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    std::string errorMessage;
+    if (!reader->parse(json_doc.data(), json_doc.data() + json_doc.size(), root, &errorMessage)) {
+        LOG(ERROR) << "Failed to parse JSON config: " << errorMessage;
+        return false;
+    }
+    return true;
+}
+
+// Parse the Profiles array of the AdpfConfig section
+bool ParseAdpfProfiles(const Json::Value &profiles, std::vector<AdpfProfile> *profiles_parsed) {
+    if (!profiles.isArray()) {
+        LOG(ERROR) << "Invalid AdpfConfig's Profiles";
+        return false;
+    }
+    profiles_parsed->clear();
+    std::set<std::string> names;
+    for (Json::Value::ArrayIndex i = 0; i < profiles.size(); ++i) {
+        const Json::Value &profile = profiles[i];
+        if (!profile.isObject()) {
+            LOG(ERROR) << "Invalid Profile[" << i << "]";
+            return false;
+        }
+        // Profiles inherit the tunables they leave out from the default one
+        AdpfProfile parsed = profiles_parsed->empty() ? AdpfProfile() : profiles_parsed->front();
+        parsed.uids.clear();
+        parsed.modes.clear();
+        parsed.name = profile["Name"].isString() ? profile["Name"].asString() : "";
+        if (parsed.name.empty() || !names.insert(parsed.name).second) {
+            LOG(ERROR) << "Missing or duplicate Profile[" << i << "]'s Name";
+            return false;
+        }
+        for (const std::string &key : profile.getMemberNames()) {
+            const Json::Value &value = profile[key];
+            if (key == "Name") {
+                continue;
+            } else if (key == "Controller") {
+                parsed.controller = value.isString() ? value.asString() : "";
+                if (!SessionController::Create(parsed.controller, parsed.controller_config)) {
+                    LOG(ERROR) << "Invalid Profile[" << i << "]'s Controller";
+                    return false;
+                }
+            } else if (key == "StaleTimeFactor") {
+                if (!value.isUInt() || value.asUInt() == 0) {
+                    LOG(ERROR) << "Failed to read Profile[" << i << "]'s StaleTimeFactor";
+                    return false;
+                }
+                parsed.stale_time_factor = value.asUInt();
+            } else if ((key == "Uids" || key == "Modes") && !value.isArray()) {
+                LOG(ERROR) << "Failed to read Profile[" << i << "]'s " << key;
+                return false;
+            } else if (key == "Uids") {
+                for (Json::Value::ArrayIndex j = 0; j < value.size(); ++j) {
+                    if (!value[j].isInt()) {
+                        LOG(ERROR) << "Failed to read Profile[" << i << "]'s Uids[" << j << "]";
+                        return false;
+                    }
+                    parsed.uids.push_back(value[j].asInt());
+                }
+            } else if (key == "Modes") {
+                for (Json::Value::ArrayIndex j = 0; j < value.size(); ++j) {
+                    if (!value[j].isString() || value[j].asString().empty()) {
+                        LOG(ERROR) << "Failed to read Profile[" << i << "]'s Modes[" << j << "]";
+                        return false;
+                    }
+                    parsed.modes.push_back(value[j].asString());
+                }
+            } else if (!value.isNumeric() ||
+                       !SetControllerTunable(key, value.asDouble(), &parsed.controller_config)) {
+                LOG(ERROR) << "Invalid Profile[" << i << "]'s " << key;
+                return false;
+            }
+        }
+        LOG(VERBOSE) << "Profile[" << i << "]: " << parsed.name << ", " << parsed.uids.size()
+                     << " uids, " << parsed.modes.size() << " modes";
+        profiles_parsed->push_back(std::move(parsed));
+    }
+    if (profiles_parsed->empty()) {
+        LOG(ERROR) << "Empty AdpfConfig's Profiles";
+        return false;
+    }
+    LOG(INFO) << profiles_parsed->size() << " ADPF profiles parsed successfully";
+    return true;
+}
+
+// Check the hints AdpfConfig refers to are in actions
+bool ValidateAdpfConfig(const AdpfConfig &config,
+                        const std::unordered_map<std::string, Hint> &actions) {
+    if (!config.escalation.hint.empty() &&
+        actions.find(config.escalation.hint) == actions.end()) {
+        LOG(ERROR) << "Escalation's Hint " << config.escalation.hint
+                   << " is not defined in Actions section";
+        return false;
+    }
+    return true;
+}
 }  // namespace
 
-bool HintManager::ValidateHint(const std::string& hint_type) const {
-    if (nm_.get() == nullptr) {
+HintManager::HintManager(sp<NodeLooperThread> nm,
+                         const std::unordered_map<std::string, Hint> &actions)
+    : owned_config_(MakeConfig(std::move(nm), actions)),
+      config_release_(std::make_shared<ConfigRelease>()),
+      config_(Publish(owned_config_, config_release_)) {}
+
+HintManager::~HintManager() {
+    std::shared_ptr<HintConfig> config = LoadConfig();
+    if (config->nm.get() != nullptr) config->nm->Stop();
+}
+
+std::shared_ptr<HintManager::HintConfig> HintManager::MakeConfig(
+        sp<NodeLooperThread> nm, const std::unordered_map<std::string, Hint> &actions,
+        std::shared_ptr<const AdpfConfig> adpf, std::shared_ptr<const BoostPolicy> boost_policy) {
+    auto config = std::make_shared<HintConfig>();
+    config->nm = std::move(nm);
+    config->actions = actions;
+    config->adpf = std::move(adpf);
+    config->boost_policy = std::move(boost_policy);
+    for (auto &a : config->actions) {
+        a.second.id = HintIdRegistry::Intern(a.first);
+        if (a.second.id >= config->hints.size()) {
+            config->hints.resize(a.second.id + 1, nullptr);
+        }
+        config->hints[a.second.id] = &a;
+        // Register node actions so DoHint/EndHint can queue them lock-free
+        if (config->nm.get() != nullptr &&
+            !config->nm->RegisterActions(a.second.node_actions, &a.second.actions_id)) {
+            LOG(ERROR) << "Failed to register actions of " << a.first;
+        }
+        if (config->nm.get() != nullptr) {
+            a.second.level = config->nm->GetActionsLevel(a.second.node_actions);
+        }
+    }
+    return config;
+}
+
+std::shared_ptr<HintManager::HintConfig> HintManager::Publish(
+        std::shared_ptr<HintConfig> config, std::shared_ptr<ConfigRelease> release) {
+    HintConfig *published = config.get();
+    // The deleter keeps config alive, only the published reference goes away
+    return std::shared_ptr<HintConfig>(
+            published, [config = std::move(config), release = std::move(release)](HintConfig *) {
+                std::lock_guard<std::mutex> lock(release->mutex);
+                release->released = true;
+                release->cond.notify_all();
+            });
+}
+
+std::shared_ptr<HintManager::HintConfig> HintManager::LoadConfig() const {
+    return std::atomic_load(&config_);
+}
+
+bool HintManager::ValidateHint(const HintConfig &config, const std::string &hint_type) const {
+    if (config.nm.get() == nullptr) {
         LOG(ERROR) << "NodeLooperThread not present";
         return false;
     }
-    return IsHintSupported(hint_type);
+    if (config.actions.find(hint_type) == config.actions.end()) {
+        LOG(INFO) << "Hint type not present in actions: " << hint_type;
+        return false;
+    }
+    return true;
+}
+
+HintManager::HintEntry *HintManager::GetHintEntry(const HintConfig &config,
+                                                  HintId hint_id) const {
+    if (config.nm.get() == nullptr) {
+        LOG(ERROR) << "NodeLooperThread not present";
+        return nullptr;
+    }
+    if (hint_id >= config.hints.size() || config.hints[hint_id] == nullptr) {
+        LOG(INFO) << "Hint id not present in actions: " << hint_id;
+        return nullptr;
+    }
+    return config.hints[hint_id];
+}
+
+bool HintManager::GetHintId(const std::string &hint_type, HintId *hint_id) const {
+    std::shared_ptr<HintConfig> config = LoadConfig();
+    auto it = config->actions.find(hint_type);
+    if (it == config->actions.end()) {
+        return false;
+    }
+    *hint_id = it->second.id;
+    return true;
 }
 
 bool HintManager::IsHintSupported(const std::string& hint_type) const {
-    if (actions_.find(hint_type) == actions_.end()) {
+    std::shared_ptr<HintConfig> config = LoadConfig();
+    if (config->actions.find(hint_type) == config->actions.end()) {
         LOG(INFO) << "Hint type not present in actions: " << hint_type;
         return false;
     }
     return true;
 }
 
+bool HintManager::IsHintSupported(HintId hint_id) const {
+    std::shared_ptr<HintConfig> config = LoadConfig();
+    return hint_id < config->hints.size() && config->hints[hint_id] != nullptr;
+}
+
+bool HintManager::GetHintInfo(HintId hint_id, std::chrono::milliseconds *timeout,
+                              double *level) const {
+    std::shared_ptr<HintConfig> config = LoadConfig();
+    if (config->nm.get() == nullptr || hint_id >= config->hints.size() ||
+        config->hints[hint_id] == nullptr) {
+        return false;
+    }
+    const Hint &hint = config->hints[hint_id]->second;
+    *timeout = hint.status ? hint.status->max_timeout : kMilliSecondZero;
+    *level = hint.level;
+    return true;
+}
+
+bool HintManager::GetHintEndTime(HintId hint_id, std::chrono::steady_clock::time_point *end_time,
+                                 bool *enabled) const {
+    std::shared_ptr<HintConfig> config = LoadConfig();
+    if (config->nm.get() == nullptr || hint_id >= config->hints.size() ||
+        config->hints[hint_id] == nullptr || !config->hints[hint_id]->second.status) {
+        return false;
+    }
+    const Hint &hint = config->hints[hint_id]->second;
+    {
+        std::lock_guard<std::mutex> lock(hint.status->mutex);
+        *end_time = hint.status->end_time;
+    }
+    *enabled = hint.enabled;
+    return true;
+}
+
 bool HintManager::IsHintEnabled(const std::string &hint_type) const {
-    return actions_.at(hint_type).enabled;
+    return LoadConfig()->actions.at(hint_type).enabled;
 }
 
 bool HintManager::InitHintStatus(const std::unique_ptr<HintManager> &hm) {
     if (hm.get() == nullptr) {
         return false;
     }
-    for (auto &a : hm->actions_) {
+    InitHintStatus(hm->LoadConfig().get());
+    return true;
+}
+
+void HintManager::InitHintStatus(HintConfig *config) {
+    for (auto &a : config->actions) {
         // timeout_ms equaling kMilliSecondZero means forever until cancelling.
         // As a result, if there's one NodeAction has timeout_ms of 0, we will store
         // 0 instead of max. Also node actions could be empty, set to 0 in that case.
@@ -81,56 +307,68 @@ bool HintManager::InitHintStatus(const std::unique_ptr<HintManager> &hm) {
         }
         a.second.status.reset(new HintStatus(timeout));
     }
-    return true;
+    RegisterApplyStats(*config);
+}
+
+void HintManager::RegisterApplyStats(const HintConfig &config) {
+    if (config.nm.get() == nullptr) {
+        return;
+    }
+    for (const auto &a : config.actions) {
+        const std::shared_ptr<HintStatus> &status = a.second.status;
+        config.nm->SetHintStats(a.second.id,
+                                std::shared_ptr<HintApplyStats>(status, &status->apply_stats));
+    }
 }
 
-void HintManager::DoHintStatus(const std::string &hint_type, std::chrono::milliseconds timeout_ms) {
-    std::lock_guard<std::mutex> lock(actions_.at(hint_type).status->mutex);
-    actions_.at(hint_type).status->stats.count.fetch_add(1);
+void HintManager::DoHintStatus(HintEntry *entry, std::chrono::milliseconds timeout_ms) {
+    HintStatus &status = *entry->second.status;
+    std::lock_guard<std::mutex> lock(status.mutex);
+    status.stats.count.fetch_add(1);
     auto now = std::chrono::steady_clock::now();
-    ATRACE_INT(hint_type.c_str(), (timeout_ms == kMilliSecondZero) ? std::numeric_limits<int>::max()
-                                                                   : timeout_ms.count());
-    if (now > actions_.at(hint_type).status->end_time) {
-        actions_.at(hint_type).status->stats.duration_ms.fetch_add(
-                std::chrono::duration_cast<std::chrono::milliseconds>(
-                        actions_.at(hint_type).status->end_time -
-                        actions_.at(hint_type).status->start_time)
+    ATRACE_INT(entry->first.c_str(), (timeout_ms == kMilliSecondZero)
+                                             ? std::numeric_limits<int>::max()
+                                             : timeout_ms.count());
+    if (now > status.end_time) {
+        status.stats.duration_ms.fetch_add(
+                std::chrono::duration_cast<std::chrono::milliseconds>(status.end_time -
+                                                                      status.start_time)
                         .count());
-        actions_.at(hint_type).status->start_time = now;
+        status.start_time = now;
     }
-    actions_.at(hint_type).status->end_time =
-            (timeout_ms == kMilliSecondZero) ? kTimePointMax : now + timeout_ms;
+    status.end_time = (timeout_ms == kMilliSecondZero) ? kTimePointMax : now + timeout_ms;
 }
 
-void HintManager::EndHintStatus(const std::string &hint_type) {
-    std::lock_guard<std::mutex> lock(actions_.at(hint_type).status->mutex);
+void HintManager::EndHintStatus(HintEntry *entry) {
+    HintStatus &status = *entry->second.status;
+    std::lock_guard<std::mutex> lock(status.mutex);
     // Update HintStats if the hint ends earlier than expected end_time
     auto now = std::chrono::steady_clock::now();
-    ATRACE_INT(hint_type.c_str(), 0);
-    if (now < actions_.at(hint_type).status->end_time) {
-        actions_.at(hint_type).status->stats.duration_ms.fetch_add(
-                std::chrono::duration_cast<std::chrono::milliseconds>(
-                        now - actions_.at(hint_type).status->start_time)
+    ATRACE_INT(entry->first.c_str(), 0);
+    if (now < status.end_time) {
+        status.stats.duration_ms.fetch_add(
+                std::chrono::duration_cast<std::chrono::milliseconds>(now - status.start_time)
                         .count());
-        actions_.at(hint_type).status->end_time = now;
+        status.end_time = now;
     }
 }
 
-void HintManager::DoHintAction(const std::string &hint_type) {
-    for (auto &action : actions_.at(hint_type).hint_actions) {
+void HintManager::DoHintAction(const HintConfig &config, HintEntry *entry) {
+    for (auto &action : entry->second.hint_actions) {
         switch (action.type) {
             case HintActionType::DoHint:
                 // TODO: add parse logic to prevent circular hints.
-                DoHint(action.value);
+                DoHint(config, action.value_id, QueuedRequest::kNoOverride);
                 break;
             case HintActionType::EndHint:
-                EndHint(action.value);
+                EndHint(config, action.value_id);
                 break;
             case HintActionType::MaskHint:
-                if (actions_.find(action.value) == actions_.end()) {
+                if (action.value_id >= config.hints.size() ||
+                    config.hints[action.value_id] == nullptr) {
                     LOG(ERROR) << "Failed to find " << action.value << " action";
                 } else {
-                    actions_.at(action.value).enabled = false;
+                    config.hints[action.value_id]->second.enabled = false;
                 }
                 break;
             default:
@@ -142,62 +380,113 @@ void HintManager::DoHintAction(const std::string &hint_type) {
     }
 }
 
-void HintManager::EndHintAction(const std::string &hint_type) {
-    for (auto &action : actions_.at(hint_type).hint_actions) {
-        if (action.type == HintActionType::MaskHint &&
-            actions_.find(action.value) != actions_.end()) {
-            actions_.at(action.value).enabled = true;
+void HintManager::EndHintAction(const HintConfig &config, HintEntry *entry) {
+    for (auto &action : entry->second.hint_actions) {
+        if (action.type == HintActionType::MaskHint && action.value_id < config.hints.size() &&
+            config.hints[action.value_id] != nullptr) {
+            config.hints[action.value_id]->second.enabled = true;
         }
     }
 }
 
 bool HintManager::DoHint(const std::string& hint_type) {
     LOG(VERBOSE) << "Do Powerhint: " << hint_type;
-    if (!ValidateHint(hint_type) || !IsHintEnabled(hint_type) ||
-        !nm_->Request(actions_.at(hint_type).node_actions, hint_type)) {
+    std::shared_ptr<HintConfig> config = LoadConfig();
+    if (!ValidateHint(*config, hint_type)) {
         return false;
     }
-    DoHintStatus(hint_type, actions_.at(hint_type).status->max_timeout);
-    DoHintAction(hint_type);
-    return true;
+    return DoHint(*config, config->actions.at(hint_type).id, QueuedRequest::kNoOverride);
 }
 
 bool HintManager::DoHint(const std::string& hint_type,
                          std::chrono::milliseconds timeout_ms_override) {
     LOG(VERBOSE) << "Do Powerhint: " << hint_type << " for "
                  << timeout_ms_override.count() << "ms";
-    if (!ValidateHint(hint_type) || !IsHintEnabled(hint_type)) {
+    std::shared_ptr<HintConfig> config = LoadConfig();
+    if (!ValidateHint(*config, hint_type)) {
         return false;
     }
-    std::vector<NodeAction> actions_override = actions_.at(hint_type).node_actions;
-    for (auto& action : actions_override) {
-        action.timeout_ms = timeout_ms_override;
+    return DoHint(*config, config->actions.at(hint_type).id, timeout_ms_override);
+}
+
+bool HintManager::EndHint(const std::string& hint_type) {
+    LOG(VERBOSE) << "End Powerhint: " << hint_type;
+    std::shared_ptr<HintConfig> config = LoadConfig();
+    if (!ValidateHint(*config, hint_type)) {
+        return false;
     }
-    if (!nm_->Request(actions_override, hint_type)) {
+    return EndHint(*config, config->actions.at(hint_type).id);
+}
+
+bool HintManager::DoHint(HintId hint_id) {
+    return DoHint(*LoadConfig(), hint_id, QueuedRequest::kNoOverride);
+}
+
+bool HintManager::DoHint(HintId hint_id, std::chrono::milliseconds timeout_ms_override) {
+    return DoHint(*LoadConfig(), hint_id, timeout_ms_override);
+}
+
+bool HintManager::EndHint(HintId hint_id) {
+    return EndHint(*LoadConfig(), hint_id);
+}
+
+bool HintManager::DoHint(const HintConfig &config, HintId hint_id,
+                         std::chrono::milliseconds timeout_ms_override) {
+    auto start = std::chrono::steady_clock::now();
+    HintEntry *entry = GetHintEntry(config, hint_id);
+    if (entry == nullptr || !entry->second.enabled ||
+        !SubmitRequest(config, entry, timeout_ms_override)) {
         return false;
     }
-    DoHintStatus(hint_type, timeout_ms_override);
-    DoHintAction(hint_type);
+    DoHintStatus(entry, timeout_ms_override == QueuedRequest::kNoOverride
+                                ? entry->second.status->max_timeout
+                                : timeout_ms_override);
+    DoHintAction(config, entry);
+    do_hint_latency_.Record(std::chrono::steady_clock::now() - start);
     return true;
 }
 
-bool HintManager::EndHint(const std::string& hint_type) {
-    LOG(VERBOSE) << "End Powerhint: " << hint_type;
-    if (!ValidateHint(hint_type) || !nm_->Cancel(actions_.at(hint_type).node_actions, hint_type)) {
+bool HintManager::SubmitRequest(const HintConfig &config, HintEntry *entry,
+                                std::chrono::milliseconds timeout_override) {
+    const Hint &hint = entry->second;
+    if (hint.actions_id != Hint::kNoActionsId) {
+        return config.nm->SubmitRequest(hint.actions_id, hint.id, timeout_override);
+    }
+    // Actions not registered, request through the locked path
+    if (timeout_override == QueuedRequest::kNoOverride) {
+        return config.nm->Request(hint.node_actions, hint.id);
+    }
+    std::vector<NodeAction> actions_override = hint.node_actions;
+    for (auto& action : actions_override) {
+        action.timeout_ms = timeout_override;
+    }
+    return config.nm->Request(actions_override, hint.id);
+}
+
+bool HintManager::EndHint(const HintConfig &config, HintId hint_id) {
+    HintEntry *entry = GetHintEntry(config, hint_id);
+    if (entry == nullptr) {
         return false;
     }
-    EndHintStatus(hint_type);
-    EndHintAction(hint_type);
+    const Hint &hint = entry->second;
+    if (!(hint.actions_id != Hint::kNoActionsId
+                  ? config.nm->SubmitCancel(hint.actions_id, hint_id)
+                  : config.nm->Cancel(hint.node_actions, hint_id))) {
+        return false;
+    }
+    EndHintStatus(entry);
+    EndHintAction(config, entry);
     return true;
 }
 
 bool HintManager::IsRunning() const {
-    return (nm_.get() == nullptr) ? false : nm_->isRunning();
+    std::shared_ptr<HintConfig> config = LoadConfig();
+    return (config->nm.get() == nullptr) ? false : config->nm->isRunning();
 }
 
 std::vector<std::string> HintManager::GetHints() const {
     std::vector<std::string> hints;
-    for (auto const& action : actions_) {
+    for (auto const& action : LoadConfig()->actions) {
         hints.push_back(action.first);
     }
     return hints;
@@ -205,16 +494,40 @@ std::vector<std::string> HintManager::GetHints() const {
 
 HintStats HintManager::GetHintStats(const std::string &hint_type) const {
     HintStats hint_stats;
-    if (ValidateHint(hint_type)) {
-        hint_stats.count =
-                actions_.at(hint_type).status->stats.count.load(std::memory_order_relaxed);
-        hint_stats.duration_ms =
-                actions_.at(hint_type).status->stats.duration_ms.load(std::memory_order_relaxed);
+    std::shared_ptr<HintConfig> config = LoadConfig();
+    if (ValidateHint(*config, hint_type)) {
+        const HintStatus &status = *config->actions.at(hint_type).status;
+        hint_stats.count = status.stats.count.load(std::memory_order_relaxed);
+        hint_stats.duration_ms = status.stats.duration_ms.load(std::memory_order_relaxed);
+        hint_stats.apply_latency = status.apply_stats.apply_latency.Summary();
+        hint_stats.write_latency = status.apply_stats.write_latency.Summary();
+        hint_stats.shadowed = status.apply_stats.shadowed.load(std::memory_order_relaxed);
     }
     return hint_stats;
 }
 
+std::map<std::string, HintStats> HintManager::GetAllHintStats() const {
+    std::map<std::string, HintStats> all_stats;
+    for (const auto &hint : GetHints()) {
+        all_stats.emplace(hint, GetHintStats(hint));
+    }
+    return all_stats;
+}
+
+std::shared_ptr<const AdpfConfig> HintManager::GetAdpfConfig() const {
+    return LoadConfig()->adpf;
+}
+
+std::shared_ptr<const BoostPolicy> HintManager::GetBoostPolicy() const {
+    return LoadConfig()->boost_policy;
+}
+
+const LatencyHistogram &HintManager::GetDoHintLatency() const {
+    return do_hint_latency_;
+}
+
 void HintManager::DumpToFd(int fd) {
+    std::shared_ptr<HintConfig> config = LoadConfig();
     std::string header(
         "========== Begin perfmgr nodes ==========\n"
         "Node Name\t"
@@ -224,7 +537,7 @@ void HintManager::DumpToFd(int fd) {
     if (!android::base::WriteStringToFd(header, fd)) {
         LOG(ERROR) << "Failed to dump fd: " << fd;
     }
-    nm_->DumpToFd(fd);
+    config->nm->DumpToFd(fd);
     std::string footer("==========  End perfmgr nodes  ==========\n");
     if (!android::base::WriteStringToFd(footer, fd)) {
         LOG(ERROR) << "Failed to dump fd: " << fd;
@@ -237,13 +550,17 @@ void HintManager::DumpToFd(int fd) {
         LOG(ERROR) << "Failed to dump fd: " << fd;
     }
     std::string hint_stats_string;
-    std::vector<std::string> keys(GetHints());
-    std::sort(keys.begin(), keys.end());
-    for (const auto &ordered_key : keys) {
-        HintStats hint_stats(GetHintStats(ordered_key));
+    std::string hint_effect_string;
+    for (const auto &[hint, hint_stats] : GetAllHintStats()) {
         hint_stats_string +=
-                android::base::StringPrintf("%s\t%" PRIu32 "\t%" PRIu64 "\n", ordered_key.c_str(),
+                android::base::StringPrintf("%s\t%" PRIu32 "\t%" PRIu64 "\n", hint.c_str(),
                                             hint_stats.count, hint_stats.duration_ms);
+        hint_effect_string += android::base::StringPrintf(
+                "%s\t%" PRIu64 "\t%.1f\t%.1f\t%.1f\t%.1f\t%" PRIu64 "\n", hint.c_str(),
+                hint_stats.apply_latency.count, hint_stats.apply_latency.p50.count() / 1000.0,
+                hint_stats.apply_latency.p99.count() / 1000.0,
+                hint_stats.write_latency.p50.count() / 1000.0,
+                hint_stats.write_latency.p99.count() / 1000.0, hint_stats.shadowed);
     }
     if (!android::base::WriteStringToFd(hint_stats_string, fd)) {
         LOG(ERROR) << "Failed to dump fd: " << fd;
@@ -252,42 +569,122 @@ void HintManager::DumpToFd(int fd) {
     if (!android::base::WriteStringToFd(footer, fd)) {
         LOG(ERROR) << "Failed to dump fd: " << fd;
     }
+    std::string latency_string = android::base::StringPrintf(
+            "========== Begin perfmgr latency ==========\n"
+            "Call\tCounts\tP50(us)\tP99(us)\n"
+            "DoHint\t%" PRIu64 "\t%.1f\t%.1f\n"
+            "==========  End perfmgr latency  ==========\n",
+            do_hint_latency_.Count(), do_hint_latency_.Percentile(50).count() / 1000.0,
+            do_hint_latency_.Percentile(99).count() / 1000.0);
+    if (!android::base::WriteStringToFd(latency_string, fd)) {
+        LOG(ERROR) << "Failed to dump fd: " << fd;
+    }
+    header = "========== Begin perfmgr hint effect ==========\n"
+             "Hint Name\t"
+             "Applied\t"
+             "Apply P50(us)\t"
+             "Apply P99(us)\t"
+             "Write P50(us)\t"
+             "Write P99(us)\t"
+             "Shadowed\n";
+    footer = "==========  End perfmgr hint effect  ==========\n";
+    if (!android::base::WriteStringToFd(header + hint_effect_string + footer, fd)) {
+        LOG(ERROR) << "Failed to dump fd: " << fd;
+    }
     fsync(fd);
 }
 
 bool HintManager::Start() {
-    return nm_->Start();
+    return LoadConfig()->nm->Start();
 }
 
-std::unique_ptr<HintManager> HintManager::GetFromJSON(
-    const std::string& config_path, bool start) {
+bool HintManager::LoadConfigFile(const std::string &config_path,
+                                 std::vector<std::unique_ptr<Node>> *nodes,
+                                 std::unordered_map<std::string, Hint> *actions,
+                                 std::shared_ptr<const AdpfConfig> *adpf,
+                                 std::shared_ptr<const BoostPolicy> *boost_policy) {
     std::string json_doc;
 
+    auto load_start = std::chrono::steady_clock::now();
     if (!android::base::ReadFileToString(config_path, &json_doc)) {
         LOG(ERROR) << "Failed to read JSON config from " << config_path;
-        return nullptr;
+        return false;
     }
 
-    std::vector<std::unique_ptr<Node>> nodes = ParseNodes(json_doc);
-    if (nodes.empty()) {
-        LOG(ERROR) << "Failed to parse Nodes section from " << config_path;
-        return nullptr;
+    // Precompiled image skips JSON parsing on the boot path
+    const std::string image_path = ConfigImage::GetImagePath(config_path);
+    auto adpf_config = std::make_shared<AdpfConfig>();
+    auto policy = std::make_shared<BoostPolicy>();
+    const bool from_image = ConfigImage::Load(image_path, json_doc, nodes, actions,
+                                              adpf_config.get(), policy.get());
+    if (!from_image) {
+        Json::Value root;
+        if (!ParseJsonRoot(json_doc, &root)) {
+            LOG(ERROR) << "Failed to parse JSON config from " << config_path;
+            return false;
+        }
+        *nodes = ParseNodes(root);
+        if (nodes->empty()) {
+            LOG(ERROR) << "Failed to parse Nodes section from " << config_path;
+            return false;
+        }
+        *actions = HintManager::ParseActions(root, *nodes);
+        if (!actions->empty() && !ParseAdpfConfig(root, adpf_config.get())) {
+            LOG(ERROR) << "Failed to parse AdpfConfig section from " << config_path;
+            return false;
+        }
+        if (!actions->empty() && !ParseBoostPolicy(root, policy.get())) {
+            LOG(ERROR) << "Failed to parse BoostArbiter section from " << config_path;
+            return false;
+        }
     }
-    std::unordered_map<std::string, Hint> actions = HintManager::ParseActions(json_doc, nodes);
 
-    if (actions.empty()) {
+    if (actions->empty()) {
         LOG(ERROR) << "Failed to parse Actions section from " << config_path;
+        return false;
+    }
+    if (!ValidateAdpfConfig(*adpf_config, *actions)) {
+        LOG(ERROR) << "Failed to parse AdpfConfig section from " << config_path;
+        return false;
+    }
+    if (!adpf_config->escalation.hint.empty()) {
+        adpf_config->escalation.hint_id = HintIdRegistry::Intern(adpf_config->escalation.hint);
+    }
+    *adpf = std::move(adpf_config);
+    *boost_policy = std::move(policy);
+    LOG(INFO) << "Loaded config from " << (from_image ? image_path : config_path) << " in "
+              << std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now() - load_start)
+                         .count()
+              << "us";
+    return true;
+}
+
+std::unique_ptr<HintManager> HintManager::GetFromJSON(
+    const std::string& config_path, bool start) {
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::unordered_map<std::string, Hint> actions;
+    std::shared_ptr<const AdpfConfig> adpf;
+    std::shared_ptr<const BoostPolicy> boost_policy;
+    if (!LoadConfigFile(config_path, &nodes, &actions, &adpf, &boost_policy)) {
         return nullptr;
     }
 
-    sp<NodeLooperThread> nm = new NodeLooperThread(std::move(nodes));
+    sp<NodeLooperThread> nm = new NodeLooperThread(
+            std::move(nodes), android::base::GetBoolProperty(kFullUpdateProperty, false));
     std::unique_ptr<HintManager> hm =
         std::make_unique<HintManager>(std::move(nm), actions);
+    hm->config_->adpf = std::move(adpf);
+    hm->config_->boost_policy = std::move(boost_policy);
 
     if (!HintManager::InitHintStatus(hm)) {
         LOG(ERROR) << "Failed to initialize hint status";
         return nullptr;
     }
+    {
+        std::lock_guard<std::mutex> lock(hm->path_mutex_);
+        hm->config_path_ = config_path;
+    }
 
     LOG(INFO) << "Initialized HintManager from JSON config: " << config_path;
 
@@ -297,23 +694,145 @@ std::unique_ptr<HintManager> HintManager::GetFromJSON(
     return hm;
 }
 
+bool HintManager::Reload(const std::string &config_path) {
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    auto reload_start = std::chrono::steady_clock::now();
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::unordered_map<std::string, Hint> actions;
+    std::shared_ptr<const AdpfConfig> adpf;
+    std::shared_ptr<const BoostPolicy> boost_policy;
+    if (!LoadConfigFile(config_path, &nodes, &actions, &adpf, &boost_policy)) {
+        LOG(ERROR) << "Keep current config, failed to reload " << config_path;
+        return false;
+    }
+
+    sp<NodeLooperThread> nm = new NodeLooperThread(
+            std::move(nodes), android::base::GetBoolProperty(kFullUpdateProperty, false));
+    std::shared_ptr<HintConfig> config =
+            MakeConfig(nm, actions, std::move(adpf), std::move(boost_policy));
+    InitHintStatus(config.get());
+
+    std::shared_ptr<HintConfig> old_config = owned_config_;
+    std::shared_ptr<ConfigRelease> old_release = config_release_;
+    for (auto &a : config->actions) {
+        auto it = old_config->actions.find(a.first);
+        if (it == old_config->actions.end()) {
+            continue;
+        }
+        a.second.enabled = it->second.enabled;
+        if (it->second.status->max_timeout == a.second.status->max_timeout) {
+            a.second.status = it->second.status;
+        }
+    }
+    RegisterApplyStats(*config);
+    const bool running = old_config->nm.get() != nullptr && old_config->nm->isRunning();
+
+    // New calls queue on the new looper, which is not started yet
+    std::shared_ptr<ConfigRelease> release = std::make_shared<ConfigRelease>();
+    std::atomic_store(&config_, Publish(config, release));
+    // Wait for calls still holding the old config, a request reaching the old
+    // looper after its requests were migrated would be lost. Calls only hold
+    // the config for their own duration.
+    bool released;
+    {
+        std::unique_lock<std::mutex> lock(old_release->mutex);
+        released = old_release->cond.wait_for(lock, kReloadDrainTimeout,
+                                              [&old_release] { return old_release->released; });
+    }
+    if (!released) {
+        // The old looper is still running, go back to it
+        config_release_ = std::make_shared<ConfigRelease>();
+        std::atomic_store(&config_, Publish(old_config, config_release_));
+        LOG(ERROR) << "Keep current config, calls on it did not finish in "
+                   << kReloadDrainTimeout.count() << "ms, failed to reload " << config_path;
+        return false;
+    }
+    owned_config_ = config;
+    config_release_ = release;
+    if (old_config->nm.get() != nullptr) {
+        old_config->nm->Stop();
+        nm->MigrateFrom(old_config->nm);
+    }
+    if (running) {
+        nm->Start();
+    }
+    {
+        std::lock_guard<std::mutex> lock(path_mutex_);
+        config_path_ = config_path;
+    }
+    LOG(INFO) << "Reloaded config " << config_path << " in "
+              << std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now() - reload_start)
+                         .count()
+              << "us";
+    return true;
+}
+
+std::string HintManager::GetConfigPath() const {
+    std::lock_guard<std::mutex> lock(path_mutex_);
+    return config_path_;
+}
+
+bool HintManager::CompileConfig(const std::string &config_path, const std::string &image_path) {
+    std::string json_doc;
+
+    if (!android::base::ReadFileToString(config_path, &json_doc)) {
+        LOG(ERROR) << "Failed to read JSON config from " << config_path;
+        return false;
+    }
+    Json::Value root;
+    if (!ParseJsonRoot(json_doc, &root)) {
+        LOG(ERROR) << "Failed to parse JSON config from " << config_path;
+        return false;
+    }
+
+    std::vector<std::unique_ptr<Node>> nodes = ParseNodes(root);
+    if (nodes.empty()) {
+        LOG(ERROR) << "Failed to parse Nodes section from " << config_path;
+        return false;
+    }
+    std::unordered_map<std::string, Hint> actions = HintManager::ParseActions(root, nodes);
+    if (actions.empty()) {
+        LOG(ERROR) << "Failed to parse Actions section from " << config_path;
+        return false;
+    }
+    AdpfConfig adpf;
+    if (!ParseAdpfConfig(root, &adpf) || !ValidateAdpfConfig(adpf, actions)) {
+        LOG(ERROR) << "Failed to parse AdpfConfig section from " << config_path;
+        return false;
+    }
+    BoostPolicy boost_policy;
+    if (!ParseBoostPolicy(root, &boost_policy)) {
+        LOG(ERROR) << "Failed to parse BoostArbiter section from " << config_path;
+        return false;
+    }
+
+    // Node type is not kept by Node, read it again from the verified config
+    const Json::Value &json_nodes = root["Nodes"];
+    std::vector<bool> is_file;
+    for (Json::Value::ArrayIndex i = 0; i < json_nodes.size(); ++i) {
+        is_file.emplace_back(json_nodes[i]["Type"].asString() != "Property");
+    }
+
+    return ConfigImage::Write(image_path, json_doc, nodes, is_file, actions, adpf, boost_policy);
+}
+
 std::vector<std::unique_ptr<Node>> HintManager::ParseNodes(
     const std::string& json_doc) {
+    Json::Value root;
+    if (!ParseJsonRoot(json_doc, &root)) {
+        return {};
+    }
+    return ParseNodes(root);
+}
+
+std::vector<std::unique_ptr<Node>> HintManager::ParseNodes(const Json::Value &root) {
     // function starts
     std::vector<std::unique_ptr<Node>> nodes_parsed;
     std::set<std::string> nodes_name_parsed;
     std::set<std::string> nodes_path_parsed;
-    Json::Value root;
-    Json::CharReaderBuilder builder;
-    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
-    std::string errorMessage;
-
-    if (!reader->parse(&*json_doc.begin(), &*json_doc.end(), &root, &errorMessage)) {
-        LOG(ERROR) << "Failed to parse JSON config: " << errorMessage;
-        return nodes_parsed;
-    }
 
-    Json::Value nodes = root["Nodes"];
+    const Json::Value &nodes = root["Nodes"];
     for (Json::Value::ArrayIndex i = 0; i < nodes.size(); ++i) {
         std::string name = nodes[i]["Name"].asString();
         LOG(VERBOSE) << "Node[" << i << "]'s Name: " << name;
@@ -366,7 +885,7 @@ std::vector<std::unique_ptr<Node>> HintManager::ParseNodes(
 
         std::vector<RequestGroup> values_parsed;
         std::set<std::string> values_set_parsed;
-        Json::Value values = nodes[i]["Values"];
+        const Json::Value &values = nodes[i]["Values"];
         for (Json::Value::ArrayIndex j = 0; j < values.size(); ++j) {
             std::string value = values[j].asString();
             LOG(VERBOSE) << "Node[" << i << "]'s Value[" << j << "]: " << value;
@@ -421,6 +940,30 @@ std::vector<std::unique_ptr<Node>> HintManager::ParseNodes(
         LOG(VERBOSE) << "Node[" << i << "]'s ResetOnInit: " << std::boolalpha
                      << reset << std::noboolalpha;
 
+        std::vector<std::string> depends_on;
+        const Json::Value &depends = nodes[i]["DependsOn"];
+        for (Json::Value::ArrayIndex j = 0; j < depends.size(); ++j) {
+            std::string dep = depends[j].asString();
+            LOG(VERBOSE) << "Node[" << i << "]'s DependsOn[" << j << "]: " << dep;
+            if (dep.empty() || dep == name) {
+                LOG(ERROR) << "Invalid Node[" << i << "]'s DependsOn[" << j << "]";
+                nodes_parsed.clear();
+                return nodes_parsed;
+            }
+            depends_on.emplace_back(dep);
+        }
+
+        std::string write_group;
+        if (!nodes[i]["WriteGroup"].empty()) {
+            if (!nodes[i]["WriteGroup"].isString()) {
+                LOG(ERROR) << "Failed to read Node[" << i << "]'s WriteGroup";
+                nodes_parsed.clear();
+                return nodes_parsed;
+            }
+            write_group = nodes[i]["WriteGroup"].asString();
+        }
+        LOG(VERBOSE) << "Node[" << i << "]'s WriteGroup: " << write_group;
+
         if (is_file) {
             bool hold_fd = false;
             if (nodes[i]["HoldFd"].empty() || !nodes[i]["HoldFd"].isBool()) {
@@ -440,6 +983,32 @@ std::vector<std::unique_ptr<Node>> HintManager::ParseNodes(
                 name, path, values_parsed,
                 static_cast<std::size_t>(default_index), reset));
         }
+        nodes_parsed.back()->SetDependsOn(std::move(depends_on));
+        nodes_parsed.back()->SetWriteGroup(std::move(write_group));
+    }
+
+    // DependsOn may refer to nodes defined later, validate once all parsed
+    std::unordered_map<std::string, const Node *> nodes_by_name;
+    for (const auto &node : nodes_parsed) {
+        nodes_by_name[node->GetName()] = node.get();
+    }
+    for (const auto &node : nodes_parsed) {
+        for (const auto &dep : node->GetDependsOn()) {
+            auto it = nodes_by_name.find(dep);
+            if (it == nodes_by_name.end()) {
+                LOG(ERROR) << "Node " << node->GetName() << "'s DependsOn: [" << dep
+                           << "] is not defined in Nodes section";
+                nodes_parsed.clear();
+                return nodes_parsed;
+            }
+            // Ordering between dependent nodes only holds within a group
+            if (it->second->GetWriteGroup() != node->GetWriteGroup()) {
+                LOG(ERROR) << "Node " << node->GetName() << "'s DependsOn: [" << dep
+                           << "] is not in the same WriteGroup";
+                nodes_parsed.clear();
+                return nodes_parsed;
+            }
+        }
     }
     LOG(INFO) << nodes_parsed.size() << " Nodes parsed successfully";
     return nodes_parsed;
@@ -447,19 +1016,19 @@ std::vector<std::unique_ptr<Node>> HintManager::ParseNodes(
 
 std::unordered_map<std::string, Hint> HintManager::ParseActions(
         const std::string &json_doc, const std::vector<std::unique_ptr<Node>> &nodes) {
-    // function starts
-    std::unordered_map<std::string, Hint> actions_parsed;
     Json::Value root;
-    Json::CharReaderBuilder builder;
-    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
-    std::string errorMessage;
-
-    if (!reader->parse(&*json_doc.begin(), &*json_doc.end(), &root, &errorMessage)) {
-        LOG(ERROR) << "Failed to parse JSON config";
-        return actions_parsed;
+    if (!ParseJsonRoot(json_doc, &root)) {
+        return {};
     }
+    return ParseActions(root, nodes);
+}
 
-    Json::Value actions = root["Actions"];
+std::unordered_map<std::string, Hint> HintManager::ParseActions(
+        const Json::Value &root, const std::vector<std::unique_ptr<Node>> &nodes) {
+    // function starts
+    std::unordered_map<std::string, Hint> actions_parsed;
+
+    const Json::Value &actions = root["Actions"];
     std::size_t total_parsed = 0;
 
     std::map<std::string, std::size_t> nodes_index;
@@ -569,5 +1138,212 @@ std::unordered_map<std::string, Hint> HintManager::ParseActions(
     return actions_parsed;
 }
 
+bool HintManager::ParseAdpfConfig(const std::string &json_doc, AdpfConfig *config) {
+    Json::Value root;
+    if (!ParseJsonRoot(json_doc, &root)) {
+        return false;
+    }
+    return ParseAdpfConfig(root, config);
+}
+
+bool HintManager::ParseAdpfConfig(const Json::Value &root, AdpfConfig *config) {
+    *config = AdpfConfig();
+    const Json::Value &adpf = root["AdpfConfig"];
+    if (adpf.empty()) {
+        return true;
+    }
+    if (!adpf.isObject()) {
+        LOG(ERROR) << "Invalid AdpfConfig section";
+        return false;
+    }
+
+    if (adpf.isMember("Profiles") && !ParseAdpfProfiles(adpf["Profiles"], &config->profiles)) {
+        return false;
+    }
+
+    const Json::Value &rate_switch = adpf["RefreshRateSwitch"];
+    if (!rate_switch.empty()) {
+        RefreshRateSwitchConfig *rs = &config->refresh_rate_switch;
+        const std::string integral = rate_switch["Integral"].asString();
+        if (integral.empty() || integral == "None") {
+            rs->integral = RefreshRateSwitchConfig::IntegralPolicy::NONE;
+        } else if (integral == "Reset") {
+            rs->integral = RefreshRateSwitchConfig::IntegralPolicy::RESET;
+        } else if (integral == "Rescale") {
+            rs->integral = RefreshRateSwitchConfig::IntegralPolicy::RESCALE;
+        } else {
+            LOG(ERROR) << "Invalid RefreshRateSwitch's Integral: " << integral;
+            return false;
+        }
+        if (!rate_switch["ScaleStaleTimeout"].empty()) {
+            if (!rate_switch["ScaleStaleTimeout"].isBool()) {
+                LOG(ERROR) << "Failed to read RefreshRateSwitch's ScaleStaleTimeout";
+                return false;
+            }
+            rs->scale_stale_timeout = rate_switch["ScaleStaleTimeout"].asBool();
+        }
+        if (!rate_switch["PreBoostUclampMin"].empty()) {
+            if (!rate_switch["PreBoostUclampMin"].isUInt() ||
+                rate_switch["PreBoostUclampMin"].asUInt() > 1024) {
+                LOG(ERROR) << "Failed to read RefreshRateSwitch's PreBoostUclampMin";
+                return false;
+            }
+            rs->preboost_uclamp_min = rate_switch["PreBoostUclampMin"].asInt();
+        }
+        if (!rate_switch["PreBoostDuration"].empty()) {
+            if (!rate_switch["PreBoostDuration"].isUInt64()) {
+                LOG(ERROR) << "Failed to read RefreshRateSwitch's PreBoostDuration";
+                return false;
+            }
+            rs->preboost_duration =
+                    std::chrono::milliseconds(rate_switch["PreBoostDuration"].asUInt64());
+        }
+        LOG(VERBOSE) << "RefreshRateSwitch: Integral " << static_cast<int>(rs->integral)
+                     << ", ScaleStaleTimeout " << rs->scale_stale_timeout
+                     << ", PreBoostUclampMin " << rs->preboost_uclamp_min
+                     << ", PreBoostDuration " << rs->preboost_duration.count() << "ms";
+    }
+
+    const Json::Value &escalation = adpf["Escalation"];
+    if (!escalation.empty()) {
+        EscalationConfig *esc = &config->escalation;
+        if (!escalation["Hint"].isString() || escalation["Hint"].asString().empty()) {
+            LOG(ERROR) << "Failed to read Escalation's Hint";
+            return false;
+        }
+        esc->hint = escalation["Hint"].asString();
+        for (const auto &[key, reports] :
+             {std::make_pair("EnterReports", &esc->enter_reports),
+              std::make_pair("ExitReports", &esc->exit_reports)}) {
+            if (escalation[key].empty()) {
+                continue;
+            }
+            if (!escalation[key].isUInt() || escalation[key].asUInt() == 0) {
+                LOG(ERROR) << "Failed to read Escalation's " << key;
+                return false;
+            }
+            *reports = escalation[key].asUInt();
+        }
+        for (const auto &[key, fraction] :
+             {std::make_pair("EnterFraction", &esc->enter_fraction),
+              std::make_pair("ExitFraction", &esc->exit_fraction)}) {
+            if (escalation[key].empty()) {
+                continue;
+            }
+            if (!escalation[key].isNumeric() || escalation[key].asDouble() <= 0 ||
+                escalation[key].asDouble() > 1) {
+                LOG(ERROR) << "Failed to read Escalation's " << key;
+                return false;
+            }
+            *fraction = escalation[key].asDouble();
+        }
+        if (esc->exit_fraction > esc->enter_fraction) {
+            LOG(ERROR) << "Escalation's ExitFraction is over its EnterFraction";
+            return false;
+        }
+        if (!escalation["Duration"].empty()) {
+            if (!escalation["Duration"].isUInt64() || escalation["Duration"].asUInt64() == 0) {
+                LOG(ERROR) << "Failed to read Escalation's Duration";
+                return false;
+            }
+            esc->duration = std::chrono::milliseconds(escalation["Duration"].asUInt64());
+        }
+        LOG(VERBOSE) << "Escalation: Hint " << esc->hint << ", EnterReports "
+                     << esc->enter_reports << ", ExitReports " << esc->exit_reports
+                     << ", EnterFraction " << esc->enter_fraction << ", ExitFraction "
+                     << esc->exit_fraction << ", Duration " << esc->duration.count() << "ms";
+    }
+    return true;
+}
+
+bool HintManager::ParseBoostPolicy(const std::string &json_doc, BoostPolicy *policy) {
+    Json::Value root;
+    if (!ParseJsonRoot(json_doc, &root)) {
+        return false;
+    }
+    return ParseBoostPolicy(root, policy);
+}
+
+bool HintManager::ParseBoostPolicy(const Json::Value &root, BoostPolicy *policy) {
+    *policy = BoostPolicy();
+    const Json::Value &arbiter = root["BoostArbiter"];
+    if (arbiter.empty()) {
+        return true;
+    }
+    if (!arbiter.isObject() || !arbiter["Rules"].isArray()) {
+        LOG(ERROR) << "Invalid BoostArbiter section";
+        return false;
+    }
+    const Json::Value &rules = arbiter["Rules"];
+    for (Json::Value::ArrayIndex i = 0; i < rules.size(); ++i) {
+        const Json::Value &rule = rules[i];
+        BoostRule parsed;
+        for (const auto &[key, ids] : {std::make_pair("WhileModes", &parsed.modes),
+                                       std::make_pair("Hints", &parsed.hints)}) {
+            if (rule[key].empty()) {
+                continue;
+            }
+            if (!rule[key].isArray()) {
+                LOG(ERROR) << "Failed to read BoostArbiter Rule[" << i << "]'s " << key;
+                return false;
+            }
+            for (Json::Value::ArrayIndex j = 0; j < rule[key].size(); ++j) {
+                if (!rule[key][j].isString() || rule[key][j].asString().empty()) {
+                    LOG(ERROR) << "Failed to read BoostArbiter Rule[" << i << "]'s " << key;
+                    return false;
+                }
+                ids->emplace_back(HintIdRegistry::Intern(rule[key][j].asString()));
+            }
+        }
+        if (!rule["Sources"].empty()) {
+            if (!rule["Sources"].isArray()) {
+                LOG(ERROR) << "Failed to read BoostArbiter Rule[" << i << "]'s Sources";
+                return false;
+            }
+            for (Json::Value::ArrayIndex j = 0; j < rule["Sources"].size(); ++j) {
+                BoostSource source;
+                if (!rule["Sources"][j].isString() ||
+                    !ParseBoostSource(rule["Sources"][j].asString(), &source)) {
+                    LOG(ERROR) << "Invalid BoostArbiter Rule[" << i << "]'s Source "
+                               << rule["Sources"][j].toStyledString();
+                    return false;
+                }
+                parsed.sources |= 1u << static_cast<uint32_t>(source);
+            }
+        }
+        if (!rule["MaxPriority"].empty()) {
+            if (!rule["MaxPriority"].isInt()) {
+                LOG(ERROR) << "Failed to read BoostArbiter Rule[" << i << "]'s MaxPriority";
+                return false;
+            }
+            parsed.max_priority = rule["MaxPriority"].asInt();
+        }
+        if (!rule["Drop"].empty()) {
+            if (!rule["Drop"].isBool()) {
+                LOG(ERROR) << "Failed to read BoostArbiter Rule[" << i << "]'s Drop";
+                return false;
+            }
+            parsed.drop = rule["Drop"].asBool();
+        }
+        if (!rule["MaxDuration"].empty()) {
+            if (!rule["MaxDuration"].isUInt64() || rule["MaxDuration"].asUInt64() == 0) {
+                LOG(ERROR) << "Failed to read BoostArbiter Rule[" << i << "]'s MaxDuration";
+                return false;
+            }
+            parsed.max_duration = std::chrono::milliseconds(rule["MaxDuration"].asUInt64());
+        }
+        if (parsed.drop == (parsed.max_duration.count() > 0)) {
+            LOG(ERROR) << "BoostArbiter Rule[" << i << "] needs either Drop or MaxDuration";
+            return false;
+        }
+        LOG(VERBOSE) << "BoostArbiter Rule[" << i << "]: " << parsed.modes.size() << " modes, "
+                     << parsed.hints.size() << " hints, MaxPriority " << parsed.max_priority
+                     << (parsed.drop ? ", Drop" : ", MaxDuration ")
+                     << (parsed.drop ? "" : std::to_string(parsed.max_duration.count()) + "ms");
+        policy->rules.emplace_back(std::move(parsed));
+    }
+    return true;
+}
+
 }  // namespace perfmgr
 }  // namespace android
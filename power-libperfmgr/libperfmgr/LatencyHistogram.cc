@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "libperfmgr"
+
+#include "perfmgr/LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace android {
+namespace perfmgr {
+
+LatencyHistogram::LatencyHistogram() : count_(0) {
+    for (auto &bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::size_t LatencyHistogram::BucketIndex(uint64_t value) {
+    if (value < kSubBuckets) {
+        return value;
+    }
+    // Values in [2^e, 2^(e+1)) are split into kSubBuckets linear buckets
+    int exponent = 63 - __builtin_clzll(value);
+    uint64_t sub = (value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+    return (exponent - kSubBucketBits + 1) * kSubBuckets + sub;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(std::size_t index) {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    int exponent = index / kSubBuckets + kSubBucketBits - 1;
+    uint64_t sub = index % kSubBuckets;
+    uint64_t width = uint64_t{1} << (exponent - kSubBucketBits);
+    return ((kSubBuckets + sub) << (exponent - kSubBucketBits)) + width - 1;
+}
+
+void LatencyHistogram::Record(std::chrono::nanoseconds duration) {
+    uint64_t value = duration.count() > 0 ? static_cast<uint64_t>(duration.count()) : 0;
+    buckets_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::Count() const {
+    return count_.load(std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds LatencyHistogram::Percentile(double percentile) const {
+    uint64_t total = Count();
+    if (total == 0) {
+        return std::chrono::nanoseconds::zero();
+    }
+    auto rank = static_cast<uint64_t>(std::ceil(total * percentile / 100.0));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < kNumBuckets; i++) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::chrono::nanoseconds(BucketUpperBound(i));
+        }
+    }
+    // Buckets updated concurrently with count_, report the largest one seen
+    for (std::size_t i = kNumBuckets; i > 0; i--) {
+        if (buckets_[i - 1].load(std::memory_order_relaxed)) {
+            return std::chrono::nanoseconds(BucketUpperBound(i - 1));
+        }
+    }
+    return std::chrono::nanoseconds::zero();
+}
+
+LatencySummary LatencyHistogram::Summary() const {
+    LatencySummary summary;
+    summary.count = Count();
+    summary.p50 = Percentile(50);
+    summary.p99 = Percentile(99);
+    return summary;
+}
+
+}  // namespace perfmgr
+}  // namespace android
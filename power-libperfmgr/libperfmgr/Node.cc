@@ -36,7 +36,7 @@ Node::Node(std::string name, std::string node_path,
       reset_on_init_(reset_on_init),
       current_val_index_(default_val_index) {}
 
-bool Node::AddRequest(std::size_t value_index, const std::string& hint_type,
+bool Node::AddRequest(std::size_t value_index, HintId hint_id,
                       ReqTime end_time) {
     if (value_index >= req_sorted_.size()) {
         LOG(ERROR) << "Value index out of bound: " << value_index
@@ -44,19 +44,35 @@ bool Node::AddRequest(std::size_t value_index, const std::string& hint_type,
         return false;
     }
     // Add/Update request to the new end_time for the specific hint_type
-    req_sorted_[value_index].AddRequest(hint_type, end_time);
+    req_sorted_[value_index].AddRequest(hint_id, end_time);
     return true;
 }
 
-bool Node::RemoveRequest(const std::string& hint_type) {
+bool Node::AddRequest(std::size_t value_index, const std::string& hint_type,
+                      ReqTime end_time) {
+    HintId hint_id;
+    if (!HintIdRegistry::Find(hint_type, &hint_id)) {
+        LOG(ERROR) << "Unknown hint: " << hint_type;
+        return false;
+    }
+    return AddRequest(value_index, hint_id, end_time);
+}
+
+bool Node::RemoveRequest(HintId hint_id) {
     bool ret = false;
     // Remove all requests for the specific hint_type
     for (auto& value : req_sorted_) {
-        ret = value.RemoveRequest(hint_type) || ret;
+        ret = value.RemoveRequest(hint_id) || ret;
     }
     return ret;
 }
 
+bool Node::RemoveRequest(const std::string& hint_type) {
+    HintId hint_id;
+    // An unknown hint never had a request
+    return HintIdRegistry::Find(hint_type, &hint_id) && RemoveRequest(hint_id);
+}
+
 const std::string& Node::GetName() const {
     return name_;
 }
@@ -81,10 +97,60 @@ std::size_t Node::GetDefaultIndex() const {
     return default_val_index_;
 }
 
+std::size_t Node::GetCurrentIndex() const {
+    return current_val_index_;
+}
+
 bool Node::GetResetOnInit() const {
     return reset_on_init_;
 }
 
+const std::vector<std::string>& Node::GetDependsOn() const {
+    return depends_on_;
+}
+
+void Node::SetDependsOn(std::vector<std::string> depends_on) {
+    depends_on_ = std::move(depends_on);
+}
+
+bool Node::MigrateFrom(Node* old) {
+    std::size_t index;
+    for (const auto& group : old->req_sorted_) {
+        if (GetValueIndex(group.GetRequestValue(), &index)) {
+            req_sorted_[index].MergeRequests(group);
+        }
+    }
+    // Node already holds the old value, skip writing it again
+    if (old->node_path_ != node_path_ || old->reset_on_init_ ||
+        old->current_val_index_ >= old->req_sorted_.size() ||
+        !GetValueIndex(old->req_sorted_[old->current_val_index_].GetRequestValue(), &index)) {
+        return false;
+    }
+    current_val_index_ = index;
+    reset_on_init_ = false;
+    return true;
+}
+
+void Node::ClearRequests() {
+    for (auto& group : req_sorted_) {
+        group.ClearRequests();
+    }
+}
+
+void Node::ReserveRequests(std::size_t num_hints) {
+    for (auto& group : req_sorted_) {
+        group.ReserveRequests(num_hints);
+    }
+}
+
+const std::string& Node::GetWriteGroup() const {
+    return write_group_;
+}
+
+void Node::SetWriteGroup(std::string write_group) {
+    write_group_ = std::move(write_group);
+}
+
 std::vector<std::string> Node::GetValues() const {
     std::vector<std::string> values;
     for (const auto& value : req_sorted_) {
@@ -23,71 +23,476 @@
 #include <android-base/logging.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
+#include <map>
+
 namespace android {
 namespace perfmgr {
 
+NodeLooperThread::NodeLooperThread(std::vector<std::unique_ptr<Node>> nodes, bool full_update)
+    : Thread(false),
+      nodes_(std::move(nodes)),
+      full_update_(full_update),
+      node_deps_(nodes_.size()),
+      node_dirty_(nodes_.size(), false),
+      node_expire_(nodes_.size(), ReqTime::max()),
+      heap_pos_(nodes_.size(), kNotInHeap),
+      node_group_(nodes_.size(), 0),
+      node_update_expire_(nodes_.size(), std::chrono::milliseconds::max()),
+      node_write_time_(nodes_.size(), std::chrono::nanoseconds::zero()),
+      num_action_lists_(0),
+      reserved_hints_(0),
+      queue_(kRequestQueueSize),
+      waiting_(false),
+      wake_pending_(false) {
+    std::map<std::string, std::size_t> nodes_index;
+    for (std::size_t i = 0; i < nodes_.size(); i++) {
+        nodes_index[nodes_[i]->GetName()] = i;
+    }
+    // Dependencies are symmetric: either side changing may unblock the other
+    for (std::size_t i = 0; i < nodes_.size(); i++) {
+        for (const auto &name : nodes_[i]->GetDependsOn()) {
+            auto it = nodes_index.find(name);
+            if (it == nodes_index.end() || it->second == i) {
+                LOG(WARNING) << "Node " << nodes_[i]->GetName()
+                             << " has invalid dependency: " << name;
+                continue;
+            }
+            node_deps_[i].emplace_back(it->second);
+            node_deps_[it->second].emplace_back(i);
+        }
+    }
+    // Number write groups in order of appearance, the default group is 0
+    std::map<std::string, std::size_t> groups_index{{"", 0}};
+    for (std::size_t i = 0; i < nodes_.size(); i++) {
+        node_group_[i] = groups_index.emplace(nodes_[i]->GetWriteGroup(), groups_index.size())
+                                 .first->second;
+    }
+    // Dependent nodes must be written in order, merge their groups
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (std::size_t i = 0; i < nodes_.size(); i++) {
+            for (std::size_t dep : node_deps_[i]) {
+                std::size_t group = std::min(node_group_[i], node_group_[dep]);
+                if (node_group_[i] != group || node_group_[dep] != group) {
+                    LOG(WARNING) << "Node " << nodes_[i]->GetName() << " and "
+                                 << nodes_[dep]->GetName() << " merged into one write group";
+                    node_group_[i] = node_group_[dep] = group;
+                    merged = true;
+                }
+            }
+        }
+    }
+    // Compact group numbers after merging
+    std::map<std::size_t, std::size_t> groups_compact{{0, 0}};
+    for (std::size_t i = 0; i < nodes_.size(); i++) {
+        node_group_[i] =
+                groups_compact.emplace(node_group_[i], groups_compact.size()).first->second;
+    }
+    group_nodes_.resize(groups_compact.size());
+    if (groups_compact.size() > 1) {
+        std::size_t num_threads = std::min(groups_compact.size() - 1, kMaxWriterThreads);
+        writer_pool_ = std::make_unique<NodeWriterPool>(num_threads);
+        update_group_task_ = [this](std::size_t task) {
+            UpdateNodeGroup(group_nodes_[busy_groups_[task]]);
+        };
+        LOG(INFO) << "NodeLooperThread writes " << groups_compact.size() << " groups with "
+                  << num_threads << " writer threads";
+    }
+    // Deferred writes, e.g. property sets, are flushed after each round
+    for (auto& n : nodes_) {
+        n->SetBatchWrites(true);
+    }
+    // Every node is evaluated in the first loop
+    for (std::size_t i = 0; i < nodes_.size(); i++) {
+        MarkDirty(i);
+    }
+    ReserveRequests();
+}
+
+void NodeLooperThread::ReserveRequests() {
+    const std::size_t num_hints = HintIdRegistry::Size();
+    if (num_hints <= reserved_hints_) {
+        return;
+    }
+    for (auto& n : nodes_) {
+        n->ReserveRequests(num_hints);
+    }
+    reserved_hints_ = num_hints;
+}
+
+void NodeLooperThread::MarkDirty(std::size_t node_index) {
+    if (node_dirty_[node_index]) {
+        return;
+    }
+    node_dirty_[node_index] = true;
+    dirty_nodes_.emplace_back(node_index);
+    for (std::size_t dep : node_deps_[node_index]) {
+        MarkDirty(dep);
+    }
+}
+
+void NodeLooperThread::HeapSwap(std::size_t a, std::size_t b) {
+    std::swap(deadline_heap_[a], deadline_heap_[b]);
+    heap_pos_[deadline_heap_[a]] = a;
+    heap_pos_[deadline_heap_[b]] = b;
+}
+
+void NodeLooperThread::HeapSiftUp(std::size_t pos) {
+    while (pos > 0) {
+        std::size_t parent = (pos - 1) / 2;
+        if (node_expire_[deadline_heap_[parent]] <= node_expire_[deadline_heap_[pos]]) {
+            break;
+        }
+        HeapSwap(parent, pos);
+        pos = parent;
+    }
+}
+
+void NodeLooperThread::HeapSiftDown(std::size_t pos) {
+    const std::size_t size = deadline_heap_.size();
+    while (true) {
+        std::size_t smallest = pos;
+        for (std::size_t child = 2 * pos + 1; child <= 2 * pos + 2 && child < size; child++) {
+            if (node_expire_[deadline_heap_[child]] < node_expire_[deadline_heap_[smallest]]) {
+                smallest = child;
+            }
+        }
+        if (smallest == pos) {
+            break;
+        }
+        HeapSwap(pos, smallest);
+        pos = smallest;
+    }
+}
+
+void NodeLooperThread::HeapRemove(std::size_t pos) {
+    std::size_t last = deadline_heap_.size() - 1;
+    heap_pos_[deadline_heap_[pos]] = kNotInHeap;
+    if (pos != last) {
+        deadline_heap_[pos] = deadline_heap_[last];
+        heap_pos_[deadline_heap_[pos]] = pos;
+    }
+    deadline_heap_.pop_back();
+    if (pos < deadline_heap_.size()) {
+        std::size_t moved = deadline_heap_[pos];
+        HeapSiftUp(pos);
+        HeapSiftDown(heap_pos_[moved]);
+    }
+}
+
+void NodeLooperThread::SetNodeDeadline(std::size_t node_index, ReqTime deadline) {
+    std::size_t pos = heap_pos_[node_index];
+    node_expire_[node_index] = deadline;
+    if (deadline == ReqTime::max()) {
+        if (pos != kNotInHeap) {
+            HeapRemove(pos);
+        }
+        return;
+    }
+    if (pos == kNotInHeap) {
+        pos = deadline_heap_.size();
+        deadline_heap_.emplace_back(node_index);
+        heap_pos_[node_index] = pos;
+    }
+    HeapSiftUp(pos);
+    HeapSiftDown(heap_pos_[node_index]);
+}
+
+void NodeLooperThread::PopExpiredNodes(ReqTime now) {
+    while (!deadline_heap_.empty() && node_expire_[deadline_heap_.front()] <= now) {
+        std::size_t node_index = deadline_heap_.front();
+        HeapRemove(0);
+        node_expire_[node_index] = ReqTime::max();
+        MarkDirty(node_index);
+    }
+}
+
 bool NodeLooperThread::Request(const std::vector<NodeAction>& actions,
                                const std::string& hint_type) {
-    if (::android::Thread::exitPending()) {
-        LOG(WARNING) << "NodeLooperThread is exiting";
+    HintId hint_id;
+    if (!HintIdRegistry::Find(hint_type, &hint_id)) {
+        LOG(ERROR) << "Unknown hint: " << hint_type;
         return false;
     }
-    if (!::android::Thread::isRunning()) {
-        LOG(WARNING) << "NodeLooperThread is not running, request " << hint_type;
-    }
+    return Request(actions, hint_id);
+}
 
+bool NodeLooperThread::ApplyRequest(const std::vector<NodeAction>& actions, HintId hint_id,
+                                    ReqTime now, std::chrono::milliseconds timeout_override) {
     bool ret = true;
-    ::android::AutoMutex _l(lock_);
     for (const auto& a : actions) {
         if (a.node_index >= nodes_.size()) {
             LOG(ERROR) << "Node index out of bound: " << a.node_index
                        << " ,size: " << nodes_.size();
             ret = false;
         } else {
+            std::chrono::milliseconds timeout_ms =
+                    (timeout_override == QueuedRequest::kNoOverride) ? a.timeout_ms
+                                                                     : timeout_override;
             // End time set to steady time point max
             ReqTime end_time = ReqTime::max();
             // Timeout is non-zero
-            if (a.timeout_ms != std::chrono::milliseconds::zero()) {
-                auto now = std::chrono::steady_clock::now();
+            if (timeout_ms != std::chrono::milliseconds::zero()) {
                 // Overflow protection in case timeout_ms is too big to overflow
                 // time point which is unsigned integer
                 if (std::chrono::duration_cast<std::chrono::milliseconds>(
-                        ReqTime::max() - now) > a.timeout_ms) {
-                    end_time = now + a.timeout_ms;
+                        ReqTime::max() - now) > timeout_ms) {
+                    end_time = now + timeout_ms;
                 }
             }
-            ret = nodes_[a.node_index]->AddRequest(a.value_index, hint_type,
+            ret = nodes_[a.node_index]->AddRequest(a.value_index, hint_id,
                                                    end_time) &&
                   ret;
+            MarkDirty(a.node_index);
+            if (hint_id < hint_stats_.size() && hint_stats_[hint_id] != nullptr &&
+                pending_applies_.size() < kMaxPendingApplies) {
+                pending_applies_.push_back({hint_id, a.node_index, a.value_index, now});
+            }
+        }
+    }
+    return ret;
+}
+
+bool NodeLooperThread::ApplyCancel(const std::vector<NodeAction>& actions, HintId hint_id) {
+    bool ret = true;
+    for (const auto& a : actions) {
+        if (a.node_index >= nodes_.size()) {
+            LOG(ERROR) << "Node index out of bound: " << a.node_index
+                       << " ,size: " << nodes_.size();
+            ret = false;
+        } else {
+            nodes_[a.node_index]->RemoveRequest(hint_id);
+            MarkDirty(a.node_index);
         }
     }
-    wake_cond_.signal();
+    return ret;
+}
+
+bool NodeLooperThread::Request(const std::vector<NodeAction>& actions, HintId hint_id) {
+    if (::android::Thread::exitPending()) {
+        LOG(WARNING) << "NodeLooperThread is exiting";
+        return false;
+    }
+    if (!::android::Thread::isRunning()) {
+        LOG(WARNING) << "NodeLooperThread is not running, request "
+                     << HintIdRegistry::GetName(hint_id);
+    }
+
+    bool ret;
+    {
+        ::android::AutoMutex _l(lock_);
+        // Keep order with requests submitted earlier
+        DrainQueue();
+        ret = ApplyRequest(actions, hint_id, std::chrono::steady_clock::now(),
+                           QueuedRequest::kNoOverride);
+    }
+    Wake();
     return ret;
 }
 
 bool NodeLooperThread::Cancel(const std::vector<NodeAction>& actions,
                               const std::string& hint_type) {
+    HintId hint_id;
+    if (!HintIdRegistry::Find(hint_type, &hint_id)) {
+        LOG(ERROR) << "Unknown hint: " << hint_type;
+        return false;
+    }
+    return Cancel(actions, hint_id);
+}
+
+bool NodeLooperThread::Cancel(const std::vector<NodeAction>& actions, HintId hint_id) {
     if (::android::Thread::exitPending()) {
         LOG(WARNING) << "NodeLooperThread is exiting";
         return false;
     }
     if (!::android::Thread::isRunning()) {
-        LOG(WARNING) << "NodeLooperThread is not running, cancel " << hint_type;
+        LOG(WARNING) << "NodeLooperThread is not running, cancel "
+                     << HintIdRegistry::GetName(hint_id);
     }
 
-    bool ret = true;
-    ::android::AutoMutex _l(lock_);
+    bool ret;
+    {
+        ::android::AutoMutex _l(lock_);
+        DrainQueue();
+        ret = ApplyCancel(actions, hint_id);
+    }
+    Wake();
+    return ret;
+}
+
+bool NodeLooperThread::RegisterActions(const std::vector<NodeAction>& actions,
+                                       std::size_t* actions_id) {
     for (const auto& a : actions) {
         if (a.node_index >= nodes_.size()) {
             LOG(ERROR) << "Node index out of bound: " << a.node_index
                        << " ,size: " << nodes_.size();
-            ret = false;
+            return false;
+        }
+        if (a.value_index >= nodes_[a.node_index]->GetValues().size()) {
+            LOG(ERROR) << "Value index out of bound: " << a.value_index
+                       << " ,node: " << nodes_[a.node_index]->GetName();
+            return false;
+        }
+    }
+    ::android::AutoMutex _l(lock_);
+    ReserveRequests();
+    *actions_id = action_lists_.size();
+    action_lists_.emplace_back(actions);
+    num_action_lists_.store(action_lists_.size(), std::memory_order_release);
+    return true;
+}
+
+double NodeLooperThread::GetActionsLevel(const std::vector<NodeAction>& actions) const {
+    double level = 0;
+    for (const auto& a : actions) {
+        if (a.node_index >= nodes_.size()) {
+            continue;
+        }
+        // Values are ordered from the highest request down, default last
+        const std::size_t default_index = nodes_[a.node_index]->GetDefaultIndex();
+        if (a.value_index < default_index) {
+            level += static_cast<double>(default_index - a.value_index) / default_index;
+        }
+    }
+    return level;
+}
+
+bool NodeLooperThread::Submit(const QueuedRequest& request) {
+    if (::android::Thread::exitPending()) {
+        LOG(WARNING) << "NodeLooperThread is exiting";
+        return false;
+    }
+    if (request.actions_id >= num_action_lists_.load(std::memory_order_acquire)) {
+        LOG(ERROR) << "Action list id out of bound: " << request.actions_id;
+        return false;
+    }
+    if (!queue_.Push(request)) {
+        // Queue full, apply directly behind the queued requests
+        ATRACE_NAME("request_queue_full");
+        ::android::AutoMutex _l(lock_);
+        DrainQueue();
+        const auto& actions = action_lists_[request.actions_id];
+        if (request.type == QueuedRequest::Type::Request) {
+            ApplyRequest(actions, request.hint_id, request.request_time,
+                         request.timeout_override);
         } else {
-            nodes_[a.node_index]->RemoveRequest(hint_type);
+            ApplyCancel(actions, request.hint_id);
         }
     }
-    wake_cond_.signal();
-    return ret;
+    Wake();
+    return true;
+}
+
+bool NodeLooperThread::SubmitRequest(std::size_t actions_id, HintId hint_id,
+                                     std::chrono::milliseconds timeout_override) {
+    return Submit({QueuedRequest::Type::Request, actions_id, hint_id,
+                   std::chrono::steady_clock::now(), timeout_override});
+}
+
+bool NodeLooperThread::SubmitCancel(std::size_t actions_id, HintId hint_id) {
+    return Submit({QueuedRequest::Type::Cancel, actions_id, hint_id,
+                   std::chrono::steady_clock::now(), QueuedRequest::kNoOverride});
+}
+
+void NodeLooperThread::DrainQueue() {
+    QueuedRequest request;
+    while (queue_.Pop(&request)) {
+        const auto& actions = action_lists_[request.actions_id];
+        if (request.type == QueuedRequest::Type::Request) {
+            ApplyRequest(actions, request.hint_id, request.request_time,
+                         request.timeout_override);
+        } else {
+            ApplyCancel(actions, request.hint_id);
+        }
+    }
+}
+
+void NodeLooperThread::Wake() {
+    // Pairs with the fence in threadLoop(): either the looper sees
+    // wake_pending_ before waiting, or this sees waiting_ set and signals.
+    wake_pending_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting_.load(std::memory_order_relaxed)) {
+        ::android::AutoMutex _l(wake_lock_);
+        wake_cond_.signal();
+    }
+}
+
+void NodeLooperThread::MigrateFrom(const sp<NodeLooperThread>& old) {
+    ::android::AutoMutex _l(lock_);
+    ::android::AutoMutex _lo(old->lock_);
+    // Requests submitted to old until it stopped
+    old->DrainQueue();
+    std::map<std::string, std::size_t> nodes_index;
+    for (std::size_t i = 0; i < nodes_.size(); i++) {
+        nodes_index[nodes_[i]->GetName()] = i;
+    }
+    std::size_t migrated = 0;
+    for (auto& n : old->nodes_) {
+        auto it = nodes_index.find(n->GetName());
+        if (it != nodes_index.end()) {
+            nodes_[it->second]->MigrateFrom(n.get());
+            migrated++;
+            continue;
+        }
+        LOG(INFO) << "Reset removed node " << n->GetName();
+        n->ClearRequests();
+        n->Update(true);
+        n->Flush();
+    }
+    LOG(INFO) << "Migrated " << migrated << " nodes, reset " << old->nodes_.size() - migrated
+              << " nodes";
+}
+
+void NodeLooperThread::SetHintStats(HintId hint_id, std::shared_ptr<HintApplyStats> stats) {
+    ::android::AutoMutex _l(lock_);
+    if (hint_id >= hint_stats_.size()) {
+        hint_stats_.resize(hint_id + 1);
+    }
+    hint_stats_[hint_id] = std::move(stats);
+}
+
+void NodeLooperThread::RecordApplyStats() {
+    if (pending_applies_.empty()) {
+        return;
+    }
+    ReqTime now = std::chrono::steady_clock::now();
+    // Entries of one request are contiguous and share hint and request time
+    std::size_t begin = 0;
+    while (begin < pending_applies_.size()) {
+        const PendingApply& first = pending_applies_[begin];
+        std::size_t end = begin + 1;
+        while (end < pending_applies_.size() && pending_applies_[end].hint_id == first.hint_id &&
+               pending_applies_[end].request_time == first.request_time) {
+            end++;
+        }
+        // Stats may have been dropped by SetHintStats() since the request
+        HintApplyStats* stats = first.hint_id < hint_stats_.size()
+                                        ? hint_stats_[first.hint_id].get()
+                                        : nullptr;
+        if (stats == nullptr) {
+            begin = end;
+            continue;
+        }
+        bool landed = false;
+        for (std::size_t i = begin; i < end; i++) {
+            const PendingApply& p = pending_applies_[i];
+            std::size_t current = nodes_[p.node_index]->GetCurrentIndex();
+            if (current == p.value_index) {
+                stats->write_latency.Record(node_write_time_[p.node_index]);
+                landed = true;
+            } else if (current < p.value_index) {
+                stats->shadowed.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        if (landed) {
+            stats->apply_latency.Record(now - first.request_time);
+        }
+        begin = end;
+    }
+    pending_applies_.clear();
 }
 
 void NodeLooperThread::DumpToFd(int fd) {
@@ -97,21 +502,113 @@ void NodeLooperThread::DumpToFd(int fd) {
     }
 }
 
-bool NodeLooperThread::threadLoop() {
-    ::android::AutoMutex _l(lock_);
-    std::chrono::milliseconds timeout_ms = kMaxUpdatePeriod;
-
+void NodeLooperThread::UpdateNodeGroup(const std::vector<std::size_t>& node_indices) {
     // Update 2 passes: some node may have dependency in other node
     // e.g. update cpufreq min to VAL while cpufreq max still set to
     // a value lower than VAL, is expected to fail in first pass
-    ATRACE_BEGIN("update_nodes");
-    for (auto& n : nodes_) {
-        n->Update(false);
+    for (std::size_t i : node_indices) {
+        auto start = std::chrono::steady_clock::now();
+        nodes_[i]->Update(false);
+        node_write_time_[i] = std::chrono::steady_clock::now() - start;
     }
-    for (auto& n : nodes_) {
-        timeout_ms = std::min(n->Update(true), timeout_ms);
+    for (std::size_t i : node_indices) {
+        auto start = std::chrono::steady_clock::now();
+        node_update_expire_[i] = nodes_[i]->Update(true);
+        node_write_time_[i] += std::chrono::steady_clock::now() - start;
+    }
+}
+
+void NodeLooperThread::UpdateNodes(const std::vector<std::size_t>& node_indices) {
+    if (writer_pool_ == nullptr) {
+        UpdateNodeGroup(node_indices);
+    } else {
+        DispatchNodeGroups(node_indices);
+    }
+    // Back to back writes deferred by the nodes in this round
+    ATRACE_BEGIN("flush_nodes");
+    for (std::size_t i : node_indices) {
+        auto start = std::chrono::steady_clock::now();
+        node_update_expire_[i] = std::min(node_update_expire_[i], nodes_[i]->Flush());
+        node_write_time_[i] += std::chrono::steady_clock::now() - start;
     }
     ATRACE_END();
+    RecordApplyStats();
+}
+
+void NodeLooperThread::DispatchNodeGroups(const std::vector<std::size_t>& node_indices) {
+    for (auto& group : group_nodes_) {
+        group.clear();
+    }
+    for (std::size_t i : node_indices) {
+        group_nodes_[node_group_[i]].emplace_back(i);
+    }
+    busy_groups_.clear();
+    for (std::size_t g = 0; g < group_nodes_.size(); g++) {
+        if (!group_nodes_[g].empty()) {
+            busy_groups_.emplace_back(g);
+        }
+    }
+    if (busy_groups_.size() == 1) {
+        UpdateNodeGroup(group_nodes_[busy_groups_[0]]);
+    } else if (busy_groups_.size() > 1) {
+        // Joined before returning, so expire times are complete
+        writer_pool_->Run(busy_groups_.size(), update_group_task_);
+    }
+}
+
+std::chrono::milliseconds NodeLooperThread::UpdateAllNodes() {
+    std::chrono::milliseconds timeout_ms = kMaxUpdatePeriod;
+    std::vector<std::size_t> node_indices(nodes_.size());
+    for (std::size_t i = 0; i < nodes_.size(); i++) {
+        node_indices[i] = i;
+    }
+    UpdateNodes(node_indices);
+    for (const auto& expire : node_update_expire_) {
+        timeout_ms = std::min(expire, timeout_ms);
+    }
+    return timeout_ms;
+}
+
+std::chrono::milliseconds NodeLooperThread::UpdateDirtyNodes() {
+    ReqTime now = std::chrono::steady_clock::now();
+    // Pick up nodes whose requests expired or need retry
+    PopExpiredNodes(now);
+
+    // Same 2 passes as UpdateAllNodes() on the dirty nodes only; declared
+    // dependencies were marked along with each node.
+    UpdateNodes(dirty_nodes_);
+    for (std::size_t i : dirty_nodes_) {
+        std::chrono::milliseconds expire = node_update_expire_[i];
+        SetNodeDeadline(i, (expire == std::chrono::milliseconds::max()) ? ReqTime::max()
+                                                                          : now + expire);
+        node_dirty_[i] = false;
+    }
+    dirty_nodes_.clear();
+
+    if (deadline_heap_.empty()) {
+        return kMaxUpdatePeriod;
+    }
+    ReqTime next_expire = node_expire_[deadline_heap_.front()];
+    return std::chrono::ceil<std::chrono::milliseconds>(
+            std::max(next_expire - now, ReqTime::duration::zero()));
+}
+
+bool NodeLooperThread::threadLoop() {
+    std::chrono::milliseconds timeout_ms = kMaxUpdatePeriod;
+    // Requests made from now on need another loop
+    wake_pending_.store(false, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    {
+        ::android::AutoMutex _l(lock_);
+        ATRACE_BEGIN("update_nodes");
+        DrainQueue();
+        if (full_update_) {
+            timeout_ms = UpdateAllNodes();
+        } else if (!nodes_.empty()) {
+            timeout_ms = UpdateDirtyNodes();
+        }
+        ATRACE_END();
+    }
 
     nsecs_t sleep_timeout_ns = std::numeric_limits<nsecs_t>::max();
     if (timeout_ms.count() < sleep_timeout_ns / 1000 / 1000) {
@@ -120,9 +617,16 @@ bool NodeLooperThread::threadLoop() {
     // VERBOSE level won't print by default in user/userdebug build
     LOG(VERBOSE) << "NodeLooperThread will wait for " << sleep_timeout_ns
                  << "ns";
-    ATRACE_BEGIN("wait");
-    wake_cond_.waitRelative(lock_, sleep_timeout_ns);
-    ATRACE_END();
+    ::android::AutoMutex _l(wake_lock_);
+    waiting_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // Skip waiting if new requests arrived while updating nodes
+    if (!wake_pending_.load(std::memory_order_relaxed) && !::android::Thread::exitPending()) {
+        ATRACE_BEGIN("wait");
+        wake_cond_.waitRelative(wake_lock_, sleep_timeout_ns);
+        ATRACE_END();
+    }
+    waiting_.store(false, std::memory_order_relaxed);
     return true;
 }
 
@@ -140,9 +644,9 @@ void NodeLooperThread::Stop() {
     if (::android::Thread::isRunning()) {
         LOG(INFO) << "NodeLooperThread stopping";
         {
-            ::android::AutoMutex _l(lock_);
-            wake_cond_.signal();
+            ::android::AutoMutex _l(wake_lock_);
             ::android::Thread::requestExit();
+            wake_cond_.signal();
         }
         ::android::Thread::join();
         LOG(INFO) << "NodeLooperThread stopped";
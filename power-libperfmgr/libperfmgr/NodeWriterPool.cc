@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "libperfmgr"
+
+#include "perfmgr/NodeWriterPool.h"
+
+#include <android-base/logging.h>
+#include <sys/resource.h>
+#include <system/thread_defs.h>
+
+namespace android {
+namespace perfmgr {
+
+NodeWriterPool::NodeWriterPool(std::size_t num_threads)
+    : task_(nullptr), num_tasks_(0), next_task_(0), pending_tasks_(0), exit_(false) {
+    for (std::size_t i = 0; i < num_threads; i++) {
+        threads_.emplace_back(&NodeWriterPool::WorkerLoop, this);
+    }
+}
+
+NodeWriterPool::~NodeWriterPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        exit_ = true;
+    }
+    work_cond_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+std::size_t NodeWriterPool::GetNumThreads() const {
+    return threads_.size();
+}
+
+void NodeWriterPool::Run(std::size_t num_tasks, const std::function<void(std::size_t)>& task) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    task_ = &task;
+    num_tasks_ = num_tasks;
+    next_task_ = 0;
+    pending_tasks_ = num_tasks;
+    work_cond_.notify_all();
+    RunTasks(&lock);
+    done_cond_.wait(lock, [this] { return pending_tasks_ == 0; });
+    task_ = nullptr;
+    num_tasks_ = 0;
+    next_task_ = 0;
+}
+
+void NodeWriterPool::RunTasks(std::unique_lock<std::mutex>* lock) {
+    while (next_task_ < num_tasks_) {
+        std::size_t index = next_task_++;
+        const auto* task = task_;
+        lock->unlock();
+        (*task)(index);
+        lock->lock();
+        if (--pending_tasks_ == 0) {
+            done_cond_.notify_all();
+        }
+    }
+}
+
+void NodeWriterPool::WorkerLoop() {
+    // Same priority as NodeLooperThread, workers write on its behalf
+    if (setpriority(PRIO_PROCESS, 0, PRIORITY_HIGHEST) != 0) {
+        LOG(VERBOSE) << "NodeWriterPool failed to raise worker priority";
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        work_cond_.wait(lock, [this] { return exit_ || next_task_ < num_tasks_; });
+        if (exit_) {
+            return;
+        }
+        RunTasks(&lock);
+    }
+}
+
+}  // namespace perfmgr
+}  // namespace android
@@ -26,6 +26,10 @@
 #include <android-base/strings.h>
 #include <utils/Trace.h>
 
+#include <inttypes.h>
+
+#include <algorithm>
+
 namespace android {
 namespace perfmgr {
 
@@ -33,7 +37,11 @@ PropertyNode::PropertyNode(std::string name, std::string node_path,
                            std::vector<RequestGroup> req_sorted,
                            std::size_t default_val_index, bool reset_on_init)
     : Node(std::move(name), std::move(node_path), std::move(req_sorted),
-           default_val_index, reset_on_init) {}
+           default_val_index, reset_on_init),
+      batch_writes_(false),
+      pending_val_index_(kNoPending),
+      flushed_writes_(0),
+      suppressed_writes_(0) {}
 
 std::chrono::milliseconds PropertyNode::Update(bool) {
     std::size_t value_index = default_val_index_;
@@ -49,32 +57,84 @@ std::chrono::milliseconds PropertyNode::Update(bool) {
 
     // Update node only if request index changes
     if (value_index != current_val_index_ || reset_on_init_) {
-        const std::string& req_value =
-            req_sorted_[value_index].GetRequestValue();
-        if (ATRACE_ENABLED()) {
-            const std::string tag = GetName() + ":" + req_value;
-            ATRACE_BEGIN(tag.c_str());
-        }
-        if (!android::base::SetProperty(node_path_, req_value)) {
-            LOG(WARNING) << "Failed to set property to : " << node_path_
-                         << " with value: " << req_value;
-        } else {
-            // Update current index only when succeed
-            current_val_index_ = value_index;
-            reset_on_init_ = false;
-        }
-        if (ATRACE_ENABLED()) {
-            ATRACE_END();
+        if (batch_writes_) {
+            pending_val_index_ = value_index;
+        } else if (!WriteValue(value_index)) {
+            // Retry in 500ms or sooner
+            expire_time = std::min(expire_time, kRetryTimeout);
         }
+    } else if (pending_val_index_ != kNoPending) {
+        // Changed back before flush
+        pending_val_index_ = kNoPending;
+        suppressed_writes_++;
     }
     return expire_time;
 }
 
+bool PropertyNode::MigrateFrom(Node* old) {
+    if (!Node::MigrateFrom(old)) {
+        return false;
+    }
+    last_written_value_ = req_sorted_[current_val_index_].GetRequestValue();
+    return true;
+}
+
+void PropertyNode::SetBatchWrites(bool batch) {
+    if (!batch) {
+        Flush();
+    }
+    batch_writes_ = batch;
+}
+
+std::chrono::milliseconds PropertyNode::Flush() {
+    if (pending_val_index_ == kNoPending) {
+        return std::chrono::milliseconds::max();
+    }
+    std::size_t value_index = pending_val_index_;
+    pending_val_index_ = kNoPending;
+    return WriteValue(value_index) ? std::chrono::milliseconds::max() : kRetryTimeout;
+}
+
+bool PropertyNode::WriteValue(std::size_t value_index) {
+    const std::string& req_value = req_sorted_[value_index].GetRequestValue();
+    if (ATRACE_ENABLED()) {
+        const std::string tag = GetName() + ":" + req_value;
+        ATRACE_BEGIN(tag.c_str());
+    }
+    bool ok = android::base::SetProperty(node_path_, req_value);
+    if (!ok) {
+        LOG(WARNING) << "Failed to set property to : " << node_path_
+                     << " with value: " << req_value;
+    } else {
+        // Update current index only when succeed
+        current_val_index_ = value_index;
+        reset_on_init_ = false;
+        last_written_value_ = req_value;
+        flushed_writes_++;
+    }
+    if (ATRACE_ENABLED()) {
+        ATRACE_END();
+    }
+    return ok;
+}
+
+uint64_t PropertyNode::GetFlushedWrites() const {
+    return flushed_writes_;
+}
+
+uint64_t PropertyNode::GetSuppressedWrites() const {
+    return suppressed_writes_;
+}
+
 void PropertyNode::DumpToFd(int fd) const {
-    std::string node_value = android::base::GetProperty(node_path_, "");
+    // Last written value saves a property service round trip per node, read
+    // the property back only if nothing was written yet
+    const std::string value = last_written_value_.empty()
+                                      ? android::base::GetProperty(node_path_, "")
+                                      : last_written_value_;
     std::string buf(android::base::StringPrintf(
         "%s\t%s\t%zu\t%s\n", name_.c_str(), node_path_.c_str(),
-        current_val_index_, node_value.c_str()));
+        current_val_index_, value.c_str()));
     if (!android::base::WriteStringToFd(buf, fd)) {
         LOG(ERROR) << "Failed to dump fd: " << fd;
     }
@@ -82,6 +142,11 @@ void PropertyNode::DumpToFd(int fd) const {
         req_sorted_[i].DumpToFd(
             fd, android::base::StringPrintf("\t\tReq%zu:\t", i));
     }
+    buf = android::base::StringPrintf("\t\tFlushed:\t%" PRIu64 "\tSuppressed:\t%" PRIu64 "\n",
+                                      flushed_writes_, suppressed_writes_);
+    if (!android::base::WriteStringToFd(buf, fd)) {
+        LOG(ERROR) << "Failed to dump fd: " << fd;
+    }
 }
 
 }  // namespace perfmgr
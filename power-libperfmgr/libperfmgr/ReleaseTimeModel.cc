@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "libperfmgr"
+
+#include "perfmgr/ReleaseTimeModel.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace android {
+namespace perfmgr {
+
+ReleaseTimeModel::ReleaseTimeModel(double miss_budget)
+    : miss_budget_(std::clamp(miss_budget, 0.0, 1.0)), next_(0), size_(0) {}
+
+void ReleaseTimeModel::Record(std::chrono::milliseconds settle, bool settled,
+                              std::chrono::milliseconds requested,
+                              std::chrono::milliseconds applied,
+                              std::chrono::milliseconds static_duration) {
+    stats_.boosts++;
+    if (settle > applied) {
+        stats_.misses++;
+    }
+    stats_.held += std::min(settle, applied);
+    stats_.static_held += std::min(settle, static_duration);
+
+    window_[next_] = {std::max(settle - std::max(requested, std::chrono::milliseconds(0)),
+                               std::chrono::milliseconds(0)),
+                      settled};
+    next_ = (next_ + 1) % kWindow;
+    size_ = std::min(size_ + 1, kWindow);
+    Learn();
+}
+
+std::chrono::milliseconds ReleaseTimeModel::Duration(
+        std::chrono::milliseconds requested, std::chrono::milliseconds static_duration) const {
+    if (!overshoot_) {
+        return static_duration;
+    }
+    return std::min(std::max(requested, std::chrono::milliseconds(0)) + *overshoot_,
+                    static_duration);
+}
+
+void ReleaseTimeModel::Learn() {
+    overshoot_.reset();
+    if (size_ < kMinSamples) {
+        return;
+    }
+    std::array<Sample, kWindow> sorted;
+    std::copy(window_.begin(), window_.begin() + size_, sorted.begin());
+    // Boosts that never settled sort after every settled one
+    const auto before = [](const Sample &a, const Sample &b) {
+        if (a.settled != b.settled) {
+            return a.settled;
+        }
+        return a.overshoot < b.overshoot;
+    };
+    // epsilon keeps e.g. 0.95 * 20 from rounding up to 20
+    const double covered = std::ceil((1.0 - miss_budget_) * size_ - 1e-9);
+    const std::size_t rank =
+            std::clamp(static_cast<std::size_t>(covered), static_cast<std::size_t>(1), size_);
+    std::nth_element(sorted.begin(), sorted.begin() + rank - 1, sorted.begin() + size_, before);
+    const Sample &sample = sorted[rank - 1];
+    if (sample.settled) {
+        overshoot_ = sample.overshoot;
+    }
+}
+
+}  // namespace perfmgr
+}  // namespace android
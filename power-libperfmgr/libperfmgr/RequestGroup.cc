@@ -21,59 +21,132 @@
 #include <android-base/file.h>
 #include <android-base/logging.h>
 
+#include <algorithm>
 #include <sstream>
 
 namespace android {
 namespace perfmgr {
 
-bool RequestGroup::AddRequest(const std::string& hint_type, ReqTime end_time) {
-    if (request_map_.find(hint_type) == request_map_.end()) {
-        request_map_.emplace(hint_type, end_time);
+bool RequestGroup::AddRequest(HintId hint_id, ReqTime end_time) {
+    // Only ids interned after the config was loaded get here
+    if (hint_id >= request_times_.size()) {
+        request_times_.resize(hint_id + 1, kInactive);
+    }
+    ReqTime &time = request_times_[hint_id];
+    if (time == kInactive) {
+        time = end_time;
+        ++active_count_;
+        earliest_end_time_ = std::min(earliest_end_time_, end_time);
         return true;
     } else {
-        if (request_map_[hint_type] < end_time) {
-            request_map_[hint_type] = end_time;
+        if (time < end_time) {
+            // Extending the earliest request moves the nearest end time
+            if (time == earliest_end_time_) {
+                earliest_valid_ = false;
+            }
+            time = end_time;
         }
         return false;
     }
 }
 
+bool RequestGroup::AddRequest(const std::string& hint_type, ReqTime end_time) {
+    HintId hint_id;
+    if (!HintIdRegistry::Find(hint_type, &hint_id)) {
+        LOG(ERROR) << "Unknown hint: " << hint_type;
+        return false;
+    }
+    return AddRequest(hint_id, end_time);
+}
+
+void RequestGroup::MergeRequests(const RequestGroup& other) {
+    for (HintId id = 0; id < other.request_times_.size(); id++) {
+        if (other.request_times_[id] != kInactive) {
+            AddRequest(id, other.request_times_[id]);
+        }
+    }
+}
+
+void RequestGroup::ClearRequests() {
+    std::fill(request_times_.begin(), request_times_.end(), kInactive);
+    active_count_ = 0;
+    earliest_end_time_ = ReqTime::max();
+    earliest_valid_ = true;
+}
+
+void RequestGroup::ReserveRequests(std::size_t num_hints) {
+    if (num_hints > request_times_.size()) {
+        request_times_.resize(num_hints, kInactive);
+    }
+}
+
+bool RequestGroup::RemoveRequest(HintId hint_id) {
+    if (hint_id >= request_times_.size() || request_times_[hint_id] == kInactive) {
+        return false;
+    }
+    request_times_[hint_id] = kInactive;
+    --active_count_;
+    earliest_valid_ = false;
+    return true;
+}
+
 bool RequestGroup::RemoveRequest(const std::string& hint_type) {
-    return request_map_.erase(hint_type);
+    HintId hint_id;
+    // An unknown hint never had a request
+    return HintIdRegistry::Find(hint_type, &hint_id) && RemoveRequest(hint_id);
 }
 
 const std::string& RequestGroup::GetRequestValue() const {
     return request_value_;
 }
 
-bool RequestGroup::GetExpireTime(std::chrono::milliseconds* expire_time) {
-    ReqTime now = std::chrono::steady_clock::now();
-    *expire_time = std::chrono::milliseconds::max();
-
-    bool active = false;
-    for (auto it = request_map_.begin(); it != request_map_.end();) {
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-            it->second - now);
+void RequestGroup::RefreshExpireTime(ReqTime now) {
+    earliest_end_time_ = ReqTime::max();
+    for (auto &time : request_times_) {
+        if (time == kInactive) {
+            continue;
+        }
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(time - now);
         if (duration <= std::chrono::milliseconds::zero()) {
-            it = request_map_.erase(it);
+            time = kInactive;
+            --active_count_;
         } else {
-            *expire_time = std::min(duration, *expire_time);
-            active = true;
-            ++it;
+            earliest_end_time_ = std::min(time, earliest_end_time_);
         }
     }
-    return active;
+    earliest_valid_ = true;
+}
+
+bool RequestGroup::GetExpireTime(std::chrono::milliseconds* expire_time) {
+    *expire_time = std::chrono::milliseconds::max();
+    if (active_count_ == 0) {
+        return false;
+    }
+
+    ReqTime now = std::chrono::steady_clock::now();
+    if (!earliest_valid_ || earliest_end_time_ - now < std::chrono::milliseconds(1)) {
+        RefreshExpireTime(now);
+    }
+    if (active_count_ == 0) {
+        return false;
+    }
+    *expire_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+        earliest_end_time_ - now);
+    return true;
 }
 
 void RequestGroup::DumpToFd(int fd, const std::string& prefix) const {
     std::ostringstream dump_buf;
     ReqTime now = std::chrono::steady_clock::now();
-    for (auto it = request_map_.begin(); it != request_map_.end(); it++) {
+    for (HintId id = 0; id < request_times_.size(); id++) {
+        if (request_times_[id] == kInactive) {
+            continue;
+        }
         auto remaining_duration =
-            std::chrono::duration_cast<std::chrono::milliseconds>(it->second -
+            std::chrono::duration_cast<std::chrono::milliseconds>(request_times_[id] -
                                                                   now);
-        dump_buf << prefix << it->first << "\t" << remaining_duration.count()
-                 << "\t" << request_value_ << "\n";
+        dump_buf << prefix << HintIdRegistry::GetName(id) << "\t"
+                 << remaining_duration.count() << "\t" << request_value_ << "\n";
     }
     if (!android::base::WriteStringToFd(dump_buf.str(), fd)) {
         LOG(ERROR) << "Failed to dump fd: " << fd;
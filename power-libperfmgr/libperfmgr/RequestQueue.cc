@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "libperfmgr"
+
+#include "perfmgr/RequestQueue.h"
+
+#include <algorithm>
+
+namespace android {
+namespace perfmgr {
+
+namespace {
+std::size_t RoundUpPowerOf2(std::size_t v) {
+    std::size_t p = 1;
+    while (p < v) {
+        p <<= 1;
+    }
+    return p;
+}
+}  // namespace
+
+RequestQueue::RequestQueue(std::size_t capacity)
+    : mask_(RoundUpPowerOf2(std::max<std::size_t>(capacity, 2)) - 1),
+      slots_(new Slot[mask_ + 1]),
+      enqueue_pos_(0),
+      dequeue_pos_(0) {
+    for (std::size_t i = 0; i <= mask_; i++) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool RequestQueue::Push(const QueuedRequest &request) {
+    std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Slot *slot;
+    while (true) {
+        slot = &slots_[pos & mask_];
+        std::size_t seq = slot->sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0) {
+            // Slot free for this lap, claim it
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Slot still holds a request from previous lap
+            return false;
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+    slot->request = request;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool RequestQueue::Pop(QueuedRequest *request) {
+    std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    Slot *slot = &slots_[pos & mask_];
+    std::size_t seq = slot->sequence.load(std::memory_order_acquire);
+    if (seq != pos + 1) {
+        // Not filled yet
+        return false;
+    }
+    *request = slot->request;
+    dequeue_pos_.store(pos + 1, std::memory_order_relaxed);
+    slot->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+}
+
+bool RequestQueue::Empty() const {
+    std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    return slots_[pos & mask_].sequence.load(std::memory_order_acquire) != pos + 1;
+}
+
+}  // namespace perfmgr
+}  // namespace android
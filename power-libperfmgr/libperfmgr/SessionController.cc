@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "libperfmgr"
+
+#include "perfmgr/SessionController.h"
+
+#include <android-base/logging.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace android {
+namespace perfmgr {
+
+namespace {
+
+// weight of the latest report in AdaptiveController::miss_rate_
+constexpr double kMissRateAlpha = 0.1;
+
+inline int64_t ns_to_100us(int64_t ns) {
+    return ns / 100000;
+}
+
+inline int64_t ScaleLimit(int64_t limit, double i) {
+    return (i == 0) ? 0 : static_cast<int64_t>(limit / i);
+}
+
+inline int64_t WindowStart(int64_t window, int64_t length) {
+    return (window == 0 || window > length) ? 0 : length - window;
+}
+
+}  // namespace
+
+bool SessionController::GetNextUclampMin(const ControllerConfig &config, int64_t output,
+                                         int current_min, int *next_min) {
+    if (output == 0) {
+        return false;
+    }
+    int64_t min = std::min<int64_t>(config.uclamp_min_high, output);
+    min = std::max<int64_t>(config.uclamp_min_low, min);
+    if (std::abs(current_min - min) <= static_cast<int64_t>(config.uclamp_min_granularity)) {
+        return false;
+    }
+    *next_min = static_cast<int>(min);
+    return true;
+}
+
+std::unique_ptr<SessionController> SessionController::Create(const std::string &type,
+                                                             const ControllerConfig &config) {
+    if (type == "pid") {
+        return std::make_unique<PidController>(config);
+    }
+    if (type == "adaptive") {
+        return std::make_unique<AdaptiveController>(config);
+    }
+    LOG(ERROR) << "Unknown session controller: " << type;
+    return nullptr;
+}
+
+PidController::PidController(const ControllerConfig &config)
+    : config_(config),
+      i_init_(ScaleLimit(config.i_init, config.i)),
+      i_high_limit_(ScaleLimit(config.i_high_limit, config.i)),
+      i_low_limit_(ScaleLimit(config.i_low_limit, config.i)),
+      integral_(0),
+      previous_error_(0) {}
+
+ControllerOutput PidController::Update(const int64_t *durations_ns, std::size_t count,
+                                       int64_t target_ns) {
+    ControllerOutput out;
+    if (count == 0) {
+        return out;
+    }
+    const int64_t length = count;
+    const int64_t p_start = WindowStart(config_.p_window, length);
+    const int64_t i_start = WindowStart(config_.i_window, length);
+    const int64_t d_start = WindowStart(config_.d_window, length);
+    const int64_t dt = std::max<int64_t>(ns_to_100us(target_ns), 1);
+    int64_t err_sum = 0;
+    int64_t derivative_sum = 0;
+    for (int64_t i = std::min({p_start, i_start, d_start}); i < length; i++) {
+        int64_t actual_ns = durations_ns[i];
+        if (std::abs(actual_ns) > target_ns * 20) {
+            LOG(WARNING) << "The actual duration is way far from the target (" << actual_ns
+                         << " >> " << target_ns << ")";
+        }
+        int64_t error = ns_to_100us(actual_ns - target_ns);
+        if (i >= d_start) {
+            derivative_sum += error - previous_error_;
+        }
+        if (i >= p_start) {
+            err_sum += error;
+        }
+        if (i >= i_start) {
+            integral_ = integral_ + error * dt;
+            integral_ = std::min(i_high_limit_, integral_);
+            integral_ = std::max(i_low_limit_, integral_);
+        }
+        previous_error_ = error;
+    }
+    out.err = err_sum / (length - p_start);
+    out.integral = integral_;
+    out.derivative = derivative_sum / dt / (length - d_start);
+    out.p_out = static_cast<int64_t>((err_sum > 0 ? config_.p_over : config_.p_under) * err_sum /
+                                     (length - p_start));
+    out.i_out = static_cast<int64_t>(config_.i * integral_);
+    out.d_out = static_cast<int64_t>((derivative_sum > 0 ? config_.d_over : config_.d_under) *
+                                     derivative_sum / dt / (length - d_start));
+    out.output = out.p_out + out.i_out + out.d_out;
+    return out;
+}
+
+void PidController::ResetIntegral() {
+    integral_ = std::max(i_init_, integral_);
+}
+
+void PidController::RescaleIntegral(double ratio) {
+    integral_ = std::max(i_init_, static_cast<int64_t>(integral_ * ratio));
+}
+
+int64_t PidController::GetIntegral() const {
+    return integral_;
+}
+
+const char *PidController::GetName() const {
+    return "pid";
+}
+
+AdaptiveController::AdaptiveController(const ControllerConfig &config)
+    : PidController(config),
+      level_(0),
+      trend_(0),
+      has_level_(false),
+      miss_rate_(config.miss_rate_target),
+      margin_(0) {}
+
+ControllerOutput AdaptiveController::Update(const int64_t *durations_ns, std::size_t count,
+                                            int64_t target_ns) {
+    const int64_t pid_target_ns = static_cast<int64_t>(target_ns * (1 - margin_));
+    ControllerOutput out = PidController::Update(durations_ns, count, pid_target_ns);
+    if (count == 0) {
+        return out;
+    }
+    std::size_t misses = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        const double duration = durations_ns[i];
+        if (durations_ns[i] > target_ns) {
+            misses++;
+        }
+        // Holt's linear smoothing of the duration level and its trend
+        if (!has_level_) {
+            level_ = duration;
+            trend_ = 0;
+            has_level_ = true;
+            continue;
+        }
+        const double previous_level = level_;
+        level_ = config_.trend_alpha * duration + (1 - config_.trend_alpha) * (level_ + trend_);
+        trend_ = config_.trend_beta * (level_ - previous_level) + (1 - config_.trend_beta) * trend_;
+    }
+    out.ff_out = static_cast<int64_t>(config_.ff_gain * trend_ / 100000);
+    out.output = out.p_out + out.i_out + out.d_out + out.ff_out;
+
+    // Margin for the next report, steered by the smoothed miss rate
+    miss_rate_ += kMissRateAlpha * (static_cast<double>(misses) / count - miss_rate_);
+    if (miss_rate_ > config_.miss_rate_target) {
+        margin_ = std::min(config_.margin_max, margin_ + config_.margin_step);
+    } else if (miss_rate_ < config_.miss_rate_target / 2) {
+        margin_ = std::max(0.0, margin_ - config_.margin_step);
+    }
+    return out;
+}
+
+const char *AdaptiveController::GetName() const {
+    return "adaptive";
+}
+
+double AdaptiveController::GetMargin() const {
+    return margin_;
+}
+
+}  // namespace perfmgr
+}  // namespace android
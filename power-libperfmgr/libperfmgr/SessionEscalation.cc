@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "libperfmgr"
+
+#include "perfmgr/SessionEscalation.h"
+
+#include <algorithm>
+
+namespace android {
+namespace perfmgr {
+
+bool SaturationFilter::Update(bool saturated, const EscalationConfig &config) {
+    if (saturated == saturated_) {
+        run_ = 0;
+        return false;
+    }
+    run_++;
+    if (run_ < std::max<uint32_t>(saturated ? config.enter_reports : config.exit_reports, 1)) {
+        return false;
+    }
+    saturated_ = saturated;
+    run_ = 0;
+    return true;
+}
+
+bool ShouldEscalate(bool escalated, std::size_t saturated, std::size_t active,
+                    const EscalationConfig &config) {
+    if (config.hint.empty() || active == 0) {
+        return false;
+    }
+    const double fraction = static_cast<double>(saturated) / active;
+    return fraction >= (escalated ? config.exit_fraction : config.enter_fraction);
+}
+
+}  // namespace perfmgr
+}  // namespace android
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "libperfmgr"
+
+#include "perfmgr/SessionReplay.h"
+
+#include <android-base/logging.h>
+#include <android-base/parseint.h>
+#include <android-base/strings.h>
+
+#include <random>
+
+namespace android {
+namespace perfmgr {
+
+bool ParseWorkDurationTrace(const std::string &csv, std::vector<WorkDurationReport> *reports) {
+    reports->clear();
+    std::vector<std::string> lines = android::base::Split(csv, "\n");
+    bool has_report = false;
+    int64_t last_report = 0;
+    for (std::size_t i = 0; i < lines.size(); i++) {
+        const std::string line = android::base::Trim(lines[i]);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> fields = android::base::Split(line, ",");
+        int64_t timestamp_ns, duration_ns, target_ns, report;
+        if ((fields.size() != 3 && fields.size() != 4) ||
+            !android::base::ParseInt(android::base::Trim(fields[0]), &timestamp_ns) ||
+            !android::base::ParseInt(android::base::Trim(fields[1]), &duration_ns) ||
+            !android::base::ParseInt(android::base::Trim(fields[2]), &target_ns, int64_t{1})) {
+            LOG(ERROR) << "Malformed WorkDuration at line " << i + 1 << ": " << line;
+            return false;
+        }
+        if (fields.size() == 4) {
+            if (!android::base::ParseInt(android::base::Trim(fields[3]), &report)) {
+                LOG(ERROR) << "Malformed report number at line " << i + 1 << ": " << line;
+                return false;
+            }
+            if (has_report && report == last_report && !reports->empty()) {
+                reports->back().timestamp_ns = timestamp_ns;
+                reports->back().target_ns = target_ns;
+                reports->back().durations_ns.push_back(duration_ns);
+                continue;
+            }
+            has_report = true;
+            last_report = report;
+        } else {
+            has_report = false;
+        }
+        reports->push_back({timestamp_ns, target_ns, {duration_ns}});
+    }
+    return true;
+}
+
+ReplayResult ReplayTrace(SessionController *controller, const ControllerConfig &config,
+                         const std::vector<WorkDurationReport> &reports,
+                         const ReplayOptions &options) {
+    ReplayResult result;
+    if (reports.empty()) {
+        return result;
+    }
+    // A new session starts boosted at the high limit
+    int current_min = config.uclamp_min_high;
+    double boost = current_min;
+    int64_t target_ns = reports.front().target_ns;
+    int64_t last_timestamp_ns = reports.front().timestamp_ns;
+    double min_sum = 0;
+    std::vector<int64_t> durations_ns;
+    result.uclamp_timeline.emplace_back(last_timestamp_ns, current_min);
+
+    for (const WorkDurationReport &report : reports) {
+        if (report.target_ns != target_ns) {
+            controller->RescaleIntegral(static_cast<double>(target_ns) / report.target_ns);
+            target_ns = report.target_ns;
+        }
+        if (options.stale_timeout_ns > 0 &&
+            report.timestamp_ns - last_timestamp_ns > options.stale_timeout_ns) {
+            // PowerHintMonitor dropped the boost, the report wakes it up
+            if (current_min != 0) {
+                current_min = 0;
+                result.setattr_calls++;
+                result.uclamp_timeline.emplace_back(last_timestamp_ns + options.stale_timeout_ns,
+                                                    current_min);
+            }
+            controller->ResetIntegral();
+        }
+        last_timestamp_ns = report.timestamp_ns;
+
+        durations_ns.clear();
+        for (int64_t work_ns : report.durations_ns) {
+            int64_t duration_ns = work_ns;
+            if (options.closed_loop) {
+                boost += options.plant_ramp * (current_min - boost);
+                duration_ns = static_cast<int64_t>(work_ns * options.plant_ref /
+                                                   (options.plant_ref + boost));
+            }
+            durations_ns.push_back(duration_ns);
+            result.frames++;
+            if (duration_ns > target_ns) {
+                result.frames_over_target++;
+            }
+            min_sum += current_min;
+        }
+
+        const ControllerOutput out =
+                controller->Update(durations_ns.data(), durations_ns.size(), target_ns);
+        int next_min;
+        if (SessionController::GetNextUclampMin(config, out.output, current_min, &next_min)) {
+            current_min = next_min;
+            result.setattr_calls++;
+            result.uclamp_timeline.emplace_back(report.timestamp_ns, current_min);
+        }
+    }
+    if (result.frames > 0) {
+        result.average_min = min_sum / result.frames;
+    }
+    return result;
+}
+
+std::vector<WorkDurationReport> MakeSyntheticTrace(SyntheticWorkload workload, std::size_t frames,
+                                                   int64_t target_ns, uint32_t seed) {
+    // Bursts of kBurstFrames heavy frames every kBurstPeriod frames
+    constexpr std::size_t kBurstPeriod = 60;
+    constexpr std::size_t kBurstFrames = 8;
+    // +/- 5% jitter on every frame
+    constexpr double kJitter = 0.05;
+    std::minstd_rand rng(seed);
+    std::vector<WorkDurationReport> reports;
+    reports.reserve(frames);
+    for (std::size_t i = 0; i < frames; i++) {
+        double load;
+        switch (workload) {
+            case SyntheticWorkload::STEADY:
+                load = 1.1;
+                break;
+            case SyntheticWorkload::BURSTY:
+                load = (i % kBurstPeriod) < kBurstFrames ? 1.6 : 0.7;
+                break;
+            case SyntheticWorkload::PHASE_CHANGE:
+            default:
+                load = i < frames / 2 ? 0.65 : 1.25;
+                break;
+        }
+        // rng() % 2001 is in [0, 2000], mapped to [-1, 1]
+        const double jitter = kJitter * (static_cast<double>(rng() % 2001) / 1000 - 1);
+        const int64_t work_ns = static_cast<int64_t>(target_ns * load * (1 + jitter));
+        reports.push_back({static_cast<int64_t>(i) * target_ns, target_ns, {work_ns}});
+    }
+    return reports;
+}
+
+}  // namespace perfmgr
+}  // namespace android
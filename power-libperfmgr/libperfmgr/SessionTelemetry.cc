@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "libperfmgr"
+
+#include "perfmgr/SessionTelemetry.h"
+
+#include <android-base/stringprintf.h>
+
+#include <algorithm>
+#include <cinttypes>
+
+namespace android {
+namespace perfmgr {
+
+namespace {
+
+constexpr char kBinaryMagic[] = {'A', 'D', 'P', 'T'};
+
+template <typename T>
+void Append(T value, std::string *out) {
+    out->append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+}  // namespace
+
+SessionTelemetry::SessionTelemetry()
+    : reports_(0), over_target_(0), setattr_(0), stale_transitions_(0) {
+    for (Slot &slot : ring_) {
+        slot.seq.store(0, std::memory_order_relaxed);
+        for (auto &field : slot.fields) {
+            field.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void SessionTelemetry::RecordReport(const Record &record, uint64_t over_target) {
+    const uint64_t index = reports_.load(std::memory_order_relaxed);
+    Slot &slot = ring_[index % kCapacity];
+    // Seqlock write: mark the slot busy before touching the fields
+    slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    const int64_t fields[kRecordFields] = {record.timestamp_ns, record.actual_ns,
+                                           record.target_ns,    record.p_out,
+                                           record.i_out,        record.d_out,
+                                           record.uclamp_min};
+    for (std::size_t i = 0; i < kRecordFields; i++) {
+        slot.fields[i].store(fields[i], std::memory_order_relaxed);
+    }
+    slot.seq.store(2 * index + 2, std::memory_order_release);
+    over_target_.fetch_add(over_target, std::memory_order_relaxed);
+    reports_.store(index + 1, std::memory_order_release);
+}
+
+void SessionTelemetry::RecordSetattr(uint64_t count) {
+    setattr_.fetch_add(count, std::memory_order_relaxed);
+}
+
+void SessionTelemetry::RecordStaleTransition() {
+    stale_transitions_.fetch_add(1, std::memory_order_relaxed);
+}
+
+SessionTelemetry::Counters SessionTelemetry::GetCounters() const {
+    return {reports_.load(std::memory_order_acquire),
+            over_target_.load(std::memory_order_relaxed),
+            setattr_.load(std::memory_order_relaxed),
+            stale_transitions_.load(std::memory_order_relaxed)};
+}
+
+std::vector<SessionTelemetry::Record> SessionTelemetry::GetRecords() const {
+    const uint64_t end = reports_.load(std::memory_order_acquire);
+    const uint64_t begin = end - std::min<uint64_t>(end, kCapacity);
+    std::vector<Record> records;
+    records.reserve(end - begin);
+    for (uint64_t index = begin; index < end; index++) {
+        const Slot &slot = ring_[index % kCapacity];
+        const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+        if (seq != 2 * index + 2) {
+            // already overwritten by a newer report
+            continue;
+        }
+        int64_t fields[kRecordFields];
+        for (std::size_t i = 0; i < kRecordFields; i++) {
+            fields[i] = slot.fields[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq) {
+            continue;
+        }
+        records.push_back({fields[0], fields[1], fields[2], static_cast<int32_t>(fields[3]),
+                           static_cast<int32_t>(fields[4]), static_cast<int32_t>(fields[5]),
+                           static_cast<int32_t>(fields[6])});
+    }
+    return records;
+}
+
+void SessionTelemetry::DumpText(const std::string &id, std::string *out) const {
+    const Counters counters = GetCounters();
+    out->append(android::base::StringPrintf(
+            "Session %s: reports %" PRIu64 ", over target %" PRIu64 ", setattr %" PRIu64
+            ", stale transitions %" PRIu64 "\n",
+            id.c_str(), counters.reports, counters.over_target, counters.setattr,
+            counters.stale_transitions));
+    out->append("  Timestamp(ns)\tActual(ns)\tTarget(ns)\tPOut\tIOut\tDOut\tMin\n");
+    for (const Record &r : GetRecords()) {
+        out->append(android::base::StringPrintf(
+                "  %" PRId64 "\t%" PRId64 "\t%" PRId64 "\t%" PRId32 "\t%" PRId32 "\t%" PRId32
+                "\t%" PRId32 "\n",
+                r.timestamp_ns, r.actual_ns, r.target_ns, r.p_out, r.i_out, r.d_out,
+                r.uclamp_min));
+    }
+}
+
+void SessionTelemetry::DumpBinary(const std::string &id, std::string *out) const {
+    const Counters counters = GetCounters();
+    const std::vector<Record> records = GetRecords();
+    Append(static_cast<uint32_t>(id.size()), out);
+    out->append(id);
+    Append(counters.reports, out);
+    Append(counters.over_target, out);
+    Append(counters.setattr, out);
+    Append(counters.stale_transitions, out);
+    Append(static_cast<uint32_t>(records.size()), out);
+    for (const Record &r : records) {
+        Append(r.timestamp_ns, out);
+        Append(r.actual_ns, out);
+        Append(r.target_ns, out);
+        Append(r.p_out, out);
+        Append(r.i_out, out);
+        Append(r.d_out, out);
+        Append(r.uclamp_min, out);
+    }
+}
+
+void SessionTelemetry::DumpBinaryHeader(uint32_t sessions, std::string *out) {
+    out->append(kBinaryMagic, sizeof(kBinaryMagic));
+    Append(kBinaryVersion, out);
+    Append(sessions, out);
+}
+
+}  // namespace perfmgr
+}  // namespace android
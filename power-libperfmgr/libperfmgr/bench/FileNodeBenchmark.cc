@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <android-base/unique_fd.h>
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "perfmgr/FileNode.h"
+
+namespace android {
+namespace perfmgr {
+
+using std::literals::chrono_literals::operator""s;
+
+// Fake sysfs tree backed by a temporary directory (tmpfs on host and /dev
+// based targets), one file per node.
+class FakeSysfs {
+  public:
+    explicit FakeSysfs(std::size_t num_nodes) {
+        for (std::size_t i = 0; i < num_nodes; i++) {
+            paths_.emplace_back(android::base::StringPrintf("%s/node%zu", dir_.path, i));
+            android::base::WriteStringToFile("", paths_.back());
+        }
+    }
+    const std::vector<std::string> &paths() const { return paths_; }
+
+  private:
+    TemporaryDir dir_;
+    std::vector<std::string> paths_;
+};
+
+// Count the syscalls entered by the calling thread through the
+// raw_syscalls:sys_enter tracepoint. Needs tracefs and perf access (root on
+// device); Valid() is false otherwise and no counter is reported.
+class SyscallCounter {
+  public:
+    SyscallCounter() {
+        std::string id;
+        if (!android::base::ReadFileToString(
+                    "/sys/kernel/tracing/events/raw_syscalls/sys_enter/id", &id) &&
+            !android::base::ReadFileToString(
+                    "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id", &id)) {
+            return;
+        }
+        struct perf_event_attr attr = {};
+        attr.type = PERF_TYPE_TRACEPOINT;
+        attr.size = sizeof(attr);
+        attr.config = std::stoull(id);
+        attr.disabled = 1;
+        fd_.reset(syscall(__NR_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+    }
+    bool Valid() const { return fd_ != -1; }
+    void Start() {
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    // Return the syscalls since Start(), less the ioctl stopping the count
+    uint64_t Stop() {
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t count = 0;
+        if (read(fd_, &count, sizeof(count)) != sizeof(count)) {
+            return 0;
+        }
+        return count > 0 ? count - 1 : 0;
+    }
+
+  private:
+    android::base::unique_fd fd_;
+};
+
+// Report the syscalls of one more call to update as a counter of state
+template <typename F>
+static void ReportSyscalls(benchmark::State &state, F update) {
+    SyscallCounter counter;
+    if (!counter.Valid()) {
+        return;
+    }
+    counter.Start();
+    update();
+    state.counters["syscalls_per_update"] = counter.Stop();
+}
+
+static const std::vector<RequestGroup> kValues{{"1708800"}, {"1209600"}, {"300000"}};
+
+// Write sequence used by FileNode before the fd cache: open(O_TRUNC) + write
+// + fsync + close.
+static void BM_FileNodeLegacyWrite(benchmark::State &state) {
+    FakeSysfs sysfs(1);
+    const std::string &path = sysfs.paths()[0];
+    std::size_t i = 0;
+    auto update = [&]() {
+        const std::string &value = kValues[i++ % kValues.size()].GetRequestValue();
+        android::base::unique_fd fd(
+                TEMP_FAILURE_RETRY(open(path.c_str(), O_WRONLY | O_CLOEXEC | O_TRUNC)));
+        android::base::WriteStringToFd(value, fd);
+        fsync(fd);
+    };
+    for (auto _ : state) {
+        update();
+    }
+    ReportSyscalls(state, update);
+}
+BENCHMARK(BM_FileNodeLegacyWrite);
+
+// FileNode::Update with the cached fd of path
+static void FileNodeUpdate(benchmark::State &state, const std::string &path) {
+    FileNode node("bench", path, kValues, 2, true);
+    node.Update(false);
+    const HintId hint_id = HintIdRegistry::Intern("BENCH");
+    auto end_time = std::chrono::steady_clock::now() + 3600s;
+    std::size_t i = 0;
+    auto update = [&]() {
+        if (i++ % 2) {
+            node.RemoveRequest(hint_id);
+        } else {
+            node.AddRequest(0, hint_id, end_time);
+        }
+        node.Update(true);
+    };
+    for (auto _ : state) {
+        update();
+    }
+    ReportSyscalls(state, update);
+}
+
+// On the regular-file fake tree a write also pays ftruncate + fsync
+static void BM_FileNodeUpdate(benchmark::State &state) {
+    FakeSysfs sysfs(1);
+    FileNodeUpdate(state, sysfs.paths()[0]);
+}
+BENCHMARK(BM_FileNodeUpdate);
+
+// A character device, like /dev/cpu_dma_latency, takes a single pwrite
+static void BM_FileNodeUpdateCharDevice(benchmark::State &state) {
+    FileNodeUpdate(state, "/dev/null");
+}
+BENCHMARK(BM_FileNodeUpdateCharDevice);
+
+// Boost across many nodes, as done by one looper iteration for a large hint.
+static void BM_FileNodeUpdateNodes(benchmark::State &state) {
+    FakeSysfs sysfs(state.range(0));
+    std::vector<std::unique_ptr<FileNode>> nodes;
+    for (const auto &path : sysfs.paths()) {
+        nodes.emplace_back(std::make_unique<FileNode>(path, path, kValues, 2, true));
+        nodes.back()->Update(false);
+    }
+    const HintId hint_id = HintIdRegistry::Intern("BENCH");
+    auto end_time = std::chrono::steady_clock::now() + 3600s;
+    std::size_t i = 0;
+    for (auto _ : state) {
+        bool boost = i++ % 2 == 0;
+        for (auto &n : nodes) {
+            if (boost) {
+                n->AddRequest(0, hint_id, end_time);
+            } else {
+                n->RemoveRequest(hint_id);
+            }
+            n->Update(true);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FileNodeUpdateNodes)->Arg(16)->Arg(80);
+
+}  // namespace perfmgr
+}  // namespace android
+
+BENCHMARK_MAIN();
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "perfmgr/FileNode.h"
+#include "perfmgr/NodeLooperThread.h"
+
+namespace android {
+namespace perfmgr {
+
+using std::literals::chrono_literals::operator""ms;
+using std::literals::chrono_literals::operator""us;
+
+// FileNode with injected write latency, e.g. a devfreq or GPU governor node
+// taking milliseconds to apply a new value. Counts completed value changes.
+class SlowFileNode : public FileNode {
+  public:
+    SlowFileNode(const std::string &path, std::chrono::microseconds latency,
+                 std::atomic<std::size_t> *writes)
+        : FileNode(path, path, {{"1"}, {"0"}}, 1, false), latency_(latency), writes_(writes) {}
+
+    std::chrono::milliseconds Update(bool log_error) override {
+        std::size_t index = current_val_index_;
+        std::chrono::milliseconds ret = FileNode::Update(log_error);
+        if (index != current_val_index_) {
+            std::this_thread::sleep_for(latency_);
+            writes_->fetch_add(1, std::memory_order_release);
+        }
+        return ret;
+    }
+
+  private:
+    const std::chrono::microseconds latency_;
+    std::atomic<std::size_t> *writes_;
+};
+
+// Time from Request() until every node in the hint is written, for 4 slow
+// nodes spread over range(0) write groups.
+static void BM_NodeLooperThreadSlowNodes(benchmark::State &state) {
+    constexpr std::size_t kNumNodes = 4;
+    const std::size_t num_groups = state.range(0);
+    TemporaryDir dir;
+    std::atomic<std::size_t> writes(0);
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::vector<NodeAction> actions;
+    for (std::size_t i = 0; i < kNumNodes; i++) {
+        std::string path = android::base::StringPrintf("%s/node%zu", dir.path, i);
+        android::base::WriteStringToFile("", path);
+        nodes.emplace_back(std::make_unique<SlowFileNode>(path, 1000us, &writes));
+        nodes.back()->SetWriteGroup(std::to_string(i % num_groups));
+        actions.emplace_back(i, 0, 0ms);
+    }
+    const HintId hint_id = HintIdRegistry::Intern("BENCH");
+    sp<NodeLooperThread> looper = new NodeLooperThread(std::move(nodes));
+    looper->Start();
+    std::size_t expected = 0;
+    bool boost = true;
+    for (auto _ : state) {
+        if (boost) {
+            looper->Request(actions, hint_id);
+        } else {
+            looper->Cancel(actions, hint_id);
+        }
+        boost = !boost;
+        expected += kNumNodes;
+        while (writes.load(std::memory_order_acquire) < expected) {
+            std::this_thread::yield();
+        }
+    }
+    looper->Stop();
+    state.counters["write_groups"] = num_groups;
+}
+BENCHMARK(BM_NodeLooperThreadSlowNodes)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+}  // namespace perfmgr
+}  // namespace android
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include "perfmgr/SessionReplay.h"
+
+namespace android {
+namespace perfmgr {
+
+constexpr int64_t kTargetNs = 16666666;
+constexpr std::size_t kFrames = 1200;
+static const char *const kControllers[] = {"pid", "adaptive"};
+
+// Closed loop replay of a synthetic workload, range(0) the controller and
+// range(1) the SyntheticWorkload. Time is the controller cost per report;
+// counters are the tuning outcome, identical on every run.
+static void BM_ReplaySynthetic(benchmark::State &state) {
+    const ControllerConfig config;
+    ReplayOptions options;
+    options.closed_loop = true;
+    const std::vector<WorkDurationReport> trace = MakeSyntheticTrace(
+            static_cast<SyntheticWorkload>(state.range(1)), kFrames, kTargetNs, 1);
+    ReplayResult result;
+    for (auto _ : state) {
+        std::unique_ptr<SessionController> controller =
+                SessionController::Create(kControllers[state.range(0)], config);
+        result = ReplayTrace(controller.get(), config, trace, options);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.iterations() * trace.size());
+    state.SetLabel(kControllers[state.range(0)]);
+    state.counters["over_target_pct"] = 100.0 * result.frames_over_target / result.frames;
+    state.counters["setattr_calls"] = result.setattr_calls;
+    state.counters["average_min"] = result.average_min;
+}
+BENCHMARK(BM_ReplaySynthetic)->ArgsProduct({{0, 1}, {0, 1, 2}});
+
+}  // namespace perfmgr
+}  // namespace android
+
+BENCHMARK_MAIN();
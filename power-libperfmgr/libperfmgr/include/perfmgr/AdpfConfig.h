@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBPERFMGR_ADPFCONFIG_H_
+#define ANDROID_LIBPERFMGR_ADPFCONFIG_H_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "perfmgr/HintId.h"
+#include "perfmgr/SessionController.h"
+
+namespace android {
+namespace perfmgr {
+
+// How ADPF sessions follow a display refresh rate switch, from the
+// "RefreshRateSwitch" object of the "AdpfConfig" JSON section.
+struct RefreshRateSwitchConfig {
+    enum class IntegralPolicy {
+        // keep the integral term as is
+        NONE,
+        // restart the integral term from its initial value
+        RESET,
+        // scale the integral term by new rate / old rate
+        RESCALE,
+    };
+    RefreshRateSwitchConfig()
+        : integral(IntegralPolicy::NONE),
+          scale_stale_timeout(false),
+          preboost_uclamp_min(0),
+          preboost_duration(0) {}
+    IntegralPolicy integral;
+    // scale the stale timeout by kReferenceRate / current rate
+    bool scale_stale_timeout;
+    // uclamp.min floor of active sessions right after a switch, 0 disables
+    int32_t preboost_uclamp_min;
+    std::chrono::milliseconds preboost_duration;
+
+    static constexpr int32_t kReferenceRate = 60;
+};
+
+// When ADPF sessions hand over to node based boosting, from the
+// "Escalation" object of the "AdpfConfig" JSON section. A session is
+// saturated while it misses its target with uclamp.min at its high limit.
+struct EscalationConfig {
+    EscalationConfig()
+        : enter_reports(30),
+          exit_reports(10),
+          enter_fraction(1.0),
+          exit_fraction(0.5),
+          duration(std::chrono::milliseconds(1000)),
+          hint_id(0) {}
+    // hint done while escalated, empty disables escalation
+    std::string hint;
+    // consecutive saturated reports before a session counts as saturated,
+    // and consecutive unsaturated ones before it no longer does
+    uint32_t enter_reports;
+    uint32_t exit_reports;
+    // escalate once this fraction of the active sessions is saturated, and
+    // de-escalate when it drops below exit_fraction
+    double enter_fraction;
+    double exit_fraction;
+    // timeout of the hint, renewed while escalated
+    std::chrono::milliseconds duration;
+    // id of hint, resolved by HintManager when the config is loaded
+    HintId hint_id;
+};
+
+// Controller tunables of a group of sessions, an entry of the "Profiles"
+// array of the "AdpfConfig" JSON section.
+struct AdpfProfile {
+    AdpfProfile() : name("Default"), controller("pid"), stale_time_factor(20) {}
+    std::string name;
+    // type passed to SessionController::Create
+    std::string controller;
+    ControllerConfig controller_config;
+    // stale timeout in units of the ADPF report rate
+    uint32_t stale_time_factor;
+    // sessions of these uids use the profile
+    std::vector<int32_t> uids;
+    // otherwise, sessions created while one of these power modes is enabled
+    std::vector<std::string> modes;
+};
+
+// ADPF settings of the powerhint JSON config. Defaults apply when the
+// "AdpfConfig" section is absent.
+struct AdpfConfig {
+    // one profile with the default tunables
+    AdpfConfig() : profiles(1) {}
+    // never empty, profiles[0] is the default profile
+    std::vector<AdpfProfile> profiles;
+    RefreshRateSwitchConfig refresh_rate_switch;
+    EscalationConfig escalation;
+
+    // Return the first profile listing uid, else the first one listing an
+    // enabled mode, else the default profile.
+    const AdpfProfile &SelectProfile(
+            int32_t uid, const std::function<bool(const std::string &)> &is_mode_enabled) const;
+};
+
+// Set the ControllerConfig field named key, as in the JSON profile, e.g.
+// "PID_Po". Return false if key is not a ControllerConfig tunable.
+bool SetControllerTunable(const std::string &key, double value, ControllerConfig *config);
+
+}  // namespace perfmgr
+}  // namespace android
+
+#endif  // ANDROID_LIBPERFMGR_ADPFCONFIG_H_
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBPERFMGR_BOOSTARBITER_H_
+#define ANDROID_LIBPERFMGR_BOOSTARBITER_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "perfmgr/HintId.h"
+
+namespace android {
+namespace perfmgr {
+
+class HintManager;
+
+// Producers of boosts in the power HAL
+enum class BoostSource : uint8_t {
+    // Power::setBoost
+    BOOST,
+    // Power::setMode
+    MODE,
+    // InteractionHandler
+    INTERACTION,
+    // PowerSessionManager
+    ADPF,
+    // IPowerExt, e.g. the thermal HAL
+    EXT,
+    COUNT,
+};
+
+// Return the name of source as used in the "BoostArbiter" JSON section
+const char *BoostSourceName(BoostSource source);
+// Parse a source name, return false if name is not a source
+bool ParseBoostSource(const std::string &name, BoostSource *source);
+
+// A rule of the "BoostArbiter" JSON section. A request matches when one of
+// modes is enabled, it comes from one of sources, is for one of hints and its
+// priority is at most max_priority. Empty lists match anything.
+struct BoostRule {
+    BoostRule() : sources(0), max_priority(std::numeric_limits<int32_t>::max()), drop(false),
+                  max_duration(0) {}
+    std::vector<HintId> modes;
+    // bit mask of BoostSource
+    uint32_t sources;
+    std::vector<HintId> hints;
+    int32_t max_priority;
+    // drop matching requests, otherwise cap their duration to max_duration
+    bool drop;
+    std::chrono::milliseconds max_duration;
+};
+
+// Arbitration settings of the powerhint JSON config
+struct BoostPolicy {
+    struct Verdict {
+        Verdict() : drop(false), capped(false), duration(0) {}
+        bool drop;
+        bool capped;
+        // duration to request, 0 for the hint's own timeout
+        std::chrono::milliseconds duration;
+    };
+
+    // Apply the first rule matching the request. duration is 0 for the
+    // hint's own timeout, which is hint_timeout (0 for forever).
+    Verdict Apply(BoostSource source, HintId hint, std::chrono::milliseconds duration,
+                  std::chrono::milliseconds hint_timeout, int32_t priority,
+                  const std::vector<bool> &enabled_modes) const;
+
+    std::vector<BoostRule> rules;
+};
+
+// BoostArbiter sits between the boost producers of the power HAL and
+// HintManager. Every request is checked against the BoostPolicy of the
+// current config. A timed request is not submitted when HintManager already
+// holds the hint until at least its deadline. Per source, the boosted time
+// weighted by the node level of the hint is accounted as its cost. Thread
+// safe, HintManager is never called with the arbiter lock held.
+class BoostArbiter {
+  public:
+    struct SourceStats {
+        SourceStats() : requests(0), coalesced(0), capped(0), dropped(0), cost(0) {}
+        uint64_t requests;
+        // not submitted, the hint was held long enough already
+        uint64_t coalesced;
+        uint64_t capped;
+        uint64_t dropped;
+        // boosted milliseconds times hint level
+        double cost;
+    };
+
+    explicit BoostArbiter(std::shared_ptr<HintManager> hm);
+
+    // Default priority of each source, higher wins against policy rules
+    static int32_t DefaultPriority(BoostSource source);
+
+    // Request hint for duration, 0 for the hint's own timeout.
+    bool DoHint(BoostSource source, HintId hint, std::chrono::milliseconds duration,
+                int32_t priority);
+    bool DoHint(BoostSource source, HintId hint,
+                std::chrono::milliseconds duration = std::chrono::milliseconds(0)) {
+        return DoHint(source, hint, duration, DefaultPriority(source));
+    }
+    bool EndHint(BoostSource source, HintId hint);
+    // Track power modes the policy rules depend on
+    void SetMode(HintId mode, bool enabled);
+
+    std::array<SourceStats, static_cast<std::size_t>(BoostSource::COUNT)> GetStats();
+    void DumpToFd(int fd);
+
+  private:
+    // Who requested a hint through the arbiter and until when, to account cost
+    struct Hold {
+        Hold() : active(false), source(BoostSource::BOOST), level(0) {}
+        bool active;
+        BoostSource source;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point deadline;
+        double level;
+    };
+
+    // Charge the hold up to now, or up to end_time if HintManager ended the
+    // hint earlier, to its source and restart it from now
+    void SettleLocked(Hold *hold, std::chrono::steady_clock::time_point now,
+                      std::chrono::steady_clock::time_point end_time);
+    Hold *GetHoldLocked(HintId hint);
+
+    const std::shared_ptr<HintManager> hm_;
+    std::mutex lock_;
+    std::vector<Hold> holds_;
+    std::vector<bool> enabled_modes_;
+    std::array<SourceStats, static_cast<std::size_t>(BoostSource::COUNT)> stats_;
+};
+
+}  // namespace perfmgr
+}  // namespace android
+
+#endif  // ANDROID_LIBPERFMGR_BOOSTARBITER_H_
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBPERFMGR_CONFIGIMAGE_H_
+#define ANDROID_LIBPERFMGR_CONFIGIMAGE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "perfmgr/HintManager.h"
+#include "perfmgr/Node.h"
+
+namespace android {
+namespace perfmgr {
+
+// ConfigImage is a precompiled form of the powerhint JSON config, built
+// offline by perfmgr_config_verifier. It is a single mmap-able file with a
+// header, a string table and flat node, value, dependency, hint, node action,
+// hint action, ADPF and boost rule tables referring to each other by index.
+// The header records a hash of the JSON it was compiled from, so a stale
+// image is rejected and HintManager falls back to parsing JSON.
+class ConfigImage {
+  public:
+    // Return the image path used for config_path: ".json" replaced by ".bin".
+    static std::string GetImagePath(const std::string &config_path);
+
+    // Return the hash of a JSON config recorded in images compiled from it.
+    static uint64_t HashSource(const std::string &json_doc);
+
+    // Write nodes, actions, ADPF settings and boost policy parsed from
+    // json_doc to image_path. is_file tells FileNode from PropertyNode for
+    // each node. Return true on success.
+    static bool Write(const std::string &image_path, const std::string &json_doc,
+                      const std::vector<std::unique_ptr<Node>> &nodes,
+                      const std::vector<bool> &is_file,
+                      const std::unordered_map<std::string, Hint> &actions,
+                      const AdpfConfig &adpf, const BoostPolicy &boost_policy);
+
+    // Map image_path read-only and rebuild nodes, actions, ADPF settings and
+    // boost policy from it. Return false if image is missing, malformed or
+    // not compiled from json_doc.
+    static bool Load(const std::string &image_path, const std::string &json_doc,
+                     std::vector<std::unique_ptr<Node>> *nodes,
+                     std::unordered_map<std::string, Hint> *actions, AdpfConfig *adpf,
+                     BoostPolicy *boost_policy);
+
+  private:
+    ConfigImage() = delete;
+};
+
+}  // namespace perfmgr
+}  // namespace android
+
+#endif  // ANDROID_LIBPERFMGR_CONFIGIMAGE_H_
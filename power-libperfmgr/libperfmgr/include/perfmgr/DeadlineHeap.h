@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBPERFMGR_DEADLINEHEAP_H_
+#define ANDROID_LIBPERFMGR_DEADLINEHEAP_H_
+
+#include <chrono>
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace android {
+namespace perfmgr {
+
+// Min-heap of one deadline per key, indexed so a key's deadline can be
+// moved or removed in O(log n). Not thread safe.
+template <typename Key, typename TimePoint = std::chrono::steady_clock::time_point>
+class DeadlineHeap {
+  public:
+    using Entry = std::pair<TimePoint, Key>;
+
+    // Set the deadline of key, adding key if absent
+    void Update(const Key &key, TimePoint deadline) {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            index_.emplace(key, heap_.size());
+            heap_.emplace_back(deadline, key);
+            SiftUp(heap_.size() - 1);
+            return;
+        }
+        const std::size_t i = it->second;
+        const bool earlier = deadline < heap_[i].first;
+        heap_[i].first = deadline;
+        if (earlier) {
+            SiftUp(i);
+        } else {
+            SiftDown(i);
+        }
+    }
+
+    // Return false if key has no deadline
+    bool Remove(const Key &key) {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return false;
+        }
+        const std::size_t i = it->second;
+        index_.erase(it);
+        const std::size_t last = heap_.size() - 1;
+        if (i != last) {
+            heap_[i] = std::move(heap_[last]);
+            index_[heap_[i].second] = i;
+        }
+        heap_.pop_back();
+        if (i < heap_.size()) {
+            SiftUp(i);
+            SiftDown(i);
+        }
+        return true;
+    }
+
+    bool Contains(const Key &key) const { return index_.count(key) > 0; }
+    bool Empty() const { return heap_.empty(); }
+    std::size_t Size() const { return heap_.size(); }
+
+    // Soonest deadline, the heap must not be empty
+    const Entry &Top() const { return heap_.front(); }
+
+    // Remove the keys due at now, soonest first
+    void PopExpired(TimePoint now, std::vector<Key> *expired) {
+        while (!heap_.empty() && !(now < heap_.front().first)) {
+            Key key = heap_.front().second;
+            Remove(key);
+            expired->push_back(std::move(key));
+        }
+    }
+
+  private:
+    void Swap(std::size_t a, std::size_t b) {
+        std::swap(heap_[a], heap_[b]);
+        index_[heap_[a].second] = a;
+        index_[heap_[b].second] = b;
+    }
+
+    void SiftUp(std::size_t i) {
+        while (i > 0) {
+            const std::size_t parent = (i - 1) / 2;
+            if (!(heap_[i].first < heap_[parent].first)) {
+                break;
+            }
+            Swap(i, parent);
+            i = parent;
+        }
+    }
+
+    void SiftDown(std::size_t i) {
+        while (true) {
+            const std::size_t left = 2 * i + 1;
+            const std::size_t right = left + 1;
+            std::size_t smallest = i;
+            if (left < heap_.size() && heap_[left].first < heap_[smallest].first) {
+                smallest = left;
+            }
+            if (right < heap_.size() && heap_[right].first < heap_[smallest].first) {
+                smallest = right;
+            }
+            if (smallest == i) {
+                break;
+            }
+            Swap(i, smallest);
+            i = smallest;
+        }
+    }
+
+    std::vector<Entry> heap_;
+    std::unordered_map<Key, std::size_t> index_;
+};
+
+}  // namespace perfmgr
+}  // namespace android
+
+#endif  // ANDROID_LIBPERFMGR_DEADLINEHEAP_H_
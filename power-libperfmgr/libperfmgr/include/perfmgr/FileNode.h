@@ -37,6 +37,11 @@ class FileNode : public Node {
 
     std::chrono::milliseconds Update(bool log_error) override;
 
+    // A hold_fd node also takes over the fd held by old, so the value stays
+    // in effect across the takeover.
+    bool MigrateFrom(Node* old) override;
+    android::base::unique_fd ReleaseHeldFd() override;
+
     bool GetHoldFd() const;
 
     void DumpToFd(int fd) const override;
@@ -45,7 +50,17 @@ class FileNode : public Node {
     FileNode(const Node& other) = delete;
     FileNode& operator=(Node const&) = delete;
 
+    // Open node_path_ into fd_ if it is not already open; return false on
+    // failure.
+    bool OpenFd();
+    // Write value at offset 0 through the cached fd_; on failure fd_ is
+    // released so that the next Update() reopens the node.
+    bool WriteValue(const std::string& value);
+
     const bool hold_fd_;
+    // fd_ is a regular file outside sysfs/procfs/cgroupfs, which needs
+    // truncation and fsync after a write; set when fd_ is opened.
+    bool is_plain_file_;
     const std::chrono::milliseconds warn_timeout_;
     android::base::unique_fd fd_;
 };
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBPERFMGR_HINTID_H_
+#define ANDROID_LIBPERFMGR_HINTID_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace android {
+namespace perfmgr {
+
+// Dense integer id of a hint name, shared by HintManager, NodeLooperThread,
+// Node and RequestGroup so that the hint path does not hash or compare
+// strings.
+using HintId = uint32_t;
+
+// HintIdRegistry interns hint names into HintIds. Ids start at 0 and are never
+// released, so they can index flat per-hint arrays. Interning is expected at
+// config load; the registry is thread safe.
+class HintIdRegistry {
+  public:
+    // Return the id of name, assigning the next free id on first use.
+    static HintId Intern(const std::string &name);
+    // Look up the id of an already interned name without assigning one.
+    // Return false if name is unknown.
+    static bool Find(const std::string &name, HintId *id);
+    // Return the name of id, or an empty string for an unknown id.
+    static const std::string &GetName(HintId id);
+    // Return the number of ids assigned so far.
+    static std::size_t Size();
+
+  private:
+    HintIdRegistry() = delete;
+};
+
+}  // namespace perfmgr
+}  // namespace android
+
+#endif  // ANDROID_LIBPERFMGR_HINTID_H_
@@ -18,8 +18,11 @@
 #define ANDROID_LIBPERFMGR_HINTMANAGER_H_
 
 #include <atomic>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -27,15 +30,29 @@
 #include <utility>
 #include <vector>
 
+#include "perfmgr/AdpfConfig.h"
+#include "perfmgr/BoostArbiter.h"
+#include "perfmgr/HintId.h"
+#include "perfmgr/LatencyHistogram.h"
 #include "perfmgr/NodeLooperThread.h"
 
+namespace Json {
+class Value;
+}  // namespace Json
+
 namespace android {
 namespace perfmgr {
 
 struct HintStats {
-    HintStats() : count(0), duration_ms(0) {}
+    HintStats() : count(0), duration_ms(0), shadowed(0) {}
     uint32_t count;
     uint64_t duration_ms;
+    // DoHint to values written on the nodes, see HintApplyStats
+    LatencySummary apply_latency;
+    // time to write each node
+    LatencySummary write_latency;
+    // node requests shadowed by a higher priority value on the node
+    uint64_t shadowed;
 };
 
 struct HintStatus {
@@ -53,37 +70,47 @@ struct HintStatus {
         std::atomic<uint32_t> count;
         std::atomic<uint64_t> duration_ms;
     } stats;
+    // filled by NodeLooperThread
+    HintApplyStats apply_stats;
 };
 
 enum class HintActionType { Node, DoHint, EndHint, MaskHint };
 
 struct HintAction {
-    HintAction(HintActionType t, const std::string &v) : type(t), value(v) {}
+    HintAction(HintActionType t, const std::string &v)
+        : type(t), value(v), value_id(HintIdRegistry::Intern(v)) {}
     HintActionType type;
     std::string value;
+    HintId value_id;
 };
 
 struct Hint {
-    Hint() : enabled(true) {}
+    static constexpr std::size_t kNoActionsId = std::numeric_limits<std::size_t>::max();
+    Hint() : enabled(true), id(0), actions_id(kNoActionsId), level(0) {}
     std::vector<NodeAction> node_actions;
     std::vector<HintAction> hint_actions;
     // No locking for `enabled' flag
     // There should not be multiple writers
     bool enabled;
     std::shared_ptr<HintStatus> status;
+    // Interned id of the hint name, assigned by HintManager
+    HintId id;
+    // id of node_actions registered with NodeLooperThread
+    std::size_t actions_id;
+    // NodeLooperThread::GetActionsLevel of node_actions
+    double level;
 };
 
 // HintManager is the external interface of the library to be used by PowerHAL
 // to do power hints with sysfs nodes. HintManager maintains a representation of
 // the actions that are parsed from the configuration file as a mapping from a
 // PowerHint to the set of actions that are performed for that PowerHint.
+// Hint names are interned into HintIds on construction; the string based
+// methods are a lookup layer on top of the HintId based ones.
 class HintManager {
   public:
-    HintManager(sp<NodeLooperThread> nm, const std::unordered_map<std::string, Hint> &actions)
-        : nm_(std::move(nm)), actions_(actions) {}
-    ~HintManager() {
-        if (nm_.get() != nullptr) nm_->Stop();
-    }
+    HintManager(sp<NodeLooperThread> nm, const std::unordered_map<std::string, Hint> &actions);
+    ~HintManager();
 
     // Return true if the sysfs manager thread is running.
     bool IsRunning() const;
@@ -103,21 +130,70 @@ class HintManager {
     // NodeLooperThread::Cancel succeeds; otherwise return false.
     bool EndHint(const std::string& hint_type);
 
+    // HintId variants of the above, use GetHintId() to resolve the id once.
+    bool DoHint(HintId hint_id);
+    bool DoHint(HintId hint_id, std::chrono::milliseconds timeout_ms_override);
+    bool EndHint(HintId hint_id);
+
+    // Resolve hint_type into its HintId. Return false if hint not supported.
+    bool GetHintId(const std::string &hint_type, HintId *hint_id) const;
+
     // Query if given hint supported.
     bool IsHintSupported(const std::string& hint_type) const;
+    bool IsHintSupported(HintId hint_id) const;
+
+    // Return the timeout of hint_id (0 for forever) and its level, the sum
+    // over its nodes of how far the requested value is above the default in
+    // [0, 1]. Return false if hint not supported.
+    bool GetHintInfo(HintId hint_id, std::chrono::milliseconds *timeout, double *level) const;
+
+    // Return when the last request of hint_id ends, time_point::max() for
+    // forever and a past time if it is not held, and whether hint_id is
+    // enabled, i.e. not masked. Return false if hint not supported.
+    bool GetHintEndTime(HintId hint_id, std::chrono::steady_clock::time_point *end_time,
+                        bool *enabled) const;
 
     // Query if given hint enabled.
     bool IsHintEnabled(const std::string &hint_type) const;
 
-    // Static method to construct HintManager from the JSON config file.
+    // Static method to construct HintManager from the JSON config file. The
+    // precompiled image at ConfigImage::GetImagePath(config_path) is used
+    // instead of parsing JSON when it matches the config.
     static std::unique_ptr<HintManager> GetFromJSON(
         const std::string& config_path, bool start = true);
 
+    // Parse config_path and swap it in as the new config. Calls in flight
+    // finish on the old config before its requests are taken over; requests
+    // on nodes present in both configs are migrated, including fds held open
+    // by hold_fd nodes, and removed nodes are reset to their default values.
+    // Hint stats and masks carry over by hint name. Return false and keep the
+    // current config if config_path is invalid, or if calls on the current
+    // config do not finish in time; requests made on the new config in the
+    // meantime are dropped then.
+    bool Reload(const std::string &config_path);
+
+    // Return the config path HintManager was last loaded from.
+    std::string GetConfigPath() const;
+
+    // Static method to verify the JSON config and compile it to image_path.
+    static bool CompileConfig(const std::string &config_path, const std::string &image_path);
+
     // Return available hints managed by HintManager
     std::vector<std::string> GetHints() const;
 
     // Return stats of hints managed by HintManager
     HintStats GetHintStats(const std::string &hint_type) const;
+    // Return HintStats of all hints ordered by hint name
+    std::map<std::string, HintStats> GetAllHintStats() const;
+
+    // Return ADPF settings of the current config, never nullptr
+    std::shared_ptr<const AdpfConfig> GetAdpfConfig() const;
+
+    // Return boost arbitration settings of the current config, never nullptr
+    std::shared_ptr<const BoostPolicy> GetBoostPolicy() const;
+
+    // Return latency distribution of DoHint calls
+    const LatencyHistogram &GetDoHintLatency() const;
 
     // Dump internal status to fd
     void DumpToFd(int fd);
@@ -126,26 +202,97 @@ class HintManager {
     bool Start();
 
   protected:
+    // Read nodes, actions, ADPF and boost arbitration settings from the image
+    // of config_path. Only if the image is missing, stale or malformed, parse
+    // the JSON of config_path instead.
+    static bool LoadConfigFile(const std::string &config_path,
+                               std::vector<std::unique_ptr<Node>> *nodes,
+                               std::unordered_map<std::string, Hint> *actions,
+                               std::shared_ptr<const AdpfConfig> *adpf,
+                               std::shared_ptr<const BoostPolicy> *boost_policy);
+    // Section parsers take the root of the parsed JSON config, the json_doc
+    // overloads parse the document first.
     static std::vector<std::unique_ptr<Node>> ParseNodes(
         const std::string& json_doc);
+    static std::vector<std::unique_ptr<Node>> ParseNodes(const Json::Value &root);
     static std::unordered_map<std::string, Hint> ParseActions(
             const std::string &json_doc, const std::vector<std::unique_ptr<Node>> &nodes);
+    static std::unordered_map<std::string, Hint> ParseActions(
+            const Json::Value &root, const std::vector<std::unique_ptr<Node>> &nodes);
+    // Parse the optional AdpfConfig section. Return false if it is malformed.
+    static bool ParseAdpfConfig(const std::string &json_doc, AdpfConfig *config);
+    static bool ParseAdpfConfig(const Json::Value &root, AdpfConfig *config);
+    // Parse the optional BoostArbiter section. Return false if it is malformed.
+    static bool ParseBoostPolicy(const std::string &json_doc, BoostPolicy *policy);
+    static bool ParseBoostPolicy(const Json::Value &root, BoostPolicy *policy);
     static bool InitHintStatus(const std::unique_ptr<HintManager> &hm);
 
   private:
+    using HintEntry = std::unordered_map<std::string, Hint>::value_type;
+
+    // Nodes and hints of one config. Reload() publishes a new HintConfig with
+    // an atomic pointer swap; every call works on the snapshot it loaded.
+    struct HintConfig {
+        sp<NodeLooperThread> nm;
+        std::unordered_map<std::string, Hint> actions;
+        // entries of actions indexed by HintId, nullptr for ids not in actions
+        std::vector<HintEntry *> hints;
+        std::shared_ptr<const AdpfConfig> adpf;
+        std::shared_ptr<const BoostPolicy> boost_policy;
+    };
+    // Set once config_ no longer holds a published config and every call
+    // that loaded it has returned.
+    struct ConfigRelease {
+        std::mutex mutex;
+        std::condition_variable cond;
+        bool released = false;
+    };
+
     HintManager(HintManager const&) = delete;
     void operator=(HintManager const&) = delete;
-    bool ValidateHint(const std::string& hint_type) const;
+    static std::shared_ptr<HintConfig> MakeConfig(
+            sp<NodeLooperThread> nm, const std::unordered_map<std::string, Hint> &actions,
+            std::shared_ptr<const AdpfConfig> adpf = std::make_shared<const AdpfConfig>(),
+            std::shared_ptr<const BoostPolicy> boost_policy =
+                    std::make_shared<const BoostPolicy>());
+    static void InitHintStatus(HintConfig *config);
+    // Return the pointer to store in config_ for config, which signals
+    // release when the last copy of it is dropped.
+    static std::shared_ptr<HintConfig> Publish(std::shared_ptr<HintConfig> config,
+                                               std::shared_ptr<ConfigRelease> release);
+    // Let the looper of config collect HintApplyStats into the hint status.
+    static void RegisterApplyStats(const HintConfig &config);
+    std::shared_ptr<HintConfig> LoadConfig() const;
+    bool ValidateHint(const HintConfig &config, const std::string &hint_type) const;
+    // Return the hint entry of hint_id, or nullptr if not supported.
+    HintEntry *GetHintEntry(const HintConfig &config, HintId hint_id) const;
+    bool DoHint(const HintConfig &config, HintId hint_id,
+                std::chrono::milliseconds timeout_ms_override);
+    bool EndHint(const HintConfig &config, HintId hint_id);
     // Helper function to update the HintStatus when DoHint
-    void DoHintStatus(const std::string &hint_type, std::chrono::milliseconds timeout_ms);
+    void DoHintStatus(HintEntry *entry, std::chrono::milliseconds timeout_ms);
     // Helper function to update the HintStatus when EndHint
-    void EndHintStatus(const std::string &hint_type);
+    void EndHintStatus(HintEntry *entry);
     // Helper function to take hint actions when DoHint
-    void DoHintAction(const std::string &hint_type);
+    void DoHintAction(const HintConfig &config, HintEntry *entry);
     // Helper function to take hint actions when EndHint
-    void EndHintAction(const std::string &hint_type);
-    sp<NodeLooperThread> nm_;
-    std::unordered_map<std::string, Hint> actions_;
+    void EndHintAction(const HintConfig &config, HintEntry *entry);
+    // Helper function to submit node actions to NodeLooperThread when DoHint
+    bool SubmitRequest(const HintConfig &config, HintEntry *entry,
+                       std::chrono::milliseconds timeout_override);
+    // owner of the current config and release of its published pointer,
+    // reload_mutex_ held
+    std::shared_ptr<HintConfig> owned_config_;
+    std::shared_ptr<ConfigRelease> config_release_;
+    // current config, only accessed through std::atomic_load/atomic_store
+    std::shared_ptr<HintConfig> config_;
+    // serializes Reload()
+    std::mutex reload_mutex_;
+    // protects config_path_, never held while waiting for calls
+    mutable std::mutex path_mutex_;
+    std::string config_path_;
+    // duration of DoHint calls
+    LatencyHistogram do_hint_latency_;
 };
 
 }  // namespace perfmgr
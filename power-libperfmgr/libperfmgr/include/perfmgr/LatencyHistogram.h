@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBPERFMGR_LATENCYHISTOGRAM_H_
+#define ANDROID_LIBPERFMGR_LATENCYHISTOGRAM_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace android {
+namespace perfmgr {
+
+// Copyable digest of a LatencyHistogram.
+struct LatencySummary {
+    LatencySummary() : count(0), p50(0), p99(0) {}
+    uint64_t count;
+    std::chrono::nanoseconds p50;
+    std::chrono::nanoseconds p99;
+};
+
+// LatencyHistogram is a lock-free log-linear histogram of durations in
+// nanoseconds. Each power of 2 range is split into 8 linear buckets, so a
+// reported percentile is within 12.5% of the recorded value. Record() may be
+// called concurrently from any thread.
+class LatencyHistogram {
+  public:
+    LatencyHistogram();
+
+    void Record(std::chrono::nanoseconds duration);
+    // Return the number of recorded durations.
+    uint64_t Count() const;
+    // Return the upper bound of the bucket holding the given percentile
+    // (0-100), or zero if nothing recorded.
+    std::chrono::nanoseconds Percentile(double percentile) const;
+    // Return count, P50 and P99.
+    LatencySummary Summary() const;
+
+  private:
+    LatencyHistogram(LatencyHistogram const &) = delete;
+    void operator=(LatencyHistogram const &) = delete;
+
+    static constexpr int kSubBucketBits = 3;
+    static constexpr std::size_t kSubBuckets = 1 << kSubBucketBits;
+    static constexpr std::size_t kNumBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+    static std::size_t BucketIndex(uint64_t value);
+    static uint64_t BucketUpperBound(std::size_t index);
+
+    std::array<std::atomic<uint64_t>, kNumBuckets> buckets_;
+    std::atomic<uint64_t> count_;
+};
+
+}  // namespace perfmgr
+}  // namespace android
+
+#endif  // ANDROID_LIBPERFMGR_LATENCYHISTOGRAM_H_
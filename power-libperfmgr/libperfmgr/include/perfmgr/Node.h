@@ -49,10 +49,13 @@ class Node {
     virtual ~Node() {}
 
     // Return true if successfully add a request
+    bool AddRequest(std::size_t value_index, HintId hint_id, ReqTime end_time);
+    // hint_type has to be interned already, unknown names are rejected
     bool AddRequest(std::size_t value_index, const std::string& hint_type,
                     ReqTime end_time);
 
     // Return true if successfully remove a request
+    bool RemoveRequest(HintId hint_id);
     bool RemoveRequest(const std::string& hint_type);
 
     // Return the nearest expire time of active requests; return
@@ -65,8 +68,38 @@ class Node {
     const std::string& GetPath() const;
     std::vector<std::string> GetValues() const;
     std::size_t GetDefaultIndex() const;
+    // Index of the value last written to the node.
+    std::size_t GetCurrentIndex() const;
     bool GetResetOnInit() const;
     bool GetValueIndex(const std::string& value, std::size_t* index) const;
+    // Names of nodes that must be re-evaluated together with this node, e.g.
+    // cpufreq min/max pair where one write may fail until the other lands.
+    const std::vector<std::string>& GetDependsOn() const;
+    void SetDependsOn(std::vector<std::string> depends_on);
+    // Name of the write group of this node; nodes in different groups may be
+    // written concurrently, empty for the default group.
+    const std::string& GetWriteGroup() const;
+    void SetWriteGroup(std::string write_group);
+    // Take over the active requests of old, the node of the same name in a
+    // previous config, and its current value if old controls the same path.
+    // Return true if the current value was taken over.
+    virtual bool MigrateFrom(Node* old);
+    // Release the fd kept open to hold the current value, if any, for the
+    // node taking over from this one.
+    virtual android::base::unique_fd ReleaseHeldFd() { return {}; }
+    // Remove all requests so that next Update() sets the default value.
+    void ClearRequests();
+    // Size the requests of every value for hint ids below num_hints.
+    void ReserveRequests(std::size_t num_hints);
+    // Defer writes of Update() until Flush(); ignored by nodes always writing
+    // in Update().
+    virtual void SetBatchWrites(bool) {}
+    // Write the value deferred by Update(), if any. Return when to retry a
+    // failed write like Update() does, std::chrono::milliseconds::max()
+    // otherwise.
+    virtual std::chrono::milliseconds Flush() {
+        return std::chrono::milliseconds::max();
+    }
     virtual void DumpToFd(int fd) const = 0;
 
   protected:
@@ -84,6 +117,8 @@ class Node {
     // node will be explicitly initialized when first time called Update().
     bool reset_on_init_;
     std::size_t current_val_index_;
+    std::vector<std::string> depends_on_;
+    std::string write_group_;
 };
 
 }  // namespace perfmgr
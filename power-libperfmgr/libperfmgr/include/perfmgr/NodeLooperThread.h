@@ -19,13 +19,19 @@
 
 #include <utils/Thread.h>
 
+#include <atomic>
 #include <cstddef>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "perfmgr/LatencyHistogram.h"
 #include "perfmgr/Node.h"
+#include "perfmgr/NodeWriterPool.h"
+#include "perfmgr/RequestQueue.h"
 
 namespace android {
 namespace perfmgr {
@@ -43,6 +49,18 @@ struct NodeAction {
     std::chrono::milliseconds timeout_ms;  // 0ms for forever
 };
 
+// Effect of the requests of one hint, filled by the looper after the nodes of
+// a request are written:
+struct HintApplyStats {
+    HintApplyStats() : shadowed(0) {}
+    // request to value landing on all its nodes, once per request
+    LatencyHistogram apply_latency;
+    // time to write each node of a request
+    LatencyHistogram write_latency;
+    // node requests without effect as a higher priority value held the node
+    std::atomic<uint64_t> shadowed;
+};
+
 // The NodeLooperThread is responsible for managing each of the sysfs nodes
 // specified in the configuration. At initialization, the NodeLooperThrea holds
 // a vector containing the nodes defined in the configuration. The NodeManager
@@ -51,10 +69,17 @@ struct NodeAction {
 // decides how to apply the requests. The NodeLooperThread contains a ThreadLoop
 // to maintain the sysfs nodes, and that thread is woken up both to handle
 // powerhint requests and when the timeout expires for an in-progress powerhint.
+// Action lists registered with RegisterActions() can be submitted through a
+// lock-free queue, so callers never wait on lock_ which is held while nodes
+// are written; the looper drains the queue before updating nodes.
+// By default only nodes touched by Request/Cancel, nodes whose requests expire,
+// and their declared dependencies are updated on each wake up. The legacy
+// behaviour of updating every node twice is kept as a fallback when
+// full_update is set.
 class NodeLooperThread : public ::android::Thread {
   public:
-    explicit NodeLooperThread(std::vector<std::unique_ptr<Node>> nodes)
-        : Thread(false), nodes_(std::move(nodes)) {}
+    explicit NodeLooperThread(std::vector<std::unique_ptr<Node>> nodes,
+                              bool full_update = false);
     virtual ~NodeLooperThread() { Stop(); }
 
     // Need call Stop() as the threadloop will hold a strong pointer
@@ -65,14 +90,45 @@ class NodeLooperThread : public ::android::Thread {
     // Return true when successfully adds request from actions for the hint_type
     // in each individual node. Return false if any of the actions has either
     // invalid node index or value index.
+    bool Request(const std::vector<NodeAction>& actions, HintId hint_id);
+    // hint_type has to be interned already, unknown names are rejected
     bool Request(const std::vector<NodeAction>& actions,
                  const std::string& hint_type);
     // Return when successfully cancels request from actions for the hint_type
     // in each individual node. Return false if any of the actions has invalid
     // node index.
+    bool Cancel(const std::vector<NodeAction>& actions, HintId hint_id);
     bool Cancel(const std::vector<NodeAction>& actions,
                 const std::string& hint_type);
 
+    // Register an action list for SubmitRequest/SubmitCancel and return its
+    // id in actions_id. Return false if any of the actions has either invalid
+    // node index or value index.
+    bool RegisterActions(const std::vector<NodeAction>& actions,
+                         std::size_t* actions_id);
+    // Queue request of a registered action list and return without waiting
+    // for lock_. timeout_override replaces the timeout of every action unless
+    // it is QueuedRequest::kNoOverride. Falls back to Request() when the queue
+    // is full. Return false for invalid actions_id or exiting thread.
+    bool SubmitRequest(std::size_t actions_id, HintId hint_id,
+                       std::chrono::milliseconds timeout_override =
+                               QueuedRequest::kNoOverride);
+    // Queue cancel of a registered action list, see SubmitRequest.
+    bool SubmitCancel(std::size_t actions_id, HintId hint_id);
+
+    // Return the sum over actions of how far the requested value is above
+    // the default value of its node, each in [0, 1].
+    double GetActionsLevel(const std::vector<NodeAction>& actions) const;
+
+    // Take over requests from old, the looper of a previous config, before
+    // Start(). Nodes are matched by name; nodes of old not present here are
+    // reset to their default values. old must be stopped.
+    void MigrateFrom(const sp<NodeLooperThread>& old);
+
+    // Collect apply latency and shadowed requests of hint_id into stats,
+    // nullptr stops collecting.
+    void SetHintStats(HintId hint_id, std::shared_ptr<HintApplyStats> stats);
+
     // Dump all nodes to fd
     void DumpToFd(int fd);
 
@@ -83,18 +139,119 @@ class NodeLooperThread : public ::android::Thread {
     NodeLooperThread(NodeLooperThread const&) = delete;
     void operator=(NodeLooperThread const&) = delete;
     bool threadLoop() override;
+    // Queue a request and wake up looper, fall back to apply it directly
+    // when the queue is full.
+    bool Submit(const QueuedRequest& request);
+    // Apply requests of actions to nodes with end time counted from now,
+    // lock_ held.
+    bool ApplyRequest(const std::vector<NodeAction>& actions, HintId hint_id,
+                      ReqTime now, std::chrono::milliseconds timeout_override);
+    // Cancel requests of actions from nodes, lock_ held.
+    bool ApplyCancel(const std::vector<NodeAction>& actions, HintId hint_id);
+    // Apply all queued requests, lock_ held.
+    void DrainQueue();
+    // Wake up the looper if it is waiting, safe to call without lock_.
+    void Wake();
+    // Mark node and its dependencies to be updated in next loop, lock_ held.
+    void MarkDirty(std::size_t node_index);
+    // Size the requests of all nodes for the hint ids interned so far, so
+    // DoHint does not allocate; lock_ held or not started yet.
+    void ReserveRequests();
+    // Update nodes, dispatching different write groups to writer_pool_, flush
+    // deferred writes and store the result of each node in
+    // node_update_expire_.
+    void UpdateNodes(const std::vector<std::size_t>& node_indices);
+    // Update nodes of each write group on writer_pool_ and join.
+    void DispatchNodeGroups(const std::vector<std::size_t>& node_indices);
+    // Update nodes of one write group twice in order.
+    void UpdateNodeGroup(const std::vector<std::size_t>& node_indices);
+    // Record the effect of requests in pending_applies_ after their nodes
+    // were updated, lock_ held.
+    void RecordApplyStats();
+    // Update all nodes twice and return the nearest expire time.
+    std::chrono::milliseconds UpdateAllNodes();
+    // Update dirty and expired nodes and return the nearest expire time.
+    std::chrono::milliseconds UpdateDirtyNodes();
+    // Set next expire time of node in the deadline heap, ReqTime::max()
+    // removes the node from the heap.
+    void SetNodeDeadline(std::size_t node_index, ReqTime deadline);
+    // Pop nodes whose deadline is not after now from the heap and mark them
+    // dirty.
+    void PopExpiredNodes(ReqTime now);
+    void HeapSwap(std::size_t a, std::size_t b);
+    void HeapSiftUp(std::size_t pos);
+    void HeapSiftDown(std::size_t pos);
+    void HeapRemove(std::size_t pos);
 
     static constexpr auto kMaxUpdatePeriod = std::chrono::milliseconds::max();
+    static constexpr std::size_t kRequestQueueSize = 256;
+    static constexpr std::size_t kMaxWriterThreads = 3;
+    // bound of pending_applies_ while the looper is not running
+    static constexpr std::size_t kMaxPendingApplies = 1024;
 
     std::vector<std::unique_ptr<Node>> nodes_;  // parsed from Config
 
+    // fallback to update all nodes in every loop
+    const bool full_update_;
+    // node indices to be updated together, resolved from Node::GetDependsOn
+    std::vector<std::vector<std::size_t>> node_deps_;
+    // nodes pending update and membership flags
+    std::vector<std::size_t> dirty_nodes_;
+    std::vector<bool> node_dirty_;
+    // next expire time of each node as returned by its last Update()
+    std::vector<ReqTime> node_expire_;
+    // indexed min-heap of node indices keyed by node_expire_, and position of
+    // each node in the heap (kNotInHeap if no pending deadline)
+    static constexpr std::size_t kNotInHeap = std::numeric_limits<std::size_t>::max();
+    std::vector<std::size_t> deadline_heap_;
+    std::vector<std::size_t> heap_pos_;
+
+    // write group of each node, 0 being the default group; nodes with
+    // dependencies always share a group
+    std::vector<std::size_t> node_group_;
+    // per-group scratch list of nodes to update and groups with any of them
+    std::vector<std::vector<std::size_t>> group_nodes_;
+    std::vector<std::size_t> busy_groups_;
+    // result of the last Update(true) of each node
+    std::vector<std::chrono::milliseconds> node_update_expire_;
+    // workers for write groups, null if all nodes are in one group
+    std::unique_ptr<NodeWriterPool> writer_pool_;
+    std::function<void(std::size_t)> update_group_task_;
+
+    // request of a node waiting for its update, for hints with stats
+    struct PendingApply {
+        HintId hint_id;
+        std::size_t node_index;
+        std::size_t value_index;
+        ReqTime request_time;
+    };
+    // stats of each hint indexed by HintId, null if not collected
+    std::vector<std::shared_ptr<HintApplyStats>> hint_stats_;
+    std::vector<PendingApply> pending_applies_;
+    // time spent writing each node in the current loop
+    std::vector<std::chrono::nanoseconds> node_write_time_;
+
+    // action lists registered for SubmitRequest/SubmitCancel
+    std::vector<std::vector<NodeAction>> action_lists_;
+    std::atomic<std::size_t> num_action_lists_;
+    // hint ids the requests of nodes_ are sized for
+    std::size_t reserved_hints_;
+    // requests submitted without holding lock_
+    RequestQueue queue_;
+    // set while the looper is waiting on wake_cond_
+    std::atomic<bool> waiting_;
+    // set by Wake() for changes not yet handled by the looper
+    std::atomic<bool> wake_pending_;
+
     // conditional variable from C++ standard library can be affected by wall
     // time change as it is using CLOCK_REAL (b/35756266). The component should
     // not be impacted by wall time, thus need use Android specific Condition
     // class for waking up threadloop.
     ::android::Condition wake_cond_;
+    // lock for wake_cond_, never held while writing nodes
+    ::android::Mutex wake_lock_;
 
-    // lock to protect nodes_
+    // lock to protect nodes_ and action_lists_
     ::android::Mutex lock_;
 };
 
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBPERFMGR_NODEWRITERPOOL_H_
+#define ANDROID_LIBPERFMGR_NODEWRITERPOOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace perfmgr {
+
+// Small fork-join pool used by NodeLooperThread to write independent groups
+// of nodes concurrently. The calling thread runs tasks as well, so a pool of
+// N threads executes up to N + 1 tasks at once.
+class NodeWriterPool {
+  public:
+    explicit NodeWriterPool(std::size_t num_threads);
+    ~NodeWriterPool();
+
+    // Run task(0) ... task(num_tasks - 1) and return once all have finished.
+    // Must not be called concurrently.
+    void Run(std::size_t num_tasks, const std::function<void(std::size_t)>& task);
+
+    std::size_t GetNumThreads() const;
+
+  private:
+    NodeWriterPool(NodeWriterPool const&) = delete;
+    void operator=(NodeWriterPool const&) = delete;
+
+    void WorkerLoop();
+    // Run tasks until none is left to start, mutex_ held by lock on entry
+    // and exit.
+    void RunTasks(std::unique_lock<std::mutex>* lock);
+
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    // signaled when new tasks are posted or on exit
+    std::condition_variable work_cond_;
+    // signaled when the last running task finishes
+    std::condition_variable done_cond_;
+    const std::function<void(std::size_t)>* task_;
+    std::size_t num_tasks_;
+    std::size_t next_task_;
+    std::size_t pending_tasks_;
+    bool exit_;
+};
+
+}  // namespace perfmgr
+}  // namespace android
+
+#endif  // ANDROID_LIBPERFMGR_NODEWRITERPOOL_H_
@@ -18,6 +18,7 @@
 #define ANDROID_LIBPERFMGR_PROPERTYNODE_H_
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -35,11 +36,39 @@ class PropertyNode : public Node {
 
     std::chrono::milliseconds Update(bool log_error) override;
 
+    bool MigrateFrom(Node* old) override;
+
+    // In batch mode Update() only records the value to write, and Flush()
+    // sets the property once per round of updates. This collapses the
+    // multiple Update() passes of a looper iteration into one IPC.
+    void SetBatchWrites(bool batch) override;
+    std::chrono::milliseconds Flush() override;
+
+    // Number of property writes done, and of batched writes dropped as the
+    // value changed back before Flush().
+    uint64_t GetFlushedWrites() const;
+    uint64_t GetSuppressedWrites() const;
+
     void DumpToFd(int fd) const override;
 
   private:
     PropertyNode(const Node& other) = delete;
     PropertyNode& operator=(Node const&) = delete;
+
+    static constexpr std::size_t kNoPending = SIZE_MAX;
+    static constexpr std::chrono::milliseconds kRetryTimeout{500};
+
+    // Set property to the value of value_index, return false on failure.
+    bool WriteValue(std::size_t value_index);
+
+    bool batch_writes_;
+    // value index recorded by Update() in batch mode
+    std::size_t pending_val_index_;
+    // last value set successfully, served to DumpToFd without IPC; empty
+    // before the first write
+    std::string last_written_value_;
+    uint64_t flushed_writes_;
+    uint64_t suppressed_writes_;
 };
 
 }  // namespace perfmgr
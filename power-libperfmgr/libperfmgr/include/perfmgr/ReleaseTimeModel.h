@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBPERFMGR_RELEASETIMEMODEL_H_
+#define ANDROID_LIBPERFMGR_RELEASETIMEMODEL_H_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace android {
+namespace perfmgr {
+
+// ReleaseTimeModel learns how long a boost has to outlast the duration asked
+// for until the device settles, from a window of recent boosts. The learned
+// overshoot is the shortest one that would have covered all but miss_budget
+// of them. Not thread safe.
+class ReleaseTimeModel {
+  public:
+    static constexpr std::size_t kWindow = 64;
+    // boosts recorded before the learned duration is used
+    static constexpr std::size_t kMinSamples = 16;
+
+    struct Stats {
+        Stats() : boosts(0), misses(0), held(0), static_held(0) {}
+        uint64_t boosts;
+        // boosts released before the device settled
+        uint64_t misses;
+        // time boosted, and the time the static duration would have boosted
+        std::chrono::milliseconds held;
+        std::chrono::milliseconds static_held;
+    };
+
+    // miss_budget is the fraction (0-1) of boosts allowed to be released
+    // before the device settles.
+    explicit ReleaseTimeModel(double miss_budget);
+
+    // Record one boost that asked for requested and was held for at most
+    // applied, where static_duration is what the static policy would have
+    // used. If settled, settle is when the device settled, otherwise a lower
+    // bound of it, e.g. the time observation stopped.
+    void Record(std::chrono::milliseconds settle, bool settled,
+                std::chrono::milliseconds requested, std::chrono::milliseconds applied,
+                std::chrono::milliseconds static_duration);
+
+    // Return requested plus the learned overshoot, at most static_duration.
+    // Return static_duration until kMinSamples boosts are recorded, or when
+    // more than miss_budget of the window did not settle.
+    std::chrono::milliseconds Duration(std::chrono::milliseconds requested,
+                                       std::chrono::milliseconds static_duration) const;
+
+    // Learned overshoot, if any
+    std::optional<std::chrono::milliseconds> Overshoot() const { return overshoot_; }
+    std::size_t Samples() const { return size_; }
+    const Stats &GetStats() const { return stats_; }
+
+  private:
+    struct Sample {
+        std::chrono::milliseconds overshoot;
+        bool settled;
+    };
+
+    void Learn();
+
+    const double miss_budget_;
+    std::array<Sample, kWindow> window_;
+    std::size_t next_;
+    std::size_t size_;
+    std::optional<std::chrono::milliseconds> overshoot_;
+    Stats stats_;
+};
+
+}  // namespace perfmgr
+}  // namespace android
+
+#endif  // ANDROID_LIBPERFMGR_RELEASETIMEMODEL_H_
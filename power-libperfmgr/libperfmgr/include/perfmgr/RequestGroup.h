@@ -18,9 +18,11 @@
 #define ANDROID_LIBPERFMGR_REQUESTGROUP_H_
 
 #include <chrono>
-#include <map>
 #include <string>
 #include <utility>
+#include <vector>
+
+#include "perfmgr/HintId.h"
 
 namespace android {
 namespace perfmgr {
@@ -32,33 +34,60 @@ using ReqTime = std::chrono::time_point<std::chrono::steady_clock>;
 // add requests, a function to remove requests, and a function to check for the
 // next expiration time if there is an outstanding request, and a function to
 // check the requested value. There may only be one request per PowerHint, so
-// the representation is simple: a map from PowerHint to the expiration time for
-// that hint.
+// the representation is simple: a flat array indexed by HintId holding the
+// expiration time for that hint. The string overloads look the hint name up
+// in HintIdRegistry.
 class RequestGroup {
   public:
     RequestGroup(const std::string &request_value)  // NOLINT(runtime/explicit)
-        : request_value_(request_value) {}
+        : request_value_(request_value),
+          active_count_(0),
+          earliest_end_time_(ReqTime::max()),
+          earliest_valid_(true) {}
 
-    // Remove expired request in the map and return true when request_map_ is
-    // not empty, false when request_map_ is empty; also update expire_time with
-    // nearest timeout in request_map_ or std::chrono::milliseconds::max() when
-    // request_map_ is empty.
+    // Remove expired request and return true when there is active request,
+    // false otherwise; also update expire_time with nearest timeout of active
+    // requests or std::chrono::milliseconds::max() when there is none.
     bool GetExpireTime(std::chrono::milliseconds* expire_time);
     // Return the request value.
     const std::string& GetRequestValue() const;
     // Return true for adding request, false for extending expire time of
-    // existing active request on given hint_type.
+    // existing active request on given hint_type. If request exits and the new
+    // end_time is less than the active time, expire time will not be updated;
+    // also returns false.
+    bool AddRequest(HintId hint_id, ReqTime end_time);
+    // hint_type has to be interned already, unknown names are rejected
     bool AddRequest(const std::string& hint_type, ReqTime end_time);
     // Return true for removing request, false if request is not active on given
-    // hint_type. If request exits and the new end_time is less than the active
-    // time, expire time will not be updated; also returns false.
+    // hint_type.
+    bool RemoveRequest(HintId hint_id);
     bool RemoveRequest(const std::string& hint_type);
+    // Add all active requests of other, keeping the later end time of
+    // requests present in both.
+    void MergeRequests(const RequestGroup& other);
+    // Remove all requests.
+    void ClearRequests();
+    // Size the request slots for hint ids below num_hints up front, so adding
+    // their requests does not allocate.
+    void ReserveRequests(std::size_t num_hints);
     // Dump internal status to fd
     void DumpToFd(int fd, const std::string& prefix) const;
 
   private:
+    // Drop expired requests and recompute earliest_end_time_.
+    void RefreshExpireTime(ReqTime now);
+
+    // end time marking an inactive slot in request_times_
+    static constexpr ReqTime kInactive = ReqTime::min();
+
     const std::string request_value_;
-    std::map<std::string, ReqTime> request_map_;
+    // end time of each hint indexed by HintId, kInactive if no request
+    std::vector<ReqTime> request_times_;
+    std::size_t active_count_;
+    // Cached nearest end time of active requests, so GetExpireTime only walks
+    // the requests when one may have expired or the cache was invalidated.
+    ReqTime earliest_end_time_;
+    bool earliest_valid_;
 };
 
 }  // namespace perfmgr
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBPERFMGR_REQUESTQUEUE_H_
+#define ANDROID_LIBPERFMGR_REQUESTQUEUE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+
+#include "perfmgr/HintId.h"
+#include "perfmgr/RequestGroup.h"
+
+namespace android {
+namespace perfmgr {
+
+// A request or cancel of a registered action list, queued by HintManager
+// callers for the NodeLooperThread to apply.
+struct QueuedRequest {
+    enum class Type { Request, Cancel };
+    // timeout_override value meaning the per-action timeout is used
+    static constexpr std::chrono::milliseconds kNoOverride = std::chrono::milliseconds(-1);
+
+    Type type;
+    std::size_t actions_id;
+    HintId hint_id;
+    // time the request was submitted, end time of each action is counted
+    // from it
+    ReqTime request_time;
+    std::chrono::milliseconds timeout_override;
+};
+
+// RequestQueue is a bounded lock-free multi-producer single-consumer FIFO.
+// Each slot carries a sequence number telling producers and the consumer
+// whether it is free or filled for the current lap, so Push() never blocks
+// and fails only when the queue is full.
+class RequestQueue {
+  public:
+    // capacity is rounded up to a power of 2
+    explicit RequestQueue(std::size_t capacity);
+
+    // Return false when queue is full. Safe to call from any thread.
+    bool Push(const QueuedRequest &request);
+    // Return false when queue is empty. Only called by the single consumer.
+    bool Pop(QueuedRequest *request);
+    // Return true if there is no request queued.
+    bool Empty() const;
+
+  private:
+    RequestQueue(RequestQueue const &) = delete;
+    void operator=(RequestQueue const &) = delete;
+
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        QueuedRequest request;
+    };
+
+    const std::size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    // producers and consumer positions on separate cache lines
+    alignas(64) std::atomic<std::size_t> enqueue_pos_;
+    alignas(64) std::atomic<std::size_t> dequeue_pos_;
+};
+
+}  // namespace perfmgr
+}  // namespace android
+
+#endif  // ANDROID_LIBPERFMGR_REQUESTQUEUE_H_
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBPERFMGR_SESSIONCONTROLLER_H_
+#define ANDROID_LIBPERFMGR_SESSIONCONTROLLER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace android {
+namespace perfmgr {
+
+// Tunables of the ADPF session controllers. Errors are in units of 100us and
+// outputs in uclamp.min units; integral limits are given in output units.
+struct ControllerConfig {
+    ControllerConfig()
+        : p_over(2.0),
+          p_under(1.0),
+          i(0.001),
+          d_over(500.0),
+          d_under(0.0),
+          i_init(200),
+          i_high_limit(512),
+          i_low_limit(-30),
+          p_window(1),
+          i_window(0),
+          d_window(1),
+          uclamp_min_high(384),
+          uclamp_min_low(2),
+          uclamp_min_granularity(5),
+          ff_gain(1.0),
+          trend_alpha(0.5),
+          trend_beta(0.3),
+          margin_step(0.005),
+          margin_max(0.25),
+          miss_rate_target(0.05) {}
+    // PID gains, "over" applies when the error is positive
+    double p_over;
+    double p_under;
+    double i;
+    double d_over;
+    double d_under;
+    int64_t i_init;
+    int64_t i_high_limit;
+    int64_t i_low_limit;
+    // number of latest samples of a report used by each term, 0 for all
+    int64_t p_window;
+    int64_t i_window;
+    int64_t d_window;
+    int32_t uclamp_min_high;
+    int32_t uclamp_min_low;
+    uint32_t uclamp_min_granularity;
+    // AdaptiveController: gain of the duration trend feed-forward, smoothing
+    // factors of the duration level and trend, step and limit of the target
+    // margin, as a fraction of the target, and the missed deadline rate the
+    // margin steers to.
+    double ff_gain;
+    double trend_alpha;
+    double trend_beta;
+    double margin_step;
+    double margin_max;
+    double miss_rate_target;
+};
+
+// Terms of one controller update, for tracing and telemetry.
+struct ControllerOutput {
+    ControllerOutput()
+        : err(0), integral(0), derivative(0), p_out(0), i_out(0), d_out(0), ff_out(0), output(0) {}
+    // average error of the P window and derivative of the D window
+    int64_t err;
+    int64_t integral;
+    int64_t derivative;
+    int64_t p_out;
+    int64_t i_out;
+    int64_t d_out;
+    int64_t ff_out;
+    int64_t output;
+};
+
+// SessionController turns the work durations reported by an ADPF session
+// into a uclamp.min request. Controllers keep per-session state and are not
+// thread safe; PowerHintSession serializes calls.
+class SessionController {
+  public:
+    virtual ~SessionController() {}
+
+    // Run the controller over durations reported in one call, oldest first.
+    virtual ControllerOutput Update(const int64_t *durations_ns, std::size_t count,
+                                    int64_t target_ns) = 0;
+    // Raise the integral to at least its initial value, e.g. on resume or
+    // when the session wakes up from stale.
+    virtual void ResetIntegral() = 0;
+    // Scale the integral when the target duration changes.
+    virtual void RescaleIntegral(double ratio) = 0;
+    virtual int64_t GetIntegral() const = 0;
+    virtual const char *GetName() const = 0;
+
+    // Return true and set next_min if output moves uclamp.min away from
+    // current_min by more than the granularity.
+    static bool GetNextUclampMin(const ControllerConfig &config, int64_t output, int current_min,
+                                 int *next_min);
+    // Return the controller named type, "pid" or "adaptive", or nullptr.
+    static std::unique_ptr<SessionController> Create(const std::string &type,
+                                                     const ControllerConfig &config);
+};
+
+// The PID controller ADPF sessions have always used.
+class PidController : public SessionController {
+  public:
+    explicit PidController(const ControllerConfig &config);
+
+    ControllerOutput Update(const int64_t *durations_ns, std::size_t count,
+                            int64_t target_ns) override;
+    void ResetIntegral() override;
+    void RescaleIntegral(double ratio) override;
+    int64_t GetIntegral() const override;
+    const char *GetName() const override;
+
+  protected:
+    const ControllerConfig config_;
+
+  private:
+    // integral limits in units of the integral, i.e. divided by config_.i
+    const int64_t i_init_;
+    const int64_t i_high_limit_;
+    const int64_t i_low_limit_;
+    int64_t integral_;
+    int64_t previous_error_;
+};
+
+// PID with feed-forward of the recent work duration trend, so a rising
+// workload is boosted before the error builds up. The PID settles where the
+// average duration meets its target, missing about half the deadlines of a
+// noisy workload; the target is therefore shrunk by a margin adapted per
+// session to keep the missed deadline rate near config.miss_rate_target.
+class AdaptiveController : public PidController {
+  public:
+    explicit AdaptiveController(const ControllerConfig &config);
+
+    ControllerOutput Update(const int64_t *durations_ns, std::size_t count,
+                            int64_t target_ns) override;
+    const char *GetName() const override;
+    double GetMargin() const;
+
+  private:
+    // smoothed duration level and trend in ns, valid once has_level_
+    double level_;
+    double trend_;
+    bool has_level_;
+    // smoothed rate of reports over target
+    double miss_rate_;
+    // fraction of the target removed before running the PID
+    double margin_;
+};
+
+}  // namespace perfmgr
+}  // namespace android
+
+#endif  // ANDROID_LIBPERFMGR_SESSIONCONTROLLER_H_
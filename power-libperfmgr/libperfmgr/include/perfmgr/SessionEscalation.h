@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBPERFMGR_SESSIONESCALATION_H_
+#define ANDROID_LIBPERFMGR_SESSIONESCALATION_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "perfmgr/AdpfConfig.h"
+
+namespace android {
+namespace perfmgr {
+
+// Saturation of one session with hysteresis: set after
+// config.enter_reports consecutive saturated reports and cleared after
+// config.exit_reports consecutive unsaturated ones. Not thread safe.
+class SaturationFilter {
+  public:
+    SaturationFilter() : saturated_(false), run_(0) {}
+
+    // Feed the saturation of one report, return true if IsSaturated() changed
+    bool Update(bool saturated, const EscalationConfig &config);
+    bool IsSaturated() const { return saturated_; }
+
+  private:
+    bool saturated_;
+    // consecutive reports disagreeing with saturated_
+    uint32_t run_;
+};
+
+// Return whether to be escalated given the saturated and active session
+// counts, with the fraction hysteresis of config.
+bool ShouldEscalate(bool escalated, std::size_t saturated, std::size_t active,
+                    const EscalationConfig &config);
+
+}  // namespace perfmgr
+}  // namespace android
+
+#endif  // ANDROID_LIBPERFMGR_SESSIONESCALATION_H_
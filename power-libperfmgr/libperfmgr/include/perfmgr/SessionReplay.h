@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBPERFMGR_SESSIONREPLAY_H_
+#define ANDROID_LIBPERFMGR_SESSIONREPLAY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "perfmgr/SessionController.h"
+
+namespace android {
+namespace perfmgr {
+
+// One reportActualWorkDuration call of a recorded ADPF session.
+struct WorkDurationReport {
+    // timestamp of the last WorkDuration of the report
+    int64_t timestamp_ns;
+    int64_t target_ns;
+    std::vector<int64_t> durations_ns;
+};
+
+struct ReplayOptions {
+    ReplayOptions() : stale_timeout_ns(0), closed_loop(false), plant_ref(256), plant_ramp(0.25) {}
+    // Gap between reports after which the session goes stale, i.e. drops
+    // uclamp.min to 0 and resets the integral on the next report; 0 never.
+    int64_t stale_timeout_ns;
+    // Treat recorded durations as unboosted work, scaled by the replayed
+    // boost: work * plant_ref / (plant_ref + boost), where boost follows
+    // uclamp.min by plant_ramp per report. Otherwise durations are replayed
+    // as recorded, which only shows how the controller reacts to them.
+    bool closed_loop;
+    double plant_ref;
+    double plant_ramp;
+};
+
+struct ReplayResult {
+    ReplayResult() : setattr_calls(0), frames(0), frames_over_target(0), average_min(0) {}
+    // (timestamp_ns, uclamp.min) each time uclamp.min changes, starting with
+    // the initial boost of the session
+    std::vector<std::pair<int64_t, int>> uclamp_timeline;
+    // uclamp.min changes after the initial boost, each one sched_setattr
+    // per session thread
+    std::size_t setattr_calls;
+    std::size_t frames;
+    std::size_t frames_over_target;
+    // uclamp.min in effect averaged over frames, the energy proxy
+    double average_min;
+};
+
+enum class SyntheticWorkload {
+    STEADY,
+    BURSTY,
+    PHASE_CHANGE,
+};
+
+// Parse a recorded trace, one WorkDuration per line:
+//   timestamp_ns,duration_ns,target_ns[,report]
+// Consecutive lines with the same report number form one report, lines
+// without one are reports of their own. Empty lines and lines starting with
+// '#' are skipped. Return false on malformed lines.
+bool ParseWorkDurationTrace(const std::string &csv, std::vector<WorkDurationReport> *reports);
+
+// Run the reports through controller the way PowerHintSession does.
+ReplayResult ReplayTrace(SessionController *controller, const ControllerConfig &config,
+                         const std::vector<WorkDurationReport> &reports,
+                         const ReplayOptions &options);
+
+// Deterministic trace of frames single WorkDuration reports, unboosted
+// work in the ballpark of target_ns.
+std::vector<WorkDurationReport> MakeSyntheticTrace(SyntheticWorkload workload, std::size_t frames,
+                                                   int64_t target_ns, uint32_t seed);
+
+}  // namespace perfmgr
+}  // namespace android
+
+#endif  // ANDROID_LIBPERFMGR_SESSIONREPLAY_H_
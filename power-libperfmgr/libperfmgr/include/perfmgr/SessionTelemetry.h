@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBPERFMGR_SESSIONTELEMETRY_H_
+#define ANDROID_LIBPERFMGR_SESSIONTELEMETRY_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace android {
+namespace perfmgr {
+
+// Telemetry of one ADPF session: the latest kCapacity reports in a ring
+// and aggregate counters. Reports are recorded by a single writer, the
+// binder thread of the session; counters and dumps are safe from any thread
+// and never block the writer.
+//
+// Binary dump, native byte order (little-endian on all supported devices):
+//   header:  char[4] "ADPT", u32 version, u32 session count
+//   session: u32 id length, id, u64 reports, u64 over target, u64 setattr,
+//            u64 stale transitions, u32 record count, records oldest first
+//   record:  i64 timestamp_ns, i64 actual_ns, i64 target_ns, i32 p_out,
+//            i32 i_out, i32 d_out, i32 uclamp_min
+class SessionTelemetry {
+  public:
+    static constexpr std::size_t kCapacity = 64;
+    static constexpr uint32_t kBinaryVersion = 1;
+
+    struct Record {
+        // timestamp and duration of the last WorkDuration of the report
+        int64_t timestamp_ns;
+        int64_t actual_ns;
+        int64_t target_ns;
+        int32_t p_out;
+        int32_t i_out;
+        int32_t d_out;
+        // uclamp.min requested by the session after the report
+        int32_t uclamp_min;
+    };
+
+    struct Counters {
+        uint64_t reports;
+        // WorkDurations over target
+        uint64_t over_target;
+        uint64_t setattr;
+        uint64_t stale_transitions;
+    };
+
+    SessionTelemetry();
+
+    // Single writer
+    void RecordReport(const Record &record, uint64_t over_target);
+    // Any thread
+    void RecordSetattr(uint64_t count);
+    void RecordStaleTransition();
+
+    Counters GetCounters() const;
+    // Records still in the ring, oldest first. A record being overwritten
+    // while read is left out.
+    std::vector<Record> GetRecords() const;
+
+    void DumpText(const std::string &id, std::string *out) const;
+    void DumpBinary(const std::string &id, std::string *out) const;
+    static void DumpBinaryHeader(uint32_t sessions, std::string *out);
+
+  private:
+    static constexpr std::size_t kRecordFields = 7;
+    // Slot of the ring. seq is 2 * index + 1 while the record of report
+    // index is written and 2 * index + 2 once complete.
+    struct Slot {
+        std::atomic<uint64_t> seq;
+        std::array<std::atomic<int64_t>, kRecordFields> fields;
+    };
+    std::array<Slot, kCapacity> ring_;
+    std::atomic<uint64_t> reports_;
+    std::atomic<uint64_t> over_target_;
+    std::atomic<uint64_t> setattr_;
+    std::atomic<uint64_t> stale_transitions_;
+
+    SessionTelemetry(SessionTelemetry const &) = delete;
+    void operator=(SessionTelemetry const &) = delete;
+};
+
+}  // namespace perfmgr
+}  // namespace android
+
+#endif  // ANDROID_LIBPERFMGR_SESSIONTELEMETRY_H_
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <string>
+
+#include "perfmgr/AdpfConfig.h"
+
+namespace android {
+namespace perfmgr {
+
+// Test profile selection by uid, then by enabled mode, then the default
+TEST(AdpfConfigTest, SelectProfile) {
+    AdpfConfig config;
+    config.profiles.resize(3);
+    config.profiles[1].name = "Game";
+    config.profiles[1].uids = {10100};
+    config.profiles[1].modes = {"GAME"};
+    config.profiles[2].name = "Camera";
+    config.profiles[2].uids = {10200};
+    config.profiles[2].modes = {"CAMERA_STREAMING_HIGH"};
+
+    std::set<std::string> modes;
+    auto is_mode_enabled = [&modes](const std::string &mode) { return modes.count(mode) > 0; };
+    EXPECT_EQ("Default", config.SelectProfile(10000, is_mode_enabled).name);
+    EXPECT_EQ("Game", config.SelectProfile(10100, is_mode_enabled).name);
+    EXPECT_EQ("Camera", config.SelectProfile(10200, is_mode_enabled).name);
+    modes.insert("CAMERA_STREAMING_HIGH");
+    EXPECT_EQ("Camera", config.SelectProfile(10000, is_mode_enabled).name);
+    // uid wins over mode
+    EXPECT_EQ("Game", config.SelectProfile(10100, is_mode_enabled).name);
+    modes.insert("GAME");
+    EXPECT_EQ("Game", config.SelectProfile(10000, is_mode_enabled).name);
+}
+
+// Test tunables are set by their JSON key
+TEST(AdpfConfigTest, SetControllerTunable) {
+    ControllerConfig config;
+    EXPECT_TRUE(SetControllerTunable("PID_Po", 3.5, &config));
+    EXPECT_TRUE(SetControllerTunable("PID_I_Low", -64, &config));
+    EXPECT_TRUE(SetControllerTunable("UclampMin_High", 512, &config));
+    EXPECT_TRUE(SetControllerTunable("SamplingWindow_I", 4, &config));
+    EXPECT_TRUE(SetControllerTunable("MissRateTarget", 0.1, &config));
+    EXPECT_FALSE(SetControllerTunable("pid_p.over", 1.0, &config));
+    EXPECT_DOUBLE_EQ(3.5, config.p_over);
+    EXPECT_EQ(-64, config.i_low_limit);
+    EXPECT_EQ(512, config.uclamp_min_high);
+    EXPECT_EQ(4, config.i_window);
+    EXPECT_DOUBLE_EQ(0.1, config.miss_rate_target);
+    // untouched fields keep their defaults
+    EXPECT_DOUBLE_EQ(ControllerConfig().p_under, config.p_under);
+}
+
+}  // namespace perfmgr
+}  // namespace android
@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <android-base/strings.h>
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "perfmgr/BoostArbiter.h"
+#include "perfmgr/HintManager.h"
+
+namespace android {
+namespace perfmgr {
+
+using std::literals::chrono_literals::operator""ms;
+
+constexpr char kJSON_RAW[] = R"(
+{
+    "Nodes": [
+        {
+            "Name": "CPUMinFreq",
+            "Path": "NODE_PATH",
+            "Values": ["1512000", "1134000", "384000"],
+            "DefaultIndex": 2
+        }
+    ],
+    "Actions": [
+        {
+            "PowerHint": "INTERACTION",
+            "Node": "CPUMinFreq",
+            "Value": "1134000",
+            "Duration": 1000
+        },
+        {
+            "PowerHint": "LAUNCH",
+            "Node": "CPUMinFreq",
+            "Value": "1512000",
+            "Duration": 0
+        }
+    ],
+    "BoostArbiter": {"Rules": [
+        {"WhileModes": ["THERMAL_SKIN_SEVERE"], "Sources": ["Interaction"],
+         "MaxDuration": 100},
+        {"WhileModes": ["THERMAL_SKIN_CRITICAL"], "MaxPriority": 10, "Drop": true}
+    ]}
+}
+)";
+
+static uint32_t SourceBit(BoostSource source) {
+    return 1u << static_cast<uint32_t>(source);
+}
+
+// Test the first matching rule decides
+TEST(BoostPolicyTest, Apply) {
+    const HintId severe = HintIdRegistry::Intern("THERMAL_SKIN_SEVERE");
+    const HintId interaction = HintIdRegistry::Intern("INTERACTION");
+    BoostPolicy policy;
+    BoostRule cap;
+    cap.modes = {severe};
+    cap.sources = SourceBit(BoostSource::INTERACTION);
+    cap.hints = {interaction};
+    cap.max_duration = 100ms;
+    policy.rules.emplace_back(cap);
+    BoostRule drop;
+    drop.max_priority = 10;
+    drop.drop = true;
+    policy.rules.emplace_back(drop);
+
+    std::vector<bool> modes;
+    // no mode enabled, the second rule drops low priorities
+    BoostPolicy::Verdict verdict =
+            policy.Apply(BoostSource::INTERACTION, interaction, 500ms, 0ms, 0, modes);
+    EXPECT_TRUE(verdict.drop);
+    verdict = policy.Apply(BoostSource::MODE, interaction, 500ms, 0ms, 20, modes);
+    EXPECT_FALSE(verdict.drop);
+    EXPECT_FALSE(verdict.capped);
+    EXPECT_EQ(500ms, verdict.duration);
+
+    modes.resize(severe + 1, false);
+    modes[severe] = true;
+    verdict = policy.Apply(BoostSource::INTERACTION, interaction, 500ms, 0ms, 0, modes);
+    EXPECT_FALSE(verdict.drop);
+    EXPECT_TRUE(verdict.capped);
+    EXPECT_EQ(100ms, verdict.duration);
+    // shorter requests pass as is
+    verdict = policy.Apply(BoostSource::INTERACTION, interaction, 50ms, 0ms, 0, modes);
+    EXPECT_FALSE(verdict.capped);
+    EXPECT_EQ(50ms, verdict.duration);
+    // the hint's own timeout, forever here, is capped too
+    verdict = policy.Apply(BoostSource::INTERACTION, interaction, 0ms, 0ms, 0, modes);
+    EXPECT_TRUE(verdict.capped);
+    EXPECT_EQ(100ms, verdict.duration);
+    verdict = policy.Apply(BoostSource::INTERACTION, interaction, 0ms, 80ms, 0, modes);
+    EXPECT_FALSE(verdict.capped);
+    EXPECT_EQ(0ms, verdict.duration);
+}
+
+TEST(BoostPolicyTest, SourceNames) {
+    BoostSource source;
+    for (std::size_t i = 0; i < static_cast<std::size_t>(BoostSource::COUNT); i++) {
+        ASSERT_TRUE(ParseBoostSource(BoostSourceName(static_cast<BoostSource>(i)), &source));
+        EXPECT_EQ(static_cast<BoostSource>(i), source);
+    }
+    EXPECT_FALSE(ParseBoostSource("Thermal", &source));
+}
+
+class BoostArbiterTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+        const std::string json_doc =
+                android::base::StringReplace(kJSON_RAW, "NODE_PATH", node_file_.path, false);
+        ASSERT_TRUE(android::base::WriteStringToFile(json_doc, json_file_.path))
+                << strerror(errno);
+        hm_ = HintManager::GetFromJSON(json_file_.path, true);
+        ASSERT_NE(nullptr, hm_.get());
+        arbiter_ = std::make_unique<BoostArbiter>(hm_);
+    }
+
+    static const BoostArbiter::SourceStats &Stats(
+            const std::array<BoostArbiter::SourceStats,
+                             static_cast<std::size_t>(BoostSource::COUNT)> &stats,
+            BoostSource source) {
+        return stats[static_cast<std::size_t>(source)];
+    }
+
+    TemporaryFile node_file_;
+    TemporaryFile json_file_;
+    std::shared_ptr<HintManager> hm_;
+    std::unique_ptr<BoostArbiter> arbiter_;
+};
+
+// Test timed requests covered by the current hold are not submitted
+TEST_F(BoostArbiterTest, Coalesce) {
+    const HintId interaction = HintIdRegistry::Intern("INTERACTION");
+    EXPECT_TRUE(arbiter_->DoHint(BoostSource::BOOST, interaction, 500ms, 20));
+    EXPECT_TRUE(arbiter_->DoHint(BoostSource::BOOST, interaction, 100ms, 20));
+    EXPECT_TRUE(arbiter_->DoHint(BoostSource::EXT, interaction, 200ms));
+    // a later deadline is submitted
+    EXPECT_TRUE(arbiter_->DoHint(BoostSource::EXT, interaction, 1000ms));
+    auto stats = arbiter_->GetStats();
+    EXPECT_EQ(2u, Stats(stats, BoostSource::BOOST).requests);
+    EXPECT_EQ(1u, Stats(stats, BoostSource::BOOST).coalesced);
+    EXPECT_EQ(2u, Stats(stats, BoostSource::EXT).requests);
+    EXPECT_EQ(1u, Stats(stats, BoostSource::EXT).coalesced);
+
+    // after EndHint nothing is held
+    EXPECT_TRUE(arbiter_->EndHint(BoostSource::EXT, interaction));
+    EXPECT_TRUE(arbiter_->DoHint(BoostSource::BOOST, interaction, 100ms, 20));
+    stats = arbiter_->GetStats();
+    EXPECT_EQ(1u, Stats(stats, BoostSource::BOOST).coalesced);
+}
+
+// Test hints ended around the arbiter are neither coalesced nor charged
+TEST_F(BoostArbiterTest, EndedAroundArbiter) {
+    const HintId interaction = HintIdRegistry::Intern("INTERACTION");
+    EXPECT_TRUE(arbiter_->DoHint(BoostSource::BOOST, interaction, 500ms, 20));
+    std::this_thread::sleep_for(20ms);
+    EXPECT_TRUE(hm_->EndHint(interaction));
+    std::this_thread::sleep_for(50ms);
+    auto stats = arbiter_->GetStats();
+    EXPECT_GE(Stats(stats, BoostSource::BOOST).cost, 10.0);
+    EXPECT_LT(Stats(stats, BoostSource::BOOST).cost, 30.0);
+    // the stale request does not swallow a new one
+    EXPECT_TRUE(arbiter_->DoHint(BoostSource::BOOST, interaction, 100ms, 20));
+    stats = arbiter_->GetStats();
+    EXPECT_EQ(0u, Stats(stats, BoostSource::BOOST).coalesced);
+    // requests made around the arbiter coalesce requests through it
+    EXPECT_TRUE(hm_->DoHint(interaction, 1000ms));
+    EXPECT_TRUE(arbiter_->DoHint(BoostSource::EXT, interaction, 500ms));
+    stats = arbiter_->GetStats();
+    EXPECT_EQ(1u, Stats(stats, BoostSource::EXT).coalesced);
+}
+
+// Test the policy follows the modes set on the arbiter
+TEST_F(BoostArbiterTest, Policy) {
+    const HintId interaction = HintIdRegistry::Intern("INTERACTION");
+    const HintId launch = HintIdRegistry::Intern("LAUNCH");
+    arbiter_->SetMode(HintIdRegistry::Intern("THERMAL_SKIN_SEVERE"), true);
+    EXPECT_TRUE(arbiter_->DoHint(BoostSource::INTERACTION, interaction));
+    EXPECT_TRUE(arbiter_->DoHint(BoostSource::MODE, launch));
+    auto stats = arbiter_->GetStats();
+    EXPECT_EQ(1u, Stats(stats, BoostSource::INTERACTION).capped);
+    EXPECT_EQ(0u, Stats(stats, BoostSource::MODE).capped);
+    arbiter_->SetMode(HintIdRegistry::Intern("THERMAL_SKIN_SEVERE"), false);
+
+    arbiter_->SetMode(HintIdRegistry::Intern("THERMAL_SKIN_CRITICAL"), true);
+    EXPECT_FALSE(arbiter_->DoHint(BoostSource::INTERACTION, interaction));
+    EXPECT_FALSE(arbiter_->DoHint(BoostSource::BOOST, launch));
+    // above MaxPriority
+    EXPECT_TRUE(arbiter_->DoHint(BoostSource::EXT, launch));
+    stats = arbiter_->GetStats();
+    EXPECT_EQ(1u, Stats(stats, BoostSource::INTERACTION).dropped);
+    EXPECT_EQ(1u, Stats(stats, BoostSource::BOOST).dropped);
+    EXPECT_EQ(0u, Stats(stats, BoostSource::EXT).dropped);
+}
+
+// Test cost is boosted time times level, charged to the holder
+TEST_F(BoostArbiterTest, Cost) {
+    const HintId interaction = HintIdRegistry::Intern("INTERACTION");
+    const HintId launch = HintIdRegistry::Intern("LAUNCH");
+    // INTERACTION is level 0.5 for 20ms
+    EXPECT_TRUE(arbiter_->DoHint(BoostSource::BOOST, interaction, 20ms, 20));
+    // LAUNCH is level 1 until ended
+    EXPECT_TRUE(arbiter_->DoHint(BoostSource::MODE, launch));
+    std::this_thread::sleep_for(50ms);
+    EXPECT_TRUE(arbiter_->EndHint(BoostSource::MODE, launch));
+    std::this_thread::sleep_for(20ms);
+    auto stats = arbiter_->GetStats();
+    EXPECT_DOUBLE_EQ(10.0, Stats(stats, BoostSource::BOOST).cost);
+    EXPECT_GE(Stats(stats, BoostSource::MODE).cost, 50.0);
+    EXPECT_LT(Stats(stats, BoostSource::MODE).cost, 70.0);
+}
+
+}  // namespace perfmgr
+}  // namespace android
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+#include <vector>
+
+#include "perfmgr/DeadlineHeap.h"
+
+namespace android {
+namespace perfmgr {
+
+using TimePoint = std::chrono::steady_clock::time_point;
+using std::literals::chrono_literals::operator""ms;
+
+// Test ordering, moving and removing deadlines
+TEST(DeadlineHeapTest, UpdateRemove) {
+    DeadlineHeap<int> heap;
+    const TimePoint t0;
+    EXPECT_TRUE(heap.Empty());
+    heap.Update(1, t0 + 30ms);
+    heap.Update(2, t0 + 10ms);
+    heap.Update(3, t0 + 20ms);
+    EXPECT_EQ(3u, heap.Size());
+    EXPECT_EQ(2, heap.Top().second);
+    // Move the soonest later, then another one earlier
+    heap.Update(2, t0 + 40ms);
+    EXPECT_EQ(3, heap.Top().second);
+    heap.Update(1, t0 + 5ms);
+    EXPECT_EQ(1, heap.Top().second);
+    EXPECT_EQ(t0 + 5ms, heap.Top().first);
+    EXPECT_TRUE(heap.Remove(1));
+    EXPECT_FALSE(heap.Remove(1));
+    EXPECT_FALSE(heap.Contains(1));
+    EXPECT_EQ(3, heap.Top().second);
+
+    std::vector<int> expired;
+    heap.PopExpired(t0 + 20ms, &expired);
+    EXPECT_EQ(std::vector<int>({3}), expired);
+    heap.PopExpired(t0 + 100ms, &expired);
+    EXPECT_EQ(std::vector<int>({3, 2}), expired);
+    EXPECT_TRUE(heap.Empty());
+}
+
+// Test against a reference map under random updates and removals
+TEST(DeadlineHeapTest, RandomOps) {
+    DeadlineHeap<int> heap;
+    std::map<int, TimePoint> reference;
+    std::minstd_rand rng(1);
+    const TimePoint t0;
+    for (int i = 0; i < 20000; i++) {
+        const int key = rng() % 64;
+        if (rng() % 4 == 0) {
+            EXPECT_EQ(reference.erase(key) > 0, heap.Remove(key));
+        } else {
+            const TimePoint deadline = t0 + std::chrono::milliseconds(rng() % 1000);
+            heap.Update(key, deadline);
+            reference[key] = deadline;
+        }
+        ASSERT_EQ(reference.size(), heap.Size());
+        if (!reference.empty()) {
+            TimePoint soonest = TimePoint::max();
+            for (const auto &[k, d] : reference) {
+                soonest = std::min(soonest, d);
+            }
+            ASSERT_EQ(soonest, heap.Top().first);
+            ASSERT_EQ(soonest, reference[heap.Top().second]);
+        }
+    }
+    std::vector<int> expired;
+    heap.PopExpired(TimePoint::max(), &expired);
+    EXPECT_EQ(reference.size(), expired.size());
+    for (std::size_t i = 1; i < expired.size(); i++) {
+        EXPECT_LE(reference[expired[i - 1]], reference[expired[i]]);
+    }
+}
+
+}  // namespace perfmgr
+}  // namespace android
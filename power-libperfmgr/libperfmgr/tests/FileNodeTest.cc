@@ -31,6 +31,17 @@ using std::literals::chrono_literals::operator""ms;
 constexpr double kTIMING_TOLERANCE_MS = std::chrono::milliseconds(25).count();
 constexpr auto kSLEEP_TOLERANCE_MS = 2ms;
 
+// Hint names used below, the string overloads reject names not interned yet
+class HintNamesEnvironment : public ::testing::Environment {
+  public:
+    void SetUp() override {
+        HintIdRegistry::Intern("INTERACTION");
+        HintIdRegistry::Intern("LAUNCH");
+    }
+};
+::testing::Environment *const kHintNamesEnv =
+        ::testing::AddGlobalTestEnvironment(new HintNamesEnvironment);
+
 static inline void _VerifyPathValue(const std::string& path,
                                     const std::string& value) {
     std::string s;
@@ -186,6 +197,41 @@ TEST(FileNodeTest, RemoveRequestTest) {
     EXPECT_EQ(std::chrono::milliseconds::max(), expire_time);
 }
 
+// Test values of different length written through the cached fd
+TEST(FileNodeTest, AddRequestTestValueLength) {
+    TemporaryFile tf;
+    FileNode t("t", tf.path, {{"1234567"}, {"12"}, {"12345"}}, 2, true);
+    t.Update(false);
+    _VerifyPathValue(tf.path, "12345");
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(t.AddRequest(1, "INTERACTION", start + 500ms));
+    t.Update(true);
+    _VerifyPathValue(tf.path, "12");
+    EXPECT_TRUE(t.AddRequest(0, "LAUNCH", start + 500ms));
+    t.Update(true);
+    _VerifyPathValue(tf.path, "1234567");
+    t.RemoveRequest("LAUNCH");
+    t.RemoveRequest("INTERACTION");
+    t.Update(true);
+    _VerifyPathValue(tf.path, "12345");
+}
+
+// Test node reopened after cached fd failed to write
+TEST(FileNodeTest, AddRequestTestReopen) {
+    TemporaryDir td;
+    std::string path = android::base::StringPrintf("%s/node", td.path);
+    FileNode t("t", path, {{"value0"}, {"value1"}, {"value2"}}, 2, true);
+    // Node not present at init, retry in 500ms
+    EXPECT_EQ(std::chrono::milliseconds(500), t.Update(false));
+    ASSERT_TRUE(android::base::WriteStringToFile("", path));
+    EXPECT_EQ(std::chrono::milliseconds::max(), t.Update(true));
+    _VerifyPathValue(path, "value2");
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(t.AddRequest(1, "INTERACTION", start + 500ms));
+    t.Update(true);
+    _VerifyPathValue(path, "value1");
+}
+
 // Test add request with holding fd
 TEST(FileNodeTest, AddRequestTestHoldFdOverride) {
     TemporaryFile tf;
@@ -230,5 +276,58 @@ TEST(FileNodeTest, AddRequestTestHoldFdOverride) {
     EXPECT_EQ(std::chrono::milliseconds::max(), expire_time);
 }
 
+// Test writes to a character device, which rejects ftruncate, succeed and
+// keep the held fd
+TEST(FileNodeTest, AddRequestTestCharDevice) {
+    FileNode t("t", "/dev/null", {{"value0"}, {"value1"}, {"value2"}}, 2, false, true);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(t.AddRequest(1, "INTERACTION", start + 2000ms));
+    std::chrono::milliseconds expire_time = t.Update(true);
+    // Not the 500ms retry of a failed write
+    EXPECT_NEAR(std::chrono::milliseconds(2000).count(), expire_time.count(),
+                kTIMING_TOLERANCE_MS);
+    TemporaryFile dumptf;
+    t.DumpToFd(dumptf.fd);
+    std::string dump;
+    ASSERT_TRUE(android::base::ReadFileToString(dumptf.path, &dump));
+    // Current value index is value1
+    EXPECT_NE(std::string::npos, dump.find("/dev/null\t1\t")) << dump;
+    t.RemoveRequest("INTERACTION");
+    EXPECT_EQ(std::chrono::milliseconds::max(), t.Update(true));
+}
+
+// Test a reloaded hold_fd node takes over the fd held by the old node
+TEST(FileNodeTest, MigrateFromTestHoldFd) {
+    TemporaryFile tf;
+    FileNode old("t", tf.path, {{"value0"}, {"value1"}, {"value2"}}, 2, true, true);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(old.AddRequest(1, "INTERACTION", start + 500ms));
+    old.Update(true);
+    _VerifyPathValue(tf.path, "value1");
+    FileNode t("t", tf.path, {{"value0"}, {"value1"}, {"value2"}}, 2, true, true);
+    EXPECT_TRUE(t.MigrateFrom(&old));
+    EXPECT_EQ(-1, old.ReleaseHeldFd().get());
+    // Value taken over, no write
+    ASSERT_TRUE(android::base::WriteStringToFile("other", tf.path));
+    t.Update(true);
+    _VerifyPathValue(tf.path, "other");
+    EXPECT_NE(-1, t.ReleaseHeldFd().get());
+}
+
+// Test a hold_fd node writes the value again when old held no fd
+TEST(FileNodeTest, MigrateFromTestNoHeldFd) {
+    TemporaryFile tf;
+    FileNode old("t", tf.path, {{"value0"}, {"value1"}, {"value2"}}, 2, true, false);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(old.AddRequest(1, "INTERACTION", start + 500ms));
+    old.Update(true);
+    FileNode t("t", tf.path, {{"value0"}, {"value1"}, {"value2"}}, 2, true, true);
+    EXPECT_FALSE(t.MigrateFrom(&old));
+    ASSERT_TRUE(android::base::WriteStringToFile("other", tf.path));
+    t.Update(true);
+    _VerifyPathValue(tf.path, "value1");
+    EXPECT_NE(-1, t.ReleaseHeldFd().get());
+}
+
 }  // namespace perfmgr
 }  // namespace android
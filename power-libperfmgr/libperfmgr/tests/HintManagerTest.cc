@@ -20,9 +20,14 @@
 #include <android-base/stringprintf.h>
 #include <gtest/gtest.h>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <algorithm>
+#include <future>
 #include <thread>
 
+#include "perfmgr/ConfigImage.h"
 #include "perfmgr/FileNode.h"
 #include "perfmgr/HintManager.h"
 #include "perfmgr/PropertyNode.h"
@@ -31,6 +36,8 @@ namespace android {
 namespace perfmgr {
 
 using std::literals::chrono_literals::operator""ms;
+using std::literals::chrono_literals::operator""ns;
+using std::literals::chrono_literals::operator""us;
 
 constexpr auto kSLEEP_TOLERANCE_MS = 50ms;
 
@@ -119,6 +126,44 @@ constexpr char kJSON_RAW[] = R"(
 }
 )";
 
+constexpr char kJSON_WRITE_GROUPS[] = R"(
+{
+    "Nodes": [
+        {
+            "Name": "CPUCluster0MinFreq",
+            "Path": "/sys/devices/system/cpu/cpu0/cpufreq/scaling_min_freq",
+            "Values": [
+                "1512000",
+                "384000"
+            ],
+            "DefaultIndex": 1
+        },
+        {
+            "Name": "CPUCluster1MinFreq",
+            "Path": "/sys/devices/system/cpu/cpu4/cpufreq/scaling_min_freq",
+            "Values": [
+                "1512000",
+                "384000"
+            ],
+            "DefaultIndex": 1,
+            "DependsOn": [
+                "CPUCluster0MinFreq"
+            ]
+        },
+        {
+            "Name": "ModeProperty",
+            "Path": "vendor.pwhal.mode",
+            "Values": [
+                "HIGH",
+                "NONE"
+            ],
+            "Type": "Property",
+            "WriteGroup": "mode"
+        }
+    ]
+}
+)";
+
 class HintManagerTest : public ::testing::Test, public HintManager {
   protected:
     HintManagerTest() : HintManager(nullptr, std::unordered_map<std::string, Hint>{}) {
@@ -247,6 +292,34 @@ TEST_F(HintManagerTest, HintSupportedTest) {
     EXPECT_TRUE(hm.IsHintSupported("INTERACTION"));
     EXPECT_TRUE(hm.IsHintSupported("LAUNCH"));
     EXPECT_FALSE(hm.IsHintSupported("NO_SUCH_HINT"));
+    EXPECT_TRUE(hm.IsHintSupported(HintIdRegistry::Intern("LAUNCH")));
+    EXPECT_FALSE(hm.IsHintSupported(HintIdRegistry::Intern("NO_SUCH_HINT")));
+}
+
+// Test hints by HintId
+TEST_F(HintManagerTest, HintIdTest) {
+    auto hm = std::make_unique<HintManager>(nm_, actions_);
+    EXPECT_TRUE(InitHintStatus(hm));
+    EXPECT_TRUE(hm->Start());
+    HintId launch_id;
+    EXPECT_TRUE(hm->GetHintId("LAUNCH", &launch_id));
+    EXPECT_EQ(HintIdRegistry::Intern("LAUNCH"), launch_id);
+    EXPECT_EQ("LAUNCH", HintIdRegistry::GetName(launch_id));
+    HintId unknown_id = 1234;
+    EXPECT_FALSE(hm->GetHintId("NO_SUCH_HINT", &unknown_id));
+    EXPECT_EQ(1234u, unknown_id);
+    EXPECT_FALSE(hm->DoHint(HintIdRegistry::Intern("NO_SUCH_HINT")));
+    EXPECT_TRUE(hm->DoHint(launch_id));
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    _VerifyPathValue(files_[0]->path, "n0_value0");
+    _VerifyPathValue(files_[1]->path, "n1_value0");
+    _VerifyPropertyValue(prop_, "n2_value0");
+    EXPECT_TRUE(hm->EndHint(launch_id));
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    _VerifyPathValue(files_[0]->path, "n0_value2");
+    _VerifyPathValue(files_[1]->path, "n1_value2");
+    _VerifyPropertyValue(prop_, "n2_value2");
+    EXPECT_EQ(1u, hm->GetHintStats("LAUNCH").count);
 }
 
 // Test DumpToFd
@@ -260,10 +333,20 @@ TEST_F(HintManagerTest, DumpToFdTest) {
     dump_buf << "========== Begin perfmgr nodes ==========\nNode Name\tNode "
                 "Path\tCurrent Index\tCurrent Value\nn0\t"
              << files_[0]->path << "\t2\t\nn1\t" << files_[1]->path
-             << "\t2\t\nn2\tvendor.pwhal.mode\t2\t\n==========  End perfmgr "
+             << "\t2\t\nn2\tvendor.pwhal.mode\t2\t\n\t\tFlushed:\t0\tSuppressed:\t0\n"
+                "==========  End perfmgr "
                 "nodes  ==========\n========== Begin perfmgr stats ==========\n"
                 "Hint Name\tCounts\tDuration\nINTERACTION\t0\t0\nLAUNCH\t0\t0\n"
-                "==========  End perfmgr stats  ==========\n";
+                "==========  End perfmgr stats  ==========\n"
+                "========== Begin perfmgr latency ==========\n"
+                "Call\tCounts\tP50(us)\tP99(us)\nDoHint\t0\t0.0\t0.0\n"
+                "==========  End perfmgr latency  ==========\n"
+                "========== Begin perfmgr hint effect ==========\n"
+                "Hint Name\tApplied\tApply P50(us)\tApply P99(us)\tWrite P50(us)\t"
+                "Write P99(us)\tShadowed\n"
+                "INTERACTION\t0\t0.0\t0.0\t0.0\t0.0\t0\n"
+                "LAUNCH\t0\t0.0\t0.0\t0.0\t0.0\t0\n"
+                "==========  End perfmgr hint effect  ==========\n";
     _VerifyPathValue(dumptf.path, dump_buf.str());
     TemporaryFile dumptf_started;
     EXPECT_TRUE(hm->Start());
@@ -276,10 +359,20 @@ TEST_F(HintManagerTest, DumpToFdTest) {
     dump_buf << "========== Begin perfmgr nodes ==========\nNode Name\tNode "
                 "Path\tCurrent Index\tCurrent Value\nn0\t"
              << files_[0]->path << "\t2\t\nn1\t" << files_[1]->path
-             << "\t2\tn1_value2\nn2\tvendor.pwhal.mode\t2\tn2_value2\n========="
+             << "\t2\tn1_value2\nn2\tvendor.pwhal.mode\t2\tn2_value2\n"
+                "\t\tFlushed:\t1\tSuppressed:\t0\n========="
                 "=  End perfmgr nodes  ==========\n========== Begin perfmgr "
                 "stats ==========\nHint Name\tCounts\tDuration\nINTERACTION\t0\t"
-                "0\nLAUNCH\t0\t0\n==========  End perfmgr stats  ==========\n";
+                "0\nLAUNCH\t0\t0\n==========  End perfmgr stats  ==========\n"
+                "========== Begin perfmgr latency ==========\n"
+                "Call\tCounts\tP50(us)\tP99(us)\nDoHint\t0\t0.0\t0.0\n"
+                "==========  End perfmgr latency  ==========\n"
+                "========== Begin perfmgr hint effect ==========\n"
+                "Hint Name\tApplied\tApply P50(us)\tApply P99(us)\tWrite P50(us)\t"
+                "Write P99(us)\tShadowed\n"
+                "INTERACTION\t0\t0.0\t0.0\t0.0\t0.0\t0\n"
+                "LAUNCH\t0\t0.0\t0.0\t0.0\t0.0\t0\n"
+                "==========  End perfmgr hint effect  ==========\n";
     _VerifyPathValue(dumptf_started.path, dump_buf.str());
 }
 
@@ -303,6 +396,7 @@ TEST_F(HintManagerTest, HintTest) {
     _VerifyPathValue(files_[1]->path, "n1_value0");
     _VerifyPropertyValue(prop_, "n2_value0");
     EXPECT_TRUE(hm->DoHint("LAUNCH", 500ms));
+    EXPECT_EQ(4u, hm->GetDoHintLatency().Count());
     // "LAUNCH" node1 not expired
     std::this_thread::sleep_for(400ms);
     _VerifyPathValue(files_[0]->path, "n0_value0");
@@ -374,6 +468,31 @@ TEST_F(HintManagerTest, HintStatsTest) {
     _VerifyStats(launch_stats, 2, 500, 600);
 }
 
+// Test collecting apply latency and shadowed requests
+TEST_F(HintManagerTest, HintApplyStatsTest) {
+    auto hm = std::make_unique<HintManager>(nm_, actions_);
+    EXPECT_TRUE(InitHintStatus(hm));
+    EXPECT_TRUE(hm->Start());
+    EXPECT_TRUE(hm->DoHint("INTERACTION"));
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    HintStats interaction_stats(hm->GetHintStats("INTERACTION"));
+    EXPECT_EQ(1u, interaction_stats.apply_latency.count);
+    EXPECT_LT(std::chrono::nanoseconds::zero(), interaction_stats.apply_latency.p50);
+    EXPECT_EQ(3u, interaction_stats.write_latency.count);
+    EXPECT_EQ(0u, interaction_stats.shadowed);
+    EXPECT_TRUE(hm->DoHint("LAUNCH"));
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    EXPECT_EQ(1u, hm->GetHintStats("LAUNCH").apply_latency.count);
+    // LAUNCH holds higher priority values on all nodes
+    EXPECT_TRUE(hm->DoHint("INTERACTION"));
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    std::map<std::string, HintStats> all_stats(hm->GetAllHintStats());
+    ASSERT_EQ(2u, all_stats.size());
+    EXPECT_EQ(1u, all_stats["INTERACTION"].apply_latency.count);
+    EXPECT_EQ(3u, all_stats["INTERACTION"].shadowed);
+    EXPECT_EQ(0u, all_stats["LAUNCH"].shadowed);
+}
+
 // Test parsing nodes
 TEST_F(HintManagerTest, ParseNodesTest) {
     std::vector<std::unique_ptr<Node>> nodes =
@@ -434,6 +553,42 @@ TEST_F(HintManagerTest, ParseNodesDuplicatePathTest) {
     EXPECT_EQ(0u, nodes.size());
 }
 
+// Test parsing nodes with DependsOn and WriteGroup
+TEST_F(HintManagerTest, ParseNodesWriteGroupTest) {
+    std::vector<std::unique_ptr<Node>> nodes = HintManager::ParseNodes(kJSON_WRITE_GROUPS);
+    ASSERT_EQ(3u, nodes.size());
+    EXPECT_EQ(0u, nodes[0]->GetDependsOn().size());
+    ASSERT_EQ(1u, nodes[1]->GetDependsOn().size());
+    EXPECT_EQ("CPUCluster0MinFreq", nodes[1]->GetDependsOn()[0]);
+    EXPECT_EQ("", nodes[0]->GetWriteGroup());
+    EXPECT_EQ("", nodes[1]->GetWriteGroup());
+    EXPECT_EQ("mode", nodes[2]->GetWriteGroup());
+}
+
+// Test parsing nodes with undefined dependency
+TEST_F(HintManagerTest, ParseNodesInvalidDependsOnTest) {
+    std::string json_doc = kJSON_WRITE_GROUPS;
+    std::string from = R"("CPUCluster0MinFreq"
+            ])";
+    size_t start_pos = json_doc.find(from);
+    ASSERT_NE(std::string::npos, start_pos);
+    json_doc.replace(start_pos, from.length(), R"("NON_EXIST"
+            ])");
+    std::vector<std::unique_ptr<Node>> nodes = HintManager::ParseNodes(json_doc);
+    EXPECT_EQ(0u, nodes.size());
+}
+
+// Test parsing nodes with DependsOn across write groups
+TEST_F(HintManagerTest, ParseNodesDependsOnWriteGroupTest) {
+    std::string json_doc = kJSON_WRITE_GROUPS;
+    std::string from = R"("DependsOn": [)";
+    size_t start_pos = json_doc.find(from);
+    ASSERT_NE(std::string::npos, start_pos);
+    json_doc.replace(start_pos, from.length(), R"("WriteGroup": "cpu", "DependsOn": [)");
+    std::vector<std::unique_ptr<Node>> nodes = HintManager::ParseNodes(json_doc);
+    EXPECT_EQ(0u, nodes.size());
+}
+
 // Test parsing file node with duplicate value
 TEST_F(HintManagerTest, ParseFileNodesDuplicateValueTest) {
     std::string from = "1512000";
@@ -593,6 +748,226 @@ TEST_F(HintManagerTest, ParseBadActionsTest) {
     EXPECT_EQ(0u, actions.size());
 }
 
+// Append an AdpfConfig section with the given body to json_doc
+static std::string _AddAdpfConfig(const std::string &json_doc, const std::string &adpf) {
+    std::string doc = json_doc;
+    doc.insert(doc.rfind('}'), ",\n    \"AdpfConfig\": " + adpf + "\n");
+    return doc;
+}
+
+// Test parsing AdpfConfig section
+TEST_F(HintManagerTest, ParseAdpfConfigTest) {
+    AdpfConfig config;
+    // Absent section gives the defaults
+    EXPECT_TRUE(ParseAdpfConfig(json_doc_, &config));
+    EXPECT_EQ(RefreshRateSwitchConfig::IntegralPolicy::NONE,
+              config.refresh_rate_switch.integral);
+    EXPECT_FALSE(config.refresh_rate_switch.scale_stale_timeout);
+    EXPECT_EQ(0, config.refresh_rate_switch.preboost_uclamp_min);
+
+    std::string json_doc = _AddAdpfConfig(json_doc_, R"({"RefreshRateSwitch": {
+        "Integral": "Rescale", "ScaleStaleTimeout": true,
+        "PreBoostUclampMin": 512, "PreBoostDuration": 50}})");
+    EXPECT_TRUE(ParseAdpfConfig(json_doc, &config));
+    EXPECT_EQ(RefreshRateSwitchConfig::IntegralPolicy::RESCALE,
+              config.refresh_rate_switch.integral);
+    EXPECT_TRUE(config.refresh_rate_switch.scale_stale_timeout);
+    EXPECT_EQ(512, config.refresh_rate_switch.preboost_uclamp_min);
+    EXPECT_EQ(50ms, config.refresh_rate_switch.preboost_duration);
+
+    json_doc = _AddAdpfConfig(json_doc_, R"({"RefreshRateSwitch": {"Integral": "Reset"}})");
+    EXPECT_TRUE(ParseAdpfConfig(json_doc, &config));
+    EXPECT_EQ(RefreshRateSwitchConfig::IntegralPolicy::RESET,
+              config.refresh_rate_switch.integral);
+    EXPECT_EQ(0, config.refresh_rate_switch.preboost_uclamp_min);
+
+    json_doc = _AddAdpfConfig(json_doc_, R"({"RefreshRateSwitch": {"Integral": "Hold"}})");
+    EXPECT_FALSE(ParseAdpfConfig(json_doc, &config));
+    json_doc = _AddAdpfConfig(json_doc_, R"({"RefreshRateSwitch": {"PreBoostUclampMin": 2048}})");
+    EXPECT_FALSE(ParseAdpfConfig(json_doc, &config));
+    json_doc = _AddAdpfConfig(json_doc_, R"({"RefreshRateSwitch": {"PreBoostDuration": -1}})");
+    EXPECT_FALSE(ParseAdpfConfig(json_doc, &config));
+}
+
+// Test parsing AdpfConfig profiles
+TEST_F(HintManagerTest, ParseAdpfProfilesTest) {
+    AdpfConfig config;
+    EXPECT_TRUE(ParseAdpfConfig(json_doc_, &config));
+    ASSERT_EQ(1u, config.profiles.size());
+    EXPECT_EQ("pid", config.profiles[0].controller);
+
+    std::string json_doc = _AddAdpfConfig(json_doc_, R"({"Profiles": [
+        {"Name": "Default", "PID_Po": 3.0, "UclampMin_High": 400, "StaleTimeFactor": 10},
+        {"Name": "Game", "Uids": [10100], "Modes": ["GAME"], "Controller": "adaptive",
+         "PID_I": 0.002}]})");
+    EXPECT_TRUE(ParseAdpfConfig(json_doc, &config));
+    ASSERT_EQ(2u, config.profiles.size());
+    EXPECT_DOUBLE_EQ(3.0, config.profiles[0].controller_config.p_over);
+    EXPECT_EQ(400, config.profiles[0].controller_config.uclamp_min_high);
+    EXPECT_EQ(10u, config.profiles[0].stale_time_factor);
+    const AdpfProfile &game = config.profiles[1];
+    EXPECT_EQ("Game", game.name);
+    EXPECT_EQ("adaptive", game.controller);
+    EXPECT_EQ(std::vector<int32_t>({10100}), game.uids);
+    EXPECT_EQ(std::vector<std::string>({"GAME"}), game.modes);
+    EXPECT_DOUBLE_EQ(0.002, game.controller_config.i);
+    // Inherited from the default profile
+    EXPECT_DOUBLE_EQ(3.0, game.controller_config.p_over);
+    EXPECT_EQ(10u, game.stale_time_factor);
+
+    const std::vector<std::string> bad_profiles = {
+            R"([])",
+            R"([{"PID_Po": 1.0}])",
+            R"([{"Name": "A"}, {"Name": "A"}])",
+            R"([{"Name": "A", "Controller": "fuzzy"}])",
+            R"([{"Name": "A", "PID_Pover": 1.0}])",
+            R"([{"Name": "A", "PID_Po": "high"}])",
+            R"([{"Name": "A", "Uids": ["app"]}])",
+            R"([{"Name": "A", "Modes": "GAME"}])",
+            R"([{"Name": "A", "StaleTimeFactor": 0}])",
+    };
+    for (const auto &profiles : bad_profiles) {
+        json_doc = _AddAdpfConfig(json_doc_, R"({"Profiles": )" + profiles + "}");
+        EXPECT_FALSE(ParseAdpfConfig(json_doc, &config)) << profiles;
+    }
+}
+
+// Test parsing AdpfConfig escalation
+TEST_F(HintManagerTest, ParseAdpfEscalationTest) {
+    AdpfConfig config;
+    EXPECT_TRUE(ParseAdpfConfig(json_doc_, &config));
+    EXPECT_TRUE(config.escalation.hint.empty());
+
+    std::string json_doc = _AddAdpfConfig(json_doc_, R"({"Escalation": {
+        "Hint": "LAUNCH", "EnterReports": 5, "ExitReports": 3,
+        "EnterFraction": 0.75, "ExitFraction": 0.25, "Duration": 200}})");
+    EXPECT_TRUE(ParseAdpfConfig(json_doc, &config));
+    EXPECT_EQ("LAUNCH", config.escalation.hint);
+    EXPECT_EQ(5u, config.escalation.enter_reports);
+    EXPECT_EQ(3u, config.escalation.exit_reports);
+    EXPECT_DOUBLE_EQ(0.75, config.escalation.enter_fraction);
+    EXPECT_DOUBLE_EQ(0.25, config.escalation.exit_fraction);
+    EXPECT_EQ(200ms, config.escalation.duration);
+
+    const std::vector<std::string> bad_escalations = {
+            R"({"EnterReports": 5})",
+            R"({"Hint": "LAUNCH", "ExitReports": 0})",
+            R"({"Hint": "LAUNCH", "EnterFraction": 1.5})",
+            R"({"Hint": "LAUNCH", "EnterFraction": 0.5, "ExitFraction": 0.75})",
+            R"({"Hint": "LAUNCH", "Duration": 0})",
+    };
+    for (const auto &escalation : bad_escalations) {
+        json_doc = _AddAdpfConfig(json_doc_, R"({"Escalation": )" + escalation + "}");
+        EXPECT_FALSE(ParseAdpfConfig(json_doc, &config)) << escalation;
+    }
+
+    // The hint is resolved to its id when the config is loaded
+    TemporaryFile escalation_file;
+    ASSERT_TRUE(android::base::WriteStringToFile(
+            _AddAdpfConfig(json_doc_, R"({"Escalation": {"Hint": "LAUNCH"}})"),
+            escalation_file.path))
+            << strerror(errno);
+    std::unique_ptr<HintManager> hm = HintManager::GetFromJSON(escalation_file.path, false);
+    ASSERT_NE(nullptr, hm.get());
+    EXPECT_EQ(HintIdRegistry::Intern("LAUNCH"), hm->GetAdpfConfig()->escalation.hint_id);
+
+    // The hint has to be defined in Actions
+    TemporaryFile json_file;
+    ASSERT_TRUE(android::base::WriteStringToFile(
+            _AddAdpfConfig(json_doc_, R"({"Escalation": {"Hint": "ADPF_SATURATED"}})"),
+            json_file.path))
+            << strerror(errno);
+    EXPECT_EQ(nullptr, HintManager::GetFromJSON(json_file.path, false));
+}
+
+// Test AdpfConfig is loaded with the config and swapped on reload
+TEST_F(HintManagerTest, AdpfConfigReloadTest) {
+    TemporaryFile json_file;
+    ASSERT_TRUE(android::base::WriteStringToFile(json_doc_, json_file.path)) << strerror(errno);
+    std::unique_ptr<HintManager> hm = HintManager::GetFromJSON(json_file.path, false);
+    ASSERT_NE(nullptr, hm.get());
+    std::shared_ptr<const AdpfConfig> config = hm->GetAdpfConfig();
+    ASSERT_NE(nullptr, config.get());
+    EXPECT_EQ(0, config->refresh_rate_switch.preboost_uclamp_min);
+
+    TemporaryFile reload_file;
+    ASSERT_TRUE(android::base::WriteStringToFile(
+            _AddAdpfConfig(json_doc_, R"({"RefreshRateSwitch": {"PreBoostUclampMin": 300}})"),
+            reload_file.path))
+            << strerror(errno);
+    EXPECT_TRUE(hm->Reload(reload_file.path));
+    EXPECT_EQ(300, hm->GetAdpfConfig()->refresh_rate_switch.preboost_uclamp_min);
+    // Snapshots taken before the reload stay valid
+    EXPECT_EQ(0, config->refresh_rate_switch.preboost_uclamp_min);
+
+    // A malformed section fails the reload and keeps the current config
+    TemporaryFile invalid_file;
+    ASSERT_TRUE(android::base::WriteStringToFile(
+            _AddAdpfConfig(json_doc_, R"({"RefreshRateSwitch": {"Integral": 1}})"),
+            invalid_file.path))
+            << strerror(errno);
+    EXPECT_FALSE(hm->Reload(invalid_file.path));
+    EXPECT_EQ(300, hm->GetAdpfConfig()->refresh_rate_switch.preboost_uclamp_min);
+}
+
+// Test parsing BoostArbiter section
+TEST_F(HintManagerTest, ParseBoostPolicyTest) {
+    BoostPolicy policy;
+    // Absent section gives no rules
+    EXPECT_TRUE(ParseBoostPolicy(json_doc_, &policy));
+    EXPECT_TRUE(policy.rules.empty());
+
+    std::string json_doc = json_doc_;
+    json_doc.insert(json_doc.rfind('}'), R"(,
+    "BoostArbiter": {"Rules": [
+        {"WhileModes": ["THERMAL_SKIN_SEVERE"], "Sources": ["Interaction", "Boost"],
+         "Hints": ["INTERACTION"], "MaxPriority": 10, "MaxDuration": 200},
+        {"WhileModes": ["THERMAL_SKIN_CRITICAL"], "Drop": true}
+    ]})");
+    EXPECT_TRUE(ParseBoostPolicy(json_doc, &policy));
+    ASSERT_EQ(2u, policy.rules.size());
+    EXPECT_EQ(std::vector<HintId>{HintIdRegistry::Intern("THERMAL_SKIN_SEVERE")},
+              policy.rules[0].modes);
+    EXPECT_EQ((1u << static_cast<uint32_t>(BoostSource::INTERACTION)) |
+                      (1u << static_cast<uint32_t>(BoostSource::BOOST)),
+              policy.rules[0].sources);
+    EXPECT_EQ(std::vector<HintId>{HintIdRegistry::Intern("INTERACTION")}, policy.rules[0].hints);
+    EXPECT_EQ(10, policy.rules[0].max_priority);
+    EXPECT_FALSE(policy.rules[0].drop);
+    EXPECT_EQ(200ms, policy.rules[0].max_duration);
+    EXPECT_TRUE(policy.rules[1].drop);
+    EXPECT_EQ(0u, policy.rules[1].sources);
+
+    const std::vector<std::string> bad_rules = {
+            R"({"Sources": ["Interaction"]})",
+            R"({"Drop": true, "MaxDuration": 100})",
+            R"({"Sources": ["Thermal"], "Drop": true})",
+            R"({"Hints": "INTERACTION", "Drop": true})",
+            R"({"MaxDuration": 0})",
+    };
+    for (const auto &rule : bad_rules) {
+        json_doc = json_doc_;
+        json_doc.insert(json_doc.rfind('}'), R"(, "BoostArbiter": {"Rules": [)" + rule + "]}");
+        EXPECT_FALSE(ParseBoostPolicy(json_doc, &policy)) << rule;
+    }
+}
+
+// Test hint timeout and level used by the arbiter
+TEST_F(HintManagerTest, GetHintInfoTest) {
+    auto hm = std::make_unique<HintManager>(nm_, actions_);
+    EXPECT_TRUE(InitHintStatus(hm));
+    std::chrono::milliseconds timeout;
+    double level;
+    // One node action is forever, value1 of 3 nodes defaulting to value2
+    EXPECT_TRUE(hm->GetHintInfo(HintIdRegistry::Intern("INTERACTION"), &timeout, &level));
+    EXPECT_EQ(0ms, timeout);
+    EXPECT_DOUBLE_EQ(1.5, level);
+    EXPECT_TRUE(hm->GetHintInfo(HintIdRegistry::Intern("LAUNCH"), &timeout, &level));
+    EXPECT_EQ(0ms, timeout);
+    EXPECT_DOUBLE_EQ(3.0, level);
+    EXPECT_FALSE(hm->GetHintInfo(HintIdRegistry::Intern("NO_SUCH_HINT"), &timeout, &level));
+}
+
 // Test hint/cancel/expire with json config
 TEST_F(HintManagerTest, GetFromJSONTest) {
     TemporaryFile json_file;
@@ -673,5 +1048,294 @@ TEST_F(HintManagerTest, GetFromJSONTest) {
     _VerifyPropertyValue(prop_, "HIGH");
 }
 
+// Test reloading config with requests in flight
+TEST_F(HintManagerTest, ReloadTest) {
+    TemporaryFile json_file;
+    ASSERT_TRUE(android::base::WriteStringToFile(json_doc_, json_file.path)) << strerror(errno);
+    std::unique_ptr<HintManager> hm = HintManager::GetFromJSON(json_file.path);
+    EXPECT_NE(nullptr, hm.get());
+    EXPECT_EQ(json_file.path, hm->GetConfigPath());
+    EXPECT_TRUE(hm->DoHint("LAUNCH"));
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    _VerifyPathValue(files_[0 + 2]->path, "1134000");
+    _VerifyPathValue(files_[1 + 2]->path, "1512000");
+    _VerifyPropertyValue(prop_, "HIGH");
+    // Rename ModeProperty, so the old node is removed from the config
+    std::string json_doc = json_doc_;
+    const std::string from = "ModeProperty";
+    for (size_t pos = json_doc.find(from); pos != std::string::npos;
+         pos = json_doc.find(from, pos + from.length() + 1)) {
+        json_doc.replace(pos, from.length(), "ModeProperty2");
+    }
+    TemporaryFile reload_file;
+    ASSERT_TRUE(android::base::WriteStringToFile(json_doc, reload_file.path)) << strerror(errno);
+    EXPECT_TRUE(hm->Reload(reload_file.path));
+    EXPECT_EQ(reload_file.path, hm->GetConfigPath());
+    EXPECT_TRUE(hm->IsRunning());
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    // LAUNCH requests migrated, removed node reset
+    _VerifyPathValue(files_[0 + 2]->path, "1134000");
+    _VerifyPathValue(files_[1 + 2]->path, "1512000");
+    _VerifyPropertyValue(prop_, "NONE");
+    EXPECT_EQ(1u, hm->GetHintStats("LAUNCH").count);
+    std::this_thread::sleep_for(500ms);
+    // Migrated "LAUNCH" node0 expired
+    _VerifyPathValue(files_[0 + 2]->path, "384000");
+    _VerifyPathValue(files_[1 + 2]->path, "1512000");
+    EXPECT_TRUE(hm->DoHint("INTERACTION"));
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    _VerifyPropertyValue(prop_, "LOW");
+    // Invalid config keeps the current one
+    TemporaryFile invalid_file;
+    ASSERT_TRUE(android::base::WriteStringToFile("{}", invalid_file.path)) << strerror(errno);
+    EXPECT_FALSE(hm->Reload(invalid_file.path));
+    EXPECT_EQ(reload_file.path, hm->GetConfigPath());
+    EXPECT_TRUE(hm->EndHint("LAUNCH"));
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    _VerifyPathValue(files_[1 + 2]->path, "1134000");
+    _VerifyPropertyValue(prop_, "LOW");
+}
+
+// Test reload gives up on calls that do not finish on the old config
+TEST_F(HintManagerTest, ReloadTimeoutTest) {
+    TemporaryFile json_file;
+    ASSERT_TRUE(android::base::WriteStringToFile(json_doc_, json_file.path)) << strerror(errno);
+    std::unique_ptr<HintManager> hm = HintManager::GetFromJSON(json_file.path);
+    EXPECT_NE(nullptr, hm.get());
+    // DumpToFd blocks on a full pipe while holding the config
+    int fds[2];
+    ASSERT_EQ(0, pipe2(fds, O_NONBLOCK)) << strerror(errno);
+    const std::string fill(4096, 'x');
+    while (write(fds[1], fill.data(), fill.size()) > 0) {
+    }
+    ASSERT_EQ(0, fcntl(fds[1], F_SETFL, 0)) << strerror(errno);
+    std::thread dump([&hm, &fds] { hm->DumpToFd(fds[1]); });
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    TemporaryFile reload_file;
+    ASSERT_TRUE(android::base::WriteStringToFile(json_doc_, reload_file.path)) << strerror(errno);
+    std::future<bool> reload = std::async(std::launch::async, [&hm, &reload_file] {
+        return hm->Reload(reload_file.path);
+    });
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    // Path is not blocked by the pending reload
+    EXPECT_EQ(json_file.path, hm->GetConfigPath());
+    EXPECT_FALSE(reload.get());
+    EXPECT_EQ(json_file.path, hm->GetConfigPath());
+    EXPECT_TRUE(hm->IsRunning());
+    // Old looper still takes requests
+    EXPECT_TRUE(hm->DoHint("INTERACTION"));
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    _VerifyPropertyValue(prop_, "LOW");
+    // Drain the pipe so the dump returns, then the reload goes through
+    ASSERT_EQ(0, fcntl(fds[0], F_SETFL, 0)) << strerror(errno);
+    std::thread drain([&fds] {
+        char buf[4096];
+        while (read(fds[0], buf, sizeof(buf)) > 0) {
+        }
+    });
+    dump.join();
+    close(fds[1]);
+    drain.join();
+    close(fds[0]);
+    EXPECT_TRUE(hm->Reload(reload_file.path));
+    EXPECT_EQ(reload_file.path, hm->GetConfigPath());
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    _VerifyPropertyValue(prop_, "LOW");
+}
+
+// Test compiling config into image and loading it back
+TEST_F(HintManagerTest, ConfigImageTest) {
+    TemporaryFile json_file;
+    ASSERT_TRUE(android::base::WriteStringToFile(json_doc_, json_file.path))
+        << strerror(errno);
+    const std::string image_path = ConfigImage::GetImagePath(json_file.path);
+    ASSERT_TRUE(HintManager::CompileConfig(json_file.path, image_path));
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::unordered_map<std::string, Hint> actions;
+    AdpfConfig adpf;
+    BoostPolicy boost_policy;
+    ASSERT_TRUE(ConfigImage::Load(image_path, json_doc_, &nodes, &actions, &adpf, &boost_policy));
+    std::vector<std::unique_ptr<Node>> nodes_parsed = HintManager::ParseNodes(json_doc_);
+    ASSERT_EQ(nodes_parsed.size(), nodes.size());
+    for (std::size_t i = 0; i < nodes.size(); i++) {
+        EXPECT_EQ(nodes_parsed[i]->GetName(), nodes[i]->GetName());
+        EXPECT_EQ(nodes_parsed[i]->GetPath(), nodes[i]->GetPath());
+        EXPECT_EQ(nodes_parsed[i]->GetValues(), nodes[i]->GetValues());
+        EXPECT_EQ(nodes_parsed[i]->GetDefaultIndex(), nodes[i]->GetDefaultIndex());
+        EXPECT_EQ(nodes_parsed[i]->GetResetOnInit(), nodes[i]->GetResetOnInit());
+        EXPECT_EQ(nodes_parsed[i]->GetDependsOn(), nodes[i]->GetDependsOn());
+        EXPECT_EQ(nodes_parsed[i]->GetWriteGroup(), nodes[i]->GetWriteGroup());
+    }
+    // no dynamic_cast intentionally in Android
+    EXPECT_TRUE(reinterpret_cast<FileNode*>(nodes[1].get())->GetHoldFd());
+    std::unordered_map<std::string, Hint> actions_parsed =
+            HintManager::ParseActions(json_doc_, nodes_parsed);
+    ASSERT_EQ(actions_parsed.size(), actions.size());
+    for (const auto& a : actions_parsed) {
+        const Hint& hint = actions[a.first];
+        ASSERT_EQ(a.second.node_actions.size(), hint.node_actions.size());
+        for (std::size_t i = 0; i < hint.node_actions.size(); i++) {
+            EXPECT_EQ(a.second.node_actions[i].node_index, hint.node_actions[i].node_index);
+            EXPECT_EQ(a.second.node_actions[i].value_index, hint.node_actions[i].value_index);
+            EXPECT_EQ(a.second.node_actions[i].timeout_ms, hint.node_actions[i].timeout_ms);
+        }
+        ASSERT_EQ(a.second.hint_actions.size(), hint.hint_actions.size());
+        for (std::size_t i = 0; i < hint.hint_actions.size(); i++) {
+            EXPECT_EQ(a.second.hint_actions[i].type, hint.hint_actions[i].type);
+            EXPECT_EQ(a.second.hint_actions[i].value, hint.hint_actions[i].value);
+        }
+    }
+    // HintManager built from image
+    std::unique_ptr<HintManager> hm = HintManager::GetFromJSON(json_file.path);
+    EXPECT_NE(nullptr, hm.get());
+    EXPECT_TRUE(hm->IsRunning());
+    EXPECT_TRUE(hm->DoHint("LAUNCH"));
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    _VerifyPathValue(files_[0 + 2]->path, "1134000");
+    _VerifyPathValue(files_[1 + 2]->path, "1512000");
+    _VerifyPropertyValue(prop_, "HIGH");
+    hm.reset();
+    // Stale image is rejected, JSON still loads
+    json_doc_ += "\n";
+    ASSERT_TRUE(android::base::WriteStringToFile(json_doc_, json_file.path));
+    EXPECT_FALSE(ConfigImage::Load(image_path, json_doc_, &nodes, &actions, &adpf, &boost_policy));
+    hm = HintManager::GetFromJSON(json_file.path, false);
+    EXPECT_NE(nullptr, hm.get());
+    // Truncated image is rejected
+    std::string image;
+    ASSERT_TRUE(HintManager::CompileConfig(json_file.path, image_path));
+    ASSERT_TRUE(android::base::ReadFileToString(image_path, &image));
+    image.resize(image.size() / 2);
+    ASSERT_TRUE(android::base::WriteStringToFile(image, image_path));
+    EXPECT_FALSE(ConfigImage::Load(image_path, json_doc_, &nodes, &actions, &adpf, &boost_policy));
+    unlink(image_path.c_str());
+    EXPECT_FALSE(ConfigImage::Load(image_path, json_doc_, &nodes, &actions, &adpf, &boost_policy));
+}
+
+// Test ADPF settings are compiled into the image and loaded back
+TEST_F(HintManagerTest, ConfigImageAdpfTest) {
+    const std::string json_doc = _AddAdpfConfig(json_doc_, R"({"Profiles": [
+        {"Name": "Default", "PID_Po": 3.0, "StaleTimeFactor": 10},
+        {"Name": "Game", "Uids": [10100], "Modes": ["GAME"], "Controller": "adaptive",
+         "PID_I": 0.002}],
+        "RefreshRateSwitch": {"Integral": "Rescale", "PreBoostUclampMin": 300,
+                              "PreBoostDuration": 50},
+        "Escalation": {"Hint": "LAUNCH", "EnterReports": 5, "ExitFraction": 0.25}})");
+    TemporaryFile json_file;
+    ASSERT_TRUE(android::base::WriteStringToFile(json_doc, json_file.path)) << strerror(errno);
+    const std::string image_path = ConfigImage::GetImagePath(json_file.path);
+    ASSERT_TRUE(HintManager::CompileConfig(json_file.path, image_path));
+    AdpfConfig parsed;
+    ASSERT_TRUE(ParseAdpfConfig(json_doc, &parsed));
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::unordered_map<std::string, Hint> actions;
+    AdpfConfig adpf;
+    BoostPolicy boost_policy;
+    ASSERT_TRUE(ConfigImage::Load(image_path, json_doc, &nodes, &actions, &adpf, &boost_policy));
+    ASSERT_EQ(parsed.profiles.size(), adpf.profiles.size());
+    for (std::size_t i = 0; i < adpf.profiles.size(); i++) {
+        EXPECT_EQ(parsed.profiles[i].name, adpf.profiles[i].name);
+        EXPECT_EQ(parsed.profiles[i].controller, adpf.profiles[i].controller);
+        EXPECT_EQ(parsed.profiles[i].stale_time_factor, adpf.profiles[i].stale_time_factor);
+        EXPECT_EQ(parsed.profiles[i].uids, adpf.profiles[i].uids);
+        EXPECT_EQ(parsed.profiles[i].modes, adpf.profiles[i].modes);
+        EXPECT_DOUBLE_EQ(parsed.profiles[i].controller_config.p_over,
+                         adpf.profiles[i].controller_config.p_over);
+        EXPECT_DOUBLE_EQ(parsed.profiles[i].controller_config.i,
+                         adpf.profiles[i].controller_config.i);
+    }
+    EXPECT_EQ(RefreshRateSwitchConfig::IntegralPolicy::RESCALE,
+              adpf.refresh_rate_switch.integral);
+    EXPECT_EQ(300, adpf.refresh_rate_switch.preboost_uclamp_min);
+    EXPECT_EQ(50ms, adpf.refresh_rate_switch.preboost_duration);
+    EXPECT_EQ("LAUNCH", adpf.escalation.hint);
+    EXPECT_EQ(5u, adpf.escalation.enter_reports);
+    EXPECT_DOUBLE_EQ(0.25, adpf.escalation.exit_fraction);
+    EXPECT_EQ(parsed.escalation.duration, adpf.escalation.duration);
+    // HintManager takes the ADPF settings from the image
+    std::unique_ptr<HintManager> hm = HintManager::GetFromJSON(json_file.path, false);
+    ASSERT_NE(nullptr, hm.get());
+    ASSERT_EQ(2u, hm->GetAdpfConfig()->profiles.size());
+    EXPECT_EQ("Game", hm->GetAdpfConfig()->profiles[1].name);
+    // An unknown controller is rejected like in the JSON
+    std::string image;
+    ASSERT_TRUE(android::base::ReadFileToString(image_path, &image));
+    const std::size_t controller = image.find("adaptive");
+    ASSERT_NE(std::string::npos, controller);
+    std::string bad_image = image;
+    bad_image[controller] = 'X';
+    ASSERT_TRUE(android::base::WriteStringToFile(bad_image, image_path));
+    EXPECT_FALSE(ConfigImage::Load(image_path, json_doc, &nodes, &actions, &adpf, &boost_policy));
+    // So is a table whose entries do not have the size of this build, the
+    // entry size of the nodes table follows magic, version, byte order, the
+    // source hash and size and the strings table
+    bad_image = image;
+    constexpr std::size_t kNodesEntrySize = 8 + 4 + 4 + 8 + 8 + 12 + 8;
+    bad_image[kNodesEntrySize]++;
+    ASSERT_TRUE(android::base::WriteStringToFile(bad_image, image_path));
+    EXPECT_FALSE(ConfigImage::Load(image_path, json_doc, &nodes, &actions, &adpf, &boost_policy));
+    ASSERT_TRUE(android::base::WriteStringToFile(image, image_path));
+    EXPECT_TRUE(ConfigImage::Load(image_path, json_doc, &nodes, &actions, &adpf, &boost_policy));
+    unlink(image_path.c_str());
+}
+
+// Test the boost policy is compiled into the image and loaded back
+TEST_F(HintManagerTest, ConfigImageBoostPolicyTest) {
+    std::string json_doc = json_doc_;
+    json_doc.insert(json_doc.rfind('}'), R"(,
+    "BoostArbiter": {"Rules": [
+        {"WhileModes": ["THERMAL_SKIN_SEVERE"], "Sources": ["Interaction", "Boost"],
+         "Hints": ["INTERACTION", "LAUNCH"], "MaxPriority": 10, "MaxDuration": 200},
+        {"WhileModes": ["THERMAL_SKIN_CRITICAL"], "Drop": true}
+    ]})");
+    TemporaryFile json_file;
+    ASSERT_TRUE(android::base::WriteStringToFile(json_doc, json_file.path)) << strerror(errno);
+    const std::string image_path = ConfigImage::GetImagePath(json_file.path);
+    ASSERT_TRUE(HintManager::CompileConfig(json_file.path, image_path));
+    BoostPolicy parsed;
+    ASSERT_TRUE(ParseBoostPolicy(json_doc, &parsed));
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::unordered_map<std::string, Hint> actions;
+    AdpfConfig adpf;
+    BoostPolicy boost_policy;
+    ASSERT_TRUE(ConfigImage::Load(image_path, json_doc, &nodes, &actions, &adpf, &boost_policy));
+    ASSERT_EQ(parsed.rules.size(), boost_policy.rules.size());
+    for (std::size_t i = 0; i < boost_policy.rules.size(); i++) {
+        EXPECT_EQ(parsed.rules[i].modes, boost_policy.rules[i].modes);
+        EXPECT_EQ(parsed.rules[i].sources, boost_policy.rules[i].sources);
+        EXPECT_EQ(parsed.rules[i].hints, boost_policy.rules[i].hints);
+        EXPECT_EQ(parsed.rules[i].max_priority, boost_policy.rules[i].max_priority);
+        EXPECT_EQ(parsed.rules[i].drop, boost_policy.rules[i].drop);
+        EXPECT_EQ(parsed.rules[i].max_duration, boost_policy.rules[i].max_duration);
+    }
+    std::unique_ptr<HintManager> hm = HintManager::GetFromJSON(json_file.path, false);
+    ASSERT_NE(nullptr, hm.get());
+    EXPECT_EQ(2u, hm->GetBoostPolicy()->rules.size());
+    unlink(image_path.c_str());
+}
+
+// Test image path derived from config path
+TEST(ConfigImageTest, GetImagePath) {
+    EXPECT_EQ("/vendor/etc/powerhint.bin",
+              ConfigImage::GetImagePath("/vendor/etc/powerhint.json"));
+    EXPECT_EQ("/data/powerhint.bin", ConfigImage::GetImagePath("/data/powerhint"));
+}
+
+// Test DoHint latency histogram
+TEST(LatencyHistogramTest, Percentile) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(0u, histogram.Count());
+    EXPECT_EQ(0ns, histogram.Percentile(50));
+    for (int i = 1; i <= 100; i++) {
+        histogram.Record(std::chrono::microseconds(i));
+    }
+    EXPECT_EQ(100u, histogram.Count());
+    // Buckets are within 12.5% of the recorded value
+    EXPECT_GE(histogram.Percentile(50), 50us);
+    EXPECT_LE(histogram.Percentile(50), 57us);
+    EXPECT_GE(histogram.Percentile(99), 99us);
+    EXPECT_LE(histogram.Percentile(99), 112us);
+}
+
 }  // namespace perfmgr
 }  // namespace android
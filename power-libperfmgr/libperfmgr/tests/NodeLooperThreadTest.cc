@@ -33,6 +33,8 @@ constexpr auto kSLEEP_TOLERANCE_MS = 50ms;
 class NodeLooperThreadTest : public ::testing::Test {
   protected:
     virtual void SetUp() {
+        HintIdRegistry::Intern("INTERACTION");
+        HintIdRegistry::Intern("LAUNCH");
         std::unique_ptr<TemporaryFile> tf = std::make_unique<TemporaryFile>();
         nodes_.emplace_back(new FileNode(
             "n0", tf->path, {{"n0_value0"}, {"n0_value1"}, {"n0_value2"}}, 2,
@@ -191,5 +193,213 @@ TEST_F(NodeLooperThreadTest, MultipleRequest) {
     EXPECT_FALSE(th->isRunning());
 }
 
+// Test request with legacy full update mode
+TEST_F(NodeLooperThreadTest, AddRequestFullUpdate) {
+    sp<NodeLooperThread> th = new NodeLooperThread(std::move(nodes_), true);
+    EXPECT_TRUE(th->Start());
+    EXPECT_TRUE(th->isRunning());
+    std::vector<NodeAction> actions{{0, 0, 200ms}, {1, 1, 400ms}};
+    EXPECT_TRUE(th->Request(actions, "LAUNCH"));
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    _VerifyPathValue(files_[0]->path, "n0_value0");
+    _VerifyPathValue(files_[1]->path, "n1_value1");
+    std::this_thread::sleep_for(200ms);
+    _VerifyPathValue(files_[0]->path, "n0_value2");
+    _VerifyPathValue(files_[1]->path, "n1_value1");
+    std::this_thread::sleep_for(200ms);
+    _VerifyPathValue(files_[0]->path, "n0_value2");
+    _VerifyPathValue(files_[1]->path, "n1_value2");
+    th->Stop();
+    EXPECT_FALSE(th->isRunning());
+}
+
+// Test dependent node is updated along with a requested node
+TEST_F(NodeLooperThreadTest, DependsOnRequest) {
+    TemporaryDir td;
+    std::string path = std::string(td.path) + "/n2";
+    nodes_.emplace_back(
+            new FileNode("n2", path, {{"n2_value0"}, {"n2_value1"}, {"n2_value2"}}, 2, false));
+    nodes_[1]->SetDependsOn({"n2"});
+    sp<NodeLooperThread> th = new NodeLooperThread(std::move(nodes_));
+    EXPECT_TRUE(th->Start());
+    // Node2 not present yet, its write fails and retries in 500ms
+    std::vector<NodeAction> actions_n2{{2, 0, 0ms}};
+    EXPECT_TRUE(th->Request(actions_n2, "LAUNCH"));
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    ASSERT_TRUE(android::base::WriteStringToFile("", path));
+    // Request on Node1 also re-evaluates Node2 without waiting for retry
+    std::vector<NodeAction> actions_n1{{1, 1, 0ms}};
+    EXPECT_TRUE(th->Request(actions_n1, "INTERACTION"));
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    _VerifyPathValue(files_[0]->path, "");
+    _VerifyPathValue(files_[1]->path, "n1_value1");
+    _VerifyPathValue(path, "n2_value0");
+    th->Stop();
+    EXPECT_FALSE(th->isRunning());
+}
+
+// Stress test with thousands of concurrent timed requests
+TEST_F(NodeLooperThreadTest, ConcurrentTimedRequestStress) {
+    constexpr int kThreads = 4;
+    constexpr int kRequestsPerThread = 1000;
+    sp<NodeLooperThread> th = new NodeLooperThread(std::move(nodes_));
+    EXPECT_TRUE(th->Start());
+    auto start = std::chrono::steady_clock::now();
+    // Highest priority value on both nodes for 200ms
+    std::vector<NodeAction> actions_launch{{0, 0, 200ms}, {1, 0, 200ms}};
+    EXPECT_TRUE(th->Request(actions_launch, "LAUNCH"));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&th, t]() {
+            for (int i = 0; i < kRequestsPerThread; i++) {
+                // Timeouts spread over [250ms, 400ms)
+                auto timeout = std::chrono::milliseconds(250 + (t * kRequestsPerThread + i) % 150);
+                std::vector<NodeAction> actions{{static_cast<std::size_t>(i % 2), 1, timeout}};
+                HintId hint = HintIdRegistry::Intern("HINT_" + std::to_string(t) + "_" +
+                                                     std::to_string(i));
+                EXPECT_TRUE(th->Request(actions, hint));
+                // Cancel every third request right away
+                if (i % 3 == 0) {
+                    EXPECT_TRUE(th->Cancel(actions, hint));
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    auto issued = std::chrono::steady_clock::now();
+    std::this_thread::sleep_until(start + 150ms);
+    _VerifyPathValue(files_[0]->path, "n0_value0");
+    _VerifyPathValue(files_[1]->path, "n1_value0");
+    // LAUNCH expired, the longest timed requests are still active
+    std::this_thread::sleep_until(start + 200ms + kSLEEP_TOLERANCE_MS);
+    _VerifyPathValue(files_[0]->path, "n0_value1");
+    _VerifyPathValue(files_[1]->path, "n1_value1");
+    // All requests expired
+    std::this_thread::sleep_until(issued + 400ms + kSLEEP_TOLERANCE_MS);
+    _VerifyPathValue(files_[0]->path, "n0_value2");
+    _VerifyPathValue(files_[1]->path, "n1_value2");
+    th->Stop();
+    EXPECT_FALSE(th->isRunning());
+}
+
+// Test requests submitted through the lock-free queue
+TEST_F(NodeLooperThreadTest, SubmitRequest) {
+    sp<NodeLooperThread> th = new NodeLooperThread(std::move(nodes_));
+    EXPECT_TRUE(th->Start());
+    EXPECT_TRUE(th->isRunning());
+    std::vector<NodeAction> actions{{0, 0, 200ms}, {1, 1, 400ms}};
+    std::size_t actions_id;
+    EXPECT_TRUE(th->RegisterActions(actions, &actions_id));
+    HintId hint_id = HintIdRegistry::Intern("LAUNCH");
+    EXPECT_FALSE(th->SubmitRequest(actions_id + 1, hint_id));
+    EXPECT_TRUE(th->SubmitRequest(actions_id, hint_id));
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    _VerifyPathValue(files_[0]->path, "n0_value0");
+    _VerifyPathValue(files_[1]->path, "n1_value1");
+    EXPECT_TRUE(th->SubmitCancel(actions_id, hint_id));
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    _VerifyPathValue(files_[0]->path, "n0_value2");
+    _VerifyPathValue(files_[1]->path, "n1_value2");
+    // Override timeout
+    EXPECT_TRUE(th->SubmitRequest(actions_id, hint_id, 100ms));
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    _VerifyPathValue(files_[0]->path, "n0_value0");
+    _VerifyPathValue(files_[1]->path, "n1_value1");
+    std::this_thread::sleep_for(100ms);
+    _VerifyPathValue(files_[0]->path, "n0_value2");
+    _VerifyPathValue(files_[1]->path, "n1_value2");
+    th->Stop();
+    EXPECT_FALSE(th->isRunning());
+}
+
+// Test nodes in different write groups
+TEST_F(NodeLooperThreadTest, WriteGroupRequest) {
+    TemporaryDir td;
+    std::string path = std::string(td.path) + "/n2";
+    nodes_.emplace_back(
+            new FileNode("n2", path, {{"n2_value0"}, {"n2_value1"}, {"n2_value2"}}, 2, false));
+    nodes_[1]->SetWriteGroup("g1");
+    nodes_[2]->SetWriteGroup("g2");
+    // Node0 is pulled into the group of Node2
+    nodes_[0]->SetDependsOn({"n2"});
+    ASSERT_TRUE(android::base::WriteStringToFile("", path));
+    sp<NodeLooperThread> th = new NodeLooperThread(std::move(nodes_));
+    EXPECT_TRUE(th->Start());
+    std::vector<NodeAction> actions{{0, 0, 200ms}, {1, 1, 400ms}, {2, 1, 200ms}};
+    EXPECT_TRUE(th->Request(actions, "LAUNCH"));
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    _VerifyPathValue(files_[0]->path, "n0_value0");
+    _VerifyPathValue(files_[1]->path, "n1_value1");
+    _VerifyPathValue(path, "n2_value1");
+    std::this_thread::sleep_for(200ms);
+    _VerifyPathValue(files_[0]->path, "n0_value2");
+    _VerifyPathValue(files_[1]->path, "n1_value1");
+    _VerifyPathValue(path, "n2_value2");
+    std::this_thread::sleep_for(200ms);
+    _VerifyPathValue(files_[1]->path, "n1_value2");
+    th->Stop();
+    EXPECT_FALSE(th->isRunning());
+}
+
+// Test apply stats are collected, and skipped once dropped while a request is
+// pending
+TEST_F(NodeLooperThreadTest, HintStatsRequest) {
+    sp<NodeLooperThread> th = new NodeLooperThread(std::move(nodes_));
+    HintId launch = HintIdRegistry::Intern("LAUNCH");
+    HintId interaction = HintIdRegistry::Intern("INTERACTION");
+    auto launch_stats = std::make_shared<HintApplyStats>();
+    auto interaction_stats = std::make_shared<HintApplyStats>();
+    th->SetHintStats(launch, launch_stats);
+    th->SetHintStats(interaction, interaction_stats);
+    std::vector<NodeAction> actions{{0, 0, 200ms}};
+    EXPECT_TRUE(th->Request(actions, interaction));
+    EXPECT_TRUE(th->Request(actions, launch));
+    // Requests are recorded when the looper writes them
+    th->SetHintStats(interaction, nullptr);
+    EXPECT_TRUE(th->Start());
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    _VerifyPathValue(files_[0]->path, "n0_value0");
+    EXPECT_EQ(1u, launch_stats->apply_latency.Count());
+    EXPECT_EQ(0u, interaction_stats->apply_latency.Count());
+    th->Stop();
+    EXPECT_FALSE(th->isRunning());
+}
+
+// Test NodeWriterPool runs every task once per Run
+TEST(NodeWriterPoolTest, Run) {
+    NodeWriterPool pool(2);
+    EXPECT_EQ(2u, pool.GetNumThreads());
+    std::vector<std::atomic<int>> counts(5);
+    std::function<void(std::size_t)> task = [&counts](std::size_t i) { counts[i]++; };
+    for (int round = 0; round < 100; round++) {
+        pool.Run(counts.size(), task);
+    }
+    for (const auto& count : counts) {
+        EXPECT_EQ(100, count.load());
+    }
+}
+
+// Test RequestQueue ordering and capacity
+TEST(RequestQueueTest, PushPop) {
+    RequestQueue queue(3);
+    QueuedRequest request{QueuedRequest::Type::Request, 0, 0, ReqTime::max(),
+                          QueuedRequest::kNoOverride};
+    EXPECT_TRUE(queue.Empty());
+    for (HintId i = 0; i < 4; i++) {
+        request.hint_id = i;
+        EXPECT_TRUE(queue.Push(request));
+    }
+    EXPECT_FALSE(queue.Push(request));
+    QueuedRequest out;
+    for (HintId i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.Pop(&out));
+        EXPECT_EQ(i, out.hint_id);
+    }
+    EXPECT_FALSE(queue.Pop(&out));
+    EXPECT_TRUE(queue.Empty());
+}
+
 }  // namespace perfmgr
 }  // namespace android
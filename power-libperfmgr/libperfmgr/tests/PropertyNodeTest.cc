@@ -18,6 +18,7 @@
 #include <android-base/properties.h>
 #include <android-base/stringprintf.h>
 #include <gtest/gtest.h>
+#include <sys/system_properties.h>
 
 #include <algorithm>
 #include <thread>
@@ -32,6 +33,17 @@ using std::literals::chrono_literals::operator""ms;
 constexpr double kTIMING_TOLERANCE_MS = std::chrono::milliseconds(25).count();
 constexpr auto kSLEEP_TOLERANCE_MS = 2ms;
 
+// Hint names used below, the string overloads reject names not interned yet
+class HintNamesEnvironment : public ::testing::Environment {
+  public:
+    void SetUp() override {
+        HintIdRegistry::Intern("INTERACTION");
+        HintIdRegistry::Intern("LAUNCH");
+    }
+};
+::testing::Environment *const kHintNamesEnv =
+        ::testing::AddGlobalTestEnvironment(new HintNamesEnvironment);
+
 static inline void _VerifyPropertyValue(const std::string& path,
                                         const std::string& value) {
     std::string s = android::base::GetProperty(path, "");
@@ -74,13 +86,86 @@ TEST(PropertyNodeTest, DumpToFdTest) {
     t.DumpToFd(dumptf.fd);
     fsync(dumptf.fd);
     std::string buf(
-        android::base::StringPrintf("test_dump\t%s\t1\tvalue1\n", key.c_str()));
+        android::base::StringPrintf("test_dump\t%s\t1\tvalue1\n"
+                                    "\t\tFlushed:\t1\tSuppressed:\t0\n",
+                                    key.c_str()));
     std::string s;
     EXPECT_TRUE(android::base::ReadFileToString(dumptf.path, &s))
         << strerror(errno);
     EXPECT_EQ(buf, s);
 }
 
+// Test DumpToFd serves the last written value
+TEST(PropertyNodeTest, DumpToFdCachedValueTest) {
+    std::string key = _InitProperty("test.libperfmgr.key");
+    PropertyNode t("test_dump", key, {{"value0"}, {"value1"}, {"value2"}}, 1,
+                   true);
+    t.Update(false);
+    EXPECT_TRUE(android::base::SetProperty(key, "other"));
+    TemporaryFile dumptf;
+    t.DumpToFd(dumptf.fd);
+    fsync(dumptf.fd);
+    std::string s;
+    EXPECT_TRUE(android::base::ReadFileToString(dumptf.path, &s))
+        << strerror(errno);
+    EXPECT_EQ(0u, s.find(android::base::StringPrintf("test_dump\t%s\t1\tvalue1\n",
+                                                     key.c_str())));
+}
+
+// Test DumpToFd reads the property back before the first write
+TEST(PropertyNodeTest, DumpToFdNotWrittenTest) {
+    std::string key = _InitProperty("test.libperfmgr.key");
+    EXPECT_TRUE(android::base::SetProperty(key, "other"));
+    PropertyNode t("test_dump", key, {{"value0"}, {"value1"}, {"value2"}}, 1,
+                   false);
+    TemporaryFile dumptf;
+    t.DumpToFd(dumptf.fd);
+    fsync(dumptf.fd);
+    std::string s;
+    EXPECT_TRUE(android::base::ReadFileToString(dumptf.path, &s))
+        << strerror(errno);
+    EXPECT_EQ(0u, s.find(android::base::StringPrintf("test_dump\t%s\t1\tother\n",
+                                                     key.c_str())));
+}
+
+// Test batch writes are deferred to Flush
+TEST(PropertyNodeTest, BatchWritesTest) {
+    std::string key = _InitProperty("test.libperfmgr.key");
+    PropertyNode t("t", key, {{"value0"}, {"value1"}, {"value2"}}, 2, true);
+    t.SetBatchWrites(true);
+    t.Update(false);
+    t.Update(true);
+    _VerifyPropertyValue(key, "");
+    t.Flush();
+    _VerifyPropertyValue(key, "value2");
+    EXPECT_EQ(1u, t.GetFlushedWrites());
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(t.AddRequest(0, "LAUNCH", start + 500ms));
+    t.Update(false);
+    t.Update(true);
+    t.Flush();
+    t.Flush();
+    _VerifyPropertyValue(key, "value0");
+    EXPECT_EQ(2u, t.GetFlushedWrites());
+    EXPECT_EQ(0u, t.GetSuppressedWrites());
+    // Request removed before flush, nothing written
+    EXPECT_TRUE(t.AddRequest(1, "INTERACTION", start + 500ms));
+    t.RemoveRequest("LAUNCH");
+    t.Update(false);
+    EXPECT_TRUE(t.AddRequest(0, "LAUNCH", start + 500ms));
+    t.Update(true);
+    t.Flush();
+    _VerifyPropertyValue(key, "value0");
+    EXPECT_EQ(2u, t.GetFlushedWrites());
+    EXPECT_EQ(1u, t.GetSuppressedWrites());
+    // Leaving batch mode flushes pending write
+    t.RemoveRequest("LAUNCH");
+    t.Update(true);
+    t.SetBatchWrites(false);
+    _VerifyPropertyValue(key, "value1");
+    EXPECT_EQ(3u, t.GetFlushedWrites());
+}
+
 // Test GetValueIndex
 TEST(PropertyNodeTest, GetValueIndexTest) {
     std::string key = _InitProperty("test.libperfmgr.key");
@@ -218,5 +303,26 @@ TEST(PropertyNodeTest, AddRequestTestOverride) {
     EXPECT_EQ(std::chrono::milliseconds::max(), expire_time);
 }
 
+// Test a failed write is retried in 500ms, in batch mode too
+TEST(PropertyNodeTest, AddRequestTestFail) {
+    std::string key = _InitProperty("test.libperfmgr.key");
+    // Values longer than PROP_VALUE_MAX are rejected by the property service
+    std::string too_long(PROP_VALUE_MAX, 'x');
+    PropertyNode t("t", key, {{too_long}, {"value1"}}, 1, true);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(t.AddRequest(0, "INTERACTION", start + 2000ms));
+    std::chrono::milliseconds expire_time = t.Update(true);
+    _VerifyPropertyValue(key, "");
+    EXPECT_NEAR(std::chrono::milliseconds(500).count(), expire_time.count(),
+                kTIMING_TOLERANCE_MS);
+    t.SetBatchWrites(true);
+    expire_time = t.Update(true);
+    EXPECT_NEAR(std::chrono::milliseconds(2000).count(), expire_time.count(),
+                kTIMING_TOLERANCE_MS);
+    expire_time = t.Flush();
+    _VerifyPropertyValue(key, "");
+    EXPECT_EQ(std::chrono::milliseconds(500), expire_time);
+}
+
 }  // namespace perfmgr
 }  // namespace android
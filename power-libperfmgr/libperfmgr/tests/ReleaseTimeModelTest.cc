@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "perfmgr/ReleaseTimeModel.h"
+
+namespace android {
+namespace perfmgr {
+
+using std::literals::chrono_literals::operator""ms;
+
+// Test the learned overshoot is the percentile covering all but the budget
+TEST(ReleaseTimeModelTest, Percentile) {
+    ReleaseTimeModel model(0.1);
+    EXPECT_EQ(1400ms, model.Duration(0ms, 1400ms));
+    // 20 taps settling at 100, 110, ... 290ms after being requested
+    for (int i = 0; i < 20; i++) {
+        const std::chrono::milliseconds settle(100 + 10 * i);
+        model.Record(settle, true, 0ms, 1400ms, 1400ms);
+        if (model.Samples() < ReleaseTimeModel::kMinSamples) {
+            EXPECT_FALSE(model.Overshoot());
+        }
+    }
+    // 18 of 20 settle within 270ms
+    ASSERT_TRUE(model.Overshoot());
+    EXPECT_EQ(270ms, *model.Overshoot());
+    EXPECT_EQ(270ms, model.Duration(0ms, 1400ms));
+    // the overshoot adds to the requested duration, capped by the static one
+    EXPECT_EQ(770ms, model.Duration(500ms, 1400ms));
+    EXPECT_EQ(1400ms, model.Duration(1300ms, 1400ms));
+
+    const ReleaseTimeModel::Stats &stats = model.GetStats();
+    EXPECT_EQ(20u, stats.boosts);
+    EXPECT_EQ(0u, stats.misses);
+    EXPECT_EQ(stats.static_held, stats.held);
+}
+
+// Test boosts that never settle fall back to the static duration
+TEST(ReleaseTimeModelTest, Unsettled) {
+    ReleaseTimeModel model(0.1);
+    for (int i = 0; i < 16; i++) {
+        model.Record(100ms, true, 0ms, 1400ms, 1400ms);
+    }
+    EXPECT_EQ(100ms, model.Duration(0ms, 1400ms));
+    // one in 17 unsettled is within the budget
+    model.Record(1400ms, false, 0ms, 1400ms, 1400ms);
+    EXPECT_EQ(100ms, model.Duration(0ms, 1400ms));
+    // the window forgets them once they are gone
+    for (int i = 0; i < 2; i++) {
+        model.Record(1400ms, false, 0ms, 1400ms, 1400ms);
+    }
+    EXPECT_EQ(1400ms, model.Duration(0ms, 1400ms));
+    for (std::size_t i = 0; i < ReleaseTimeModel::kWindow; i++) {
+        model.Record(200ms, true, 0ms, 1400ms, 1400ms);
+    }
+    EXPECT_EQ(ReleaseTimeModel::kWindow, model.Samples());
+    EXPECT_EQ(200ms, model.Duration(0ms, 1400ms));
+}
+
+// Test the misses and boost time accounting
+TEST(ReleaseTimeModelTest, Stats) {
+    ReleaseTimeModel model(0.05);
+    // settled before the learned duration
+    model.Record(200ms, true, 0ms, 300ms, 1400ms);
+    // released at 300ms, settled at 500ms
+    model.Record(500ms, true, 0ms, 300ms, 1400ms);
+    // released at 300ms, still busy at the static duration
+    model.Record(1400ms, false, 0ms, 300ms, 1400ms);
+    const ReleaseTimeModel::Stats &stats = model.GetStats();
+    EXPECT_EQ(3u, stats.boosts);
+    EXPECT_EQ(2u, stats.misses);
+    EXPECT_EQ(800ms, stats.held);
+    EXPECT_EQ(2100ms, stats.static_held);
+}
+
+}  // namespace perfmgr
+}  // namespace android
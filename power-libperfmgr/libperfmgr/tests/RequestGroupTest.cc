@@ -28,6 +28,17 @@ using std::literals::chrono_literals::operator""ms;
 
 constexpr double kTIMING_TOLERANCE_MS = std::chrono::milliseconds(25).count();
 
+// Hint names used below, the string overloads reject names not interned yet
+class HintNamesEnvironment : public ::testing::Environment {
+  public:
+    void SetUp() override {
+        HintIdRegistry::Intern("INTERACTION");
+        HintIdRegistry::Intern("LAUNCH");
+    }
+};
+::testing::Environment *const kHintNamesEnv =
+        ::testing::AddGlobalTestEnvironment(new HintNamesEnvironment);
+
 // Test GetRequestValue()
 TEST(RequestGroupTest, GetRequestValueTest) {
     std::string test_str = "TESTREQ_1";
@@ -160,5 +171,60 @@ TEST(RequestGroupTest, RemoveRequestTestMultiple) {
     EXPECT_EQ(true, active);
 }
 
+// Test nearest expire time follows extending and removing the earliest request
+TEST(RequestGroupTest, ExpireTimeTestUpdateEarliest) {
+    RequestGroup req("");
+    auto start = std::chrono::steady_clock::now();
+    req.AddRequest("INTERACTION", start + 100ms);
+    req.AddRequest("LAUNCH", start + 300ms);
+    std::chrono::milliseconds expire_time;
+    EXPECT_TRUE(req.GetExpireTime(&expire_time));
+    EXPECT_NEAR(100, expire_time.count(), kTIMING_TOLERANCE_MS);
+    // Extend the earliest request beyond the other one
+    req.AddRequest("INTERACTION", start + 500ms);
+    EXPECT_TRUE(req.GetExpireTime(&expire_time));
+    EXPECT_NEAR(300, expire_time.count(), kTIMING_TOLERANCE_MS);
+    // Remove the earliest request
+    req.RemoveRequest("LAUNCH");
+    EXPECT_TRUE(req.GetExpireTime(&expire_time));
+    EXPECT_NEAR(500, expire_time.count(), kTIMING_TOLERANCE_MS);
+    // Add an earlier request
+    req.AddRequest("LAUNCH", start + 200ms);
+    EXPECT_TRUE(req.GetExpireTime(&expire_time));
+    EXPECT_NEAR(200, expire_time.count(), kTIMING_TOLERANCE_MS);
+}
+
+// Test requests on reserved slots, cleared slots and ids beyond the reserve
+TEST(RequestGroupTest, ReserveRequests) {
+    RequestGroup req("");
+    req.ReserveRequests(HintIdRegistry::Size());
+    auto start = std::chrono::steady_clock::now();
+    const HintId launch = HintIdRegistry::Intern("LAUNCH");
+    EXPECT_TRUE(req.AddRequest(launch, start + 100ms));
+    req.ClearRequests();
+    std::chrono::milliseconds expire_time;
+    EXPECT_FALSE(req.GetExpireTime(&expire_time));
+    EXPECT_TRUE(req.AddRequest(launch, start + 200ms));
+    const HintId late = HintIdRegistry::Intern("RESERVE_LATE");
+    EXPECT_TRUE(req.AddRequest(late, start + 100ms));
+    EXPECT_TRUE(req.GetExpireTime(&expire_time));
+    EXPECT_NEAR(100, expire_time.count(), kTIMING_TOLERANCE_MS);
+    EXPECT_TRUE(req.RemoveRequest(late));
+    EXPECT_TRUE(req.GetExpireTime(&expire_time));
+    EXPECT_NEAR(200, expire_time.count(), kTIMING_TOLERANCE_MS);
+}
+
+// Test names never interned are rejected without growing the registry
+TEST(RequestGroupTest, AddRequestUnknownHint) {
+    RequestGroup req("");
+    std::size_t size = HintIdRegistry::Size();
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(req.AddRequest("UNKNOWN_HINT", start + 100ms));
+    EXPECT_FALSE(req.RemoveRequest("UNKNOWN_HINT"));
+    EXPECT_EQ(size, HintIdRegistry::Size());
+    std::chrono::milliseconds expire_time;
+    EXPECT_FALSE(req.GetExpireTime(&expire_time));
+}
+
 }  // namespace perfmgr
 }  // namespace android
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "perfmgr/SessionController.h"
+
+namespace android {
+namespace perfmgr {
+
+constexpr int64_t kTargetNs = 16666666;
+
+// Test the PID terms of a single report
+TEST(SessionControllerTest, PidUpdate) {
+    ControllerConfig config;
+    PidController pid(config);
+    int64_t duration = 20000000;
+    ControllerOutput out = pid.Update(&duration, 1, kTargetNs);
+    // error 33 (100us), dt 166
+    EXPECT_EQ(33, out.err);
+    EXPECT_EQ(33 * 166, out.integral);
+    EXPECT_EQ(66, out.p_out);
+    EXPECT_EQ(5, out.i_out);
+    EXPECT_EQ(99, out.d_out);
+    EXPECT_EQ(0, out.ff_out);
+    EXPECT_EQ(170, out.output);
+    // Integral restored to its initial value, 200 / i
+    pid.ResetIntegral();
+    EXPECT_EQ(200000, pid.GetIntegral());
+    pid.RescaleIntegral(0.5);
+    EXPECT_EQ(200000, pid.GetIntegral());
+    pid.RescaleIntegral(2.0);
+    EXPECT_EQ(400000, pid.GetIntegral());
+}
+
+// Test uclamp.min clamping and granularity
+TEST(SessionControllerTest, GetNextUclampMin) {
+    ControllerConfig config;
+    int next_min = -1;
+    EXPECT_FALSE(SessionController::GetNextUclampMin(config, 0, 100, &next_min));
+    EXPECT_TRUE(SessionController::GetNextUclampMin(config, 1000, 100, &next_min));
+    EXPECT_EQ(384, next_min);
+    EXPECT_TRUE(SessionController::GetNextUclampMin(config, -50, 100, &next_min));
+    EXPECT_EQ(2, next_min);
+    EXPECT_FALSE(SessionController::GetNextUclampMin(config, 105, 100, &next_min));
+    EXPECT_TRUE(SessionController::GetNextUclampMin(config, 106, 100, &next_min));
+    EXPECT_EQ(106, next_min);
+}
+
+// Test creating controllers by name
+TEST(SessionControllerTest, Create) {
+    ControllerConfig config;
+    EXPECT_STREQ("pid", SessionController::Create("pid", config)->GetName());
+    EXPECT_STREQ("adaptive", SessionController::Create("adaptive", config)->GetName());
+    EXPECT_EQ(nullptr, SessionController::Create("mpc", config));
+}
+
+// Test feed-forward of a rising work duration trend
+TEST(SessionControllerTest, AdaptiveFeedForward) {
+    ControllerConfig config;
+    AdaptiveController adaptive(config);
+    ControllerOutput out;
+    for (int64_t duration = 8000000; duration < 16000000; duration += 1000000) {
+        out = adaptive.Update(&duration, 1, kTargetNs);
+    }
+    // Still under target, but trending up
+    EXPECT_LT(out.err, 0);
+    EXPECT_GT(out.ff_out, 0);
+}
+
+}  // namespace perfmgr
+}  // namespace android
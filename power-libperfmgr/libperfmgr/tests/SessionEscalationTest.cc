@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "perfmgr/SessionEscalation.h"
+
+namespace android {
+namespace perfmgr {
+
+// Test a session only flips after a full run of reports
+TEST(SessionEscalationTest, SaturationFilter) {
+    EscalationConfig config;
+    config.enter_reports = 3;
+    config.exit_reports = 2;
+    SaturationFilter filter;
+    EXPECT_FALSE(filter.Update(true, config));
+    EXPECT_FALSE(filter.Update(true, config));
+    // an unsaturated report restarts the run
+    EXPECT_FALSE(filter.Update(false, config));
+    EXPECT_FALSE(filter.Update(true, config));
+    EXPECT_FALSE(filter.Update(true, config));
+    EXPECT_FALSE(filter.IsSaturated());
+    EXPECT_TRUE(filter.Update(true, config));
+    EXPECT_TRUE(filter.IsSaturated());
+    EXPECT_FALSE(filter.Update(true, config));
+    EXPECT_FALSE(filter.Update(false, config));
+    EXPECT_TRUE(filter.IsSaturated());
+    EXPECT_TRUE(filter.Update(false, config));
+    EXPECT_FALSE(filter.IsSaturated());
+}
+
+// Test escalating and de-escalating on the session fractions
+TEST(SessionEscalationTest, ShouldEscalate) {
+    EscalationConfig config;
+    config.enter_fraction = 1.0;
+    config.exit_fraction = 0.5;
+    // disabled without hint
+    EXPECT_FALSE(ShouldEscalate(false, 2, 2, config));
+    config.hint = "ADPF_SATURATED";
+    EXPECT_FALSE(ShouldEscalate(false, 0, 0, config));
+    EXPECT_FALSE(ShouldEscalate(false, 1, 2, config));
+    EXPECT_TRUE(ShouldEscalate(false, 2, 2, config));
+    // stays escalated down to exit_fraction
+    EXPECT_TRUE(ShouldEscalate(true, 1, 2, config));
+    EXPECT_FALSE(ShouldEscalate(true, 1, 3, config));
+    EXPECT_FALSE(ShouldEscalate(true, 0, 0, config));
+}
+
+}  // namespace perfmgr
+}  // namespace android
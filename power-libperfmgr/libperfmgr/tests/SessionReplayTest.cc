@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "perfmgr/SessionReplay.h"
+
+namespace android {
+namespace perfmgr {
+
+constexpr int64_t kTargetNs = 16666666;
+constexpr std::size_t kFrames = 1200;
+
+// Test parsing reports out of a CSV trace
+TEST(SessionReplayTest, ParseWorkDurationTrace) {
+    const std::string csv =
+            "# timestamp_ns,duration_ns,target_ns,report\n"
+            "100,10,16,0\n"
+            "200,20,16,0\n"
+            "\n"
+            "300,30,8,1\n"
+            "400,40,8\n";
+    std::vector<WorkDurationReport> reports;
+    ASSERT_TRUE(ParseWorkDurationTrace(csv, &reports));
+    ASSERT_EQ(3u, reports.size());
+    EXPECT_EQ(200, reports[0].timestamp_ns);
+    EXPECT_EQ(16, reports[0].target_ns);
+    EXPECT_EQ(std::vector<int64_t>({10, 20}), reports[0].durations_ns);
+    EXPECT_EQ(300, reports[1].timestamp_ns);
+    EXPECT_EQ(8, reports[1].target_ns);
+    EXPECT_EQ(std::vector<int64_t>({30}), reports[1].durations_ns);
+    EXPECT_EQ(std::vector<int64_t>({40}), reports[2].durations_ns);
+
+    EXPECT_FALSE(ParseWorkDurationTrace("100,10\n", &reports));
+    EXPECT_FALSE(ParseWorkDurationTrace("100,10,0\n", &reports));
+    EXPECT_FALSE(ParseWorkDurationTrace("100,ten,16\n", &reports));
+}
+
+// Test the timeline and setattr count of an open loop replay
+TEST(SessionReplayTest, ReplayOpenLoop) {
+    ControllerConfig config;
+    PidController pid(config);
+    std::vector<WorkDurationReport> reports;
+    for (int64_t i = 0; i < 10; i++) {
+        reports.push_back({i * kTargetNs, kTargetNs, {kTargetNs / 2}});
+    }
+    ReplayResult result = ReplayTrace(&pid, config, reports, ReplayOptions());
+    EXPECT_EQ(10u, result.frames);
+    EXPECT_EQ(0u, result.frames_over_target);
+    // Boosted at start, dropped to the low limit on the first report
+    ASSERT_EQ(2u, result.uclamp_timeline.size());
+    EXPECT_EQ(std::make_pair(int64_t{0}, config.uclamp_min_high), result.uclamp_timeline[0]);
+    EXPECT_EQ(std::make_pair(int64_t{0}, config.uclamp_min_low), result.uclamp_timeline[1]);
+    EXPECT_EQ(1u, result.setattr_calls);
+    EXPECT_DOUBLE_EQ((config.uclamp_min_high + 9.0 * config.uclamp_min_low) / 10,
+                     result.average_min);
+}
+
+// Test a report after a gap drops the boost and resets the integral
+TEST(SessionReplayTest, ReplayStale) {
+    ControllerConfig config;
+    PidController pid(config);
+    std::vector<WorkDurationReport> reports = {
+            {0, kTargetNs, {kTargetNs * 2}},
+            {kTargetNs * 100, kTargetNs, {kTargetNs}},
+    };
+    ReplayOptions options;
+    options.stale_timeout_ns = kTargetNs * 20;
+    ReplayResult result = ReplayTrace(&pid, config, reports, options);
+    ASSERT_EQ(3u, result.uclamp_timeline.size());
+    EXPECT_EQ(std::make_pair(kTargetNs * 20, 0), result.uclamp_timeline[1]);
+    // Woken up with the initial integral, i.e. 200 out of the I term
+    EXPECT_EQ(std::make_pair(kTargetNs * 100, 200), result.uclamp_timeline[2]);
+    EXPECT_EQ(2u, result.setattr_calls);
+}
+
+// Test synthetic traces are deterministic and shaped as documented
+TEST(SessionReplayTest, MakeSyntheticTrace) {
+    for (SyntheticWorkload workload : {SyntheticWorkload::STEADY, SyntheticWorkload::BURSTY,
+                                       SyntheticWorkload::PHASE_CHANGE}) {
+        std::vector<WorkDurationReport> trace =
+                MakeSyntheticTrace(workload, kFrames, kTargetNs, 1);
+        ASSERT_EQ(kFrames, trace.size());
+        std::vector<WorkDurationReport> again =
+                MakeSyntheticTrace(workload, kFrames, kTargetNs, 1);
+        for (std::size_t i = 0; i < kFrames; i++) {
+            EXPECT_EQ(trace[i].durations_ns, again[i].durations_ns);
+        }
+    }
+    std::vector<WorkDurationReport> phase =
+            MakeSyntheticTrace(SyntheticWorkload::PHASE_CHANGE, kFrames, kTargetNs, 1);
+    EXPECT_LT(phase.front().durations_ns[0], kTargetNs);
+    EXPECT_GT(phase.back().durations_ns[0], kTargetNs);
+}
+
+// Compare missed deadline rate and average uclamp.min of the controllers on
+// the synthetic workloads in closed loop
+TEST(SessionReplayTest, ReplaySyntheticClosedLoop) {
+    ControllerConfig config;
+    ReplayOptions options;
+    options.closed_loop = true;
+    for (SyntheticWorkload workload : {SyntheticWorkload::STEADY, SyntheticWorkload::BURSTY,
+                                       SyntheticWorkload::PHASE_CHANGE}) {
+        const std::vector<WorkDurationReport> trace =
+                MakeSyntheticTrace(workload, kFrames, kTargetNs, 1);
+        PidController pid(config);
+        AdaptiveController adaptive(config);
+        const ReplayResult pid_result = ReplayTrace(&pid, config, trace, options);
+        const ReplayResult adaptive_result = ReplayTrace(&adaptive, config, trace, options);
+        const std::string name = std::to_string(static_cast<int>(workload));
+        RecordProperty("pid_over_target_" + name, pid_result.frames_over_target);
+        RecordProperty("pid_average_min_" + name, static_cast<int>(pid_result.average_min));
+        RecordProperty("adaptive_over_target_" + name, adaptive_result.frames_over_target);
+        RecordProperty("adaptive_average_min_" + name,
+                       static_cast<int>(adaptive_result.average_min));
+        EXPECT_EQ(kFrames, pid_result.frames);
+        EXPECT_EQ(pid_result.uclamp_timeline.size(), pid_result.setattr_calls + 1);
+        // The adaptive margin trades some boost for fewer missed deadlines,
+        // but still settles well below the high limit. Misses of bursts are
+        // mostly in the ramp up, which neither controller avoids.
+        EXPECT_LE(adaptive_result.frames_over_target, pid_result.frames_over_target) << name;
+        if (workload != SyntheticWorkload::BURSTY) {
+            EXPECT_LT(adaptive_result.frames_over_target * 2, pid_result.frames_over_target)
+                    << name;
+        }
+        EXPECT_LT(adaptive_result.average_min, config.uclamp_min_high / 2) << name;
+    }
+}
+
+}  // namespace perfmgr
+}  // namespace android
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "perfmgr/SessionTelemetry.h"
+
+namespace android {
+namespace perfmgr {
+
+// Record of report i, every field derived from i
+static SessionTelemetry::Record MakeRecord(int64_t i) {
+    return {i * 1000, i * 10, i * 20, static_cast<int32_t>(i), static_cast<int32_t>(-i),
+            static_cast<int32_t>(i * 2), static_cast<int32_t>(i % 1024)};
+}
+
+static void ExpectRecord(int64_t i, const SessionTelemetry::Record &r) {
+    EXPECT_EQ(i * 1000, r.timestamp_ns);
+    EXPECT_EQ(i * 10, r.actual_ns);
+    EXPECT_EQ(i * 20, r.target_ns);
+    EXPECT_EQ(i, r.p_out);
+    EXPECT_EQ(-i, r.i_out);
+    EXPECT_EQ(i * 2, r.d_out);
+    EXPECT_EQ(i % 1024, r.uclamp_min);
+}
+
+// Test the ring keeps the latest kCapacity records, oldest first
+TEST(SessionTelemetryTest, Ring) {
+    SessionTelemetry telemetry;
+    EXPECT_TRUE(telemetry.GetRecords().empty());
+    for (int64_t i = 0; i < 3; i++) {
+        telemetry.RecordReport(MakeRecord(i), 1);
+    }
+    std::vector<SessionTelemetry::Record> records = telemetry.GetRecords();
+    ASSERT_EQ(3u, records.size());
+    for (int64_t i = 0; i < 3; i++) {
+        ExpectRecord(i, records[i]);
+    }
+    const int64_t total = SessionTelemetry::kCapacity * 2 + 5;
+    for (int64_t i = 3; i < total; i++) {
+        telemetry.RecordReport(MakeRecord(i), 0);
+    }
+    records = telemetry.GetRecords();
+    ASSERT_EQ(SessionTelemetry::kCapacity, records.size());
+    for (std::size_t i = 0; i < records.size(); i++) {
+        ExpectRecord(total - SessionTelemetry::kCapacity + i, records[i]);
+    }
+}
+
+// Test the aggregate counters
+TEST(SessionTelemetryTest, Counters) {
+    SessionTelemetry telemetry;
+    telemetry.RecordReport(MakeRecord(1), 2);
+    telemetry.RecordReport(MakeRecord(2), 0);
+    telemetry.RecordSetattr(3);
+    telemetry.RecordSetattr(1);
+    telemetry.RecordStaleTransition();
+    SessionTelemetry::Counters counters = telemetry.GetCounters();
+    EXPECT_EQ(2u, counters.reports);
+    EXPECT_EQ(2u, counters.over_target);
+    EXPECT_EQ(4u, counters.setattr);
+    EXPECT_EQ(1u, counters.stale_transitions);
+}
+
+// Test text and binary dumps
+TEST(SessionTelemetryTest, Dump) {
+    SessionTelemetry telemetry;
+    telemetry.RecordReport(MakeRecord(7), 1);
+    telemetry.RecordSetattr(2);
+
+    std::string text;
+    telemetry.DumpText("1-2-3", &text);
+    EXPECT_EQ(
+            "Session 1-2-3: reports 1, over target 1, setattr 2, stale transitions 0\n"
+            "  Timestamp(ns)\tActual(ns)\tTarget(ns)\tPOut\tIOut\tDOut\tMin\n"
+            "  7000\t70\t140\t7\t-7\t14\t7\n",
+            text);
+
+    std::string binary;
+    SessionTelemetry::DumpBinaryHeader(1, &binary);
+    telemetry.DumpBinary("1-2-3", &binary);
+    // header 12, id 4 + 5, counters 32, record count 4, record 40
+    ASSERT_EQ(12u + 9u + 32u + 4u + 40u, binary.size());
+    EXPECT_EQ(0, memcmp(binary.data(), "ADPT", 4));
+    uint32_t version, sessions;
+    memcpy(&version, binary.data() + 4, sizeof(version));
+    memcpy(&sessions, binary.data() + 8, sizeof(sessions));
+    EXPECT_EQ(SessionTelemetry::kBinaryVersion, version);
+    EXPECT_EQ(1u, sessions);
+    EXPECT_EQ("1-2-3", binary.substr(16, 5));
+    uint64_t setattr;
+    memcpy(&setattr, binary.data() + 21 + 16, sizeof(setattr));
+    EXPECT_EQ(2u, setattr);
+    int64_t timestamp;
+    int32_t min;
+    memcpy(&timestamp, binary.data() + 57, sizeof(timestamp));
+    memcpy(&min, binary.data() + 57 + 36, sizeof(min));
+    EXPECT_EQ(7000, timestamp);
+    EXPECT_EQ(7, min);
+}
+
+// Test readers never see a torn record while the writer laps the ring
+TEST(SessionTelemetryTest, ConcurrentRead) {
+    SessionTelemetry telemetry;
+    std::atomic<bool> done(false);
+    std::thread writer([&telemetry, &done]() {
+        for (int64_t i = 0; i < 200000; i++) {
+            telemetry.RecordReport(MakeRecord(i), 0);
+        }
+        done = true;
+    });
+    std::size_t reads = 0;
+    while (!done || reads == 0) {
+        std::vector<SessionTelemetry::Record> records = telemetry.GetRecords();
+        int64_t last = -1;
+        for (const auto &r : records) {
+            const int64_t i = r.p_out;
+            ExpectRecord(i, r);
+            EXPECT_GT(i, last);
+            last = i;
+        }
+        reads++;
+    }
+    writer.join();
+    EXPECT_EQ(200000u, telemetry.GetCounters().reports);
+}
+
+}  // namespace perfmgr
+}  // namespace android
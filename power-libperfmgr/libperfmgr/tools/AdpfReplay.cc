@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specic language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/parsedouble.h>
+#include <android-base/parseint.h>
+#include <getopt.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "perfmgr/AdpfConfig.h"
+#include "perfmgr/SessionController.h"
+#include "perfmgr/SessionReplay.h"
+
+using android::perfmgr::ControllerConfig;
+using android::perfmgr::MakeSyntheticTrace;
+using android::perfmgr::ReplayOptions;
+using android::perfmgr::ReplayResult;
+using android::perfmgr::SessionController;
+using android::perfmgr::SyntheticWorkload;
+using android::perfmgr::WorkDurationReport;
+
+static void printUsage(const char* exec_name) {
+    std::string usage = exec_name;
+    usage =
+        usage +
+        " is a command-line tool to replay ADPF work duration traces through a\n"
+        "session controller.\n"
+        "Usages:\n"
+        "    " +
+        exec_name +
+        " [options]\n"
+        "\n"
+        "Options:\n"
+        "   --trace, -t  [PATH]\n"
+        "       CSV trace, one timestamp_ns,duration_ns,target_ns[,report] per line\n\n"
+        "   --synthetic, -s  [steady|bursty|phase]\n"
+        "       replay a synthetic trace instead\n\n"
+        "   --frames, -n  [frames]\n"
+        "       frames of the synthetic trace, 1200 by default\n\n"
+        "   --target, -g  [ns]\n"
+        "       target duration of the synthetic trace, 16666666 by default\n\n"
+        "   --controller, -c  [pid|adaptive]\n"
+        "       session controller, pid by default\n\n"
+        "   --set, -p  [name=value]\n"
+        "       override a tunable, named as in the AdpfConfig profiles of the\n"
+        "       powerhint JSON, e.g. PID_Po=2.0 or UclampMin_High=384\n\n"
+        "   --stale_timeout, -x  [ns]\n"
+        "       report gap after which the session goes stale\n\n"
+        "   --closed_loop, -l\n"
+        "       treat durations as unboosted work scaled by the replayed boost\n\n"
+        "   --timeline, -o\n"
+        "       print the uclamp.min timeline\n\n"
+        "   --help, -h\n"
+        "       print this message\n\n";
+
+    LOG(INFO) << usage;
+}
+
+// Set the ControllerConfig field of tunable name=value, named as in the
+// profiles of the powerhint JSON
+static bool setTunable(ControllerConfig* config, const std::string& tunable) {
+    const std::size_t pos = tunable.find('=');
+    double value;
+    if (pos == std::string::npos ||
+        !android::base::ParseDouble(tunable.substr(pos + 1).c_str(), &value)) {
+        LOG(ERROR) << "Malformed tunable: " << tunable;
+        return false;
+    }
+    if (!android::perfmgr::SetControllerTunable(tunable.substr(0, pos), value, config)) {
+        LOG(ERROR) << "Unknown tunable: " << tunable.substr(0, pos);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    android::base::InitLogging(argv, android::base::StdioLogger);
+
+    std::string trace_path;
+    std::string synthetic;
+    std::string controller_type = "pid";
+    std::size_t frames = 1200;
+    int64_t target_ns = 16666666;
+    bool print_timeline = false;
+    ControllerConfig config;
+    ReplayOptions options;
+
+    while (true) {
+        static struct option opts[] = {
+            {"trace", required_argument, nullptr, 't'},
+            {"synthetic", required_argument, nullptr, 's'},
+            {"frames", required_argument, nullptr, 'n'},
+            {"target", required_argument, nullptr, 'g'},
+            {"controller", required_argument, nullptr, 'c'},
+            {"set", required_argument, nullptr, 'p'},
+            {"stale_timeout", required_argument, nullptr, 'x'},
+            {"closed_loop", no_argument, nullptr, 'l'},
+            {"timeline", no_argument, nullptr, 'o'},
+            {"help", no_argument, nullptr, 'h'},
+            {0, 0, 0, 0}  // termination of the option list
+        };
+
+        int option_index = 0;
+        int c = getopt_long(argc, argv, "t:s:n:g:c:p:x:loh", opts, &option_index);
+        if (c == -1) {
+            break;
+        }
+
+        switch (c) {
+            case 't':
+                trace_path = optarg;
+                break;
+            case 's':
+                synthetic = optarg;
+                break;
+            case 'n':
+                if (!android::base::ParseUint(optarg, &frames)) {
+                    LOG(ERROR) << "Invalid frames: " << optarg;
+                    return 1;
+                }
+                break;
+            case 'g':
+                if (!android::base::ParseInt(optarg, &target_ns, int64_t{1})) {
+                    LOG(ERROR) << "Invalid target: " << optarg;
+                    return 1;
+                }
+                break;
+            case 'c':
+                controller_type = optarg;
+                break;
+            case 'p':
+                if (!setTunable(&config, optarg)) {
+                    return 1;
+                }
+                break;
+            case 'x':
+                if (!android::base::ParseInt(optarg, &options.stale_timeout_ns, int64_t{0})) {
+                    LOG(ERROR) << "Invalid stale timeout: " << optarg;
+                    return 1;
+                }
+                break;
+            case 'l':
+                options.closed_loop = true;
+                break;
+            case 'o':
+                print_timeline = true;
+                break;
+            case 'h':
+                printUsage(argv[0]);
+                return 0;
+            default:
+                // getopt already prints "invalid option -- %c" for us.
+                return 1;
+        }
+    }
+
+    std::vector<WorkDurationReport> reports;
+    if (!trace_path.empty()) {
+        std::string csv;
+        if (!android::base::ReadFileToString(trace_path, &csv)) {
+            LOG(ERROR) << "Failed to read trace " << trace_path;
+            return 1;
+        }
+        if (!android::perfmgr::ParseWorkDurationTrace(csv, &reports)) {
+            LOG(ERROR) << "Failed to parse trace " << trace_path;
+            return 1;
+        }
+    } else if (synthetic == "steady") {
+        reports = MakeSyntheticTrace(SyntheticWorkload::STEADY, frames, target_ns, 1);
+    } else if (synthetic == "bursty") {
+        reports = MakeSyntheticTrace(SyntheticWorkload::BURSTY, frames, target_ns, 1);
+    } else if (synthetic == "phase") {
+        reports = MakeSyntheticTrace(SyntheticWorkload::PHASE_CHANGE, frames, target_ns, 1);
+    } else {
+        LOG(ERROR) << "Need specify a trace or a synthetic workload";
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::unique_ptr<SessionController> controller =
+            SessionController::Create(controller_type, config);
+    if (!controller) {
+        return 1;
+    }
+    const ReplayResult result =
+            android::perfmgr::ReplayTrace(controller.get(), config, reports, options);
+
+    if (print_timeline) {
+        printf("timestamp_ns,uclamp_min\n");
+        for (const auto& point : result.uclamp_timeline) {
+            printf("%" PRId64 ",%d\n", point.first, point.second);
+        }
+    }
+    printf("controller: %s\n", controller->GetName());
+    printf("reports: %zu\n", reports.size());
+    printf("frames: %zu\n", result.frames);
+    printf("frames over target: %zu (%.2f%%)\n", result.frames_over_target,
+           result.frames ? 100.0 * result.frames_over_target / result.frames : 0.0);
+    printf("setattr calls: %zu\n", result.setattr_calls);
+    printf("average uclamp.min: %.1f\n", result.average_min);
+    return 0;
+}
@@ -22,6 +22,7 @@
 
 #include <thread>
 
+#include "perfmgr/ConfigImage.h"
 #include "perfmgr/HintManager.h"
 
 namespace android {
@@ -46,6 +47,38 @@ class NodeVerifier : public HintManager {
         return true;
     }
 
+    static bool CompileConfig(const std::string& config_path, const std::string& image_path) {
+        if (!HintManager::CompileConfig(config_path, image_path)) {
+            LOG(ERROR) << "Failed to compile " << config_path;
+            return false;
+        }
+
+        // Report the startup cost of both paths
+        std::string json_doc;
+        if (!android::base::ReadFileToString(config_path, &json_doc)) {
+            LOG(ERROR) << "Failed to read JSON config from " << config_path;
+            return false;
+        }
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::unique_ptr<Node>> nodes = ParseNodes(json_doc);
+        std::unordered_map<std::string, Hint> actions = ParseActions(json_doc, nodes);
+        auto json_time = std::chrono::steady_clock::now() - start;
+        start = std::chrono::steady_clock::now();
+        AdpfConfig adpf;
+        BoostPolicy boost_policy;
+        if (!ConfigImage::Load(image_path, json_doc, &nodes, &actions, &adpf, &boost_policy)) {
+            LOG(ERROR) << "Failed to load compiled image " << image_path;
+            return false;
+        }
+        auto image_time = std::chrono::steady_clock::now() - start;
+        LOG(INFO) << "JSON parse time: "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(json_time).count()
+                  << "us, image load time: "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(image_time).count()
+                  << "us";
+        return true;
+    }
+
   private:
     NodeVerifier() = delete;
     NodeVerifier(NodeVerifier const &) = delete;
@@ -74,6 +107,8 @@ static void printUsage(const char* exec_name) {
         "       do only the specific hint\n\n"
         "   --hint_duration, -d  [duration]\n"
         "       duration in ms for each hint\n\n"
+        "   --compile, -b  [PATH]\n"
+        "       compile Json config into binary image at PATH\n\n"
         "   --help, -h\n"
         "       print this message\n\n"
         "   --verbose, -v\n"
@@ -111,6 +146,7 @@ int main(int argc, char* argv[]) {
 
     std::string config_path;
     std::string hint_name;
+    std::string image_path;
     bool exec_hint = false;
     uint64_t hint_duration = 100;
 
@@ -120,13 +156,14 @@ int main(int argc, char* argv[]) {
             {"exec_hint", no_argument, nullptr, 'e'},
             {"hint_name", required_argument, nullptr, 'i'},
             {"hint_duration", required_argument, nullptr, 'd'},
+            {"compile", required_argument, nullptr, 'b'},
             {"help", no_argument, nullptr, 'h'},
             {"verbose", no_argument, nullptr, 'v'},
             {0, 0, 0, 0}  // termination of the option list
         };
 
         int option_index = 0;
-        int c = getopt_long(argc, argv, "c:ei:d:hv", opts, &option_index);
+        int c = getopt_long(argc, argv, "c:ei:d:b:hv", opts, &option_index);
         if (c == -1) {
             break;
         }
@@ -144,6 +181,9 @@ int main(int argc, char* argv[]) {
             case 'd':
                 hint_duration = strtoul(optarg, NULL, 10);
                 break;
+            case 'b':
+                image_path = optarg;
+                break;
             case 'v':
                 android::base::SetMinimumLogSeverity(android::base::VERBOSE);
                 break;
@@ -162,6 +202,10 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    if (!image_path.empty()) {
+        return android::perfmgr::NodeVerifier::CompileConfig(config_path, image_path) ? 0 : 1;
+    }
+
     if (exec_hint) {
         execConfig(config_path, hint_name, hint_duration);
         return 0;
@@ -681,6 +681,14 @@ Return<void> Thermal::debug(const hidl_handle &handle, const hidl_vec<hidl_strin
                 dump_buf << std::endl;
             }
             dumpVirtualSensorInfo(&dump_buf);
+            {
+                const auto stats = thermal_helper_.GetSensorReadStats();
+                dump_buf << "SensorReads:" << std::endl;
+                dump_buf << " Passes: " << stats.passes << " Reads: " << stats.reads
+                         << " LastPassReads: " << stats.last_pass_reads << " ReadsPerPass: "
+                         << (stats.passes ? static_cast<float>(stats.reads) / stats.passes : 0)
+                         << std::endl;
+            }
             dumpThrottlingInfo(&dump_buf);
             dumpThrottlingRequestStatus(&dump_buf);
             dumpPowerRailInfo(&dump_buf);
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <android-base/strings.h>
+#include <benchmark/benchmark.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+
+#include "utils/thermal_files.h"
+
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace V2_0 {
+namespace implementation {
+
+// A fake sysfs tree of thermal_zone*/temp, read once per zone per tick like
+// ThermalHelper::thermalWatcherCallbackFunc does
+class ThermalFilesBench : public benchmark::Fixture {
+  public:
+    static constexpr int kNumZones = 100;
+
+    void SetUp(::benchmark::State & /*state*/) override {
+        for (int i = 0; i < kNumZones; i++) {
+            const std::string dir = android::base::StringPrintf("%s/thermal_zone%d", dir_.path, i);
+            mkdir(dir.c_str(), S_IRWXU);
+            const std::string path = dir + "/temp";
+            android::base::WriteStringToFile(std::to_string(30000 + i * 100) + "\n", path);
+            const std::string name = android::base::StringPrintf("zone%d", i);
+            files_.addThermalFile(name, path);
+            names_.emplace_back(name);
+        }
+    }
+
+  protected:
+    TemporaryDir dir_;
+    ThermalFiles files_;
+    std::vector<std::string> names_;
+};
+
+// What readThermalFile did before: open, read, close, Trim and std::stof
+BENCHMARK_F(ThermalFilesBench, ReadFileToString)(benchmark::State &state) {
+    for (auto _ : state) {
+        float sum = 0;
+        for (const auto &name : names_) {
+            std::string data;
+            android::base::ReadFileToString(files_.getThermalFilePath(name), &data);
+            sum += std::stof(android::base::Trim(data));
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * kNumZones);
+}
+
+BENCHMARK_F(ThermalFilesBench, CachedFd)(benchmark::State &state) {
+    for (auto _ : state) {
+        float sum = 0;
+        for (const auto &name : names_) {
+            float value;
+            files_.readThermalFile(name, &value);
+            sum += value;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * kNumZones);
+}
+
+}  // namespace implementation
+}  // namespace V2_0
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
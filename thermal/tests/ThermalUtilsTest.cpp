@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/config_parser.h"
+#include "utils/thermal_files.h"
+
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace V2_0 {
+namespace implementation {
+
+namespace {
+
+void AddSensor(std::unordered_map<std::string, SensorInfo> *sensors, const std::string &name,
+               std::vector<std::string> linked_sensors = {}) {
+    SensorInfo sensor_info{};
+    if (!linked_sensors.empty()) {
+        sensor_info.virtual_sensor_info = std::make_unique<VirtualSensorInfo>();
+        sensor_info.virtual_sensor_info->linked_sensors = std::move(linked_sensors);
+    }
+    (*sensors)[name] = std::move(sensor_info);
+}
+
+size_t IndexOf(const std::vector<std::string> &order, const std::string &name) {
+    return std::find(order.begin(), order.end(), name) - order.begin();
+}
+
+}  // namespace
+
+// Test virtual sensors are ordered after the sensors they link
+TEST(SortSensorsByLinksTest, LinkedSensorsFirst) {
+    std::unordered_map<std::string, SensorInfo> sensors;
+    AddSensor(&sensors, "VIRTUAL_SKIN", {"SKIN_HINT", "VIRTUAL_SOC"});
+    AddSensor(&sensors, "VIRTUAL_SOC", {"CPU", "GPU"});
+    AddSensor(&sensors, "CPU");
+    AddSensor(&sensors, "GPU");
+    AddSensor(&sensors, "SKIN_HINT");
+    std::vector<std::string> order;
+    ASSERT_TRUE(SortSensorsByLinks(sensors, &order));
+    ASSERT_EQ(sensors.size(), order.size());
+    EXPECT_LT(IndexOf(order, "CPU"), IndexOf(order, "VIRTUAL_SOC"));
+    EXPECT_LT(IndexOf(order, "GPU"), IndexOf(order, "VIRTUAL_SOC"));
+    EXPECT_LT(IndexOf(order, "SKIN_HINT"), IndexOf(order, "VIRTUAL_SKIN"));
+    EXPECT_LT(IndexOf(order, "VIRTUAL_SOC"), IndexOf(order, "VIRTUAL_SKIN"));
+}
+
+// Test a cycle of linked sensors is rejected
+TEST(SortSensorsByLinksTest, Cycle) {
+    std::unordered_map<std::string, SensorInfo> sensors;
+    AddSensor(&sensors, "CPU");
+    AddSensor(&sensors, "VIRTUAL_A", {"CPU", "VIRTUAL_B"});
+    AddSensor(&sensors, "VIRTUAL_B", {"VIRTUAL_C"});
+    AddSensor(&sensors, "VIRTUAL_C", {"VIRTUAL_A"});
+    std::vector<std::string> order;
+    EXPECT_FALSE(SortSensorsByLinks(sensors, &order));
+    EXPECT_TRUE(order.empty());
+
+    // a virtual sensor linking itself
+    sensors.clear();
+    AddSensor(&sensors, "VIRTUAL_A", {"VIRTUAL_A"});
+    EXPECT_FALSE(SortSensorsByLinks(sensors, &order));
+    EXPECT_TRUE(order.empty());
+}
+
+// Test a link to a sensor not defined is rejected
+TEST(SortSensorsByLinksTest, MissingLink) {
+    std::unordered_map<std::string, SensorInfo> sensors;
+    AddSensor(&sensors, "CPU");
+    AddSensor(&sensors, "VIRTUAL_A", {"CPU", "GPU"});
+    std::vector<std::string> order;
+    EXPECT_FALSE(SortSensorsByLinks(sensors, &order));
+    EXPECT_TRUE(order.empty());
+}
+
+// Test values as read from sensor and cooling device nodes
+TEST(ParseThermalValueTest, Valid) {
+    float temp;
+    EXPECT_TRUE(parseThermalValue("42000\n", &temp));
+    EXPECT_FLOAT_EQ(42000.0f, temp);
+    EXPECT_TRUE(parseThermalValue("  -12.5 \n", &temp));
+    EXPECT_FLOAT_EQ(-12.5f, temp);
+    EXPECT_TRUE(parseThermalValue("+7.", &temp));
+    EXPECT_FLOAT_EQ(7.0f, temp);
+    EXPECT_TRUE(parseThermalValue(".25", &temp));
+    EXPECT_FLOAT_EQ(0.25f, temp);
+
+    int state;
+    EXPECT_TRUE(parseThermalValue("3\n", &state));
+    EXPECT_EQ(3, state);
+    EXPECT_TRUE(parseThermalValue("-2147483648", &state));
+    EXPECT_EQ(std::numeric_limits<int>::min(), state);
+}
+
+// Test malformed values are rejected and the output is left alone
+TEST(ParseThermalValueTest, Malformed) {
+    const std::vector<std::string> malformed = {
+            "", "\n", " ", "-", "+", ".", "-.", "abc", "12abc", "1.2.3", "1 2", "0x10", "--1",
+            // more digits than int64 holds safely
+            "1234567890123456789",
+    };
+    for (const auto &value : malformed) {
+        float temp = 1.0f;
+        EXPECT_FALSE(parseThermalValue(value, &temp)) << "\"" << value << "\"";
+        EXPECT_FLOAT_EQ(1.0f, temp);
+        int state = 1;
+        EXPECT_FALSE(parseThermalValue(value, &state)) << "\"" << value << "\"";
+        EXPECT_EQ(1, state);
+    }
+
+    // cooling device states are whole numbers that fit an int
+    int state = 1;
+    EXPECT_FALSE(parseThermalValue("1.5", &state));
+    EXPECT_FALSE(parseThermalValue("2147483648", &state));
+    EXPECT_FALSE(parseThermalValue("-2147483649", &state));
+    EXPECT_EQ(1, state);
+}
+
+}  // namespace implementation
+}  // namespace V2_0
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <iterator>
 #include <set>
 #include <sstream>
@@ -273,12 +274,14 @@ ThermalHelper::ThermalHelper(const NotificationCallback &cb)
             "/vendor/etc/" +
             android::base::GetProperty(kConfigProperty.data(), kConfigDefaultFileName.data());
     cooling_device_info_map_ = ParseCoolingDevice(config_path);
-    sensor_info_map_ = ParseSensorInfo(config_path);
+    std::vector<std::string> sorted_sensors;
+    sensor_info_map_ = ParseSensorInfo(config_path, &sorted_sensors);
     power_rail_info_map_ = ParsePowerRailInfo(config_path);
     auto tz_map = parseThermalPathMap(kSensorPrefix.data());
     auto cdev_map = parseThermalPathMap(kCoolingDevicePrefix.data());
 
-    is_initialized_ = initializeSensorMap(tz_map) && initializeCoolingDevices(cdev_map);
+    is_initialized_ = initializeSensorMap(tz_map) && initializeCoolingDevices(cdev_map) &&
+                      initializeSensorGraph(std::move(sorted_sensors));
     if (!is_initialized_) {
         LOG(FATAL) << "ThermalHAL could not be initialized properly.";
     }
@@ -423,8 +426,7 @@ bool getThermalZoneTypeById(int tz_id, std::string *type) {
 
 bool ThermalHelper::readCoolingDevice(std::string_view cooling_device,
                                       CoolingDevice_2_0 *out) const {
-    // Read the file.  If the file can't be read temp will be empty string.
-    std::string data;
+    int data;
 
     if (!cooling_devices_.readThermalFile(cooling_device, &data)) {
         LOG(ERROR) << "readCoolingDevice: failed to read cooling_device: " << cooling_device;
@@ -436,31 +438,17 @@ bool ThermalHelper::readCoolingDevice(std::string_view cooling_device,
 
     out->type = type;
     out->name = cooling_device.data();
-    out->value = std::stoi(data);
+    out->value = data;
 
     return true;
 }
 
-bool ThermalHelper::readTemperature(std::string_view sensor_name, Temperature_1_0 *out,
-                                    bool is_virtual_sensor) const {
-    // Read the file.  If the file can't be read temp will be empty string.
-    std::string temp;
-
-    if (!is_virtual_sensor) {
-        if (!thermal_sensors_.readThermalFile(sensor_name, &temp)) {
-            LOG(ERROR) << "readTemperature: sensor not found: " << sensor_name;
-            return false;
-        }
+bool ThermalHelper::readTemperature(std::string_view sensor_name, Temperature_1_0 *out) const {
+    float temp;
 
-        if (temp.empty()) {
-            LOG(ERROR) << "readTemperature: failed to read sensor: " << sensor_name;
-            return false;
-        }
-    } else {
-        if (!checkVirtualSensor(sensor_name.data(), &temp)) {
-            LOG(ERROR) << "readTemperature: failed to read virtual sensor: " << sensor_name;
-            return false;
-        }
+    if (!readSensorValue(sensor_index_map_.at(sensor_name.data()), &temp, nullptr)) {
+        LOG(ERROR) << "readTemperature: failed to read sensor: " << sensor_name;
+        return false;
     }
 
     const SensorInfo &sensor_info = sensor_info_map_.at(sensor_name.data());
@@ -470,7 +458,7 @@ bool ThermalHelper::readTemperature(std::string_view sensor_name, Temperature_1_
             : static_cast<TemperatureType_1_0>(sensor_info.type);
     out->type = type;
     out->name = sensor_name.data();
-    out->currentValue = std::stof(temp) * sensor_info.multiplier;
+    out->currentValue = temp * sensor_info.multiplier;
     out->throttlingThreshold =
         sensor_info.hot_thresholds[static_cast<size_t>(ThrottlingSeverity::SEVERE)];
     out->shutdownThreshold =
@@ -483,31 +471,18 @@ bool ThermalHelper::readTemperature(std::string_view sensor_name, Temperature_1_
 bool ThermalHelper::readTemperature(
         std::string_view sensor_name, Temperature_2_0 *out,
         std::pair<ThrottlingSeverity, ThrottlingSeverity> *throtting_status,
-        bool is_virtual_sensor) const {
-    // Read the file.  If the file can't be read temp will be empty string.
-    std::string temp;
-
-    if (!is_virtual_sensor) {
-        if (!thermal_sensors_.readThermalFile(sensor_name, &temp)) {
-            LOG(ERROR) << "readTemperature: sensor not found: " << sensor_name;
-            return false;
-        }
+        SensorReadCache *cache) const {
+    float temp;
 
-        if (temp.empty()) {
-            LOG(ERROR) << "readTemperature: failed to read sensor: " << sensor_name;
-            return false;
-        }
-    } else {
-        if (!checkVirtualSensor(sensor_name.data(), &temp)) {
-            LOG(ERROR) << "readTemperature: failed to read virtual sensor: " << sensor_name;
-            return false;
-        }
+    if (!readSensorValue(sensor_index_map_.at(sensor_name.data()), &temp, cache)) {
+        LOG(ERROR) << "readTemperature: failed to read sensor: " << sensor_name;
+        return false;
     }
 
     const auto &sensor_info = sensor_info_map_.at(sensor_name.data());
     out->type = sensor_info.type;
     out->name = sensor_name.data();
-    out->value = std::stof(temp) * sensor_info.multiplier;
+    out->value = temp * sensor_info.multiplier;
 
     std::pair<ThrottlingSeverity, ThrottlingSeverity> status =
         std::make_pair(ThrottlingSeverity::NONE, ThrottlingSeverity::NONE);
@@ -917,6 +892,33 @@ bool ThermalHelper::initializeCoolingDevices(
     return true;
 }
 
+bool ThermalHelper::initializeSensorGraph(std::vector<std::string> &&sorted_sensors) {
+    if (sorted_sensors.size() != sensor_info_map_.size()) {
+        LOG(ERROR) << "Sensors are not sorted by their links";
+        return false;
+    }
+
+    sensor_graph_.reserve(sorted_sensors.size());
+    for (auto &sensor_name : sorted_sensors) {
+        const SensorInfo &sensor_info = sensor_info_map_.at(sensor_name);
+        SensorNode node{.name = std::move(sensor_name), .sensor_info = &sensor_info};
+        if (sensor_info.virtual_sensor_info != nullptr) {
+            // Linked sensors are sorted first, so they are indexed already
+            for (const auto &linked_sensor : sensor_info.virtual_sensor_info->linked_sensors) {
+                node.links.emplace_back(sensor_index_map_.at(linked_sensor));
+            }
+        }
+        sensor_index_map_[node.name] = sensor_graph_.size();
+        sensor_graph_.emplace_back(std::move(node));
+    }
+
+    watcher_read_cache_.states.resize(sensor_graph_.size());
+    watcher_read_cache_.values.resize(sensor_graph_.size());
+    watcher_read_cache_.reads = 0;
+    sensor_read_stats_ = {.passes = 0, .reads = 0, .last_pass_reads = 0};
+    return true;
+}
+
 void ThermalHelper::setMinTimeout(SensorInfo *sensor_info) {
     sensor_info->polling_delay = kMinPollIntervalMs;
     sensor_info->passive_delay = kMinPollIntervalMs;
@@ -1003,8 +1005,7 @@ bool ThermalHelper::fillTemperatures(hidl_vec<Temperature_1_0> *temperatures) co
     for (const auto &name_info_pair : sensor_info_map_) {
         Temperature_1_0 temp;
 
-        if (readTemperature(name_info_pair.first, &temp,
-                            name_info_pair.second.virtual_sensor_info != nullptr)) {
+        if (readTemperature(name_info_pair.first, &temp)) {
             (*temperatures)[current_index] = temp;
         } else {
             LOG(ERROR) << __func__
@@ -1028,8 +1029,7 @@ bool ThermalHelper::fillCurrentTemperatures(bool filterType, bool filterCallback
         if (filterCallback && !name_info_pair.second.send_cb) {
             continue;
         }
-        if (readTemperature(name_info_pair.first, &temp, nullptr,
-                            name_info_pair.second.virtual_sensor_info != nullptr)) {
+        if (readTemperature(name_info_pair.first, &temp)) {
             ret.emplace_back(std::move(temp));
         } else {
             LOG(ERROR) << __func__
@@ -1091,28 +1091,58 @@ bool ThermalHelper::fillCpuUsages(hidl_vec<CpuUsage> *cpu_usages) const {
     return true;
 }
 
-bool ThermalHelper::checkVirtualSensor(std::string_view sensor_name, std::string *temp) const {
+bool ThermalHelper::readSensorValue(size_t index, float *value, SensorReadCache *cache) const {
+    if (cache != nullptr) {
+        switch (cache->states[index]) {
+            case SensorReadCache::State::READ:
+                *value = cache->values[index];
+                return true;
+            case SensorReadCache::State::FAILED:
+                return false;
+            default:
+                break;
+        }
+    }
+
+    const SensorNode &node = sensor_graph_[index];
+    bool ret;
+    if (node.sensor_info->virtual_sensor_info == nullptr) {
+        ret = thermal_sensors_.readThermalFile(node.name, value);
+        if (cache != nullptr) {
+            cache->reads++;
+        }
+    } else {
+        ret = checkVirtualSensor(index, value, cache);
+    }
+
+    if (cache != nullptr) {
+        cache->states[index] = ret ? SensorReadCache::State::READ : SensorReadCache::State::FAILED;
+        if (ret) {
+            cache->values[index] = *value;
+        }
+    }
+    return ret;
+}
+
+bool ThermalHelper::checkVirtualSensor(size_t index, float *temp, SensorReadCache *cache) const {
     float temp_val = 0.0;
 
-    const auto &sensor_info = sensor_info_map_.at(sensor_name.data());
+    const SensorNode &node = sensor_graph_[index];
+    const auto &sensor_info = *node.sensor_info;
     float offset = sensor_info.virtual_sensor_info->offset;
-    for (size_t i = 0; i < sensor_info.virtual_sensor_info->linked_sensors.size(); i++) {
-        std::string data;
-        const auto &linked_sensor_info =
-                sensor_info_map_.at(sensor_info.virtual_sensor_info->linked_sensors[i].data());
-        if (linked_sensor_info.virtual_sensor_info == nullptr) {
-            if (!thermal_sensors_.readThermalFile(
-                        sensor_info.virtual_sensor_info->linked_sensors[i], &data)) {
+    for (size_t i = 0; i < node.links.size(); i++) {
+        float sensor_reading;
+        if (!readSensorValue(node.links[i], &sensor_reading, cache)) {
+            // A physical sensor failing to read is skipped
+            if (sensor_graph_[node.links[i]].sensor_info->virtual_sensor_info == nullptr) {
                 continue;
             }
-        } else if (!checkVirtualSensor(sensor_info.virtual_sensor_info->linked_sensors[i], &data)) {
             return false;
         }
 
-        LOG(VERBOSE) << sensor_name.data() << "'s linked sensor "
-                     << sensor_info.virtual_sensor_info->linked_sensors[i] << ": temp = " << data;
-        data = ::android::base::Trim(data);
-        float sensor_reading = std::stof(data);
+        LOG(VERBOSE) << node.name << "'s linked sensor "
+                     << sensor_info.virtual_sensor_info->linked_sensors[i]
+                     << ": temp = " << sensor_reading;
         if (std::isnan(sensor_info.virtual_sensor_info->coefficients[i])) {
             return false;
         }
@@ -1142,7 +1172,7 @@ bool ThermalHelper::checkVirtualSensor(std::string_view sensor_name, std::string
                 break;
         }
     }
-    *temp = std::to_string(temp_val + offset);
+    *temp = temp_val + offset;
     return true;
 }
 
@@ -1155,6 +1185,9 @@ std::chrono::milliseconds ThermalHelper::thermalWatcherCallbackFunc(
     std::set<std::string> updated_power_rails;
     boot_clock::time_point now = boot_clock::now();
     auto min_sleep_ms = std::chrono::milliseconds::max();
+    std::fill(watcher_read_cache_.states.begin(), watcher_read_cache_.states.end(),
+              SensorReadCache::State::UNREAD);
+    watcher_read_cache_.reads = 0;
 
     for (auto &name_status_pair : sensor_status_map_) {
         bool force_update = false;
@@ -1218,7 +1251,7 @@ std::chrono::milliseconds ThermalHelper::thermalWatcherCallbackFunc(
 
         std::pair<ThrottlingSeverity, ThrottlingSeverity> throtting_status;
         if (!readTemperature(name_status_pair.first, &temp, &throtting_status,
-                             (sensor_info.virtual_sensor_info != nullptr))) {
+                             &watcher_read_cache_)) {
             LOG(ERROR) << __func__
                        << ": error reading temperature for sensor: " << name_status_pair.first;
             continue;
@@ -1305,6 +1338,13 @@ std::chrono::milliseconds ThermalHelper::thermalWatcherCallbackFunc(
         sensor_status.last_update_time = now;
     }
 
+    if (watcher_read_cache_.reads) {
+        std::lock_guard<std::mutex> _lock(sensor_read_stats_mutex_);
+        sensor_read_stats_.passes++;
+        sensor_read_stats_.reads += watcher_read_cache_.reads;
+        sensor_read_stats_.last_pass_reads = watcher_read_cache_.reads;
+    }
+
     if (!cooling_devices_to_update.empty()) {
         updateCoolingDevices(cooling_devices_to_update);
     }
@@ -88,6 +88,24 @@ struct SensorStatus {
     float prev_err;
 };
 
+// Sensor values read in one pass of the thermal watcher, indexed like the
+// sensor graph of ThermalHelper. A sensor linked by several virtual sensors is
+// read once per pass.
+struct SensorReadCache {
+    enum class State : uint8_t { UNREAD, READ, FAILED };
+    std::vector<State> states;
+    std::vector<float> values;
+    // Sensor files read in this pass
+    size_t reads;
+};
+
+struct SensorReadStats {
+    // Watcher passes that read at least one sensor file
+    uint64_t passes;
+    uint64_t reads;
+    uint64_t last_pass_reads;
+};
+
 class PowerHalService {
   public:
     PowerHalService();
@@ -126,13 +144,13 @@ class ThermalHelper {
 
     bool isInitializedOk() const { return is_initialized_; }
 
-    // Read the temperature of a single sensor.
-    bool readTemperature(std::string_view sensor_name, Temperature_1_0 *out,
-                         bool is_virtual_sensor = false) const;
+    // Read the temperature of a single sensor. With a cache, the sensor
+    // values in it are reused and the ones read are added to it.
+    bool readTemperature(std::string_view sensor_name, Temperature_1_0 *out) const;
     bool readTemperature(
             std::string_view sensor_name, Temperature_2_0 *out,
             std::pair<ThrottlingSeverity, ThrottlingSeverity> *throtting_status = nullptr,
-            bool is_virtual_sensor = false) const;
+            SensorReadCache *cache = nullptr) const;
     bool readTemperatureThreshold(std::string_view sensor_name, TemperatureThreshold *out) const;
     // Read the value of a single cooling device.
     bool readCoolingDevice(std::string_view cooling_device, CoolingDevice_2_0 *out) const;
@@ -158,6 +176,11 @@ class ThermalHelper {
         std::shared_lock<std::shared_mutex> _lock(cdev_status_map_mutex_);
         return cdev_status_map_;
     }
+    // Get the sensor files read by the thermal watcher
+    SensorReadStats GetSensorReadStats() const {
+        std::lock_guard<std::mutex> _lock(sensor_read_stats_mutex_);
+        return sensor_read_stats_;
+    }
     // Get ThrottlingRelease Map
     const std::unordered_map<std::string, CdevReleaseStatus> &GetThrottlingReleaseMap() const {
         return power_files_.GetThrottlingReleaseMap();
@@ -176,6 +199,8 @@ class ThermalHelper {
   private:
     bool initializeSensorMap(const std::unordered_map<std::string, std::string> &path_map);
     bool initializeCoolingDevices(const std::unordered_map<std::string, std::string> &path_map);
+    // Build sensor_graph_ from the sensors ordered by ParseSensorInfo
+    bool initializeSensorGraph(std::vector<std::string> &&sorted_sensors);
     void setMinTimeout(SensorInfo *sensor_info);
     void initializeTrip(const std::unordered_map<std::string, std::string> &path_map,
                         std::set<std::string> *monitored_sensors, bool thermal_genl_enabled);
@@ -189,7 +214,9 @@ class ThermalHelper {
         const ThrottlingArray &hot_hysteresis, const ThrottlingArray &cold_hysteresis,
         ThrottlingSeverity prev_hot_severity, ThrottlingSeverity prev_cold_severity,
         float value) const;
-    bool checkVirtualSensor(std::string_view sensor_name, std::string *temp) const;
+    // Read the sensor at index of sensor_graph_, through cache if not null
+    bool readSensorValue(size_t index, float *value, SensorReadCache *cache) const;
+    bool checkVirtualSensor(size_t index, float *temp, SensorReadCache *cache) const;
 
     // Return the target state of PID algorithm
     size_t getTargetStateOfPID(const SensorInfo &sensor_info, const SensorStatus &sensor_status);
@@ -216,6 +243,19 @@ class ThermalHelper {
     const NotificationCallback cb_;
     std::unordered_map<std::string, CdevInfo> cooling_device_info_map_;
     std::unordered_map<std::string, SensorInfo> sensor_info_map_;
+    // A sensor and, for a virtual sensor, the indexes of its linked sensors
+    struct SensorNode {
+        std::string name;
+        const SensorInfo *sensor_info;
+        std::vector<size_t> links;
+    };
+    // All sensors, each virtual sensor after the sensors it links
+    std::vector<SensorNode> sensor_graph_;
+    std::unordered_map<std::string, size_t> sensor_index_map_;
+    // Only used by the thermal watcher thread
+    SensorReadCache watcher_read_cache_;
+    mutable std::mutex sensor_read_stats_mutex_;
+    SensorReadStats sensor_read_stats_;
     std::unordered_map<std::string, PowerRailInfo> power_rail_info_map_;
     std::unordered_map<std::string, std::map<ThrottlingSeverity, ThrottlingSeverity>>
             supported_powerhint_map_;
@@ -17,7 +17,9 @@
 #include <android-base/logging.h>
 #include <android-base/properties.h>
 #include <android-base/strings.h>
+#include <algorithm>
 #include <cmath>
+#include <functional>
 #include <unordered_set>
 
 #include <json/reader.h>
@@ -136,9 +138,11 @@ bool getFloatFromJsonValues(const Json::Value &values, ThrottlingArray *out, boo
 }
 }  // namespace
 
-std::unordered_map<std::string, SensorInfo> ParseSensorInfo(std::string_view config_path) {
+std::unordered_map<std::string, SensorInfo> ParseSensorInfo(
+        std::string_view config_path, std::vector<std::string> *sorted_sensors) {
     std::string json_doc;
     std::unordered_map<std::string, SensorInfo> sensors_parsed;
+    sorted_sensors->clear();
     if (!android::base::ReadFileToString(config_path.data(), &json_doc)) {
         LOG(ERROR) << "Failed to read JSON config from " << config_path;
         return sensors_parsed;
@@ -676,10 +680,68 @@ std::unordered_map<std::string, SensorInfo> ParseSensorInfo(std::string_view con
         ++total_parsed;
     }
 
+    if (!SortSensorsByLinks(sensors_parsed, sorted_sensors)) {
+        sensors_parsed.clear();
+        return sensors_parsed;
+    }
+
     LOG(INFO) << total_parsed << " Sensors parsed successfully";
     return sensors_parsed;
 }
 
+bool SortSensorsByLinks(const std::unordered_map<std::string, SensorInfo> &sensor_info_map,
+                        std::vector<std::string> *order) {
+    enum class Mark { NONE, VISITING, DONE };
+    std::unordered_map<std::string_view, Mark> marks;
+    // Sort the roots so the order does not depend on the hash map
+    std::vector<std::string_view> names;
+    names.reserve(sensor_info_map.size());
+    for (const auto &sensor_info_pair : sensor_info_map) {
+        names.emplace_back(sensor_info_pair.first);
+        marks[sensor_info_pair.first] = Mark::NONE;
+    }
+    std::sort(names.begin(), names.end());
+
+    order->clear();
+    order->reserve(sensor_info_map.size());
+    // Depth first, the chains of virtual sensors are short
+    std::function<bool(std::string_view)> visit = [&](std::string_view name) {
+        auto mark_itr = marks.find(name);
+        if (mark_itr == marks.end()) {
+            LOG(ERROR) << "Linked sensor " << name << " is not defined";
+            return false;
+        }
+        if (mark_itr->second == Mark::DONE) {
+            return true;
+        }
+        if (mark_itr->second == Mark::VISITING) {
+            LOG(ERROR) << "Virtual sensor " << name << " is in a cycle of linked sensors";
+            return false;
+        }
+        mark_itr->second = Mark::VISITING;
+        const auto &sensor_info = sensor_info_map.at(std::string(name));
+        if (sensor_info.virtual_sensor_info != nullptr) {
+            for (const auto &linked_sensor : sensor_info.virtual_sensor_info->linked_sensors) {
+                if (!visit(linked_sensor)) {
+                    LOG(ERROR) << "Sensor[" << name << "]'s combination is invalid";
+                    return false;
+                }
+            }
+        }
+        mark_itr->second = Mark::DONE;
+        order->emplace_back(name);
+        return true;
+    };
+
+    for (const auto &name : names) {
+        if (!visit(name)) {
+            order->clear();
+            return false;
+        }
+    }
+    return true;
+}
+
 std::unordered_map<std::string, CdevInfo> ParseCoolingDevice(std::string_view config_path) {
     std::string json_doc;
     std::unordered_map<std::string, CdevInfo> cooling_devices_parsed;
@@ -18,6 +18,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <android/hardware/thermal/2.0/IThermal.h>
 
@@ -128,7 +129,15 @@ struct PowerRailInfo {
     std::unique_ptr<VirtualPowerRailInfo> virtual_power_rail_info;
 };
 
-std::unordered_map<std::string, SensorInfo> ParseSensorInfo(std::string_view config_path);
+// Parse the sensors of config_path and fill sorted_sensors with their names in
+// the order of SortSensorsByLinks. Returns an empty map if the config is invalid.
+std::unordered_map<std::string, SensorInfo> ParseSensorInfo(
+        std::string_view config_path, std::vector<std::string> *sorted_sensors);
+// Fill order with all sensors of sensor_info_map, each virtual sensor after
+// the sensors it links. Returns false if a linked sensor is missing or the
+// links form a cycle.
+bool SortSensorsByLinks(const std::unordered_map<std::string, SensorInfo> &sensor_info_map,
+                        std::vector<std::string> *order);
 std::unordered_map<std::string, CdevInfo> ParseCoolingDevice(std::string_view config_path);
 std::unordered_map<std::string, PowerRailInfo> ParsePowerRailInfo(std::string_view config_path);
 
@@ -14,13 +14,18 @@
  * limitations under the License.
  */
 
-#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <limits>
+#include <mutex>
 #include <string_view>
 
 #include <android-base/file.h>
 #include <android-base/logging.h>
 #include <android-base/stringprintf.h>
-#include <android-base/strings.h>
 #include "thermal_files.h"
 
 namespace android {
@@ -29,34 +34,159 @@ namespace thermal {
 namespace V2_0 {
 namespace implementation {
 
+namespace {
+
+// Sensor and cooling device nodes hold a single number and a newline
+constexpr size_t kMaxThermalValueSize = 32;
+
+// Parse s into an integer part and a fraction, in units of 1 / *scale
+bool parseDecimal(std::string_view s, int64_t *number, int64_t *scale) {
+    size_t i = 0;
+    while (i < s.size() && std::isspace(static_cast<unsigned char>(s[i]))) {
+        i++;
+    }
+    bool negative = false;
+    if (i < s.size() && (s[i] == '-' || s[i] == '+')) {
+        negative = s[i] == '-';
+        i++;
+    }
+    // int64 holds 18 digits safely
+    constexpr size_t kMaxDigits = 18;
+    size_t digits = 0;
+    int64_t n = 0;
+    int64_t sc = 1;
+    for (; i < s.size() && std::isdigit(static_cast<unsigned char>(s[i])); i++) {
+        if (++digits > kMaxDigits) {
+            return false;
+        }
+        n = n * 10 + (s[i] - '0');
+    }
+    if (i < s.size() && s[i] == '.') {
+        i++;
+        for (; i < s.size() && std::isdigit(static_cast<unsigned char>(s[i])); i++) {
+            // Ignore digits beyond what a float can represent anyway
+            if (digits < kMaxDigits) {
+                digits++;
+                n = n * 10 + (s[i] - '0');
+                sc *= 10;
+            }
+        }
+    }
+    if (digits == 0) {
+        return false;
+    }
+    while (i < s.size() && std::isspace(static_cast<unsigned char>(s[i]))) {
+        i++;
+    }
+    if (i != s.size()) {
+        return false;
+    }
+    *number = negative ? -n : n;
+    *scale = sc;
+    return true;
+}
+
+}  // namespace
+
+bool parseThermalValue(std::string_view s, float *value) {
+    int64_t number, scale;
+    if (!parseDecimal(s, &number, &scale)) {
+        return false;
+    }
+    *value = static_cast<float>(static_cast<double>(number) / scale);
+    return true;
+}
+
+bool parseThermalValue(std::string_view s, int *value) {
+    int64_t number, scale;
+    if (!parseDecimal(s, &number, &scale) || scale != 1 ||
+        number > std::numeric_limits<int>::max() || number < std::numeric_limits<int>::min()) {
+        return false;
+    }
+    *value = static_cast<int>(number);
+    return true;
+}
+
 std::string ThermalFiles::getThermalFilePath(std::string_view thermal_name) const {
-    auto sensor_itr = thermal_name_to_path_map_.find(thermal_name.data());
-    if (sensor_itr == thermal_name_to_path_map_.end()) {
+    auto sensor_itr = thermal_files_.find(thermal_name);
+    if (sensor_itr == thermal_files_.end()) {
         return "";
     }
-    return sensor_itr->second;
+    return sensor_itr->second.path;
 }
 
 bool ThermalFiles::addThermalFile(std::string_view thermal_name, std::string_view path) {
-    return thermal_name_to_path_map_.emplace(thermal_name, path).second;
+    ThermalFile file;
+    file.path = path;
+    return thermal_files_.emplace(thermal_name, std::move(file)).second;
 }
 
-bool ThermalFiles::readThermalFile(std::string_view thermal_name, std::string *data) const {
-    std::string sensor_reading;
-    std::string file_path = getThermalFilePath(std::string_view(thermal_name));
-    *data = "";
-    if (file_path.empty()) {
-        PLOG(WARNING) << "Failed to find " << thermal_name << "'s path";
-        return false;
+ssize_t ThermalFiles::readToBuffer(std::string_view thermal_name, char *buf, size_t size) const {
+    auto sensor_itr = thermal_files_.find(thermal_name);
+    if (sensor_itr == thermal_files_.end()) {
+        LOG(WARNING) << "Failed to find " << thermal_name << "'s path";
+        return -1;
+    }
+    const ThermalFile &file = sensor_itr->second;
+
+    int fd;
+    {
+        std::shared_lock<std::shared_mutex> _lock(fd_mutex_);
+        fd = file.fd.get();
+        if (fd >= 0) {
+            ssize_t n = TEMP_FAILURE_RETRY(pread(fd, buf, size, 0));
+            // The node was removed and possibly recreated, e.g. the driver was reloaded
+            if (n >= 0 || (errno != ENODEV && errno != ESTALE)) {
+                if (n < 0) {
+                    PLOG(WARNING) << "Failed to read sensor: " << thermal_name;
+                }
+                return n;
+            }
+        }
     }
 
-    if (!::android::base::ReadFileToString(file_path, &sensor_reading)) {
+    std::unique_lock<std::shared_mutex> _lock(fd_mutex_);
+    // Another reader may have reopened it meanwhile
+    if (file.fd.get() == fd) {
+        file.fd.reset(TEMP_FAILURE_RETRY(open(file.path.c_str(), O_RDONLY | O_CLOEXEC)));
+        if (file.fd.get() < 0) {
+            PLOG(WARNING) << "Failed to open sensor: " << thermal_name;
+            return -1;
+        }
+    }
+    ssize_t n = TEMP_FAILURE_RETRY(pread(file.fd.get(), buf, size, 0));
+    if (n < 0) {
         PLOG(WARNING) << "Failed to read sensor: " << thermal_name;
+    }
+    return n;
+}
+
+bool ThermalFiles::readThermalFile(std::string_view thermal_name, float *value) const {
+    char buf[kMaxThermalValueSize];
+    ssize_t n = readToBuffer(thermal_name, buf, sizeof(buf));
+    if (n < 0) {
         return false;
     }
+    if (static_cast<size_t>(n) == sizeof(buf) ||
+        !parseThermalValue(std::string_view(buf, n), value)) {
+        LOG(WARNING) << "Failed to parse sensor: " << thermal_name << ": "
+                     << std::string_view(buf, n);
+        return false;
+    }
+    return true;
+}
 
-    // Strip the newline.
-    *data = ::android::base::Trim(sensor_reading);
+bool ThermalFiles::readThermalFile(std::string_view thermal_name, int *value) const {
+    char buf[kMaxThermalValueSize];
+    ssize_t n = readToBuffer(thermal_name, buf, sizeof(buf));
+    if (n < 0) {
+        return false;
+    }
+    if (static_cast<size_t>(n) == sizeof(buf) ||
+        !parseThermalValue(std::string_view(buf, n), value)) {
+        LOG(WARNING) << "Failed to parse " << thermal_name << ": " << std::string_view(buf, n);
+        return false;
+    }
     return true;
 }
 
@@ -16,8 +16,13 @@
 
 #pragma once
 
+#include <android-base/unique_fd.h>
+
+#include <functional>
+#include <map>
+#include <shared_mutex>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
 namespace android {
 namespace hardware {
@@ -25,6 +30,11 @@ namespace thermal {
 namespace V2_0 {
 namespace implementation {
 
+// Parse a decimal number, optionally with a fraction, surrounded by
+// whitespace. Returns false if s is anything else.
+bool parseThermalValue(std::string_view s, float *value);
+bool parseThermalValue(std::string_view s, int *value);
+
 class ThermalFiles {
   public:
     ThermalFiles() = default;
@@ -35,15 +45,30 @@ class ThermalFiles {
     std::string getThermalFilePath(std::string_view thermal_name) const;
     // Returns true if add was successful, false otherwise.
     bool addThermalFile(std::string_view thermal_name, std::string_view path);
-    // If thermal_name is not found in the thermal names to path map, this will set
-    // data to empty and return false. If the thermal_name is found and its content
-    // is read, this function will fill in data accordingly then return true.
-    bool readThermalFile(std::string_view thermal_name, std::string *data) const;
+    // If thermal_name is not found in the thermal names to path map, or its
+    // content is not a number, this will return false. Otherwise value is
+    // filled in and true is returned. The file is kept open after the first
+    // read and read again with pread, it is reopened if the node went away.
+    bool readThermalFile(std::string_view thermal_name, float *value) const;
+    bool readThermalFile(std::string_view thermal_name, int *value) const;
     bool writeCdevFile(std::string_view thermal_name, std::string_view data);
-    size_t getNumThermalFiles() const { return thermal_name_to_path_map_.size(); }
+    size_t getNumThermalFiles() const { return thermal_files_.size(); }
 
   private:
-    std::unordered_map<std::string, std::string> thermal_name_to_path_map_;
+    struct ThermalFile {
+        std::string path;
+        // Opened on first read, guarded by fd_mutex_
+        mutable android::base::unique_fd fd;
+    };
+
+    // Read the file of thermal_name into buf. Returns the number of bytes
+    // read, or -1 on error.
+    ssize_t readToBuffer(std::string_view thermal_name, char *buf, size_t size) const;
+
+    // std::less<> allows lookup by std::string_view without a copy
+    std::map<std::string, ThermalFile, std::less<>> thermal_files_;
+    // Reads share the fds, reopening one is exclusive
+    mutable std::shared_mutex fd_mutex_;
 };
 
 }  // namespace implementation
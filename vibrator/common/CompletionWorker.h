@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <pthread.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+// Runs effect completion waits on one long-lived thread, in submission order,
+// so starting an effect does not spawn a thread.
+class CompletionWorker {
+  public:
+    using Task = std::function<void()>;
+
+    explicit CompletionWorker(const char *name) : mThread(&CompletionWorker::run, this) {
+        pthread_setname_np(mThread.native_handle(), name);
+    }
+
+    // Runs the tasks still queued before returning.
+    ~CompletionWorker() {
+        {
+            std::scoped_lock lock(mMutex);
+            mStopping = true;
+        }
+        mCondition.notify_one();
+        mThread.join();
+    }
+
+    void post(Task &&task) {
+        {
+            std::scoped_lock lock(mMutex);
+            mTasks.push_back(std::move(task));
+        }
+        mCondition.notify_one();
+    }
+
+    // Waits up to timeout for the posted tasks to finish. Returns false if a
+    // task is still queued or running.
+    bool waitIdle(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(mMutex);
+        return mIdleCondition.wait_for(lock, timeout,
+                                       [this] { return !mBusy && mTasks.empty(); });
+    }
+
+  private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while (true) {
+            mCondition.wait(lock, [this] { return mStopping || !mTasks.empty(); });
+            if (mTasks.empty()) {
+                return;
+            }
+            Task task = std::move(mTasks.front());
+            mTasks.pop_front();
+            mBusy = true;
+            lock.unlock();
+            task();
+            lock.lock();
+            mBusy = false;
+            if (mTasks.empty()) {
+                mIdleCondition.notify_all();
+            }
+        }
+    }
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::condition_variable mIdleCondition;
+    std::deque<Task> mTasks;
+    bool mBusy{false};
+    bool mStopping{false};
+    // Declared last so the members above exist before the thread starts.
+    std::thread mThread;
+};
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -190,7 +190,7 @@ enum class AlwaysOnId : uint32_t {
 };
 
 Vibrator::Vibrator(std::unique_ptr<HwApi> hwapi, std::unique_ptr<HwCal> hwcal)
-    : mHwApi(std::move(hwapi)), mHwCal(std::move(hwcal)), mAsyncHandle(std::async([] {})) {
+    : mHwApi(std::move(hwapi)), mHwCal(std::move(hwcal)) {
     int32_t longFreqencyShift;
     uint32_t calVer;
     uint32_t caldata;
@@ -475,7 +475,7 @@ ndk::ScopedAStatus Vibrator::on(uint32_t timeoutMs, uint32_t effectIndex,
     mHwApi->setDuration(timeoutMs);
     mHwApi->setActivate(1);
 
-    mAsyncHandle = std::async(&Vibrator::waitForComplete, this, callback);
+    mCompletionWorker.post([this, callback]() mutable { waitForComplete(std::move(callback)); });
 
     return ndk::ScopedAStatus::ok();
 }
@@ -806,7 +806,7 @@ ndk::ScopedAStatus Vibrator::composePwle(const std::vector<PrimitivePwle> &compo
 
     mHwApi->setActivate(1);
 
-    mAsyncHandle = std::async(&Vibrator::waitForComplete, this, callback);
+    mCompletionWorker.post([this, callback]() mutable { waitForComplete(std::move(callback)); });
 
     return ndk::ScopedAStatus::ok();
 }
@@ -20,7 +20,8 @@
 
 #include <array>
 #include <fstream>
-#include <future>
+
+#include "CompletionWorker.h"
 
 namespace aidl {
 namespace android {
@@ -208,13 +209,14 @@ class Vibrator : public BnVibrator {
     std::array<uint32_t, 2> mClickEffectVol;
     std::array<uint32_t, 2> mLongEffectVol;
     std::vector<uint32_t> mEffectDurations;
-    std::future<void> mAsyncHandle;
     int32_t compositionSizeMax;
     struct pcm *mHapticPcm;
     int mCard;
     int mDevice;
     bool mHasHapticAlsaDevice;
     bool mIsUnderExternalControl;
+    // Declared last so pending completions run before the members go away.
+    CompletionWorker mCompletionWorker{"vibrator-cmpl"};
 };
 
 }  // namespace vibrator
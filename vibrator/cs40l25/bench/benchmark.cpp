@@ -14,6 +14,7 @@
 
 #include "benchmark/benchmark.h"
 
+#include <aidl/android/hardware/vibrator/BnVibratorCallback.h>
 #include <android-base/file.h>
 #include <cutils/fs.h>
 
@@ -95,6 +96,11 @@ class VibratorBench : public benchmark::Fixture {
     std::shared_ptr<IVibrator> mVibrator;
 };
 
+class VibratorCallback : public BnVibratorCallback {
+  public:
+    ndk::ScopedAStatus onComplete() override { return ndk::ScopedAStatus::ok(); }
+};
+
 #define BENCHMARK_WRAPPER(fixt, test, code) \
     BENCHMARK_DEFINE_F(fixt, test)          \
     /* NOLINTNEXTLINE */                    \
@@ -158,6 +164,24 @@ BENCHMARK_WRAPPER(VibratorBench, perform, {
     }
 })->Apply(VibratorBench::SupportedEffectArgs);
 
+// Tap-to-play latency: how long a click with a completion callback takes to
+// start, the completion wait runs on the completion worker.
+BENCHMARK_WRAPPER(VibratorBench, perform_callback, {
+    auto callback = ndk::SharedRefBase::make<VibratorCallback>();
+    int32_t lengthMs;
+
+    ndk::ScopedAStatus status =
+            mVibrator->perform(Effect::CLICK, EffectStrength::MEDIUM, callback, &lengthMs);
+
+    if (!status.isOk()) {
+        return;
+    }
+
+    for (auto _ : state) {
+        mVibrator->perform(Effect::CLICK, EffectStrength::MEDIUM, callback, &lengthMs);
+    }
+});
+
 }  // namespace vibrator
 }  // namespace hardware
 }  // namespace android
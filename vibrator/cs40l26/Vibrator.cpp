@@ -214,7 +214,7 @@ static int dspmem_chunk_flush(struct dspmem_chunk *ch) {
 std::vector<struct ff_effect> mFfEffects;
 
 Vibrator::Vibrator(std::unique_ptr<HwApi> hwapi, std::unique_ptr<HwCal> hwcal)
-    : mHwApi(std::move(hwapi)), mHwCal(std::move(hwcal)), mAsyncHandle(std::async([] {})) {
+    : mHwApi(std::move(hwapi)), mHwCal(std::move(hwcal)) {
     int32_t longFrequencyShift;
     std::string caldata{8, '0'};
     uint32_t calVer;
@@ -586,7 +586,7 @@ ndk::ScopedAStatus Vibrator::on(uint32_t timeoutMs, uint32_t effectIndex,
     if (effectIndex > WAVEFORM_MAX_INDEX) {
         return ndk::ScopedAStatus::fromExceptionCode(EX_ILLEGAL_ARGUMENT);
     }
-    if (mAsyncHandle.wait_for(ASYNC_COMPLETION_TIMEOUT) != std::future_status::ready) {
+    if (!mCompletionWorker.waitIdle(ASYNC_COMPLETION_TIMEOUT)) {
         ALOGE("Previous vibration pending.");
         return ndk::ScopedAStatus::fromExceptionCode(EX_ILLEGAL_STATE);
     }
@@ -614,7 +614,9 @@ ndk::ScopedAStatus Vibrator::on(uint32_t timeoutMs, uint32_t effectIndex,
 
     mActiveId = play.code;
 
-    mAsyncHandle = std::async(&Vibrator::waitForComplete, this, callback);
+    mCompletionWorker.post([this, timeoutMs, callback]() mutable {
+        waitForComplete(timeoutMs, std::move(callback));
+    });
 
     return ndk::ScopedAStatus::ok();
 }
@@ -923,7 +925,9 @@ ndk::ScopedAStatus Vibrator::composePwle(const std::vector<PrimitivePwle> &compo
 
     // mHwApi->setActivate(1);
 
-    mAsyncHandle = std::async(&Vibrator::waitForComplete, this, callback);
+    mCompletionWorker.post([this, totalDuration, callback]() mutable {
+        waitForComplete(totalDuration, std::move(callback));
+    });
 
     return ndk::ScopedAStatus::ok();
 }
@@ -1315,11 +1319,15 @@ ndk::ScopedAStatus Vibrator::performEffect(uint32_t effectIndex, uint32_t volLev
     return on(MAX_TIME_MS, effectIndex, callback);
 }
 
-void Vibrator::waitForComplete(std::shared_ptr<IVibratorCallback> &&callback) {
+void Vibrator::waitForComplete(uint32_t timeoutMs, std::shared_ptr<IVibratorCallback> &&callback) {
     if (!mHwApi->pollVibeState("Vibe state: Haptic\n", POLLING_TIMEOUT)) {
         ALOGE("Fail to get state \"Haptic\"");
     }
-    mHwApi->pollVibeState("Vibe state: Stopped\n");
+    /* Bound the wait so a missed state change cannot hold up later effects. */
+    if (!mHwApi->pollVibeState("Vibe state: Stopped\n",
+                               std::min(timeoutMs, MAX_TIME_MS) + POLLING_TIMEOUT)) {
+        ALOGE("Fail to get state \"Stopped\"");
+    }
 
     if (callback) {
         auto ret = callback->onComplete();
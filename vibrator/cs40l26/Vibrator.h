@@ -21,7 +21,8 @@
 
 #include <array>
 #include <fstream>
-#include <future>
+
+#include "CompletionWorker.h"
 
 namespace aidl {
 namespace android {
@@ -156,7 +157,7 @@ class Vibrator : public BnVibrator {
                                      const std::shared_ptr<IVibratorCallback> &callback);
     ndk::ScopedAStatus setPwle(const std::string &pwleQueue);
     bool isUnderExternalControl();
-    void waitForComplete(std::shared_ptr<IVibratorCallback> &&callback);
+    void waitForComplete(uint32_t timeoutMs, std::shared_ptr<IVibratorCallback> &&callback);
     uint32_t intensityToVolLevel(float intensity, uint32_t effectIndex);
     bool findHapticAlsaDevice(int *card, int *device);
     bool hasHapticAlsaDevice();
@@ -169,7 +170,6 @@ class Vibrator : public BnVibrator {
     std::array<uint32_t, 2> mClickEffectVol;
     std::array<uint32_t, 2> mLongEffectVol;
     std::vector<uint32_t> mEffectDurations;
-    std::future<void> mAsyncHandle;
     int32_t compositionSizeMax;
     ::android::base::unique_fd mInputFd;
     int8_t mActiveId{-1};
@@ -182,6 +182,8 @@ class Vibrator : public BnVibrator {
     bool mIsChirpEnabled;
     uint32_t mSupportedPrimitivesBits = 0x0;
     std::vector<CompositePrimitive> mSupportedPrimitives;
+    // Declared last so pending completions run before the members go away.
+    CompletionWorker mCompletionWorker{"vibrator-cmpl"};
 };
 
 }  // namespace vibrator